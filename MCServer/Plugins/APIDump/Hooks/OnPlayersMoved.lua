@@ -0,0 +1,44 @@
+return
+{
+	HOOK_PLAYERS_MOVED =
+	{
+		CalledWhen = "Once per world tick, with all the players who have moved in that world during the tick.",
+		DefaultFnName = "OnPlayersMoved",  -- also used as pagename
+		Desc = [[
+			This hook is called at the end of each {{cWorld|world}} tick in which at least one
+			{{cPlayer|player}} has moved, with the list of all the movements in that world during the tick.
+			It is meant for plugins that only need to react to the movement, such as region or portal
+			plugins; a single call per tick is much cheaper than calling
+			{{OnPlayerMoving|HOOK_PLAYER_MOVING}} for each player. The movements that were refused by a
+			HOOK_PLAYER_MOVING handler are not included.</p>
+			<p>
+			The Moves parameter is an array-table of tables, one for each player who moved. Each of them has
+			the following members:</p>
+			<table>
+			<tr><th>Name</th><th>Type</th><th>Notes</th></tr>
+			<tr><td>Player</td><td>{{cPlayer}}</td><td>The player who has moved</td></tr>
+			<tr><td>OldPosition</td><td>{{Vector3d}}</td><td>The position at the start of the tick</td></tr>
+			<tr><td>NewPosition</td><td>{{Vector3d}}</td><td>The new position, already stored in the player object</td></tr>
+			</table>
+			<p>
+			The hook is called in the world's tick thread context. The player objects and position vectors
+			are only valid within the callback, plugins must not store them for later use; copy the
+			positions if needed.
+		]],
+		Params =
+		{
+			{ Name = "World", Type = "{{cWorld}}", Notes = "The world in which the players have moved" },
+			{ Name = "Moves", Type = "table", Notes = "Array-table of the movements, as described above" },
+		},
+		Returns = [[
+			If the function returns false or no value, the next plugin's callback is called. If the function
+			returns true, no other callback is called for this event. The movements cannot be refused from
+			this hook, use {{OnPlayerMoving|HOOK_PLAYER_MOVING}} for that.
+		]],
+	},  -- HOOK_PLAYERS_MOVED
+}
+
+
+
+
+
@@ -0,0 +1,451 @@
+
+// Pregenerator.cpp
+
+// Implements the main app entrypoint and the cPregenerator class representing the entire app
+
+#include "Globals.h"
+#include "Pregenerator.h"
+#include "Root.h"
+#include "BlockInfo.h"
+#include "LightingThread.h"
+#include "Logger.h"
+#include "LoggerListeners.h"
+#include "StringCompression.h"
+#include "Generating/ChunkDesc.h"
+#include "WorldStorage/FastNBT.h"
+#include "WorldStorage/NBTChunkSerializer.h"
+#include "BlockEntities/BlockEntity.h"
+#include "Entities/Entity.h"
+
+
+
+
+
+// The globals normally defined by the server's main.cpp, which is not a part of this app:
+bool cRoot::m_TerminateEventRaised = false;
+bool g_ShouldLogCommIn = false;
+bool g_ShouldLogCommOut = false;
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	cLogger::cListener * consoleLogListener = MakeConsoleListener();
+	cLogger::GetInstance().AttachListener(consoleLogListener);
+
+	cLogger::InitiateMultithreading();
+
+	int res = 0;
+	{
+		cPregenerator Pregenerator;
+		if (Pregenerator.Init(argc, argv))
+		{
+			Pregenerator.Run();
+		}
+		else
+		{
+			res = 1;
+		}
+	}
+
+	cLogger::GetInstance().DetachListener(consoleLogListener);
+	delete consoleLogListener;
+
+	return res;
+}
+
+
+
+
+
+/** Returns the number of seconds elapsed since a_Start. */
+static double SecondsSince(std::chrono::steady_clock::time_point a_Start)
+{
+	return std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - a_Start).count();
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPregenerator:
+
+cPregenerator::cPregenerator(void) :
+	m_MinChunkX(0),
+	m_MinChunkZ(0),
+	m_MaxChunkX(0),
+	m_MaxChunkZ(0),
+	m_NumThreads(static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u))),
+	m_CompressionFactor(6),
+	m_NumChunksWritten(0),
+	m_NumChunksSkipped(0),
+	m_NumChunksGenerated(0)
+{
+}
+
+
+
+
+
+bool cPregenerator::Init(int argc, char ** argv)
+{
+	// Parse the command line: <WorldFolder> <Radius> [<CenterChunkX> <CenterChunkZ>] [<NumThreads>]
+	if ((argc != 3) && (argc != 5) && (argc != 6))
+	{
+		PrintUsage();
+		return false;
+	}
+	m_WorldFolder = argv[1];
+	int Radius = 0, CenterX = 0, CenterZ = 0;
+	if (!StringToInteger(argv[2], Radius) || (Radius < 0))
+	{
+		LOGERROR("Invalid radius: \"%s\"", argv[2]);
+		PrintUsage();
+		return false;
+	}
+	if (argc >= 5)
+	{
+		if (!StringToInteger(argv[3], CenterX) || !StringToInteger(argv[4], CenterZ))
+		{
+			LOGERROR("Invalid center chunk coords: \"%s\", \"%s\"", argv[3], argv[4]);
+			PrintUsage();
+			return false;
+		}
+	}
+	if (argc == 6)
+	{
+		if (!StringToInteger(argv[5], m_NumThreads) || (m_NumThreads < 1))
+		{
+			LOGERROR("Invalid number of threads: \"%s\"", argv[5]);
+			PrintUsage();
+			return false;
+		}
+	}
+	m_MinChunkX = CenterX - Radius;
+	m_MinChunkZ = CenterZ - Radius;
+	m_MaxChunkX = CenterX + Radius;
+	m_MaxChunkZ = CenterZ + Radius;
+
+	// Read the world settings; the generator settings need to be there, the default generator would be of little use:
+	AString IniFileName = m_WorldFolder + cFile::PathSeparator + "world.ini";
+	if (!m_IniFile.ReadFile(IniFileName, false))
+	{
+		LOGERROR("Cannot read the world settings from \"%s\". Run the server once to create the world, then pregenerate it.", IniFileName.c_str());
+		return false;
+	}
+	m_CompressionFactor = m_IniFile.GetValueI("Storage", "CompressionFactor", m_CompressionFactor);
+
+	// Passive mobs need the server's mob configuration, they cannot be generated here:
+	AString Finishers = m_IniFile.GetValue("Generator", "Finishers");
+	AStringVector FinishersList = StringSplitAndTrim(Finishers, ",");
+	AString PregenFinishers;
+	for (AStringVector::const_iterator itr = FinishersList.begin(), end = FinishersList.end(); itr != end; ++itr)
+	{
+		if (NoCaseCompare(*itr, "Animals") == 0)
+		{
+			LOGINFO("The Animals finisher is not supported by the pregenerator, the pregenerated chunks will have no passive mobs.");
+			continue;
+		}
+		if (!PregenFinishers.empty())
+		{
+			PregenFinishers.append(", ");
+		}
+		PregenFinishers.append(*itr);
+	}
+	m_IniFile.SetValue("Generator", "Finishers", PregenFinishers);
+
+	// Create the generator; if the world has no seed yet, store the new one, so that the server uses the same:
+	bool HasSeed = m_IniFile.HasValue("Seed", "Seed");
+	if (!m_ChunkGenerator.InitGenerator(m_IniFile, m_WorldFolder))
+	{
+		LOGERROR("Cannot create the generator for world \"%s\"", m_WorldFolder.c_str());
+		return false;
+	}
+	if (!HasSeed)
+	{
+		cIniFile OrigIniFile;
+		OrigIniFile.ReadFile(IniFileName, false);
+		OrigIniFile.SetValueI("Seed", "Seed", m_ChunkGenerator.GetSeed());
+		OrigIniFile.WriteFile(IniFileName);
+	}
+	for (int i = 0; i < m_NumThreads; i++)
+	{
+		std::unique_ptr<cChunkGenerator::cGenerator> Generator = m_ChunkGenerator.CreateGeneratorInstance(m_IniFile);
+		if (Generator == nullptr)
+		{
+			LOGERROR("The generator of world \"%s\" doesn't support multiple instances, use the Composable generator.", m_WorldFolder.c_str());
+			return false;
+		}
+		m_Generators.push_back(std::move(Generator));
+	}
+
+	// The block info table is initialized on first use, make sure it is done before the threads start:
+	cBlockInfo::Get(E_BLOCK_AIR);
+
+	return true;
+}
+
+
+
+
+
+void cPregenerator::Run(void)
+{
+	LOG("Pregenerating chunks [%d, %d] to [%d, %d] of world \"%s\" in %d threads",
+		m_MinChunkX, m_MinChunkZ, m_MaxChunkX, m_MaxChunkZ, m_WorldFolder.c_str(), m_NumThreads
+	);
+	cFile::CreateFolder(m_WorldFolder + cFile::PathSeparator + "region");
+
+	auto Start = std::chrono::steady_clock::now();
+	int MinRegionX = FAST_FLOOR_DIV(m_MinChunkX, 32);
+	int MinRegionZ = FAST_FLOOR_DIV(m_MinChunkZ, 32);
+	int MaxRegionX = FAST_FLOOR_DIV(m_MaxChunkX, 32);
+	int MaxRegionZ = FAST_FLOOR_DIV(m_MaxChunkZ, 32);
+	for (int RegionZ = MinRegionZ; RegionZ <= MaxRegionZ; RegionZ++)
+	{
+		for (int RegionX = MinRegionX; RegionX <= MaxRegionX; RegionX++)
+		{
+			ProcessRegion(RegionX, RegionZ);
+		}
+	}
+	double Seconds = SecondsSince(Start);
+
+	LOG("Done: %d chunks written, %d chunks already present, %d chunks generated in %.1f seconds; %.1f chunks per second",
+		m_NumChunksWritten, m_NumChunksSkipped, m_NumChunksGenerated, Seconds, m_NumChunksWritten / std::max(Seconds, 0.001)
+	);
+}
+
+
+
+
+
+void cPregenerator::ProcessRegion(int a_RegionX, int a_RegionZ)
+{
+	// Find the chunks in this region that are to be written:
+	AString FileName = Printf("%s%cregion%cr.%d.%d.mca", m_WorldFolder.c_str(), cFile::PathSeparator, cFile::PathSeparator, a_RegionX, a_RegionZ);
+	cWSSAnvil::cMCAFile File(FileName, a_RegionX, a_RegionZ);
+	int MinChunkX = std::max(m_MinChunkX, a_RegionX * 32);
+	int MinChunkZ = std::max(m_MinChunkZ, a_RegionZ * 32);
+	int MaxChunkX = std::min(m_MaxChunkX, a_RegionX * 32 + 31);
+	int MaxChunkZ = std::min(m_MaxChunkZ, a_RegionZ * 32 + 31);
+	cChunkCoordsVector ChunksToWrite;
+	int NumPresent = 0;
+	for (int z = MinChunkZ; z <= MaxChunkZ; z++)
+	{
+		for (int x = MinChunkX; x <= MaxChunkX; x++)
+		{
+			cChunkCoords Coords(x, z);
+			if (File.HasChunkData(Coords))
+			{
+				NumPresent += 1;
+				continue;
+			}
+			ChunksToWrite.push_back(Coords);
+		}
+	}
+	m_NumChunksSkipped += NumPresent;
+	if (ChunksToWrite.empty())
+	{
+		LOG("Region [%d, %d]: all %d chunks already present, skipping", a_RegionX, a_RegionZ, NumPresent);
+		return;
+	}
+
+	// Generate the chunks to write, plus a ring of neighbors needed for lighting. Parts of the bounding box may
+	// already be present, but re-generating them is simpler and cheaper than loading them:
+	int GenMinX = m_MaxChunkX, GenMinZ = m_MaxChunkZ, GenMaxX = m_MinChunkX, GenMaxZ = m_MinChunkZ;
+	for (cChunkCoordsVector::const_iterator itr = ChunksToWrite.begin(), end = ChunksToWrite.end(); itr != end; ++itr)
+	{
+		GenMinX = std::min(GenMinX, itr->m_ChunkX - 1);
+		GenMinZ = std::min(GenMinZ, itr->m_ChunkZ - 1);
+		GenMaxX = std::max(GenMaxX, itr->m_ChunkX + 1);
+		GenMaxZ = std::max(GenMaxZ, itr->m_ChunkZ + 1);
+	}
+	int SizeX = GenMaxX - GenMinX + 1;
+	int SizeZ = GenMaxZ - GenMinZ + 1;
+	cSetChunkDataPtrs Chunks(static_cast<size_t>(SizeX * SizeZ));
+
+	auto Start = std::chrono::steady_clock::now();
+	std::atomic<int> NextChunk(0);
+	std::vector<std::thread> Threads;
+	for (int i = 0; i < m_NumThreads; i++)
+	{
+		Threads.push_back(std::thread(
+			&cPregenerator::GenerateChunks, this,
+			std::ref(*m_Generators[static_cast<size_t>(i)]), std::ref(Chunks), GenMinX, GenMinZ, SizeX, std::ref(NextChunk)
+		));
+	}
+	for (std::vector<std::thread>::iterator itr = Threads.begin(), end = Threads.end(); itr != end; ++itr)
+	{
+		itr->join();
+	}
+	Threads.clear();
+	double GenSeconds = SecondsSince(Start);
+
+	// Light, serialize and write the chunks:
+	cCriticalSection CSFile;
+	NextChunk = 0;
+	for (int i = 0; i < m_NumThreads; i++)
+	{
+		Threads.push_back(std::thread(
+			&cPregenerator::WriteChunks, this,
+			std::ref(Chunks), GenMinX, GenMinZ, SizeX, std::cref(ChunksToWrite), std::ref(NextChunk), std::ref(File), std::ref(CSFile)
+		));
+	}
+	for (std::vector<std::thread>::iterator itr = Threads.begin(), end = Threads.end(); itr != end; ++itr)
+	{
+		itr->join();
+	}
+	double Seconds = SecondsSince(Start);
+
+	// The chunk data doesn't own the entities and block entities, free them:
+	for (cSetChunkDataPtrs::iterator itr = Chunks.begin(), end = Chunks.end(); itr != end; ++itr)
+	{
+		for (cEntityList::iterator itrE = (*itr)->GetEntities().begin(), endE = (*itr)->GetEntities().end(); itrE != endE; ++itrE)
+		{
+			delete *itrE;
+		}
+		for (cBlockEntityList::iterator itrB = (*itr)->GetBlockEntities().begin(), endB = (*itr)->GetBlockEntities().end(); itrB != endB; ++itrB)
+		{
+			delete *itrB;
+		}
+	}
+
+	int NumWritten = static_cast<int>(ChunksToWrite.size());
+	m_NumChunksWritten += NumWritten;
+	m_NumChunksGenerated += SizeX * SizeZ;
+	LOG("Region [%d, %d]: %d chunks written (%d already present), %d generated in %.1f sec, %.1f sec total; %.1f chunks per second",
+		a_RegionX, a_RegionZ, NumWritten, NumPresent, SizeX * SizeZ, GenSeconds, Seconds, NumWritten / std::max(Seconds, 0.001)
+	);
+}
+
+
+
+
+
+void cPregenerator::GenerateChunks(
+	cChunkGenerator::cGenerator & a_Generator,
+	cSetChunkDataPtrs & a_Chunks, int a_MinChunkX, int a_MinChunkZ, int a_SizeX,
+	std::atomic<int> & a_NextChunk
+)
+{
+	const int NumChunks = static_cast<int>(a_Chunks.size());
+	for (int Idx = a_NextChunk++; Idx < NumChunks; Idx = a_NextChunk++)
+	{
+		// Neighboring threads work on neighboring chunks, so that they share the cached data:
+		int ChunkX = a_MinChunkX + Idx % a_SizeX;
+		int ChunkZ = a_MinChunkZ + Idx / a_SizeX;
+		cChunkDesc Desc(ChunkX, ChunkZ);
+		a_Generator.DoGenerate(ChunkX, ChunkZ, Desc);
+
+		// Store the same data as the server stores for a generated chunk, see cWorld::cChunkGeneratorCallbacks::OnChunkGenerated():
+		cChunkDef::BlockNibbles BlockMetas;
+		Desc.CompressBlockMetas(BlockMetas);
+		cSetChunkDataPtr Chunk(new cSetChunkData(
+			ChunkX, ChunkZ,
+			Desc.GetBlockTypes(), BlockMetas,
+			nullptr, nullptr,
+			&Desc.GetHeightMap(), &Desc.GetBiomeMap(),
+			Desc.GetEntities(), Desc.GetBlockEntities(),
+			true
+		));
+		Chunk->RemoveInvalidBlockEntities();
+		a_Chunks[static_cast<size_t>(Idx)] = Chunk;
+	}
+}
+
+
+
+
+
+void cPregenerator::WriteChunks(
+	cSetChunkDataPtrs & a_Chunks, int a_MinChunkX, int a_MinChunkZ, int a_SizeX,
+	const cChunkCoordsVector & a_ChunksToWrite, std::atomic<int> & a_NextChunk,
+	cWSSAnvil::cMCAFile & a_File, cCriticalSection & a_CSFile
+)
+{
+	// The lighting buffers are too large for the stack:
+	std::unique_ptr<cLightingThread> Lighting(new cLightingThread);
+	std::unique_ptr<cChunkDef::BlockNibbles[]> Light(new cChunkDef::BlockNibbles[2]);
+	const int NumChunks = static_cast<int>(a_ChunksToWrite.size());
+	for (int Idx = a_NextChunk++; Idx < NumChunks; Idx = a_NextChunk++)
+	{
+		// Light the chunk from its 3x3 neighborhood:
+		const cChunkCoords & Coords = a_ChunksToWrite[static_cast<size_t>(Idx)];
+		const BLOCKTYPE * BlockTypes[9];
+		const HEIGHTTYPE * HeightMaps[9];
+		for (int i = 0; i < 9; i++)
+		{
+			int RelX = Coords.m_ChunkX - a_MinChunkX + (i % 3) - 1;
+			int RelZ = Coords.m_ChunkZ - a_MinChunkZ + (i / 3) - 1;
+			const cSetChunkData & Neighbor = *a_Chunks[static_cast<size_t>(RelX + RelZ * a_SizeX)];
+			BlockTypes[i] = Neighbor.GetBlockTypes();
+			HeightMaps[i] = Neighbor.GetHeightMap();
+		}
+		Lighting->LightChunkData(BlockTypes, HeightMaps, Light[0], Light[1]);
+
+		// Serialize and store:
+		cSetChunkData & Chunk = *a_Chunks[static_cast<size_t>(Coords.m_ChunkX - a_MinChunkX + (Coords.m_ChunkZ - a_MinChunkZ) * a_SizeX)];
+		AString Data;
+		SerializeChunk(Chunk, Light[0], Light[1], Data);
+		cCSLock Lock(a_CSFile);
+		if (!a_File.SetChunkData(Coords, Data))
+		{
+			LOGWARNING("Cannot write chunk [%d, %d] into file \"%s\"", Coords.m_ChunkX, Coords.m_ChunkZ, a_File.GetFileName().c_str());
+		}
+	}
+}
+
+
+
+
+
+void cPregenerator::SerializeChunk(cSetChunkData & a_Chunk, const cChunkDef::BlockNibbles & a_BlockLight, const cChunkDef::BlockNibbles & a_SkyLight, AString & a_Data)
+{
+	cFastNBTWriter Writer;
+	Writer.BeginCompound("Level");
+	Writer.AddInt("xPos", a_Chunk.GetChunkX());
+	Writer.AddInt("zPos", a_Chunk.GetChunkZ());
+
+	// Feed the data to the serializer the same way as the world does when saving a chunk:
+	cNBTChunkSerializer Serializer(Writer);
+	memcpy(Serializer.m_BlockTypes,    a_Chunk.GetBlockTypes(), sizeof(Serializer.m_BlockTypes));
+	memcpy(Serializer.m_BlockMetas,    a_Chunk.GetBlockMetas(), sizeof(Serializer.m_BlockMetas));
+	memcpy(Serializer.m_BlockLight,    a_BlockLight,            sizeof(Serializer.m_BlockLight));
+	memcpy(Serializer.m_BlockSkyLight, a_SkyLight,              sizeof(Serializer.m_BlockSkyLight));
+	cChunkDataCallback & Callback = Serializer;
+	Callback.LightIsValid(true);
+	Callback.HeightMap(&a_Chunk.GetHeightMap());
+	Callback.BiomeData(&a_Chunk.GetBiomes());
+	for (cEntityList::iterator itr = a_Chunk.GetEntities().begin(), end = a_Chunk.GetEntities().end(); itr != end; ++itr)
+	{
+		Callback.Entity(*itr);
+	}
+	for (cBlockEntityList::iterator itr = a_Chunk.GetBlockEntities().begin(), end = a_Chunk.GetBlockEntities().end(); itr != end; ++itr)
+	{
+		Callback.BlockEntity(*itr);
+	}
+	cWSSAnvil::FinishChunkNBT(Serializer, 0, Writer);
+	Writer.Finish();
+
+	CompressString(Writer.GetResult().data(), Writer.GetResult().size(), a_Data, m_CompressionFactor);
+}
+
+
+
+
+
+void cPregenerator::PrintUsage(void)
+{
+	LOG("Usage: Pregenerator <WorldFolder> <Radius> [<CenterChunkX> <CenterChunkZ> [<NumThreads>]]");
+	LOG("  Generates, lights and stores the chunks within Radius chunks of the center chunk (default [0, 0]).");
+	LOG("  Run it from the server folder (so that the generator finds its prefabs), with the server stopped.");
+	LOG("  The world folder needs to contain the world.ini file with the generator settings.");
+	LOG("  Chunks already present in the world are kept, an interrupted run can be simply restarted.");
+}
+
+
+
+
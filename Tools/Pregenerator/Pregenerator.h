@@ -0,0 +1,102 @@
+
+// Pregenerator.h
+
+// Interfaces to the cPregenerator class encapsulating the entire app
+
+/*
+The pregenerator generates, lights and stores a square area of a world without running the server.
+The world's generator settings are read from the world.ini file in the world folder, the chunks are written
+directly into the region files in the world's "region" subfolder.
+The area is processed one region file at a time:
+1. All the chunks to be written, plus a ring of one chunk around them, are generated in parallel,
+each thread using its own generator instance (the instances share their caches).
+2. The chunks to be written are lit (each thread has its own lighting buffers), serialized into NBT and compressed
+in parallel, then written into the region file.
+Chunks that are already present in the region file are skipped, so an interrupted run can simply be restarted.
+*/
+
+
+
+
+
+#pragma once
+
+#include "Generating/ChunkGenerator.h"
+#include "SetChunkData.h"
+#include "IniFile.h"
+#include "WorldStorage/WSSAnvil.h"
+
+
+
+
+
+class cPregenerator
+{
+public:
+	cPregenerator(void);
+
+	/** Reads the cmdline params and initializes the generator.
+	Returns true if the app should continue, false if not. */
+	bool Init(int argc, char ** argv);
+
+	/** Runs the entire app. */
+	void Run(void);
+
+protected:
+	/** The folder of the world being pregenerated, as given on the command line */
+	AString m_WorldFolder;
+
+	/** The world's settings, read from world.ini. The generator instances are initialized from it. */
+	cIniFile m_IniFile;
+
+	/** The area to be pregenerated, in chunk coords, inclusive */
+	int m_MinChunkX, m_MinChunkZ;
+	int m_MaxChunkX, m_MaxChunkZ;
+
+	/** Number of the threads used for generating and lighting */
+	int m_NumThreads;
+
+	/** The compression factor used for the chunk data, the same setting as the server's */
+	int m_CompressionFactor;
+
+	/** The chunk generator; only used for creating the generator instances, its thread is never started */
+	cChunkGenerator m_ChunkGenerator;
+
+	/** One generator instance per thread, sharing their caches */
+	std::vector<std::unique_ptr<cChunkGenerator::cGenerator>> m_Generators;
+
+	// Statistics:
+	int m_NumChunksWritten;
+	int m_NumChunksSkipped;
+	int m_NumChunksGenerated;
+
+
+	/** Generates, lights and writes the part of the area inside the specified region file. */
+	void ProcessRegion(int a_RegionX, int a_RegionZ);
+
+	/** Generates the chunks with indices from a_NextChunk until all are done, in a single thread.
+	a_Chunks is the generated area, a_MinChunkX, a_MinChunkZ and a_SizeX are its first chunk coords and width. */
+	void GenerateChunks(
+		cChunkGenerator::cGenerator & a_Generator,
+		cSetChunkDataPtrs & a_Chunks, int a_MinChunkX, int a_MinChunkZ, int a_SizeX,
+		std::atomic<int> & a_NextChunk
+	);
+
+	/** Lights, serializes and writes the chunks from a_ChunksToWrite with indices from a_NextChunk until all are done,
+	in a single thread. a_Chunks is the generated area, see GenerateChunks(). a_CSFile protects a_File. */
+	void WriteChunks(
+		cSetChunkDataPtrs & a_Chunks, int a_MinChunkX, int a_MinChunkZ, int a_SizeX,
+		const cChunkCoordsVector & a_ChunksToWrite, std::atomic<int> & a_NextChunk,
+		cWSSAnvil::cMCAFile & a_File, cCriticalSection & a_CSFile
+	);
+
+	/** Serializes the chunk, including the light, into the compressed NBT data stored in the region files. */
+	void SerializeChunk(cSetChunkData & a_Chunk, const cChunkDef::BlockNibbles & a_BlockLight, const cChunkDef::BlockNibbles & a_SkyLight, AString & a_Data);
+
+	/** Prints the command line usage. */
+	static void PrintUsage(void);
+} ;
+
+
+
+
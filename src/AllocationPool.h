@@ -33,15 +33,21 @@ public:
 };
 
 /** Allocates memory storing unused elements in a linked list. Keeps at least NumElementsInReserve
-elements in the list unless malloc fails so that the program has a reserve to handle OOM.**/
+elements in the list unless malloc fails so that the program has a reserve to handle OOM.
+The list is intrusive - it is stored within the unused elements themselves, so that freeing an element
+doesn't need any further allocation.**/
 template <class T, size_t NumElementsInReserve>
 class cListAllocationPool : public cAllocationPool<T>
 {
 	public:
 		
 		cListAllocationPool(std::auto_ptr<typename cAllocationPool<T>::cStarvationCallbacks> a_Callbacks) :
+			m_FreeList(nullptr),
+			m_NumFree(0),
+			m_NumMallocs(0),
 			m_Callbacks(a_Callbacks)
 		{
+			static_assert(sizeof(T) >= sizeof(sFreeElement), "The pooled type is too small to hold the free list link");
 			for (size_t i = 0; i < NumElementsInReserve; i++)
 			{
 				void * space = malloc(sizeof(T));
@@ -50,33 +56,34 @@ class cListAllocationPool : public cAllocationPool<T>
 					m_Callbacks->OnStartUsingReserve();
 					break;
 				}
-				m_FreeList.push_front(space);
+				m_NumMallocs += 1;
+				PushFree(space);
 			}
 		}
 		
 		virtual ~cListAllocationPool()
 		{
-			while (!m_FreeList.empty())
+			while (m_FreeList != nullptr)
 			{
-				free (m_FreeList.front());
-				m_FreeList.pop_front();
+				free(PopFree());
 			}
 		}
 		
 		virtual T * Allocate() override
 		{
-			if (m_FreeList.size() <= NumElementsInReserve)
+			if (m_NumFree <= NumElementsInReserve)
 			{
 				void * space = malloc(sizeof(T));
 				if (space != nullptr)
 				{
+					m_NumMallocs += 1;
 					return new(space) T;
 				}
-				else if (m_FreeList.size() == NumElementsInReserve)
+				else if (m_NumFree == NumElementsInReserve)
 				{
 					m_Callbacks->OnStartUsingReserve();
 				}
-				else if (m_FreeList.empty())
+				else if (m_NumFree == 0)
 				{
 					m_Callbacks->OnOutOfReserve();
 					// Try again until the memory is avalable
@@ -84,8 +91,7 @@ class cListAllocationPool : public cAllocationPool<T>
 				}
 			}
 			// placement new, used to initalize the object
-			T * ret = new (m_FreeList.front()) T;
-			m_FreeList.pop_front();
+			T * ret = new (PopFree()) T;
 			return ret;
 		}
 		virtual void Free(T * a_ptr) override
@@ -96,16 +102,46 @@ class cListAllocationPool : public cAllocationPool<T>
 			}
 			// placement destruct.
 			a_ptr->~T();
-			m_FreeList.push_front(a_ptr);
-			if (m_FreeList.size() == NumElementsInReserve)
+			PushFree(a_ptr);
+			if (m_NumFree == NumElementsInReserve)
 			{
 				m_Callbacks->OnEndUsingReserve();
 			}
 		}
+
+		/** Returns the number of unused elements currently held by the pool. */
+		size_t GetNumFree(void) const { return m_NumFree; }
+
+		/** Returns the number of elements allocated from the heap over the pool's lifetime; the rest of the allocations reused the unused elements. */
+		size_t GetNumMallocs(void) const { return m_NumMallocs; }
 		
 	private:
-		std::list<void *> m_FreeList;
+		/** The link stored in each unused element */
+		struct sFreeElement
+		{
+			sFreeElement * m_Next;
+		};
+
+		sFreeElement * m_FreeList;
+		size_t m_NumFree;
+		size_t m_NumMallocs;
 		std::auto_ptr<typename cAllocationPool<T>::cStarvationCallbacks> m_Callbacks;
+
+		void PushFree(void * a_Space)
+		{
+			sFreeElement * Element = reinterpret_cast<sFreeElement *>(a_Space);
+			Element->m_Next = m_FreeList;
+			m_FreeList = Element;
+			m_NumFree += 1;
+		}
+
+		void * PopFree(void)
+		{
+			sFreeElement * Element = m_FreeList;
+			m_FreeList = Element->m_Next;
+			m_NumFree -= 1;
+			return Element;
+		}
 };
 
 
@@ -0,0 +1,147 @@
+// AutosaveScheduler.cpp
+
+// Implements the cAutosaveScheduler class that continuously queues the dirty chunks of a world for saving
+
+#include "Globals.h"
+#include "AutosaveScheduler.h"
+#include "World.h"
+#include "ChunkMap.h"
+#include "CommandOutput.h"
+#include "IniFile.h"
+
+
+
+
+
+/** Number of world ticks between two scheduling passes */
+static const Int64 TICKS_PER_PASS = 20;
+
+
+
+
+
+/** Returns true if a_First should be saved before a_Second.
+The chunks that will unload once saved go first, then the ones that have been dirty the longest. */
+static bool IsMoreUrgent(const sAutosaveCandidate & a_First, const sAutosaveCandidate & a_Second)
+{
+	if (a_First.m_IsUnused != a_Second.m_IsUnused)
+	{
+		return a_First.m_IsUnused;
+	}
+	return (a_First.m_DirtySince < a_Second.m_DirtySince);
+}
+
+
+
+
+
+cAutosaveScheduler::cAutosaveScheduler(cWorld & a_World, cChunkMap & a_ChunkMap) :
+	m_World(a_World),
+	m_ChunkMap(a_ChunkMap),
+	m_IntervalTicks(300 * 20),
+	m_MaxChunksPerSecond(200),
+	m_MaxQueueLength(500),
+	m_LastPassTick(0),
+	m_NumDirty(0),
+	m_NumOverdue(0),
+	m_NumQueuedLastPass(0),
+	m_OldestDirtyTicks(0),
+	m_NumQueuedTotal(0)
+{
+}
+
+
+
+
+
+void cAutosaveScheduler::LoadSettings(cIniFile & a_IniFile)
+{
+	int IntervalSeconds  = a_IniFile.GetValueSetI("Storage", "AutosaveIntervalSeconds",    300);
+	m_MaxChunksPerSecond = a_IniFile.GetValueSetI("Storage", "AutosaveMaxChunksPerSecond", m_MaxChunksPerSecond);
+	m_MaxQueueLength     = a_IniFile.GetValueSetI("Storage", "AutosaveMaxQueueLength",     m_MaxQueueLength);
+
+	m_IntervalTicks = std::max(IntervalSeconds, 1) * 20;
+	m_MaxChunksPerSecond = std::max(m_MaxChunksPerSecond, 1);
+	m_MaxQueueLength = std::max(m_MaxQueueLength, 1);
+}
+
+
+
+
+
+void cAutosaveScheduler::Tick(Int64 a_WorldAge)
+{
+	if (a_WorldAge - m_LastPassTick < TICKS_PER_PASS)
+	{
+		return;
+	}
+	m_LastPassTick = a_WorldAge;
+	SchedulePass(a_WorldAge);
+}
+
+
+
+
+
+void cAutosaveScheduler::LogStats(cCommandOutputCallback & a_Output)
+{
+	a_Output.Out("  Autosave: %d dirty chunks waiting, %d of them overdue, the oldest dirty for %d seconds",
+		m_NumDirty, m_NumOverdue, static_cast<int>(m_OldestDirtyTicks / 20)
+	);
+	a_Output.Out("  Autosave: %d chunks queued in the last pass, %llu in total; budget %d chunks per second, interval %d seconds",
+		m_NumQueuedLastPass, m_NumQueuedTotal, m_MaxChunksPerSecond, static_cast<int>(m_IntervalTicks / 20)
+	);
+	cWorldStorage::sSaveStats SaveStats = m_World.GetStorage().GetSaveStats();
+	a_Output.Out("  Chunk saving: %llu chunks saved, %.2f msec average, %.2f msec max per chunk",
+		SaveStats.m_NumSaved, SaveStats.m_AvgSaveMsec, SaveStats.m_MaxSaveMsec
+	);
+}
+
+
+
+
+
+void cAutosaveScheduler::SchedulePass(Int64 a_WorldAge)
+{
+	cAutosaveCandidates Candidates;
+	m_ChunkMap.CollectAutosaveCandidates(Candidates);
+
+	// Update the statistics:
+	m_NumDirty = static_cast<int>(Candidates.size());
+	m_NumOverdue = 0;
+	m_OldestDirtyTicks = 0;
+	for (cAutosaveCandidates::const_iterator itr = Candidates.begin(), end = Candidates.end(); itr != end; ++itr)
+	{
+		Int64 DirtyTicks = a_WorldAge - itr->m_DirtySince;
+		m_OldestDirtyTicks = std::max(m_OldestDirtyTicks, DirtyTicks);
+		if (DirtyTicks >= m_IntervalTicks)
+		{
+			m_NumOverdue += 1;
+		}
+	}
+
+	// Queue an even share of the dirty chunks, or all the overdue ones if more, within the budget and the queue room:
+	int IntervalPasses = static_cast<int>(m_IntervalTicks / TICKS_PER_PASS);
+	int NumToQueue = std::max(m_NumOverdue, (m_NumDirty + IntervalPasses - 1) / IntervalPasses);
+	int QueueRoom = m_MaxQueueLength - static_cast<int>(m_World.GetStorageSaveQueueLength());
+	NumToQueue = std::min(NumToQueue, std::min(m_MaxChunksPerSecond, QueueRoom));
+	if (NumToQueue <= 0)
+	{
+		m_NumQueuedLastPass = 0;
+		return;
+	}
+
+	// Pick the most urgent chunks:
+	if (static_cast<size_t>(NumToQueue) < Candidates.size())
+	{
+		std::partial_sort(Candidates.begin(), Candidates.begin() + NumToQueue, Candidates.end(), IsMoreUrgent);
+		Candidates.resize(static_cast<size_t>(NumToQueue));
+	}
+
+	m_NumQueuedLastPass = m_ChunkMap.QueueChunksForSave(Candidates);
+	m_NumQueuedTotal += static_cast<UInt64>(m_NumQueuedLastPass);
+}
+
+
+
+
@@ -0,0 +1,101 @@
+
+// AutosaveScheduler.h
+
+// Declares the cAutosaveScheduler class that continuously queues the dirty chunks of a world for saving
+
+/*
+Instead of queueing all the dirty chunks at once every few minutes, the scheduler runs once per second and queues
+only a part of the dirty chunks, so that the storage thread's load is spread evenly over the autosave interval.
+Each pass queues at least 1 / IntervalSeconds of the dirty chunks, and at least all the chunks that have been dirty
+for longer than the interval. The chunks that are not used by any client nor chunkstay (and thus will be unloaded
+as soon as they are saved) go first, then the chunks that have been dirty the longest.
+The number of chunks queued per pass is limited by the I/O budget (chunks per second) and by the current length
+of the storage's save queue, so that a slow disk doesn't accumulate a backlog.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+// fwd:
+class cWorld;
+class cChunkMap;
+class cCommandOutputCallback;
+class cIniFile;
+
+
+
+
+
+/** A single dirty chunk that can be queued for saving, as reported by cChunkMap::CollectAutosaveCandidates() */
+struct sAutosaveCandidate
+{
+	int m_ChunkX;
+	int m_ChunkZ;
+
+	/** The world age (in ticks) when the chunk last became dirty */
+	Int64 m_DirtySince;
+
+	/** True if the chunk is not used by any client nor chunkstay, so it will unload once saved */
+	bool m_IsUnused;
+} ;
+
+typedef std::vector<sAutosaveCandidate> cAutosaveCandidates;
+
+
+
+
+
+/** Queues the dirty chunks for saving in small portions, see the comment at the top of this file. */
+class cAutosaveScheduler
+{
+public:
+	cAutosaveScheduler(cWorld & a_World, cChunkMap & a_ChunkMap);
+
+	/** Reads the settings from the [Storage] section of the world's ini file, writing the defaults for missing values. */
+	void LoadSettings(cIniFile & a_IniFile);
+
+	/** Called by the world in each tick; runs a scheduling pass once per second. */
+	void Tick(Int64 a_WorldAge);
+
+	/** Outputs the scheduler's statistics, used by the "chunkstats" console command. */
+	void LogStats(cCommandOutputCallback & a_Output);
+
+protected:
+	cWorld & m_World;
+	cChunkMap & m_ChunkMap;
+
+	/** Each dirty chunk should be saved within this many ticks of becoming dirty */
+	Int64 m_IntervalTicks;
+
+	/** The I/O budget - maximum number of chunks to queue per second */
+	int m_MaxChunksPerSecond;
+
+	/** No more chunks are queued while the storage's save queue is at least this long */
+	int m_MaxQueueLength;
+
+	/** The world age at which the last scheduling pass was run */
+	Int64 m_LastPassTick;
+
+	// Statistics from the last scheduling pass:
+	int m_NumDirty;
+	int m_NumOverdue;
+	int m_NumQueuedLastPass;
+	Int64 m_OldestDirtyTicks;
+
+	/** Total number of chunks queued since the start */
+	UInt64 m_NumQueuedTotal;
+
+	/** Runs a single scheduling pass, queueing the most urgent portion of the dirty chunks. */
+	void SchedulePass(Int64 a_WorldAge);
+} ;
+
+
+
+
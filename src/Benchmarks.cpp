@@ -0,0 +1,554 @@
+// Benchmarks.cpp
+
+// Implements the cBenchmarks class that implements the in-server benchmarks available through the "benchmark" console command
+
+#include "Globals.h"
+#include "Benchmarks.h"
+#include "Root.h"
+#include "World.h"
+#include "ChunkCursor.h"
+#include "ChunkMap.h"
+#include "BlockArea.h"
+#include "BoundingBox.h"
+#include "CommandOutput.h"
+#include "IniFile.h"
+#include "ItemGrid.h"
+#include "Generating/ChunkDesc.h"
+
+
+
+
+
+/** Size of the area, in chunks, used by the block lookup benchmark; centered around the spawn chunk */
+static const int BENCH_AREA_CHUNKS = 3;
+
+/** Size of the TNT cube, in blocks, used by the explosion benchmark */
+static const int BENCH_TNT_SIZE = 10;
+
+/** Size of each explosion in the explosion benchmark, the same as a primed TNT */
+static const double BENCH_TNT_EXPLOSION_SIZE = 4.0;
+
+/** Size of the area, in chunks, generated by the generator benchmark */
+static const int BENCH_GEN_AREA_CHUNKS = 64;
+
+/** Chunk coords of the first chunk generated by the generator benchmark; far enough not to be cached by the world's generator */
+static const int BENCH_GEN_AREA_START = 20000;
+
+/** Number of hoppers in the ring used by the hopper chain benchmark */
+static const int BENCH_HOPPER_CHAIN_LENGTH = 256;
+
+/** Number of rounds of the hopper chain benchmark; in each round each hopper moves one item into the next one */
+static const int BENCH_HOPPER_ROUNDS = 4000;
+
+/** How long the console waits for a world to run a benchmark in its tick thread, in milliseconds */
+static const unsigned BENCH_WORLD_TIMEOUT_MSEC = 60000;
+
+
+
+
+
+/** Returns the number of seconds elapsed since a_Start, as a double. */
+static double SecondsSince(const std::chrono::steady_clock::time_point & a_Start)
+{
+	return std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - a_Start).count();
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cBenchmarks:
+
+void cBenchmarks::Run(const AStringVector & a_Split, cCommandOutputCallback & a_Output)
+{
+	// Get the world to run the benchmark in:
+	cWorld * World = (a_Split.size() > 2) ? cRoot::Get()->GetWorld(a_Split[2]) : cRoot::Get()->GetDefaultWorld();
+	if (World == nullptr)
+	{
+		a_Output.Out("No such world");
+		return;
+	}
+
+	// Dispatch by the benchmark name:
+	if (a_Split.size() > 1)
+	{
+		if (a_Split[1] == "blocklookups")
+		{
+			BlockLookups(*World, a_Output);
+			return;
+		}
+		if (a_Split[1] == "explosion")
+		{
+			Explosion(*World, a_Output);
+			return;
+		}
+		if (a_Split[1] == "generator")
+		{
+			Generator(*World, a_Output);
+			return;
+		}
+		if (a_Split[1] == "hopperchain")
+		{
+			HopperChain(a_Output);
+			return;
+		}
+	}
+
+	a_Output.Out("Usage: benchmark <name> [world]");
+	a_Output.Out("Available benchmarks:");
+	a_Output.Out("  blocklookups - cWorld::GetBlock() vs. cChunkCursor lookups around the spawn");
+	a_Output.Out("  explosion    - detonates a %d x %d x %d cube of TNT high above the spawn", BENCH_TNT_SIZE, BENCH_TNT_SIZE, BENCH_TNT_SIZE);
+	a_Output.Out("  generator    - generates a %d x %d chunk area in parallel, without storing it", BENCH_GEN_AREA_CHUNKS, BENCH_GEN_AREA_CHUNKS);
+	a_Output.Out("  hopperchain  - moves items around a ring of %d hoppers for %d rounds", BENCH_HOPPER_CHAIN_LENGTH, BENCH_HOPPER_ROUNDS);
+}
+
+
+
+
+
+void cBenchmarks::BlockLookups(cWorld & a_World, cCommandOutputCallback & a_Output)
+{
+	// Check that the whole area is loaded, otherwise the numbers would be meaningless:
+	int SpawnChunkX, SpawnChunkZ;
+	cChunkDef::BlockToChunk((int)floor(a_World.GetSpawnX()), (int)floor(a_World.GetSpawnZ()), SpawnChunkX, SpawnChunkZ);
+	int MinChunkX = SpawnChunkX - BENCH_AREA_CHUNKS / 2;
+	int MinChunkZ = SpawnChunkZ - BENCH_AREA_CHUNKS / 2;
+	for (int z = 0; z < BENCH_AREA_CHUNKS; z++)
+	{
+		for (int x = 0; x < BENCH_AREA_CHUNKS; x++)
+		{
+			if (!a_World.IsChunkValid(MinChunkX + x, MinChunkZ + z))
+			{
+				a_Output.Out("Chunk [%d, %d] around the spawn is not loaded, cannot benchmark", MinChunkX + x, MinChunkZ + z);
+				return;
+			}
+		}
+	}
+	int MinX = MinChunkX * cChunkDef::Width;
+	int MinZ = MinChunkZ * cChunkDef::Width;
+	int MaxX = MinX + BENCH_AREA_CHUNKS * cChunkDef::Width;
+	int MaxZ = MinZ + BENCH_AREA_CHUNKS * cChunkDef::Width;
+	double NumLookups = (double)(MaxX - MinX) * (double)(MaxZ - MinZ) * (double)cChunkDef::Height;
+
+	// Per-block world lookups, each locks the chunkmap and resolves the chunk:
+	// The checksums prevent the compiler from optimizing the lookups away and verify that both methods read the same data
+	int WorldChecksum = 0;
+	auto Start = std::chrono::steady_clock::now();
+	for (int z = MinZ; z < MaxZ; z++)
+	{
+		for (int x = MinX; x < MaxX; x++)
+		{
+			for (int y = 0; y < cChunkDef::Height; y++)
+			{
+				WorldChecksum += a_World.GetBlock(x, y, z);
+			}
+		}
+	}
+	double WorldTime = SecondsSince(Start);
+
+	// Lookups through a single cursor:
+	int CursorChecksum = 0;
+	int NumChunkSwitches = 0;
+	Start = std::chrono::steady_clock::now();
+	{
+		cChunkCursor Cursor(a_World);
+		for (int z = MinZ; z < MaxZ; z++)
+		{
+			for (int x = MinX; x < MaxX; x++)
+			{
+				for (int y = 0; y < cChunkDef::Height; y++)
+				{
+					CursorChecksum += Cursor.GetBlock(x, y, z);
+				}
+			}
+		}
+		NumChunkSwitches = Cursor.GetNumChunkSwitches();
+	}
+	double CursorTime = SecondsSince(Start);
+
+	a_Output.Out("Block lookups in world %s, %d x %d chunks around the spawn (%.0f lookups per method):", a_World.GetName().c_str(), BENCH_AREA_CHUNKS, BENCH_AREA_CHUNKS, NumLookups);
+	a_Output.Out("  cWorld::GetBlock(): %.3f sec, %.2f M lookups / sec", WorldTime, NumLookups / std::max(WorldTime, 1e-9) / 1e6);
+	a_Output.Out("  cChunkCursor:       %.3f sec, %.2f M lookups / sec, %d chunk switches", CursorTime, NumLookups / std::max(CursorTime, 1e-9) / 1e6, NumChunkSwitches);
+	a_Output.Out("  Speedup: %.2fx", WorldTime / std::max(CursorTime, 1e-9));
+	if (WorldChecksum != CursorChecksum)
+	{
+		// The world may have changed in between the two runs; the numbers are still valid, but let the user know
+		a_Output.Out("  (Note: the area was modified during the benchmark, the checksums differ)");
+	}
+}
+
+
+
+
+
+/** Restores the area of the explosion benchmark once the explosions are over, removing the primed TNT, shrapnel
+and drops spawned by the explosions before they go off or fall down. */
+class cExplosionBenchmarkCleanup :
+	public cWorld::cTask
+{
+public:
+	cExplosionBenchmarkCleanup(const cBlockArea & a_Saved, const cBoundingBox & a_SpawnBox) :
+		m_SpawnBox(a_SpawnBox)
+	{
+		m_Saved.CopyFrom(a_Saved);
+	}
+
+protected:
+	/** The blocks of the area before the benchmark */
+	cBlockArea m_Saved;
+
+	/** The box in which the entities spawned by the explosions are removed */
+	cBoundingBox m_SpawnBox;
+
+	// cWorld::cTask overrides:
+	virtual void Run(cWorld & a_World) override
+	{
+		class cRemover :
+			public cEntityCallback
+		{
+			virtual bool Item(cEntity * a_Entity) override
+			{
+				if (a_Entity->IsTNT() || a_Entity->IsFallingBlock() || a_Entity->IsPickup())
+				{
+					a_Entity->Destroy();
+				}
+				return false;
+			}
+		} Remover;
+		a_World.ForEachEntityInBox(m_SpawnBox, Remover);
+		m_Saved.Write(&a_World, m_Saved.GetOrigin());
+	}
+} ;
+
+
+
+
+
+/** Runs the explosion benchmark in the world's tick thread. The results are collected in a buffer, shared with the
+console thread waiting for them; the console may give up waiting, so the task mustn't refer to its output directly. */
+class cExplosionBenchmarkTask :
+	public cWorld::cTask
+{
+public:
+	/** The state shared by the task and the console thread */
+	struct sShared :
+		public cCommandOutputCallback
+	{
+		/** The output of the benchmark */
+		AString m_Output;
+
+		/** Set once the benchmark has finished */
+		cEvent m_Done;
+
+		// cCommandOutputCallback overrides:
+		virtual void Out(const AString & a_Text) override
+		{
+			m_Output.append(a_Text);
+		}
+	} ;
+
+	cExplosionBenchmarkTask(std::shared_ptr<sShared> a_Shared) :
+		m_Shared(a_Shared)
+	{
+	}
+
+protected:
+	std::shared_ptr<sShared> m_Shared;
+
+	// cWorld::cTask overrides:
+	virtual void Run(cWorld & a_World) override
+	{
+		cBenchmarks::ExplodeTNTCube(a_World, *m_Shared);
+		m_Shared->m_Done.Set();
+	}
+} ;
+
+
+
+
+
+void cBenchmarks::Explosion(cWorld & a_World, cCommandOutputCallback & a_Output)
+{
+	// The benchmark modifies the world, run it in the world's tick thread:
+	std::shared_ptr<cExplosionBenchmarkTask::sShared> Shared = std::make_shared<cExplosionBenchmarkTask::sShared>();
+	a_World.QueueTask(make_unique<cExplosionBenchmarkTask>(Shared));
+	if (!Shared->m_Done.Wait(BENCH_WORLD_TIMEOUT_MSEC))
+	{
+		a_Output.Out("World %s hasn't run the benchmark within %u seconds", a_World.GetName().c_str(), BENCH_WORLD_TIMEOUT_MSEC / 1000);
+		return;
+	}
+	a_Output.Out(Shared->m_Output);
+}
+
+
+
+
+
+void cBenchmarks::ExplodeTNTCube(cWorld & a_World, cCommandOutputCallback & a_Output)
+{
+	// Place the cube high enough so that the explosions don't reach the terrain:
+	int ExplosionSizeInt = (int)ceil(BENCH_TNT_EXPLOSION_SIZE);
+	int MinX = (int)floor(a_World.GetSpawnX()) - BENCH_TNT_SIZE / 2;
+	int MinZ = (int)floor(a_World.GetSpawnZ()) - BENCH_TNT_SIZE / 2;
+	int MinY = cChunkDef::Height - BENCH_TNT_SIZE - ExplosionSizeInt - 1;
+
+	// Check that all the chunks reached by the explosions are loaded:
+	int MinChunkX, MinChunkZ, MaxChunkX, MaxChunkZ;
+	cChunkDef::BlockToChunk(MinX - ExplosionSizeInt, MinZ - ExplosionSizeInt, MinChunkX, MinChunkZ);
+	cChunkDef::BlockToChunk(MinX + BENCH_TNT_SIZE + ExplosionSizeInt, MinZ + BENCH_TNT_SIZE + ExplosionSizeInt, MaxChunkX, MaxChunkZ);
+	for (int z = MinChunkZ; z <= MaxChunkZ; z++)
+	{
+		for (int x = MinChunkX; x <= MaxChunkX; x++)
+		{
+			if (!a_World.IsChunkValid(x, z))
+			{
+				a_Output.Out("Chunk [%d, %d] around the spawn is not loaded, cannot benchmark", x, z);
+				return;
+			}
+		}
+	}
+
+	// Save the area reached by the explosions, so that it can be restored afterwards:
+	cBlockArea Saved;
+	if (!Saved.Read(
+		&a_World,
+		MinX - ExplosionSizeInt, MinX + BENCH_TNT_SIZE + ExplosionSizeInt,
+		MinY - ExplosionSizeInt, cChunkDef::Height - 1,
+		MinZ - ExplosionSizeInt, MinZ + BENCH_TNT_SIZE + ExplosionSizeInt
+	))
+	{
+		a_Output.Out("Cannot read the area around the TNT cube from the world");
+		return;
+	}
+
+	// Build the TNT cube:
+	cBlockArea TNT;
+	TNT.Create(BENCH_TNT_SIZE, BENCH_TNT_SIZE, BENCH_TNT_SIZE);
+	TNT.Fill(cBlockArea::baTypes | cBlockArea::baMetas, E_BLOCK_TNT, 0);
+	if (!TNT.Write(&a_World, MinX, MinY, MinZ))
+	{
+		a_Output.Out("Cannot write the TNT cube into the world");
+		return;
+	}
+
+	// Detonate every block of the cube, as if the whole cube went off within a single tick:
+	cChunkMap * ChunkMap = a_World.GetChunkMap();
+	cVector3iArray BlocksAffected;
+	size_t NumBlocksAffected = 0;
+	int NumExplosions = 0;
+	auto Start = std::chrono::steady_clock::now();
+	for (int y = 0; y < BENCH_TNT_SIZE; y++)
+	{
+		for (int z = 0; z < BENCH_TNT_SIZE; z++)
+		{
+			for (int x = 0; x < BENCH_TNT_SIZE; x++)
+			{
+				BlocksAffected.clear();
+				ChunkMap->DoExplosionAt(BENCH_TNT_EXPLOSION_SIZE, MinX + x + 0.5, MinY + y + 0.5, MinZ + z + 0.5, BlocksAffected);
+				NumBlocksAffected += BlocksAffected.size();
+				NumExplosions += 1;
+			}
+		}
+	}
+	double ExplodeTime = SecondsSince(Start);
+
+	// Write all the changes into the chunks:
+	Start = std::chrono::steady_clock::now();
+	ChunkMap->FlushExplosions();
+	double FlushTime = SecondsSince(Start);
+
+	// The entities spawned by the explosions are only added to the world in the next tick, clean up after that:
+	cBoundingBox SpawnBox(
+		MinX - ExplosionSizeInt, MinX + BENCH_TNT_SIZE + ExplosionSizeInt + 1,
+		MinY - ExplosionSizeInt, cChunkDef::Height + 8,  // Shrapnel is flung up to 5 blocks above the exploded block
+		MinZ - ExplosionSizeInt, MinZ + BENCH_TNT_SIZE + ExplosionSizeInt + 1
+	);
+	a_World.ScheduleTask(1, new cExplosionBenchmarkCleanup(Saved, SpawnBox));
+
+	a_Output.Out("Explosion of a %d x %d x %d TNT cube in world %s:", BENCH_TNT_SIZE, BENCH_TNT_SIZE, BENCH_TNT_SIZE, a_World.GetName().c_str());
+	a_Output.Out("  %d explosions, %u blocks affected", NumExplosions, (unsigned)NumBlocksAffected);
+	a_Output.Out("  Explosions: %.3f sec, %.1f usec per explosion", ExplodeTime, ExplodeTime * 1e6 / NumExplosions);
+	a_Output.Out("  Writing the changes into the chunks: %.3f sec", FlushTime);
+	a_Output.Out("  Total: %.3f sec", ExplodeTime + FlushTime);
+}
+
+
+
+
+
+/** Generates the chunks of the generator benchmark's area, taking the chunk indices from a_NextChunk until all are done. */
+static void GenerateBenchmarkChunks(cChunkGenerator::cGenerator * a_Generator, std::atomic<int> * a_NextChunk)
+{
+	const int NumChunks = BENCH_GEN_AREA_CHUNKS * BENCH_GEN_AREA_CHUNKS;
+	for (int Idx = (*a_NextChunk)++; Idx < NumChunks; Idx = (*a_NextChunk)++)
+	{
+		// Neighboring threads work on neighboring chunks, so that they share the cached data:
+		int ChunkX = BENCH_GEN_AREA_START + Idx % BENCH_GEN_AREA_CHUNKS;
+		int ChunkZ = BENCH_GEN_AREA_START + Idx / BENCH_GEN_AREA_CHUNKS;
+		cChunkDesc Desc(ChunkX, ChunkZ);
+		a_Generator->DoGenerate(ChunkX, ChunkZ, Desc);
+	}
+}
+
+
+
+
+
+void cBenchmarks::Generator(cWorld & a_World, cCommandOutputCallback & a_Output)
+{
+	cIniFile IniFile;
+	if (!IniFile.ReadFile(a_World.GetIniFileName()))
+	{
+		a_Output.Out("Cannot read the world's settings from %s", a_World.GetIniFileName().c_str());
+		return;
+	}
+
+	// Create one generator instance per thread:
+	unsigned NumThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<std::unique_ptr<cChunkGenerator::cGenerator>> Generators;
+	for (unsigned i = 0; i < NumThreads; i++)
+	{
+		std::unique_ptr<cChunkGenerator::cGenerator> Generator = a_World.GetGenerator().CreateGeneratorInstance(IniFile);
+		if (Generator == nullptr)
+		{
+			a_Output.Out("The generator of world %s doesn't support multiple instances, cannot benchmark", a_World.GetName().c_str());
+			return;
+		}
+		Generators.push_back(std::move(Generator));
+	}
+
+	// Generate the area:
+	std::atomic<int> NextChunk(0);
+	std::vector<std::thread> Threads;
+	auto Start = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < NumThreads; i++)
+	{
+		Threads.push_back(std::thread(GenerateBenchmarkChunks, Generators[i].get(), &NextChunk));
+	}
+	for (std::vector<std::thread>::iterator itr = Threads.begin(), end = Threads.end(); itr != end; ++itr)
+	{
+		itr->join();
+	}
+	double GenTime = SecondsSince(Start);
+
+	const int NumChunks = BENCH_GEN_AREA_CHUNKS * BENCH_GEN_AREA_CHUNKS;
+	a_Output.Out("Generating a %d x %d chunk area with the settings of world %s:", BENCH_GEN_AREA_CHUNKS, BENCH_GEN_AREA_CHUNKS, a_World.GetName().c_str());
+	a_Output.Out("  %u threads, %.3f sec, %.1f chunks per second, %.2f msec per chunk per thread",
+		NumThreads, GenTime, NumChunks / GenTime, GenTime * 1000 * NumThreads / NumChunks
+	);
+	a_World.GetGenerator().LogCacheStats(a_Output);
+}
+
+
+
+
+
+/** Moves one item from a_Src into a_Dst, using the same rules as cHopperEntity::MoveItemsToGrid(), without the plugin hooks.
+Returns true if an item was moved. */
+static bool MoveHopperItem(cItemGrid & a_Src, cItemGrid & a_Dst)
+{
+	int NumDstSlots = a_Dst.GetNumSlots();
+	int NumSrcSlots = a_Src.GetNumSlots();
+	for (int DstSlot = 0; DstSlot < NumDstSlots; DstSlot++)
+	{
+		if (a_Dst.IsSlotEmpty(DstSlot))
+		{
+			// Move one item from the first non-empty slot:
+			for (int SrcSlot = 0; SrcSlot < NumSrcSlots; SrcSlot++)
+			{
+				if (!a_Src.IsSlotEmpty(SrcSlot))
+				{
+					a_Dst.SetSlot(DstSlot, a_Src.GetSlot(SrcSlot).CopyOne());
+					a_Src.ChangeSlotCount(SrcSlot, -1);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Top up the slot from a slot with the same item:
+		const cItem & Dst = a_Dst.GetSlot(DstSlot);
+		if (Dst.IsFullStack())
+		{
+			continue;
+		}
+		for (int SrcSlot = 0; SrcSlot < NumSrcSlots; SrcSlot++)
+		{
+			if (a_Src.GetSlot(SrcSlot).IsEqual(Dst))
+			{
+				a_Dst.ChangeSlotCount(DstSlot, 1);
+				a_Src.ChangeSlotCount(SrcSlot, -1);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+
+
+
+void cBenchmarks::HopperChain(cCommandOutputCallback & a_Output)
+{
+	// Fill the hoppers; most of the items are ordinary, some are named and some are enchanted, as in a typical sorting system:
+	std::vector<std::unique_ptr<cItemGrid>> Hoppers;
+	for (int i = 0; i < BENCH_HOPPER_CHAIN_LENGTH; i++)
+	{
+		Hoppers.push_back(make_unique<cItemGrid>(5, 1));
+		cItemGrid & Hopper = *Hoppers.back();
+		Hopper.SetSlot(0, cItem(E_BLOCK_COBBLESTONE, 32));
+		Hopper.SetSlot(1, cItem(E_ITEM_REDSTONE_DUST, 16));
+		if (i % 4 == 0)
+		{
+			Hopper.SetSlot(2, cItem(E_ITEM_DIAMOND, 8, 0, "", "Sorted diamond", "Lore`Second line"));
+		}
+		if (i % 8 == 0)
+		{
+			Hopper.SetSlot(3, cItem(E_ITEM_ENCHANTED_BOOK, 1, 0, "sharpness=3;unbreaking=2"));
+		}
+	}
+
+	// Move the items around the ring:
+	int NumMoves = 0;
+	auto Start = std::chrono::steady_clock::now();
+	for (int Round = 0; Round < BENCH_HOPPER_ROUNDS; Round++)
+	{
+		for (int i = 0; i < BENCH_HOPPER_CHAIN_LENGTH; i++)
+		{
+			if (MoveHopperItem(*Hoppers[i], *Hoppers[(i + 1) % BENCH_HOPPER_CHAIN_LENGTH]))
+			{
+				NumMoves++;
+			}
+		}
+	}
+	double MoveTime = SecondsSince(Start);
+
+	// Count the items with the out-of-line data at the end:
+	int NumItems = 0, NumExtended = 0;
+	for (std::vector<std::unique_ptr<cItemGrid>>::const_iterator itr = Hoppers.begin(), end = Hoppers.end(); itr != end; ++itr)
+	{
+		for (int Slot = 0; Slot < (*itr)->GetNumSlots(); Slot++)
+		{
+			const cItem & Item = (*itr)->GetSlot(Slot);
+			if (Item.IsEmpty())
+			{
+				continue;
+			}
+			NumItems++;
+			if (Item.HasExtendedData())
+			{
+				NumExtended++;
+			}
+		}
+	}
+
+	a_Output.Out("Hopper chain of %d hoppers, %d rounds (sizeof(cItem) = %u bytes):", BENCH_HOPPER_CHAIN_LENGTH, BENCH_HOPPER_ROUNDS, static_cast<unsigned>(sizeof(cItem)));
+	a_Output.Out("  %d item moves, %.3f sec, %.2f M moves / sec", NumMoves, MoveTime, NumMoves / std::max(MoveTime, 1e-9) / 1e6);
+	a_Output.Out("  %d non-empty slots at the end, %d of them with extended data", NumItems, NumExtended);
+}
+
+
+
+
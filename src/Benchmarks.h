@@ -0,0 +1,61 @@
+
+// Benchmarks.h
+
+// Declares the cBenchmarks class that implements the in-server benchmarks available through the "benchmark" console command
+
+
+
+
+
+#pragma once
+
+
+
+
+
+// fwd:
+class cWorld;
+class cCommandOutputCallback;
+
+
+
+
+
+/** Runs micro-benchmarks on the live data of a running world.
+The benchmarks are meant to measure the hot paths on real terrain, they are run from the console thread
+and report their results through the command output. The benchmarks that modify the world are run in the world's
+tick thread instead, the console thread waits for them to finish. */
+class cBenchmarks
+{
+public:
+	/** Runs the benchmark specified by the console command params: "benchmark <name> [world]".
+	Outputs the list of the available benchmarks if the name is missing or not recognized. */
+	static void Run(const AStringVector & a_Split, cCommandOutputCallback & a_Output);
+
+	/** Compares the per-block cWorld::GetBlock() lookups with lookups through a cChunkCursor,
+	on the chunks around the world spawn. */
+	static void BlockLookups(cWorld & a_World, cCommandOutputCallback & a_Output);
+
+	/** Runs ExplodeTNTCube() in the world's tick thread and outputs its results. */
+	static void Explosion(cWorld & a_World, cCommandOutputCallback & a_Output);
+
+	/** Builds a cube of TNT high above the world spawn and detonates each of its blocks within a single batch,
+	measuring the explosion engine and the final write of all the changes into the chunks.
+	Afterwards, the entities spawned by the explosions are removed and the original blocks of the area are restored.
+	Must be called from the world's tick thread, so that the world isn't modified while it is being ticked. */
+	static void ExplodeTNTCube(cWorld & a_World, cCommandOutputCallback & a_Output);
+
+	/** Generates a fixed area of chunks far away from the spawn using the world's generator settings,
+	with one generator instance per hardware thread, all sharing the world generator's caches.
+	The generated chunks are discarded, the world is not modified. */
+	static void Generator(cWorld & a_World, cCommandOutputCallback & a_Output);
+
+	/** Moves items around a ring of hoppers, one item per hopper per round, the same way cHopperEntity moves them
+	into another hopper. Measures the item copying and comparing that dominates large hopper-based sorting systems.
+	Runs on standalone item grids, the world is not modified. */
+	static void HopperChain(cCommandOutputCallback & a_Output);
+} ;
+
+
+
+
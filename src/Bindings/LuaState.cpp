@@ -18,6 +18,7 @@ extern "C"
 #include "DeprecatedBindings.h"
 #include "../Entities/Entity.h"
 #include "../BlockEntities/BlockEntity.h"
+#include "PluginManager.h"
 
 // fwd: SQLite/lsqlite3.c
 extern "C"
@@ -49,7 +50,14 @@ cLuaState::cLuaState(const AString & a_SubsystemName) :
 	m_LuaState(nullptr),
 	m_IsOwned(false),
 	m_SubsystemName(a_SubsystemName),
-	m_NumCurrentFunctionArgs(-1)
+	m_NumCurrentFunctionArgs(-1),
+	m_MemoryUsage(0),
+	m_PeakMemoryUsage(0),
+	m_NumAllocations(0),
+	m_IsManualGC(false),
+	m_IsGCInCycle(false),
+	m_GCBaseline(0),
+	m_GCStats()
 {
 }
 
@@ -61,7 +69,14 @@ cLuaState::cLuaState(lua_State * a_AttachState) :
 	m_LuaState(a_AttachState),
 	m_IsOwned(false),
 	m_SubsystemName("<attached>"),
-	m_NumCurrentFunctionArgs(-1)
+	m_NumCurrentFunctionArgs(-1),
+	m_MemoryUsage(0),
+	m_PeakMemoryUsage(0),
+	m_NumAllocations(0),
+	m_IsManualGC(false),
+	m_IsGCInCycle(false),
+	m_GCBaseline(0),
+	m_GCStats()
 {
 }
 
@@ -95,7 +110,13 @@ void cLuaState::Create(void)
 		LOGWARNING("%s: Trying to create an already-existing LuaState, ignoring.", __FUNCTION__);
 		return;
 	}
-	m_LuaState = lua_open();
+	m_LuaState = lua_newstate(Allocate, this);
+	if (m_LuaState == nullptr)
+	{
+		LOGWARNING("%s: Cannot create a new LuaState for %s, out of memory.", __FUNCTION__, m_SubsystemName.c_str());
+		return;
+	}
+	lua_atpanic(m_LuaState, ReportPanic);
 	luaL_openlibs(m_LuaState);
 	m_IsOwned = true;
 }
@@ -104,6 +125,49 @@ void cLuaState::Create(void)
 
 
 
+void * cLuaState::Allocate(void * a_UserData, void * a_Ptr, size_t a_OldSize, size_t a_NewSize)
+{
+	// Called by Lua only from the thread currently using the state, so there's a single writer and relaxed ordering is enough:
+	cLuaState * Self = reinterpret_cast<cLuaState *>(a_UserData);
+	if (a_NewSize == 0)
+	{
+		free(a_Ptr);
+		Self->m_MemoryUsage.fetch_sub(a_OldSize, std::memory_order_relaxed);
+		return nullptr;
+	}
+	void * res = realloc(a_Ptr, a_NewSize);
+	if (res == nullptr)
+	{
+		return nullptr;
+	}
+	if (a_Ptr == nullptr)
+	{
+		// Lua passes zero a_OldSize for new allocations
+		Self->m_NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+	size_t Usage = Self->m_MemoryUsage.load(std::memory_order_relaxed) + a_NewSize - a_OldSize;
+	Self->m_MemoryUsage.store(Usage, std::memory_order_relaxed);
+	if (Usage > Self->m_PeakMemoryUsage.load(std::memory_order_relaxed))
+	{
+		Self->m_PeakMemoryUsage.store(Usage, std::memory_order_relaxed);
+	}
+	return res;
+}
+
+
+
+
+
+int cLuaState::ReportPanic(lua_State * a_LuaState)
+{
+	LOGERROR("PANIC: unprotected error in call to Lua API (%s)", lua_tostring(a_LuaState, -1));
+	return 0;
+}
+
+
+
+
+
 void cLuaState::RegisterAPILibs(void)
 {
 	tolua_AllToLua_open(m_LuaState);
@@ -434,6 +498,32 @@ void cLuaState::Push(const cPlayer * a_Player)
 
 
 
+void cLuaState::Push(const cPlayerMoves & a_Moves)
+{
+	ASSERT(IsValid());
+
+	// Push an array of {Player = ..., OldPosition = ..., NewPosition = ...} tables:
+	lua_createtable(m_LuaState, static_cast<int>(a_Moves.size()), 0);
+	int newTable = lua_gettop(m_LuaState);
+	int index = 1;
+	for (cPlayerMoves::const_iterator itr = a_Moves.begin(), end = a_Moves.end(); itr != end; ++itr, ++index)
+	{
+		lua_createtable(m_LuaState, 0, 3);
+		tolua_pushusertype(m_LuaState, itr->m_Player, "cPlayer");
+		lua_setfield(m_LuaState, -2, "Player");
+		tolua_pushusertype(m_LuaState, (void *)&(itr->m_OldPosition), "Vector3<double>");
+		lua_setfield(m_LuaState, -2, "OldPosition");
+		tolua_pushusertype(m_LuaState, (void *)&(itr->m_NewPosition), "Vector3<double>");
+		lua_setfield(m_LuaState, -2, "NewPosition");
+		lua_rawseti(m_LuaState, newTable, index);
+	}
+	m_NumCurrentFunctionArgs += 1;
+}
+
+
+
+
+
 void cLuaState::Push(const HTTPRequest * a_Request)
 {
 	ASSERT(IsValid());
@@ -1503,6 +1593,91 @@ int cLuaState::ReportFnCallErrors(lua_State * a_LuaState)
 
 
 
+bool cLuaState::StepGC(std::chrono::microseconds a_Budget)
+{
+	ASSERT(IsValid());
+
+	if (!m_IsManualGC)
+	{
+		lua_gc(m_LuaState, LUA_GCSTOP, 0);
+		m_IsManualGC = true;
+		m_GCBaseline = GetMemoryUsage();
+	}
+
+	// Don't start a new cycle until the memory usage has doubled since the last one:
+	size_t Usage = GetMemoryUsage();
+	if (!m_IsGCInCycle && (Usage < 2 * m_GCBaseline))
+	{
+		return false;
+	}
+	m_IsGCInCycle = true;
+
+	auto Start = std::chrono::steady_clock::now();
+	auto Deadline = Start + a_Budget;
+	bool HasFinishedCycle = false;
+	bool IsOverBudget = false;
+	for (;;)
+	{
+		// A zero-sized step performs a single basic step of the incremental collector:
+		if (lua_gc(m_LuaState, LUA_GCSTEP, 0) != 0)
+		{
+			HasFinishedCycle = true;
+			break;
+		}
+		if (std::chrono::steady_clock::now() < Deadline)
+		{
+			continue;
+		}
+		if (GetMemoryUsage() < 4 * m_GCBaseline)
+		{
+			break;
+		}
+		// The collector is falling behind, keep collecting regardless of the budget
+		IsOverBudget = true;
+	}
+
+	// A step re-arms Lua's automatic collector, turn it back off:
+	lua_gc(m_LuaState, LUA_GCSTOP, 0);
+
+	if (HasFinishedCycle)
+	{
+		m_IsGCInCycle = false;
+		m_GCBaseline = GetMemoryUsage();
+		m_GCStats.m_NumCycles += 1;
+	}
+	UInt64 USec = static_cast<UInt64>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Start).count());
+	m_GCStats.m_NumSteps += 1;
+	m_GCStats.m_TotalUSec += USec;
+	m_GCStats.m_MaxStepUSec = std::max(m_GCStats.m_MaxStepUSec, USec);
+	if (IsOverBudget)
+	{
+		m_GCStats.m_NumOverBudget += 1;
+	}
+	return HasFinishedCycle;
+}
+
+
+
+
+
+void cLuaState::StopManualGC(void)
+{
+	ASSERT(IsValid());
+
+	if (!m_IsManualGC)
+	{
+		return;
+	}
+	lua_gc(m_LuaState, LUA_GCRESTART, 0);
+	m_IsManualGC = false;
+	m_IsGCInCycle = false;
+}
+
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cLuaState::cRef:
 
@@ -33,6 +33,8 @@ extern "C"
 #include "../Vector3.h"
 #include "../Defines.h"
 
+#include <atomic>
+
 
 
 
@@ -59,6 +61,8 @@ class cTNTEntity;
 class cHopperEntity;
 class cBlockEntity;
 class cBoundingBox;
+struct sPlayerMove;
+typedef std::vector<sPlayerMove> cPlayerMoves;
 
 typedef cBoundingBox * pBoundingBox;
 typedef cWorld *       pWorld;
@@ -186,6 +190,7 @@ public:
 	void Push(const char * a_Value);
 	void Push(const cItems & a_Items);
 	void Push(const cPlayer * a_Player);
+	void Push(const cPlayerMoves & a_Moves);
 	void Push(const HTTPRequest * a_Request);
 	void Push(const HTTPTemplateRequest * a_Request);
 	void Push(const Vector3d & a_Vector);
@@ -328,6 +333,48 @@ public:
 	/** Logs all the elements' types on the API stack, with an optional header for the listing. */
 	static void LogStack(lua_State * a_LuaState, const char * a_Header = nullptr);
 	
+	/** Returns the number of bytes currently allocated by the state.
+	Only tracked for the states made by Create(), attached states report zero. Can be called from any thread. */
+	size_t GetMemoryUsage(void) const { return m_MemoryUsage.load(std::memory_order_relaxed); }
+	
+	/** Returns the maximum number of bytes the state has ever had allocated. Can be called from any thread. */
+	size_t GetPeakMemoryUsage(void) const { return m_PeakMemoryUsage.load(std::memory_order_relaxed); }
+	
+	/** Returns the number of allocations the state has made so far (reallocations not counted). Can be called from any thread. */
+	UInt64 GetNumAllocations(void) const { return m_NumAllocations.load(std::memory_order_relaxed); }
+	
+	/** The statistics of the garbage collection driven by StepGC() */
+	struct sGCStats
+	{
+		/** Number of StepGC() calls that did any collecting */
+		UInt64 m_NumSteps;
+		
+		/** Number of finished collection cycles */
+		UInt64 m_NumCycles;
+		
+		/** Number of StepGC() calls that ran over the budget because the collector was falling behind the allocations */
+		UInt64 m_NumOverBudget;
+		
+		/** Total time spent collecting, in microseconds */
+		UInt64 m_TotalUSec;
+		
+		/** The longest single StepGC() call, in microseconds */
+		UInt64 m_MaxStepUSec;
+	} ;
+	
+	/** Runs incremental garbage collection steps until either a_Budget is used up or the collection cycle finishes.
+	The first call turns off Lua's automatic collector, from then on the state is only collected by calling this
+	function regularly (so that the collector doesn't kick in at random times inside the callbacks).
+	A new cycle is only started once the memory usage has doubled since the end of the previous one, the same
+	as Lua's default GC pause. If the memory usage gets to four times that size, the budget is ignored.
+	Returns true if a collection cycle has finished. */
+	bool StepGC(std::chrono::microseconds a_Budget);
+	
+	/** Turns Lua's automatic collector back on, if StepGC() has turned it off. */
+	void StopManualGC(void);
+	
+	const sGCStats & GetGCStats(void) const { return m_GCStats; }
+	
 protected:
 
 	lua_State * m_LuaState;
@@ -346,6 +393,33 @@ protected:
 	/** Number of arguments currently pushed (for the Push / Call chain) */
 	int m_NumCurrentFunctionArgs;
 
+	/** Number of bytes currently allocated by the state, updated by Allocate() */
+	std::atomic<size_t> m_MemoryUsage;
+	
+	/** The maximum value that m_MemoryUsage has reached */
+	std::atomic<size_t> m_PeakMemoryUsage;
+	
+	/** Number of allocations made by the state, updated by Allocate() */
+	std::atomic<UInt64> m_NumAllocations;
+	
+	/** Set once StepGC() has turned the automatic collector off */
+	bool m_IsManualGC;
+	
+	/** Set while StepGC() is in the middle of a collection cycle */
+	bool m_IsGCInCycle;
+	
+	/** The memory usage at the end of the last collection cycle run by StepGC() */
+	size_t m_GCBaseline;
+	
+	sGCStats m_GCStats;
+	
+	/** The allocator function used by the states made by Create(), keeps track of the memory usage.
+	a_UserData is the cLuaState object. */
+	static void * Allocate(void * a_UserData, void * a_Ptr, size_t a_OldSize, size_t a_NewSize);
+	
+	/** The panic function used by the states made by Create(), logs the error. */
+	static int ReportPanic(lua_State * a_LuaState);
+
 	/** Variadic template terminator: If there's nothing more to push / pop, just call the function.
 	Note that there are no return values either, because those are prefixed by a cRet value, so the arg list is never empty. */
 	bool PushCallPop(void)
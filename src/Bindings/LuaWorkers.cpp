@@ -0,0 +1,523 @@
+
+// LuaWorkers.cpp
+
+// Implements the cLuaWorkers class representing the worker threads that run the background jobs of a single Lua plugin
+
+#include "Globals.h"
+#include "LuaWorkers.h"
+#include <atomic>
+#include "PluginLua.h"
+#include "PluginManager.h"
+#include "tolua++/include/tolua++.h"
+#include "../World.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Globals:
+
+/** Logs the string param; registered as all the LOG functions in the worker states. */
+static int WorkerLog(lua_State * a_LuaState, cLogger::eLogLevel a_LogLevel)
+{
+	size_t Len = 0;
+	const char * Msg = lua_tolstring(a_LuaState, 1, &Len);
+	if (Msg != nullptr)
+	{
+		cLogger::GetInstance().LogSimple(AString(Msg, Len), a_LogLevel);
+	}
+	return 0;
+}
+
+static int WorkerLOG       (lua_State * a_LuaState) { return WorkerLog(a_LuaState, cLogger::llRegular); }
+static int WorkerLOGINFO   (lua_State * a_LuaState) { return WorkerLog(a_LuaState, cLogger::llInfo); }
+static int WorkerLOGWARNING(lua_State * a_LuaState) { return WorkerLog(a_LuaState, cLogger::llWarning); }
+static int WorkerLOGERROR  (lua_State * a_LuaState) { return WorkerLog(a_LuaState, cLogger::llError); }
+
+/** The ID to be assigned to the next cLuaWorkers instance. */
+static std::atomic<int> g_NextWorkersID(1);
+
+/** The number of Lua instructions between two checks whether the workers are being stopped. */
+static const int INTERRUPT_HOOK_INSTRUCTIONS = 1000;
+
+/** The address of this variable is the key of the worker thread's pointer in the worker state's registry. */
+static char g_WorkerThreadKey;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cLuaWorkerResultTask:
+
+/** The world task that delivers the result of a worker job into the plugin's callback. */
+class cLuaWorkerResultTask :
+	public cWorld::cTask
+{
+public:
+	cLuaWorkerResultTask(const AString & a_PluginFolder, int a_WorkersID, int a_CallbackRef, bool a_IsSuccess, const cLuaPlainValue & a_Result, const AString & a_ErrorMsg) :
+		m_PluginFolder(a_PluginFolder),
+		m_WorkersID(a_WorkersID),
+		m_CallbackRef(a_CallbackRef),
+		m_IsSuccess(a_IsSuccess),
+		m_Result(a_Result),
+		m_ErrorMsg(a_ErrorMsg)
+	{
+	}
+
+protected:
+	/** The folder of the plugin that queued the job; the plugin is looked up by it when the task runs,
+	because it may have been unloaded in the meantime. */
+	AString m_PluginFolder;
+
+	/** The ID of the cLuaWorkers instance that ran the job. */
+	int m_WorkersID;
+
+	int m_CallbackRef;
+	bool m_IsSuccess;
+	cLuaPlainValue m_Result;
+	AString m_ErrorMsg;
+
+
+	// cWorld::cTask overrides:
+	virtual void Run(cWorld & a_World) override
+	{
+		class cCallback :
+			public cPluginManager::cPluginCallback
+		{
+		public:
+			cCallback(cLuaWorkerResultTask & a_Task, cWorld & a_World) :
+				m_Task(a_Task),
+				m_World(a_World)
+			{
+			}
+
+		protected:
+			cLuaWorkerResultTask & m_Task;
+			cWorld & m_World;
+
+			virtual bool Item(cPlugin * a_Plugin) override
+			{
+				if (a_Plugin->GetLanguage() != cPlugin::E_LUA)
+				{
+					return false;
+				}
+				m_Task.CallCallback(*static_cast<cPluginLua *>(a_Plugin), m_World);
+				return true;
+			}
+		} Callback(*this, a_World);
+		cPluginManager::Get()->DoWithPlugin(m_PluginFolder, Callback);
+	}
+
+
+	/** Calls the callback in the plugin's state: Callback(World, Result) or Callback(World, nil, ErrorMsg). */
+	void CallCallback(cPluginLua & a_Plugin, cWorld & a_World)
+	{
+		cPluginLua::cOperation Op(a_Plugin);
+		if (!a_Plugin.HasWorkers(m_WorkersID))
+		{
+			// The plugin has been reloaded in the meantime, the callback reference was released with the old Lua state
+			return;
+		}
+		cLuaState & L = Op();
+
+		lua_rawgeti(L, LUA_REGISTRYINDEX, m_CallbackRef);
+		tolua_pushusertype(L, &a_World, "cWorld");
+		if (m_IsSuccess)
+		{
+			m_Result.Push(L);
+			L.ReportErrors(lua_pcall(L, 2, 0, 0));
+		}
+		else
+		{
+			lua_pushnil(L);
+			lua_pushlstring(L, m_ErrorMsg.data(), m_ErrorMsg.size());
+			L.ReportErrors(lua_pcall(L, 3, 0, 0));
+		}
+		luaL_unref(L, LUA_REGISTRYINDEX, m_CallbackRef);
+	}
+} ;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cLuaPlainValue:
+
+cLuaPlainValue::cLuaPlainValue(void) :
+	m_Type(LUA_TNIL),
+	m_Bool(false),
+	m_Number(0)
+{
+}
+
+
+
+
+
+bool cLuaPlainValue::Read(lua_State * a_LuaState, int a_StackPos, AString & a_ErrorMsg)
+{
+	return ReadValue(a_LuaState, a_StackPos, 0, a_ErrorMsg);
+}
+
+
+
+
+
+bool cLuaPlainValue::ReadValue(lua_State * a_LuaState, int a_StackPos, int a_Depth, AString & a_ErrorMsg)
+{
+	// Convert to an absolute stack position, the table traversal below pushes values onto the stack:
+	if (a_StackPos < 0)
+	{
+		a_StackPos = lua_gettop(a_LuaState) + a_StackPos + 1;
+	}
+
+	m_Type = lua_type(a_LuaState, a_StackPos);
+	switch (m_Type)
+	{
+		case LUA_TNIL:
+		{
+			return true;
+		}
+		case LUA_TBOOLEAN:
+		{
+			m_Bool = (lua_toboolean(a_LuaState, a_StackPos) != 0);
+			return true;
+		}
+		case LUA_TNUMBER:
+		{
+			m_Number = lua_tonumber(a_LuaState, a_StackPos);
+			return true;
+		}
+		case LUA_TSTRING:
+		{
+			size_t Len = 0;
+			const char * Str = lua_tolstring(a_LuaState, a_StackPos, &Len);
+			m_String.assign(Str, Len);
+			return true;
+		}
+		case LUA_TTABLE:
+		{
+			if (a_Depth >= MAX_DEPTH)
+			{
+				Printf(a_ErrorMsg, "the tables are nested too deep (more than %d levels), or a table contains itself", MAX_DEPTH);
+				return false;
+			}
+			lua_pushnil(a_LuaState);
+			while (lua_next(a_LuaState, a_StackPos) != 0)
+			{
+				// Stack: ... <key> <value>
+				m_TableKeys.push_back(cLuaPlainValue());
+				m_TableValues.push_back(cLuaPlainValue());
+				if (
+					!m_TableKeys.back().ReadValue(a_LuaState, -2, a_Depth + 1, a_ErrorMsg) ||
+					!m_TableValues.back().ReadValue(a_LuaState, -1, a_Depth + 1, a_ErrorMsg)
+				)
+				{
+					lua_pop(a_LuaState, 2);
+					return false;
+				}
+				lua_pop(a_LuaState, 1);
+			}
+			return true;
+		}
+	}
+	Printf(a_ErrorMsg, "a %s value cannot be passed between Lua states", lua_typename(a_LuaState, m_Type));
+	return false;
+}
+
+
+
+
+
+void cLuaPlainValue::Push(lua_State * a_LuaState) const
+{
+	switch (m_Type)
+	{
+		case LUA_TBOOLEAN: lua_pushboolean(a_LuaState, m_Bool ? 1 : 0); return;
+		case LUA_TNUMBER:  lua_pushnumber (a_LuaState, m_Number); return;
+		case LUA_TSTRING:  lua_pushlstring(a_LuaState, m_String.data(), m_String.size()); return;
+		case LUA_TTABLE:
+		{
+			lua_createtable(a_LuaState, 0, static_cast<int>(m_TableKeys.size()));
+			for (size_t i = 0; i < m_TableKeys.size(); i++)
+			{
+				m_TableKeys[i].Push(a_LuaState);
+				m_TableValues[i].Push(a_LuaState);
+				lua_rawset(a_LuaState, -3);
+			}
+			return;
+		}
+	}
+	lua_pushnil(a_LuaState);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cLuaWorkers:
+
+cLuaWorkers::cLuaWorkers(cPluginLua & a_Plugin, int a_NumThreads) :
+	m_Plugin(a_Plugin),
+	m_ID(g_NextWorkersID++),
+	m_NumThreads(std::max(a_NumThreads, 1)),
+	m_ShouldTerminate(false)
+{
+}
+
+
+
+
+
+cLuaWorkers::~cLuaWorkers()
+{
+	cWorkerThreads Threads;
+	{
+		cCSLock Lock(m_CS);
+		m_ShouldTerminate = true;
+		std::swap(Threads, m_Threads);
+		if (!m_Jobs.empty())
+		{
+			LOGINFO("Plugin %s: dropping %u unfinished worker jobs.", m_Plugin.GetName().c_str(), static_cast<unsigned>(m_Jobs.size()));
+		}
+	}
+
+	// Wake up the idle threads; each terminating thread wakes up the next one:
+	m_evtJobAdded.Set();
+	for (cWorkerThreads::iterator itr = Threads.begin(), end = Threads.end(); itr != end; ++itr)
+	{
+		(*itr)->Stop();
+	}
+
+	// Release the callbacks of the dropped jobs, including those finished while terminating:
+	cJobs Jobs;
+	{
+		cCSLock Lock(m_CS);
+		std::swap(Jobs, m_Jobs);
+	}
+	for (cJobs::const_iterator itr = Jobs.begin(), end = Jobs.end(); itr != end; ++itr)
+	{
+		m_Plugin.Unreference(itr->m_CallbackRef);
+	}
+}
+
+
+
+
+
+void cLuaWorkers::QueueJob(cWorld & a_World, const AString & a_FileName, const AString & a_FunctionName, const cLuaPlainValue & a_Params, int a_CallbackRef)
+{
+	sJob Job;
+	Job.m_World = &a_World;
+	Job.m_FileName = a_FileName;
+	Job.m_FunctionName = a_FunctionName;
+	Job.m_Params = a_Params;
+	Job.m_CallbackRef = a_CallbackRef;
+	{
+		cCSLock Lock(m_CS);
+		m_Jobs.push_back(Job);
+
+		// Start the threads on the first job:
+		if (m_Threads.empty())
+		{
+			for (int i = 0; i < m_NumThreads; i++)
+			{
+				m_Threads.push_back(make_unique<cWorkerThread>(*this, i));
+				m_Threads.back()->Start();
+			}
+		}
+	}
+	m_evtJobAdded.Set();
+}
+
+
+
+
+
+size_t cLuaWorkers::GetQueueLength(void)
+{
+	cCSLock Lock(m_CS);
+	return m_Jobs.size();
+}
+
+
+
+
+
+bool cLuaWorkers::GetNextJob(sJob & a_Job)
+{
+	for (;;)
+	{
+		{
+			cCSLock Lock(m_CS);
+			if (m_ShouldTerminate)
+			{
+				// Pass the wakeup on to the next terminating thread:
+				m_evtJobAdded.Set();
+				return false;
+			}
+			if (!m_Jobs.empty())
+			{
+				a_Job = m_Jobs.front();
+				m_Jobs.pop_front();
+				if (!m_Jobs.empty())
+				{
+					// The event releases only a single thread, let the next one pick up the rest of the jobs:
+					m_evtJobAdded.Set();
+				}
+				return true;
+			}
+		}
+		m_evtJobAdded.Wait();
+	}
+}
+
+
+
+
+
+void cLuaWorkers::DeliverResult(const sJob & a_Job, bool a_IsSuccess, const cLuaPlainValue & a_Result, const AString & a_ErrorMsg)
+{
+	{
+		cCSLock Lock(m_CS);
+		if (m_ShouldTerminate)
+		{
+			// The destructor releases the callback:
+			m_Jobs.push_back(a_Job);
+			return;
+		}
+	}
+	a_Job.m_World->QueueTask(make_unique<cLuaWorkerResultTask>(m_Plugin.GetDirectory(), m_ID, a_Job.m_CallbackRef, a_IsSuccess, a_Result, a_ErrorMsg));
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cLuaWorkers::cWorkerThread:
+
+cLuaWorkers::cWorkerThread::cWorkerThread(cLuaWorkers & a_Parent, int a_Index) :
+	super(Printf("Lua worker #%d of plugin %s", a_Index, a_Parent.m_Plugin.GetName().c_str())),
+	m_Parent(a_Parent),
+	m_LuaState(Printf("worker #%d of plugin %s", a_Index, a_Parent.m_Plugin.GetName().c_str()))
+{
+}
+
+
+
+
+
+cLuaWorkers::cWorkerThread::~cWorkerThread()
+{
+	Stop();
+}
+
+
+
+
+
+void cLuaWorkers::cWorkerThread::Execute(void)
+{
+	CreateLuaState();
+	sJob Job;
+	while (!m_ShouldTerminate && m_Parent.GetNextJob(Job))
+	{
+		cLuaPlainValue Result;
+		AString ErrorMsg;
+		bool IsSuccess = RunJob(Job, Result, ErrorMsg);
+		m_Parent.DeliverResult(Job, IsSuccess, Result, ErrorMsg);
+	}
+	m_LuaState.Close();
+}
+
+
+
+
+
+void cLuaWorkers::cWorkerThread::CreateLuaState(void)
+{
+	m_LuaState.Create();
+	AString PluginFolder = FILE_IO_PREFIX + m_Parent.m_Plugin.GetLocalFolder();
+	m_LuaState.AddPackagePath("path", PluginFolder + "/?.lua");
+
+	// The worker states don't have the API, only the logging functions:
+	lua_register(m_LuaState, "LOG",        WorkerLOG);
+	lua_register(m_LuaState, "LOGINFO",    WorkerLOGINFO);
+	lua_register(m_LuaState, "LOGWARN",    WorkerLOGWARNING);
+	lua_register(m_LuaState, "LOGWARNING", WorkerLOGWARNING);
+	lua_register(m_LuaState, "LOGERROR",   WorkerLOGERROR);
+
+	// Check periodically whether the workers are being stopped, so that a long-running job doesn't block the plugin unload:
+	lua_pushlightuserdata(m_LuaState, &g_WorkerThreadKey);
+	lua_pushlightuserdata(m_LuaState, this);
+	lua_rawset(m_LuaState, LUA_REGISTRYINDEX);
+	lua_sethook(m_LuaState, OnInterruptHook, LUA_MASKCOUNT, INTERRUPT_HOOK_INSTRUCTIONS);
+}
+
+
+
+
+
+void cLuaWorkers::cWorkerThread::OnInterruptHook(lua_State * a_LuaState, lua_Debug * a_Debug)
+{
+	UNUSED(a_Debug);
+	lua_pushlightuserdata(a_LuaState, &g_WorkerThreadKey);
+	lua_rawget(a_LuaState, LUA_REGISTRYINDEX);
+	cWorkerThread * Self = reinterpret_cast<cWorkerThread *>(lua_touserdata(a_LuaState, -1));
+	lua_pop(a_LuaState, 1);
+	if ((Self != nullptr) && (Self->m_ShouldTerminate || Self->m_Parent.m_ShouldTerminate))
+	{
+		// The error is raised again on each check, so a job catching it with pcall() cannot keep running:
+		luaL_error(a_LuaState, "The plugin's workers are being stopped, the job has been interrupted");
+	}
+}
+
+
+
+
+
+bool cLuaWorkers::cWorkerThread::RunJob(const sJob & a_Job, cLuaPlainValue & a_Result, AString & a_ErrorMsg)
+{
+	// Load the file, if not loaded yet:
+	if (m_LoadedFiles.find(a_Job.m_FileName) == m_LoadedFiles.end())
+	{
+		if (!m_LuaState.LoadFile(FILE_IO_PREFIX + m_Parent.m_Plugin.GetLocalFolder() + "/" + a_Job.m_FileName))
+		{
+			Printf(a_ErrorMsg, "Cannot load file \"%s\"", a_Job.m_FileName.c_str());
+			return false;
+		}
+		m_LoadedFiles.insert(a_Job.m_FileName);
+	}
+
+	// Call the function:
+	lua_getglobal(m_LuaState, a_Job.m_FunctionName.c_str());
+	if (!lua_isfunction(m_LuaState, -1))
+	{
+		lua_pop(m_LuaState, 1);
+		Printf(a_ErrorMsg, "Function \"%s\" not found in file \"%s\"", a_Job.m_FunctionName.c_str(), a_Job.m_FileName.c_str());
+		return false;
+	}
+	a_Job.m_Params.Push(m_LuaState);
+	if (lua_pcall(m_LuaState, 1, 1, 0) != 0)
+	{
+		size_t Len = 0;
+		const char * Msg = lua_tolstring(m_LuaState, -1, &Len);
+		a_ErrorMsg = (Msg != nullptr) ? AString(Msg, Len) : AString("(no error message)");
+		lua_pop(m_LuaState, 1);
+		return false;
+	}
+
+	// Copy the result out of the worker state:
+	bool res = a_Result.Read(m_LuaState, -1, a_ErrorMsg);
+	lua_pop(m_LuaState, 1);
+	return res;
+}
+
+
+
+
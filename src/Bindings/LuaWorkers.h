@@ -0,0 +1,183 @@
+
+// LuaWorkers.h
+
+// Declares the cLuaWorkers class representing the worker threads that run the background jobs of a single Lua plugin
+
+/*
+Each worker thread has its own isolated Lua state, with the standard Lua libraries and the LOG functions, but
+without the MCServer API, because the API objects can only be accessed safely from the plugin's own state.
+A plugin queues a job using cWorld:QueueWorkerJob(FileName, FunctionName, Params, Callback). The worker loads the
+file (from the plugin's folder, once per worker state) and calls the function with a copy of Params. The value that
+the function returns is copied back and the Callback is called with it in the plugin's own state, from the world's
+tick thread, via cWorld::QueueTask(). The task looks the plugin up by its folder when it runs and drops the result
+if the plugin has been unloaded or reloaded (its workers replaced) in the meantime.
+Only plain values can be passed between the states: nil, booleans, numbers, strings and tables of these. The values
+are copied through cLuaPlainValue, the states never share anything.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../OSSupport/IsThread.h"
+#include "LuaState.h"
+
+
+
+
+
+// fwd:
+class cPluginLua;
+class cWorld;
+
+
+
+
+
+/** A deep copy of a plain Lua value (nil, boolean, number, string, or a table of these),
+used for passing the values between two independent Lua states. */
+class cLuaPlainValue
+{
+public:
+	cLuaPlainValue(void);
+
+	/** Reads the value at the specified stack position into this object.
+	Returns false and fills a_ErrorMsg if the value (or any value nested in it) is not a plain value. */
+	bool Read(lua_State * a_LuaState, int a_StackPos, AString & a_ErrorMsg);
+
+	/** Pushes a copy of the value onto the stack of the specified Lua state. */
+	void Push(lua_State * a_LuaState) const;
+
+protected:
+	/** The maximum nesting of the tables; also prevents endless recursion on tables that contain themselves. */
+	static const int MAX_DEPTH = 32;
+
+	/** The Lua type of the value: LUA_TNIL, LUA_TBOOLEAN, LUA_TNUMBER, LUA_TSTRING or LUA_TTABLE */
+	int m_Type;
+
+	bool m_Bool;
+	double m_Number;
+	AString m_String;
+
+	/** The keys and values of a table value, m_TableValues[i] belongs to m_TableKeys[i]. */
+	std::vector<cLuaPlainValue> m_TableKeys;
+	std::vector<cLuaPlainValue> m_TableValues;
+
+
+	/** Implements Read(), keeping track of the nesting depth. */
+	bool ReadValue(lua_State * a_LuaState, int a_StackPos, int a_Depth, AString & a_ErrorMsg);
+} ;
+
+
+
+
+
+class cLuaWorkers
+{
+public:
+	/** Creates the workers for the specified plugin. The threads are started only when the first job is queued. */
+	cLuaWorkers(cPluginLua & a_Plugin, int a_NumThreads);
+
+	/** Stops all the threads, the jobs that haven't started yet are dropped and their callbacks unreferenced.
+	The running jobs are interrupted by an error raised from the worker state's instruction count hook; a job blocked
+	inside a C function (such as a file read) is only interrupted once the function returns.
+	Must be called before the plugin's Lua state is closed. */
+	~cLuaWorkers();
+
+	/** Queues a job: a_FunctionName from the file a_FileName (relative to the plugin folder) is called in a worker
+	state with the a_Params value. The callback, referenced by a_CallbackRef in the plugin's state, is then called
+	in the world's tick thread with the world and the function's result (or nil and the error message). */
+	void QueueJob(cWorld & a_World, const AString & a_FileName, const AString & a_FunctionName, const cLuaPlainValue & a_Params, int a_CallbackRef);
+
+	/** Returns the number of jobs that haven't been started yet. */
+	size_t GetQueueLength(void);
+
+	/** Returns the ID unique to this instance, identifying the workers in the queued result tasks. */
+	int GetID(void) const { return m_ID; }
+
+protected:
+	struct sJob
+	{
+		cWorld * m_World;
+		AString m_FileName;
+		AString m_FunctionName;
+		cLuaPlainValue m_Params;
+		int m_CallbackRef;
+	} ;
+
+	typedef std::list<sJob> cJobs;
+
+
+	class cWorkerThread :
+		public cIsThread
+	{
+		typedef cIsThread super;
+
+	public:
+		cWorkerThread(cLuaWorkers & a_Parent, int a_Index);
+
+		virtual ~cWorkerThread();
+
+	protected:
+		cLuaWorkers & m_Parent;
+
+		/** The worker's own Lua state, created in the worker thread. */
+		cLuaState m_LuaState;
+
+		/** The files already loaded into m_LuaState. */
+		std::set<AString> m_LoadedFiles;
+
+
+		// cIsThread overrides:
+		virtual void Execute(void) override;
+
+		/** Runs the job in m_LuaState. Returns true and fills a_Result if successful, false and a_ErrorMsg otherwise. */
+		bool RunJob(const sJob & a_Job, cLuaPlainValue & a_Result, AString & a_ErrorMsg);
+
+		/** Creates the worker's Lua state and installs OnInterruptHook() into it. */
+		void CreateLuaState(void);
+
+		/** The instruction count hook of the worker state; raises a Lua error if the workers are being stopped. */
+		static void OnInterruptHook(lua_State * a_LuaState, lua_Debug * a_Debug);
+	} ;
+
+	typedef std::vector<std::unique_ptr<cWorkerThread>> cWorkerThreads;
+
+
+	cPluginLua & m_Plugin;
+
+	/** The ID unique to this instance, see GetID(). */
+	int m_ID;
+
+	int m_NumThreads;
+
+	/** Protects m_Jobs and m_Threads */
+	cCriticalSection m_CS;
+
+	/** The jobs waiting for a worker. After termination, also the finished jobs whose results cannot be delivered. */
+	cJobs m_Jobs;
+
+	/** Set when a job is added to m_Jobs, or when the threads are terminating */
+	cEvent m_evtJobAdded;
+
+	/** The worker threads. Empty until the first job is queued. */
+	cWorkerThreads m_Threads;
+
+	/** Set in the destructor, the worker threads stop picking up new jobs. */
+	volatile bool m_ShouldTerminate;
+
+
+	/** Takes the next job out of the queue. Blocks until there's a job available.
+	Returns false if the worker should terminate instead. */
+	bool GetNextJob(sJob & a_Job);
+
+	/** Queues the task that calls the job's callback in the plugin's state.
+	If the workers are terminating, the job is put back to m_Jobs instead, so that the destructor releases its callback. */
+	void DeliverResult(const sJob & a_Job, bool a_IsSuccess, const cLuaPlainValue & a_Result, const AString & a_ErrorMsg);
+} ;
+
+
+
+
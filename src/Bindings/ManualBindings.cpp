@@ -9,12 +9,14 @@
 #include "PluginManager.h"
 #include "LuaWindow.h"
 #include "LuaChunkStay.h"
+#include "LuaWorkers.h"
 #include "../Root.h"
 #include "../World.h"
 #include "../Entities/Player.h"
 #include "../WebAdmin.h"
 #include "../ClientHandle.h"
 #include "../BlockArea.h"
+#include "../ChunkCursor.h"
 #include "../BlockEntities/BeaconEntity.h"
 #include "../BlockEntities/ChestEntity.h"
 #include "../BlockEntities/CommandBlockEntity.h"
@@ -948,6 +950,128 @@ tolua_lerror:
 
 
 
+static int tolua_cWorld_DoWithChunkCursor(lua_State * tolua_S)
+{
+	/* Function signature:
+	World:DoWithChunkCursor(Callback) -> [CallbackReturnValue]
+	Callback signature: function(cChunkCursor)
+	The cursor object is valid only inside the callback. The chunkmap is locked only for each lookup, not for the whole
+	callback, so that the callback can call any other API function without deadlocking against the other threads.
+	*/
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserType(1, "cWorld") ||
+		!L.CheckParamFunction(2) ||
+		!L.CheckParamEnd     (3)
+	)
+	{
+		return 0;
+	}
+	cWorld * World = (cWorld *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (World == nullptr)
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': Not called on an object instance");
+	}
+
+	// Call the callback with a cursor over the world's chunkmap:
+	cChunkCursor Cursor(*World, false);
+	lua_pushvalue(tolua_S, 2);
+	tolua_pushusertype(tolua_S, &Cursor, "cChunkCursor");
+	int s = lua_pcall(tolua_S, 1, 1, 0);
+	if (cLuaState::ReportErrors(tolua_S, s))
+	{
+		return 0;
+	}
+
+	// Return whatever the callback returned:
+	return 1;
+}
+
+
+
+
+
+static int tolua_cChunkCursor_GetBlockTypeMeta(lua_State * tolua_S)
+{
+	// Exported manually, because tolua would generate useless additional parameters (a_BlockType, a_BlockMeta)
+	// Function signature: GetBlockTypeMeta(BlockX, BlockY, BlockZ) -> BlockValid, [BlockType, BlockMeta]
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserType(1, "cChunkCursor") ||
+		!L.CheckParamNumber  (2, 4) ||
+		!L.CheckParamEnd     (5)
+	)
+	{
+		return 0;
+	}
+	cChunkCursor * self = (cChunkCursor *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': Not called on an object instance");
+	}
+	int BlockX = 0, BlockY = 0, BlockZ = 0;
+	L.GetStackValues(2, BlockX, BlockY, BlockZ);
+
+	BLOCKTYPE BlockType;
+	NIBBLETYPE BlockMeta;
+	if (!self->GetBlockTypeMeta(BlockX, BlockY, BlockZ, BlockType, BlockMeta))
+	{
+		L.Push(false);
+		return 1;
+	}
+	L.Push(true);
+	L.Push((int)BlockType);
+	L.Push((int)BlockMeta);
+	return 3;
+}
+
+
+
+
+
+static int tolua_cChunkCursor_GetBlockInfo(lua_State * tolua_S)
+{
+	// Exported manually, because tolua would generate useless additional parameters (a_BlockType .. a_BlockSkyLight)
+	// Function signature: GetBlockInfo(BlockX, BlockY, BlockZ) -> BlockValid, [BlockType, BlockMeta, BlockSkyLight, BlockBlockLight]
+
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserType(1, "cChunkCursor") ||
+		!L.CheckParamNumber  (2, 4) ||
+		!L.CheckParamEnd     (5)
+	)
+	{
+		return 0;
+	}
+	cChunkCursor * self = (cChunkCursor *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': Not called on an object instance");
+	}
+	int BlockX = 0, BlockY = 0, BlockZ = 0;
+	L.GetStackValues(2, BlockX, BlockY, BlockZ);
+
+	BLOCKTYPE BlockType;
+	NIBBLETYPE BlockMeta, BlockSkyLight, BlockBlockLight;
+	if (!self->GetBlockInfo(BlockX, BlockY, BlockZ, BlockType, BlockMeta, BlockSkyLight, BlockBlockLight))
+	{
+		L.Push(false);
+		return 1;
+	}
+	L.Push(true);
+	L.Push((int)BlockType);
+	L.Push((int)BlockMeta);
+	L.Push((int)BlockSkyLight);
+	L.Push((int)BlockBlockLight);
+	return 5;
+}
+
+
+
+
+
 static int tolua_cWorld_GetSignLines(lua_State * tolua_S)
 {
 	// Exported manually, because tolua would generate useless additional parameters (a_Line1 .. a_Line4)
@@ -1239,6 +1363,65 @@ static int tolua_cWorld_ScheduleTask(lua_State * tolua_S)
 
 
 
+static int tolua_cWorld_QueueWorkerJob(lua_State * tolua_S)
+{
+	// Binding for cWorld:QueueWorkerJob
+	// Params: FileName, FunctionName, Params, Callback
+
+	// Retrieve the cPlugin from the LuaState:
+	cPluginLua * Plugin = GetLuaPlugin(tolua_S);
+	if (Plugin == nullptr)
+	{
+		// An error message has been already printed in GetLuaPlugin()
+		return 0;
+	}
+
+	// Retrieve the args:
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserType(1, "cWorld") ||
+		!L.CheckParamString  (2, 3) ||
+		!L.CheckParamFunction(5) ||
+		!L.CheckParamEnd     (6)
+	)
+	{
+		return 0;
+	}
+	cWorld * World = (cWorld *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (World == nullptr)
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': Not called on an object instance");
+	}
+	AString FileName, FunctionName;
+	L.GetStackValues(2, FileName, FunctionName);
+	if (FileName.find("..") != AString::npos)
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': The file must be inside the plugin folder");
+	}
+
+	// Copy the params, only plain values can be passed to the worker state:
+	cLuaPlainValue Params;
+	AString ErrorMsg;
+	if (!Params.Read(tolua_S, 4, ErrorMsg))
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': Invalid parameter #3: %s", ErrorMsg.c_str());
+	}
+
+	// Create a reference to the callback, it is on top of the stack:
+	int FnRef = luaL_ref(tolua_S, LUA_REGISTRYINDEX);
+	if (FnRef == LUA_REFNIL)
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': Could not get function reference of parameter #4");
+	}
+
+	Plugin->GetWorkers().QueueJob(*World, FileName, FunctionName, Params, FnRef);
+	return 0;
+}
+
+
+
+
+
 static int tolua_cPluginManager_GetAllPlugins(lua_State * tolua_S)
 {
 	cPluginManager * self = (cPluginManager *)tolua_tousertype(tolua_S, 1, nullptr);
@@ -2812,6 +2995,88 @@ static int tolua_cRoot_GetFurnaceRecipe(lua_State * tolua_S)
 
 
 
+static int tolua_get_cItem_m_Enchantments(lua_State * tolua_S)
+{
+	// Getter for the cItem.m_Enchantments property
+	// Exported manually because the enchantments may be shared with the item's copies. The item's own copy is made
+	// first, so that the plugins can keep modifying the enchantments in-place without affecting the other items:
+	cItem * self = (cItem *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		tolua_error(tolua_S, "invalid 'self' in accessing variable 'm_Enchantments'", nullptr);
+		return 0;
+	}
+	tolua_pushusertype(tolua_S, &self->ModifyEnchantments(), "cEnchantments");
+	return 1;
+}
+
+
+
+
+
+static int tolua_set_cItem_m_Enchantments(lua_State * tolua_S)
+{
+	// Setter for the cItem.m_Enchantments property
+	cLuaState L(tolua_S);
+	if (!L.CheckParamUserType(2, "const cEnchantments"))
+	{
+		return 0;
+	}
+	cItem * self = (cItem *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		tolua_error(tolua_S, "invalid 'self' in accessing variable 'm_Enchantments'", nullptr);
+		return 0;
+	}
+	self->SetEnchantments(*(const cEnchantments *)tolua_tousertype(tolua_S, 2, nullptr));
+	return 0;
+}
+
+
+
+
+
+static int tolua_get_cItem_m_FireworkItem(lua_State * tolua_S)
+{
+	// Getter for the cItem.m_FireworkItem property
+	// Exported manually because the firework data may be shared with the item's copies. The item's own copy is made
+	// first, so that the plugins can keep modifying the firework data in-place without affecting the other items:
+	cItem * self = (cItem *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		tolua_error(tolua_S, "invalid 'self' in accessing variable 'm_FireworkItem'", nullptr);
+		return 0;
+	}
+	tolua_pushusertype(tolua_S, &self->ModifyFireworkItem(), "cFireworkItem");
+	return 1;
+}
+
+
+
+
+
+static int tolua_set_cItem_m_FireworkItem(lua_State * tolua_S)
+{
+	// Setter for the cItem.m_FireworkItem property
+	cLuaState L(tolua_S);
+	if (!L.CheckParamUserType(2, "const cFireworkItem"))
+	{
+		return 0;
+	}
+	cItem * self = (cItem *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		tolua_error(tolua_S, "invalid 'self' in accessing variable 'm_FireworkItem'", nullptr);
+		return 0;
+	}
+	self->SetFireworkItem(*(const cFireworkItem *)tolua_tousertype(tolua_S, 2, nullptr));
+	return 0;
+}
+
+
+
+
+
 static int tolua_cHopperEntity_GetOutputBlockPos(lua_State * tolua_S)
 {
 	// function cHopperEntity::GetOutputBlockPos()
@@ -3137,6 +3402,285 @@ static int tolua_cBlockArea_SaveToSchematicString(lua_State * tolua_S)
 
 
 
+/** Returns the internal array of the block area for the datatype given as the parameter at the specified stack pos.
+Raises a Lua error if the datatype is not valid or not present in the area. */
+static Byte * GetBlockAreaDataArray(lua_State * tolua_S, cBlockArea & a_Area, int a_DataTypeStackPos)
+{
+	int DataType = (int)tolua_tonumber(tolua_S, a_DataTypeStackPos, 0);
+	Byte * Data = a_Area.GetDataArray(DataType);
+	if (Data == nullptr)
+	{
+		lua_do_error(tolua_S, "Error in function call '#funcname#': The datatype %d is not a single datatype, or it is not present in the area", DataType);
+	}
+	return Data;
+}
+
+
+
+
+
+/** Returns the highest value that can be stored in the block area's array of the specified datatype:
+255 for the block types, 15 for the nibble datatypes (metas and lights). */
+static int GetBlockAreaDataMaxValue(int a_DataType)
+{
+	return (a_DataType == cBlockArea::baTypes) ? 255 : 15;
+}
+
+
+
+
+
+static int tolua_cBlockArea_GetDataString(lua_State * tolua_S)
+{
+	// function cBlockArea:GetDataString(DataType)
+	// Returns the entire array of the specified datatype as a string, one byte per block, indexed by MakeIndex() + 1
+	// Exported manually because there's no direct C++ equivalent
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserType(1, "cBlockArea") ||
+		!L.CheckParamNumber  (2) ||
+		!L.CheckParamEnd     (3)
+	)
+	{
+		return 0;
+	}
+	cBlockArea * self = (cBlockArea *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		tolua_error(tolua_S, "invalid 'self' in function 'cBlockArea:GetDataString'", nullptr);
+		return 0;
+	}
+	Byte * Data = GetBlockAreaDataArray(tolua_S, *self, 2);
+	lua_pushlstring(tolua_S, reinterpret_cast<const char *>(Data), self->GetBlockCount());
+	return 1;
+}
+
+
+
+
+
+static int tolua_cBlockArea_SetDataString(lua_State * tolua_S)
+{
+	// function cBlockArea:SetDataString(DataType, String)
+	// Overwrites the entire array of the specified datatype with the string, as returned by GetDataString()
+	// Exported manually because there's no direct C++ equivalent
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserType(1, "cBlockArea") ||
+		!L.CheckParamNumber  (2) ||
+		!L.CheckParamString  (3) ||
+		!L.CheckParamEnd     (4)
+	)
+	{
+		return 0;
+	}
+	cBlockArea * self = (cBlockArea *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		tolua_error(tolua_S, "invalid 'self' in function 'cBlockArea:SetDataString'", nullptr);
+		return 0;
+	}
+	Byte * Data = GetBlockAreaDataArray(tolua_S, *self, 2);
+	size_t Len = 0;
+	const char * Src = lua_tolstring(tolua_S, 3, &Len);
+	if (Len != self->GetBlockCount())
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': The string has %u bytes, the area has %u blocks", static_cast<unsigned>(Len), static_cast<unsigned>(self->GetBlockCount()));
+	}
+
+	// Check all the values before writing any, the metas and lights are only 4 bits:
+	int MaxValue = GetBlockAreaDataMaxValue(static_cast<int>(tolua_tonumber(tolua_S, 2, 0)));
+	for (size_t i = 0; i < Len; i++)
+	{
+		if (static_cast<Byte>(Src[i]) > MaxValue)
+		{
+			return lua_do_error(tolua_S, "Error in function call '#funcname#': The byte %u has the value %d, the datatype only allows 0 - %d",
+				static_cast<unsigned>(i + 1), static_cast<Byte>(Src[i]), MaxValue
+			);
+		}
+	}
+	memcpy(Data, Src, Len);
+	return 0;
+}
+
+
+
+
+
+static int tolua_cBlockArea_GetDataTable(lua_State * tolua_S)
+{
+	// function cBlockArea:GetDataTable(DataType)
+	// Returns the entire array of the specified datatype as an array-table of numbers, indexed by MakeIndex() + 1
+	// Exported manually because there's no direct C++ equivalent
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserType(1, "cBlockArea") ||
+		!L.CheckParamNumber  (2) ||
+		!L.CheckParamEnd     (3)
+	)
+	{
+		return 0;
+	}
+	cBlockArea * self = (cBlockArea *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		tolua_error(tolua_S, "invalid 'self' in function 'cBlockArea:GetDataTable'", nullptr);
+		return 0;
+	}
+	Byte * Data = GetBlockAreaDataArray(tolua_S, *self, 2);
+	int BlockCount = self->GetVolume();
+	lua_createtable(tolua_S, BlockCount, 0);
+	for (int i = 0; i < BlockCount; i++)
+	{
+		lua_pushnumber(tolua_S, Data[i]);
+		lua_rawseti(tolua_S, -2, i + 1);
+	}
+	return 1;
+}
+
+
+
+
+
+static int tolua_cBlockArea_SetDataTable(lua_State * tolua_S)
+{
+	// function cBlockArea:SetDataTable(DataType, Table)
+	// Overwrites the entire array of the specified datatype with the numbers from the array-table, as returned by GetDataTable()
+	// Exported manually because there's no direct C++ equivalent
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserType(1, "cBlockArea") ||
+		!L.CheckParamNumber  (2) ||
+		!L.CheckParamTable   (3) ||
+		!L.CheckParamEnd     (4)
+	)
+	{
+		return 0;
+	}
+	cBlockArea * self = (cBlockArea *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		tolua_error(tolua_S, "invalid 'self' in function 'cBlockArea:SetDataTable'", nullptr);
+		return 0;
+	}
+	Byte * Data = GetBlockAreaDataArray(tolua_S, *self, 2);
+	int BlockCount = self->GetVolume();
+	if (static_cast<int>(lua_objlen(tolua_S, 3)) != BlockCount)
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': The table has %d items, the area has %d blocks", static_cast<int>(lua_objlen(tolua_S, 3)), BlockCount);
+	}
+
+	// Read and check all the values before writing any, the metas and lights are only 4 bits:
+	int MaxValue = GetBlockAreaDataMaxValue(static_cast<int>(tolua_tonumber(tolua_S, 2, 0)));
+	std::vector<Byte> Values(static_cast<size_t>(BlockCount));
+	for (int i = 0; i < BlockCount; i++)
+	{
+		lua_rawgeti(tolua_S, 3, i + 1);
+		lua_Integer Value = lua_tointeger(tolua_S, -1);
+		lua_pop(tolua_S, 1);
+		if ((Value < 0) || (Value > MaxValue))
+		{
+			return lua_do_error(tolua_S, "Error in function call '#funcname#': The item %d has the value %d, the datatype only allows 0 - %d",
+				i + 1, static_cast<int>(Value), MaxValue
+			);
+		}
+		Values[static_cast<size_t>(i)] = static_cast<Byte>(Value);
+	}
+	if (BlockCount > 0)
+	{
+		memcpy(Data, &Values[0], Values.size());
+	}
+	return 0;
+}
+
+
+
+
+
+static int tolua_cBlockArea_FindBlocks(lua_State * tolua_S)
+{
+	// function cBlockArea:FindBlocks(BlockType, [BlockMeta], [MaxCount])
+	// Returns an array-table of {x, y, z} relative coords of the matching blocks
+	// Exported manually because tolua can't return the coords array
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserType(1, "cBlockArea") ||
+		!L.CheckParamNumber  (2) ||
+		!L.CheckParamEnd     (5)
+	)
+	{
+		return 0;
+	}
+	cBlockArea * self = (cBlockArea *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		tolua_error(tolua_S, "invalid 'self' in function 'cBlockArea:FindBlocks'", nullptr);
+		return 0;
+	}
+	BLOCKTYPE BlockType = (BLOCKTYPE)tolua_tonumber(tolua_S, 2, 0);
+	int BlockMeta = (int)tolua_tonumber(tolua_S, 3, -1);
+	double MaxCount = tolua_tonumber(tolua_S, 4, 0);
+	size_t Limit = (MaxCount > 0) ? static_cast<size_t>(MaxCount) : self->GetBlockCount();
+
+	std::vector<Vector3i> Coords;
+	self->FindBlocks(BlockType, BlockMeta, Limit, Coords);
+	lua_createtable(tolua_S, static_cast<int>(Coords.size()), 0);
+	int idx = 1;
+	for (std::vector<Vector3i>::const_iterator itr = Coords.begin(), end = Coords.end(); itr != end; ++itr, ++idx)
+	{
+		lua_createtable(tolua_S, 3, 0);
+		lua_pushnumber(tolua_S, itr->x);
+		lua_rawseti(tolua_S, -2, 1);
+		lua_pushnumber(tolua_S, itr->y);
+		lua_rawseti(tolua_S, -2, 2);
+		lua_pushnumber(tolua_S, itr->z);
+		lua_rawseti(tolua_S, -2, 3);
+		lua_rawseti(tolua_S, -2, idx);
+	}
+	return 1;
+}
+
+
+
+
+
+static int tolua_cBlockArea_GetBlockTypeHistogram(lua_State * tolua_S)
+{
+	// function cBlockArea:GetBlockTypeHistogram()
+	// Returns a table of BlockType -> number of blocks, only the block types present in the area are included
+	// Exported manually because tolua can't return the counts array
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamUserType(1, "cBlockArea") ||
+		!L.CheckParamEnd     (2)
+	)
+	{
+		return 0;
+	}
+	cBlockArea * self = (cBlockArea *)tolua_tousertype(tolua_S, 1, nullptr);
+	if (self == nullptr)
+	{
+		tolua_error(tolua_S, "invalid 'self' in function 'cBlockArea:GetBlockTypeHistogram'", nullptr);
+		return 0;
+	}
+	size_t Counts[256];
+	self->GetBlockTypeHistogram(Counts);
+	lua_newtable(tolua_S);
+	for (int i = 0; i < 256; i++)
+	{
+		if (Counts[i] > 0)
+		{
+			lua_pushnumber(tolua_S, static_cast<lua_Number>(Counts[i]));
+			lua_rawseti(tolua_S, -2, i);
+		}
+	}
+	return 1;
+}
+
+
+
+
+
 static int tolua_cCompositeChat_AddRunCommandPart(lua_State * tolua_S)
 {
 	// function cCompositeChat:AddRunCommandPart(Message, Command, [Style])
@@ -3403,8 +3947,12 @@ void ManualBindings::Bind(lua_State * tolua_S)
 		tolua_endmodule(tolua_S);
 		
 		tolua_beginmodule(tolua_S, "cBlockArea");
+			tolua_function(tolua_S, "FindBlocks",              tolua_cBlockArea_FindBlocks);
+			tolua_function(tolua_S, "GetBlockTypeHistogram",   tolua_cBlockArea_GetBlockTypeHistogram);
 			tolua_function(tolua_S, "GetBlockTypeMeta",        tolua_cBlockArea_GetBlockTypeMeta);
 			tolua_function(tolua_S, "GetCoordRange",           tolua_cBlockArea_GetCoordRange);
+			tolua_function(tolua_S, "GetDataString",           tolua_cBlockArea_GetDataString);
+			tolua_function(tolua_S, "GetDataTable",            tolua_cBlockArea_GetDataTable);
 			tolua_function(tolua_S, "GetOrigin",               tolua_cBlockArea_GetOrigin);
 			tolua_function(tolua_S, "GetRelBlockTypeMeta",     tolua_cBlockArea_GetRelBlockTypeMeta);
 			tolua_function(tolua_S, "GetSize",                 tolua_cBlockArea_GetSize);
@@ -3412,6 +3960,8 @@ void ManualBindings::Bind(lua_State * tolua_S)
 			tolua_function(tolua_S, "LoadFromSchematicString", tolua_cBlockArea_LoadFromSchematicString);
 			tolua_function(tolua_S, "SaveToSchematicFile",     tolua_cBlockArea_SaveToSchematicFile);
 			tolua_function(tolua_S, "SaveToSchematicString",   tolua_cBlockArea_SaveToSchematicString);
+			tolua_function(tolua_S, "SetDataString",           tolua_cBlockArea_SetDataString);
+			tolua_function(tolua_S, "SetDataTable",            tolua_cBlockArea_SetDataTable);
 		tolua_endmodule(tolua_S);
 		
 		tolua_beginmodule(tolua_S, "cCompositeChat");
@@ -3443,6 +3993,7 @@ void ManualBindings::Bind(lua_State * tolua_S)
 		tolua_beginmodule(tolua_S, "cWorld");
 			tolua_function(tolua_S, "ChunkStay",                 tolua_cWorld_ChunkStay);
 			tolua_function(tolua_S, "DoWithBlockEntityAt",       tolua_DoWithXYZ<cWorld, cBlockEntity,        &cWorld::DoWithBlockEntityAt>);
+			tolua_function(tolua_S, "DoWithChunkCursor",         tolua_cWorld_DoWithChunkCursor);
 			tolua_function(tolua_S, "DoWithBeaconAt",            tolua_DoWithXYZ<cWorld, cBeaconEntity,       &cWorld::DoWithBeaconAt>);
 			tolua_function(tolua_S, "DoWithChestAt",             tolua_DoWithXYZ<cWorld, cChestEntity,        &cWorld::DoWithChestAt>);
 			tolua_function(tolua_S, "DoWithDispenserAt",         tolua_DoWithXYZ<cWorld, cDispenserEntity,    &cWorld::DoWithDispenserAt>);
@@ -3470,10 +4021,16 @@ void ManualBindings::Bind(lua_State * tolua_S)
 			tolua_function(tolua_S, "PrepareChunk",              tolua_cWorld_PrepareChunk);
 			tolua_function(tolua_S, "QueueTask",                 tolua_cWorld_QueueTask);
 			tolua_function(tolua_S, "ScheduleTask",              tolua_cWorld_ScheduleTask);
+			tolua_function(tolua_S, "QueueWorkerJob",            tolua_cWorld_QueueWorkerJob);
 			tolua_function(tolua_S, "SetSignLines",              tolua_cWorld_SetSignLines);
 			tolua_function(tolua_S, "TryGetHeight",              tolua_cWorld_TryGetHeight);
 		tolua_endmodule(tolua_S);
 		
+		tolua_beginmodule(tolua_S, "cChunkCursor");
+			tolua_function(tolua_S, "GetBlockInfo",     tolua_cChunkCursor_GetBlockInfo);
+			tolua_function(tolua_S, "GetBlockTypeMeta", tolua_cChunkCursor_GetBlockTypeMeta);
+		tolua_endmodule(tolua_S);
+		
 		tolua_beginmodule(tolua_S, "cMapManager");
 			tolua_function(tolua_S, "DoWithMap", tolua_DoWithID<cMapManager, cMap, &cMapManager::DoWithMap>);
 		tolua_endmodule(tolua_S);
@@ -3549,6 +4106,15 @@ void ManualBindings::Bind(lua_State * tolua_S)
 			tolua_function(tolua_S, "MakeUUIDShort",              tolua_cMojangAPI_MakeUUIDShort);
 		tolua_endmodule(tolua_S);
 		
+		// cFireworkItem isn't exported by ToLua, but the cItem.m_FireworkItem property needs the type:
+		tolua_usertype(tolua_S, "cFireworkItem");
+		tolua_cclass(tolua_S, "cFireworkItem", "cFireworkItem", "", nullptr);
+
+		tolua_beginmodule(tolua_S, "cItem");
+			tolua_variable(tolua_S, "m_Enchantments", tolua_get_cItem_m_Enchantments, tolua_set_cItem_m_Enchantments);
+			tolua_variable(tolua_S, "m_FireworkItem", tolua_get_cItem_m_FireworkItem, tolua_set_cItem_m_FireworkItem);
+		tolua_endmodule(tolua_S);
+
 		tolua_beginmodule(tolua_S, "cItemGrid");
 			tolua_function(tolua_S, "GetSlotCoords", Lua_ItemGrid_GetSlotCoords);
 		tolua_endmodule(tolua_S);
@@ -20,6 +20,10 @@ class cWorld;
 class cChunkDesc;
 struct TakeDamageInfo;
 
+// fwd: PluginManager.h
+struct sPlayerMove;
+typedef std::vector<sPlayerMove> cPlayerMoves;
+
 
 // fwd: CraftingRecipes.h
 class cCraftingGrid;
@@ -87,6 +91,7 @@ public:
 	virtual bool OnPlayerUsedItem           (cPlayer & a_Player, int a_BlockX, int a_BlockY, int a_BlockZ, char a_BlockFace, int a_CursorX, int a_CursorY, int a_CursorZ) = 0;
 	virtual bool OnPlayerUsingBlock         (cPlayer & a_Player, int a_BlockX, int a_BlockY, int a_BlockZ, char a_BlockFace, int a_CursorX, int a_CursorY, int a_CursorZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta) = 0;
 	virtual bool OnPlayerUsingItem          (cPlayer & a_Player, int a_BlockX, int a_BlockY, int a_BlockZ, char a_BlockFace, int a_CursorX, int a_CursorY, int a_CursorZ) = 0;
+	virtual bool OnPlayersMoved             (cWorld & a_World, const cPlayerMoves & a_Moves) = 0;
 	virtual bool OnPluginMessage            (cClientHandle & a_Client, const AString & a_Channel, const AString & a_Message) = 0;
 	virtual bool OnPluginsLoaded            (void) = 0;
 	virtual bool OnPostCrafting             (cPlayer & a_Player, cCraftingGrid & a_Grid, cCraftingRecipe & a_Recipe) = 0;
@@ -123,6 +128,17 @@ public:
 	/// All bound console commands are to be removed, do any language-dependent cleanup here
 	virtual void ClearConsoleCommands(void) {}
 	
+	/** Runs the plugin's garbage collection for at most a_Budget.
+	Called once per server tick when the GC budget is enabled in settings.ini ([Plugins] LuaGCBudgetUSec). */
+	virtual void StepGC(std::chrono::microseconds a_Budget) { UNUSED(a_Budget); }
+	
+	/** Returns the plugin to the automatic garbage collection, after StepGC() calls. Called when the GC budget is disabled. */
+	virtual void StopManualGC(void) {}
+	
+	/** Returns a one-line summary of the plugin's memory usage and garbage collection, or an empty string if not available.
+	Used by the "pluginmem" console command and the WebAdmin. */
+	virtual AString GetMemoryStats(void) { return AString(); }
+	
 	// tolua_begin
 	const AString & GetName(void) const  { return m_Name; }
 	void SetName(const AString & a_Name) { m_Name = a_Name; }
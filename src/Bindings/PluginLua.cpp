@@ -11,6 +11,7 @@
 #define LUA_USE_POSIX
 #endif
 #include "PluginLua.h"
+#include "LuaWorkers.h"
 #include "../CommandOutput.h"
 #include "PluginManager.h"
 #include "../Item.h"
@@ -52,6 +53,9 @@ cPluginLua::~cPluginLua()
 
 void cPluginLua::Close(void)
 {
+	// Stop the workers first, so that they don't deliver any more results into the state being closed:
+	m_Workers.reset();
+
 	if (m_LuaState.IsValid())
 	{
 		// Release all the references in the hook map:
@@ -202,6 +206,52 @@ void cPluginLua::Tick(float a_Dt)
 
 
 
+void cPluginLua::StepGC(std::chrono::microseconds a_Budget)
+{
+	cCSLock Lock(m_CriticalSection);
+	if (m_LuaState.IsValid())
+	{
+		m_LuaState.StepGC(a_Budget);
+	}
+}
+
+
+
+
+
+void cPluginLua::StopManualGC(void)
+{
+	cCSLock Lock(m_CriticalSection);
+	if (m_LuaState.IsValid())
+	{
+		m_LuaState.StopManualGC();
+	}
+}
+
+
+
+
+
+AString cPluginLua::GetMemoryStats(void)
+{
+	cCSLock Lock(m_CriticalSection);
+	const cLuaState::sGCStats & GC = m_LuaState.GetGCStats();
+	return Printf("%.02f MiB (peak %.02f MiB), %llu allocations; GC: %llu cycles, %llu steps, %.02f msec total, %.02f msec max, %llu over budget",
+		static_cast<double>(m_LuaState.GetMemoryUsage()) / (1024 * 1024),
+		static_cast<double>(m_LuaState.GetPeakMemoryUsage()) / (1024 * 1024),
+		static_cast<unsigned long long>(m_LuaState.GetNumAllocations()),
+		static_cast<unsigned long long>(GC.m_NumCycles),
+		static_cast<unsigned long long>(GC.m_NumSteps),
+		static_cast<double>(GC.m_TotalUSec) / 1000,
+		static_cast<double>(GC.m_MaxStepUSec) / 1000,
+		static_cast<unsigned long long>(GC.m_NumOverBudget)
+	);
+}
+
+
+
+
+
 bool cPluginLua::OnBlockSpread(cWorld & a_World, int a_BlockX, int a_BlockY, int a_BlockZ, eSpreadSource a_Source)
 {
 	cCSLock Lock(m_CriticalSection);
@@ -1087,6 +1137,26 @@ bool cPluginLua::OnPlayerUsingItem(cPlayer & a_Player, int a_BlockX, int a_Block
 
 
 
+bool cPluginLua::OnPlayersMoved(cWorld & a_World, const cPlayerMoves & a_Moves)
+{
+	cCSLock Lock(m_CriticalSection);
+	bool res = false;
+	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYERS_MOVED];
+	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
+	{
+		m_LuaState.Call((int)(**itr), &a_World, a_Moves, cLuaState::Return, res);
+		if (res)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+
 bool cPluginLua::OnPluginMessage(cClientHandle & a_Client, const AString & a_Channel, const AString & a_Message)
 {
 	cCSLock Lock(m_CriticalSection);
@@ -1598,6 +1668,7 @@ const char * cPluginLua::GetHookFnName(int a_HookType)
 		case cPluginManager::HOOK_PLAYER_USED_ITEM:             return "OnPlayerUsedItem";
 		case cPluginManager::HOOK_PLAYER_USING_BLOCK:           return "OnPlayerUsingBlock";
 		case cPluginManager::HOOK_PLAYER_USING_ITEM:            return "OnPlayerUsingItem";
+		case cPluginManager::HOOK_PLAYERS_MOVED:                return "OnPlayersMoved";
 		case cPluginManager::HOOK_PLUGIN_MESSAGE:               return "OnPluginMessage";
 		case cPluginManager::HOOK_PLUGINS_LOADED:               return "OnPluginsLoaded";
 		case cPluginManager::HOOK_POST_CRAFTING:                return "OnPostCrafting";
@@ -1780,6 +1851,31 @@ void cPluginLua::Unreference(int a_LuaRef)
 
 
 
+cLuaWorkers & cPluginLua::GetWorkers(void)
+{
+	cCSLock Lock(m_CriticalSection);
+	if (m_Workers == nullptr)
+	{
+		// Two threads per plugin are enough to keep a long job from delaying all the others:
+		m_Workers.reset(new cLuaWorkers(*this, 2));
+	}
+	return *m_Workers;
+}
+
+
+
+
+
+bool cPluginLua::HasWorkers(int a_WorkersID)
+{
+	cCSLock Lock(m_CriticalSection);
+	return ((m_Workers != nullptr) && (m_Workers->GetID() == a_WorkersID));
+}
+
+
+
+
+
 bool cPluginLua::CallbackWindowClosing(int a_FnRef, cWindow & a_Window, cPlayer & a_Player, bool a_CanRefuse)
 {
 	ASSERT(a_FnRef != LUA_REFNIL);
@@ -23,6 +23,9 @@
 // fwd: UI/Window.h
 class cWindow;
 
+// fwd: LuaWorkers.h
+class cLuaWorkers;
+
 
 
 
@@ -68,6 +71,9 @@ public:
 	virtual bool Initialize(void) override;
 
 	virtual void Tick(float a_Dt) override;
+	virtual void StepGC(std::chrono::microseconds a_Budget) override;
+	virtual void StopManualGC(void) override;
+	virtual AString GetMemoryStats(void) override;
 
 	virtual bool OnBlockSpread              (cWorld & a_World, int a_BlockX, int a_BlockY, int a_BlockZ, eSpreadSource a_Source) override;
 	virtual bool OnBlockToPickups           (cWorld & a_World, cEntity * a_Digger, int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, cItems & a_Pickups) override;
@@ -111,6 +117,7 @@ public:
 	virtual bool OnPlayerUsedItem           (cPlayer & a_Player, int a_BlockX, int a_BlockY, int a_BlockZ, char a_BlockFace, int a_CursorX, int a_CursorY, int a_CursorZ) override;
 	virtual bool OnPlayerUsingBlock         (cPlayer & a_Player, int a_BlockX, int a_BlockY, int a_BlockZ, char a_BlockFace, int a_CursorX, int a_CursorY, int a_CursorZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta) override;
 	virtual bool OnPlayerUsingItem          (cPlayer & a_Player, int a_BlockX, int a_BlockY, int a_BlockZ, char a_BlockFace, int a_CursorX, int a_CursorY, int a_CursorZ) override;
+	virtual bool OnPlayersMoved             (cWorld & a_World, const cPlayerMoves & a_Moves) override;
 	virtual bool OnPluginMessage            (cClientHandle & a_Client, const AString & a_Channel, const AString & a_Message) override;
 	virtual bool OnPluginsLoaded            (void) override;
 	virtual bool OnPostCrafting             (cPlayer & a_Player, cCraftingGrid & a_Grid, cCraftingRecipe & a_Recipe) override;
@@ -157,6 +164,14 @@ public:
 	cLuaState & GetLuaState(void) { return m_LuaState; }
 
 	cCriticalSection & GetCriticalSection(void) { return m_CriticalSection; }
+
+	/** Returns the worker threads running the plugin's background jobs, creating them if needed.
+	Used by the cWorld:QueueWorkerJob() API. */
+	cLuaWorkers & GetWorkers(void);
+
+	/** Returns true if the plugin's current workers have the specified ID.
+	A worker's result is delivered only if the workers that ran the job haven't been stopped (plugin closed) since. */
+	bool HasWorkers(int a_WorkersID);
 	
 	/** Removes a previously referenced object (luaL_unref()) */
 	void Unreference(int a_LuaRef);
@@ -240,6 +255,9 @@ protected:
 	CommandMap m_ConsoleCommands;
 	
 	cHookMap m_HookMap;
+
+	/** The worker threads for the plugin's background jobs, created on the first use. Protected by m_CriticalSection. */
+	std::unique_ptr<cLuaWorkers> m_Workers;
 	
 	/** Releases all Lua references and closes the LuaState */
 	void Close(void);
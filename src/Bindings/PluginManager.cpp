@@ -12,13 +12,42 @@
 #include "../IniFile.h"
 #include "../Entities/Player.h"
 
-#define FIND_HOOK(a_HookName) HookMap::iterator Plugins = m_Hooks.find(a_HookName);
+#define FIND_HOOK(a_HookName) \
+	const PluginList & Plugins = m_Hooks[a_HookName]; \
+	sHookStats & HookStats = m_HookStats[a_HookName];
 #define VERIFY_HOOK \
-	if (Plugins == m_Hooks.end()) \
+	if (Plugins.empty()) \
 	{ \
 		return false; \
+	} \
+	cHookTimer HookTimer(HookStats);
+
+
+
+
+
+/** Measures the time spent in the plugins during a single hook call and adds it to the hook's statistics. */
+class cHookTimer
+{
+public:
+	cHookTimer(cPluginManager::sHookStats & a_Stats) :
+		m_Stats(a_Stats),
+		m_Start(std::chrono::steady_clock::now())
+	{
+	}
+
+	~cHookTimer()
+	{
+		auto Elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_Start);
+		m_Stats.m_NumCalls += 1;
+		m_Stats.m_TotalUSec += static_cast<UInt64>(Elapsed.count());
 	}
 
+protected:
+	cPluginManager::sHookStats & m_Stats;
+	std::chrono::steady_clock::time_point m_Start;
+} ;
+
 
 
 
@@ -33,6 +62,9 @@ cPluginManager * cPluginManager::Get(void)
 
 
 cPluginManager::cPluginManager(void) :
+	m_GCBudget(0),
+	m_GCNextPlugin(0),
+	m_IsManualGC(false),
 	m_bReloadPlugins(false)
 {
 }
@@ -128,6 +160,9 @@ void cPluginManager::ReloadPluginsNow(cIniFile & a_SettingsIni)
 		KeyNum = a_SettingsIni.FindKey("Plugins");
 	}
 
+	// The time that the plugins' garbage collection may take in each world tick, 0 to use Lua's automatic collector:
+	m_GCBudget = std::chrono::microseconds(std::max(a_SettingsIni.GetValueSetI("Plugins", "LuaGCBudgetUSec", 1000), 0));
+
 	// How many plugins are there?
 	int NumPlugins = a_SettingsIni.GetNumValues(KeyNum);
 
@@ -211,10 +246,11 @@ void cPluginManager::Tick(float a_Dt)
 		ReloadPluginsNow();
 	}
 
-	FIND_HOOK(HOOK_TICK);
-	if (Plugins != m_Hooks.end())
+	const PluginList & Plugins = m_Hooks[HOOK_TICK];
+	if (!Plugins.empty())
 	{
-		for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+		cHookTimer HookTimer(m_HookStats[HOOK_TICK]);
+		for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 		{
 			(*itr)->Tick(a_Dt);
 		}
@@ -230,7 +266,7 @@ bool cPluginManager::CallHookBlockSpread(cWorld & a_World, int a_BlockX, int a_B
 	FIND_HOOK(HOOK_BLOCK_SPREAD);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnBlockSpread(a_World, a_BlockX, a_BlockY, a_BlockZ, a_Source))
 		{
@@ -253,7 +289,7 @@ bool cPluginManager::CallHookBlockToPickups(
 	FIND_HOOK(HOOK_BLOCK_TO_PICKUPS);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnBlockToPickups(a_World, a_Digger, a_BlockX, a_BlockY, a_BlockZ, a_BlockType, a_BlockMeta, a_Pickups))
 		{
@@ -319,7 +355,7 @@ bool cPluginManager::CallHookChat(cPlayer & a_Player, AString & a_Message)
 	FIND_HOOK(HOOK_CHAT);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnChat(a_Player, a_Message))
 		{
@@ -339,7 +375,7 @@ bool cPluginManager::CallHookChunkAvailable(cWorld & a_World, int a_ChunkX, int
 	FIND_HOOK(HOOK_CHUNK_AVAILABLE);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnChunkAvailable(a_World, a_ChunkX, a_ChunkZ))
 		{
@@ -358,7 +394,7 @@ bool cPluginManager::CallHookChunkGenerated(cWorld & a_World, int a_ChunkX, int
 	FIND_HOOK(HOOK_CHUNK_GENERATED);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnChunkGenerated(a_World, a_ChunkX, a_ChunkZ, a_ChunkDesc))
 		{
@@ -377,7 +413,7 @@ bool cPluginManager::CallHookChunkGenerating(cWorld & a_World, int a_ChunkX, int
 	FIND_HOOK(HOOK_CHUNK_GENERATING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnChunkGenerating(a_World, a_ChunkX, a_ChunkZ, a_ChunkDesc))
 		{
@@ -396,7 +432,7 @@ bool cPluginManager::CallHookChunkUnloaded(cWorld & a_World, int a_ChunkX, int a
 	FIND_HOOK(HOOK_CHUNK_UNLOADED);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnChunkUnloaded(a_World, a_ChunkX, a_ChunkZ))
 		{
@@ -415,7 +451,7 @@ bool cPluginManager::CallHookChunkUnloading(cWorld & a_World, int a_ChunkX, int
 	FIND_HOOK(HOOK_CHUNK_UNLOADING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnChunkUnloading(a_World, a_ChunkX, a_ChunkZ))
 		{
@@ -434,7 +470,7 @@ bool cPluginManager::CallHookCollectingPickup(cPlayer & a_Player, cPickup & a_Pi
 	FIND_HOOK(HOOK_COLLECTING_PICKUP);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnCollectingPickup(a_Player, a_Pickup))
 		{
@@ -453,7 +489,7 @@ bool cPluginManager::CallHookCraftingNoRecipe(cPlayer & a_Player, cCraftingGrid
 	FIND_HOOK(HOOK_CRAFTING_NO_RECIPE);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnCraftingNoRecipe(a_Player, a_Grid, a_Recipe))
 		{
@@ -472,7 +508,7 @@ bool cPluginManager::CallHookDisconnect(cClientHandle & a_Client, const AString
 	FIND_HOOK(HOOK_DISCONNECT);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnDisconnect(a_Client, a_Reason))
 		{
@@ -491,7 +527,7 @@ bool cPluginManager::CallHookEntityAddEffect(cEntity & a_Entity, int a_EffectTyp
 	FIND_HOOK(HOOK_ENTITY_ADD_EFFECT);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnEntityAddEffect(a_Entity, a_EffectType, a_EffectDurationTicks, a_EffectIntensity, a_DistanceModifier))
 		{
@@ -510,7 +546,7 @@ bool cPluginManager::CallHookExecuteCommand(cPlayer * a_Player, const AStringVec
 	FIND_HOOK(HOOK_EXECUTE_COMMAND);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnExecuteCommand(a_Player, a_Split))
 		{
@@ -529,7 +565,7 @@ bool cPluginManager::CallHookExploded(cWorld & a_World, double a_ExplosionSize,
 	FIND_HOOK(HOOK_EXPLODED);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnExploded(a_World, a_ExplosionSize, a_CanCauseFire, a_X, a_Y, a_Z, a_Source, a_SourceData))
 		{
@@ -548,7 +584,7 @@ bool cPluginManager::CallHookExploding(cWorld & a_World, double & a_ExplosionSiz
 	FIND_HOOK(HOOK_EXPLODING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnExploding(a_World, a_ExplosionSize, a_CanCauseFire, a_X, a_Y, a_Z, a_Source, a_SourceData))
 		{
@@ -567,7 +603,7 @@ bool cPluginManager::CallHookHandshake(cClientHandle & a_ClientHandle, const ASt
 	FIND_HOOK(HOOK_HANDSHAKE);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnHandshake(a_ClientHandle, a_Username))
 		{
@@ -586,7 +622,7 @@ bool cPluginManager::CallHookHopperPullingItem(cWorld & a_World, cHopperEntity &
 	FIND_HOOK(HOOK_HOPPER_PULLING_ITEM);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnHopperPullingItem(a_World, a_Hopper, a_DstSlotNum, a_SrcEntity, a_SrcSlotNum))
 		{
@@ -605,7 +641,7 @@ bool cPluginManager::CallHookHopperPushingItem(cWorld & a_World, cHopperEntity &
 	FIND_HOOK(HOOK_HOPPER_PUSHING_ITEM);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnHopperPushingItem(a_World, a_Hopper, a_SrcSlotNum, a_DstEntity, a_DstSlotNum))
 		{
@@ -624,7 +660,7 @@ bool cPluginManager::CallHookKilling(cEntity & a_Victim, cEntity * a_Killer, Tak
 	FIND_HOOK(HOOK_KILLING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnKilling(a_Victim, a_Killer, a_TDI))
 		{
@@ -643,7 +679,7 @@ bool cPluginManager::CallHookLogin(cClientHandle & a_Client, int a_ProtocolVersi
 	FIND_HOOK(HOOK_LOGIN);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnLogin(a_Client, a_ProtocolVersion, a_Username))
 		{
@@ -662,7 +698,7 @@ bool cPluginManager::CallHookPlayerAnimation(cPlayer & a_Player, int a_Animation
 	FIND_HOOK(HOOK_PLAYER_ANIMATION);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerAnimation(a_Player, a_Animation))
 		{
@@ -681,7 +717,7 @@ bool cPluginManager::CallHookPlayerBreakingBlock(cPlayer & a_Player, int a_Block
 	FIND_HOOK(HOOK_PLAYER_BREAKING_BLOCK);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerBreakingBlock(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_BlockType, a_BlockMeta))
 		{
@@ -700,7 +736,7 @@ bool cPluginManager::CallHookPlayerBrokenBlock(cPlayer & a_Player, int a_BlockX,
 	FIND_HOOK(HOOK_PLAYER_BROKEN_BLOCK);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerBrokenBlock(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_BlockType, a_BlockMeta))
 		{
@@ -719,7 +755,7 @@ bool cPluginManager::CallHookPlayerDestroyed(cPlayer & a_Player)
 	FIND_HOOK(HOOK_PLAYER_DESTROYED);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerDestroyed(a_Player))
 		{
@@ -738,7 +774,7 @@ bool cPluginManager::CallHookPlayerEating(cPlayer & a_Player)
 	FIND_HOOK(HOOK_PLAYER_EATING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerEating(a_Player))
 		{
@@ -757,7 +793,7 @@ bool cPluginManager::CallHookPlayerFoodLevelChange(cPlayer & a_Player, int a_New
 	FIND_HOOK(HOOK_PLAYER_FOOD_LEVEL_CHANGE);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerFoodLevelChange(a_Player, a_NewFoodLevel))
 		{
@@ -776,7 +812,7 @@ bool cPluginManager::CallHookPlayerFished(cPlayer & a_Player, const cItems & a_R
 	FIND_HOOK(HOOK_PLAYER_FISHED);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerFished(a_Player, a_Reward))
 		{
@@ -795,7 +831,7 @@ bool cPluginManager::CallHookPlayerFishing(cPlayer & a_Player, cItems a_Reward)
 	FIND_HOOK(HOOK_PLAYER_FISHING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerFishing(a_Player, a_Reward))
 		{
@@ -814,7 +850,7 @@ bool cPluginManager::CallHookPlayerJoined(cPlayer & a_Player)
 	FIND_HOOK(HOOK_PLAYER_JOINED);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerJoined(a_Player))
 		{
@@ -833,7 +869,7 @@ bool cPluginManager::CallHookPlayerLeftClick(cPlayer & a_Player, int a_BlockX, i
 	FIND_HOOK(HOOK_PLAYER_LEFT_CLICK);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerLeftClick(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_Status))
 		{
@@ -852,7 +888,7 @@ bool cPluginManager::CallHookPlayerMoving(cPlayer & a_Player, const Vector3d & a
 	FIND_HOOK(HOOK_PLAYER_MOVING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerMoving(a_Player, a_OldPosition, a_NewPosition))
 		{
@@ -871,7 +907,7 @@ bool cPluginManager::CallHookPlayerPlacedBlock(cPlayer & a_Player, const sSetBlo
 	FIND_HOOK(HOOK_PLAYER_PLACED_BLOCK);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerPlacedBlock(a_Player, a_BlockChange))
 		{
@@ -890,7 +926,7 @@ bool cPluginManager::CallHookPlayerPlacingBlock(cPlayer & a_Player, const sSetBl
 	FIND_HOOK(HOOK_PLAYER_PLACING_BLOCK);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerPlacingBlock(a_Player, a_BlockChange))
 		{
@@ -909,7 +945,7 @@ bool cPluginManager::CallHookPlayerRightClick(cPlayer & a_Player, int a_BlockX,
 	FIND_HOOK(HOOK_PLAYER_RIGHT_CLICK);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerRightClick(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ))
 		{
@@ -928,7 +964,7 @@ bool cPluginManager::CallHookPlayerRightClickingEntity(cPlayer & a_Player, cEnti
 	FIND_HOOK(HOOK_PLAYER_RIGHT_CLICKING_ENTITY);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerRightClickingEntity(a_Player, a_Entity))
 		{
@@ -947,7 +983,7 @@ bool cPluginManager::CallHookPlayerShooting(cPlayer & a_Player)
 	FIND_HOOK(HOOK_PLAYER_SHOOTING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerShooting(a_Player))
 		{
@@ -966,7 +1002,7 @@ bool cPluginManager::CallHookPlayerSpawned(cPlayer & a_Player)
 	FIND_HOOK(HOOK_PLAYER_SPAWNED);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerSpawned(a_Player))
 		{
@@ -985,7 +1021,7 @@ bool cPluginManager::CallHookPlayerTossingItem(cPlayer & a_Player)
 	FIND_HOOK(HOOK_PLAYER_TOSSING_ITEM);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerTossingItem(a_Player))
 		{
@@ -1004,7 +1040,7 @@ bool cPluginManager::CallHookPlayerUsedBlock(cPlayer & a_Player, int a_BlockX, i
 	FIND_HOOK(HOOK_PLAYER_USED_BLOCK);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerUsedBlock(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta))
 		{
@@ -1023,7 +1059,7 @@ bool cPluginManager::CallHookPlayerUsedItem(cPlayer & a_Player, int a_BlockX, in
 	FIND_HOOK(HOOK_PLAYER_USED_ITEM);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerUsedItem(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ))
 		{
@@ -1042,7 +1078,7 @@ bool cPluginManager::CallHookPlayerUsingBlock(cPlayer & a_Player, int a_BlockX,
 	FIND_HOOK(HOOK_PLAYER_USING_BLOCK);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerUsingBlock(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta))
 		{
@@ -1061,7 +1097,7 @@ bool cPluginManager::CallHookPlayerUsingItem(cPlayer & a_Player, int a_BlockX, i
 	FIND_HOOK(HOOK_PLAYER_USING_ITEM);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerUsingItem(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ))
 		{
@@ -1075,12 +1111,31 @@ bool cPluginManager::CallHookPlayerUsingItem(cPlayer & a_Player, int a_BlockX, i
 
 
 
+bool cPluginManager::CallHookPlayersMoved(cWorld & a_World, const cPlayerMoves & a_Moves)
+{
+	FIND_HOOK(HOOK_PLAYERS_MOVED);
+	VERIFY_HOOK;
+
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
+	{
+		if ((*itr)->OnPlayersMoved(a_World, a_Moves))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+
 bool cPluginManager::CallHookPluginMessage(cClientHandle & a_Client, const AString & a_Channel, const AString & a_Message)
 {
 	FIND_HOOK(HOOK_PLUGIN_MESSAGE);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPluginMessage(a_Client, a_Channel, a_Message))
 		{
@@ -1100,7 +1155,7 @@ bool cPluginManager::CallHookPluginsLoaded(void)
 	VERIFY_HOOK;
 
 	bool res = false;
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		res = !(*itr)->OnPluginsLoaded() || res;
 	}
@@ -1116,7 +1171,7 @@ bool cPluginManager::CallHookPostCrafting(cPlayer & a_Player, cCraftingGrid & a_
 	FIND_HOOK(HOOK_POST_CRAFTING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPostCrafting(a_Player, a_Grid, a_Recipe))
 		{
@@ -1135,7 +1190,7 @@ bool cPluginManager::CallHookPreCrafting(cPlayer & a_Player, cCraftingGrid & a_G
 	FIND_HOOK(HOOK_PRE_CRAFTING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnPreCrafting(a_Player, a_Grid, a_Recipe))
 		{
@@ -1154,7 +1209,7 @@ bool cPluginManager::CallHookProjectileHitBlock(cProjectileEntity & a_Projectile
 	FIND_HOOK(HOOK_PROJECTILE_HIT_BLOCK);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnProjectileHitBlock(a_Projectile, a_BlockX, a_BlockY, a_BlockZ, a_Face, a_BlockHitPos))
 		{
@@ -1173,7 +1228,7 @@ bool cPluginManager::CallHookProjectileHitEntity(cProjectileEntity & a_Projectil
 	FIND_HOOK(HOOK_PROJECTILE_HIT_ENTITY);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnProjectileHitEntity(a_Projectile, a_HitEntity))
 		{
@@ -1192,7 +1247,7 @@ bool cPluginManager::CallHookServerPing(cClientHandle & a_ClientHandle, AString
 	FIND_HOOK(HOOK_SERVER_PING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnServerPing(a_ClientHandle, a_ServerDescription, a_OnlinePlayersCount, a_MaxPlayersCount, a_Favicon))
 		{
@@ -1211,7 +1266,7 @@ bool cPluginManager::CallHookSpawnedEntity(cWorld & a_World, cEntity & a_Entity)
 	FIND_HOOK(HOOK_SPAWNED_ENTITY);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnSpawnedEntity(a_World, a_Entity))
 		{
@@ -1229,7 +1284,7 @@ bool cPluginManager::CallHookSpawnedMonster(cWorld & a_World, cMonster & a_Monst
 	FIND_HOOK(HOOK_SPAWNED_MONSTER);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnSpawnedMonster(a_World, a_Monster))
 		{
@@ -1247,7 +1302,7 @@ bool cPluginManager::CallHookSpawningEntity(cWorld & a_World, cEntity & a_Entity
 	FIND_HOOK(HOOK_SPAWNING_ENTITY);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnSpawningEntity(a_World, a_Entity))
 		{
@@ -1266,7 +1321,7 @@ bool cPluginManager::CallHookSpawningMonster(cWorld & a_World, cMonster & a_Mons
 	FIND_HOOK(HOOK_SPAWNING_MONSTER);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnSpawningMonster(a_World, a_Monster))
 		{
@@ -1285,7 +1340,7 @@ bool cPluginManager::CallHookTakeDamage(cEntity & a_Receiver, TakeDamageInfo & a
 	FIND_HOOK(HOOK_TAKE_DAMAGE);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnTakeDamage(a_Receiver, a_TDI))
 		{
@@ -1304,7 +1359,7 @@ bool cPluginManager::CallHookUpdatingSign(cWorld & a_World, int a_BlockX, int a_
 	FIND_HOOK(HOOK_UPDATING_SIGN);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnUpdatingSign(a_World, a_BlockX, a_BlockY, a_BlockZ, a_Line1, a_Line2, a_Line3, a_Line4, a_Player))
 		{
@@ -1323,7 +1378,7 @@ bool cPluginManager::CallHookUpdatedSign(cWorld & a_World, int a_BlockX, int a_B
 	FIND_HOOK(HOOK_UPDATED_SIGN);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnUpdatedSign(a_World, a_BlockX, a_BlockY, a_BlockZ, a_Line1, a_Line2, a_Line3, a_Line4, a_Player))
 		{
@@ -1342,7 +1397,7 @@ bool cPluginManager::CallHookWeatherChanged(cWorld & a_World)
 	FIND_HOOK(HOOK_WEATHER_CHANGED);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnWeatherChanged(a_World))
 		{
@@ -1361,7 +1416,7 @@ bool cPluginManager::CallHookWeatherChanging(cWorld & a_World, eWeather & a_NewW
 	FIND_HOOK(HOOK_WEATHER_CHANGING);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnWeatherChanging(a_World, a_NewWeather))
 		{
@@ -1380,7 +1435,7 @@ bool cPluginManager::CallHookWorldStarted(cWorld & a_World)
 	FIND_HOOK(HOOK_WORLD_STARTED);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnWorldStarted(a_World))
 		{
@@ -1399,7 +1454,7 @@ bool cPluginManager::CallHookWorldTick(cWorld & a_World, std::chrono::millisecon
 	FIND_HOOK(HOOK_WORLD_TICK);
 	VERIFY_HOOK;
 
-	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
+	for (PluginList::const_iterator itr = Plugins.begin(); itr != Plugins.end(); ++itr)
 	{
 		if ((*itr)->OnWorldTick(a_World, a_Dt, a_LastTickDurationMSec))
 		{
@@ -1492,7 +1547,10 @@ const cPluginManager::PluginMap & cPluginManager::GetAllPlugins() const
 
 void cPluginManager::UnloadPluginsNow()
 {
-	m_Hooks.clear();
+	for (size_t i = 0; i < ARRAYCOUNT(m_Hooks); i++)
+	{
+		m_Hooks[i].clear();
+	}
 
 	while (!m_Plugins.empty())
 	{
@@ -1539,9 +1597,9 @@ bool cPluginManager::LoadPlugin(const AString & a_PluginName)
 
 void cPluginManager::RemoveHooks(cPlugin * a_Plugin)
 {
-	for (HookMap::iterator itr = m_Hooks.begin(), end = m_Hooks.end(); itr != end; ++itr)
+	for (size_t i = 0; i < ARRAYCOUNT(m_Hooks); i++)
 	{
-		itr->second.remove(a_Plugin);
+		m_Hooks[i].remove(a_Plugin);
 	}
 }
 
@@ -1806,6 +1864,109 @@ void cPluginManager::TabCompleteCommand(const AString & a_Text, AStringVector &
 
 
 
+void cPluginManager::LogHookStats(cCommandOutputCallback & a_Output)
+{
+	a_Output.Out("Hook calls (only the calls with any plugin registered are counted):");
+	for (int i = 0; i < HOOK_NUM_HOOKS; i++)
+	{
+		UInt64 NumCalls = m_HookStats[i].m_NumCalls;
+		if (NumCalls == 0)
+		{
+			continue;
+		}
+		UInt64 TotalUSec = m_HookStats[i].m_TotalUSec;
+		a_Output.Out("  %s: %d plugins, %llu calls, %.1f msec total, %.1f usec average",
+			cPluginLua::GetHookFnName(i), static_cast<int>(m_Hooks[i].size()), NumCalls,
+			static_cast<double>(TotalUSec) / 1000, static_cast<double>(TotalUSec) / NumCalls
+		);
+	}
+}
+
+
+
+
+
+void cPluginManager::StepPluginsGC(void)
+{
+	if (m_GCBudget.count() <= 0)
+	{
+		// Give the plugins collected so far back to Lua's automatic collector:
+		if (m_IsManualGC)
+		{
+			for (PluginMap::const_iterator itr = m_Plugins.begin(), end = m_Plugins.end(); itr != end; ++itr)
+			{
+				if (itr->second != nullptr)
+				{
+					itr->second->StopManualGC();
+				}
+			}
+			m_IsManualGC = false;
+		}
+		return;
+	}
+	m_IsManualGC = true;
+
+	std::vector<cPlugin *> Plugins;
+	for (PluginMap::const_iterator itr = m_Plugins.begin(), end = m_Plugins.end(); itr != end; ++itr)
+	{
+		if (itr->second != nullptr)
+		{
+			Plugins.push_back(itr->second);
+		}
+	}
+	size_t NumPlugins = Plugins.size();
+	if (NumPlugins == 0)
+	{
+		return;
+	}
+
+	auto Deadline = std::chrono::steady_clock::now() + m_GCBudget;
+	for (size_t i = 0; i < NumPlugins; i++)
+	{
+		auto Now = std::chrono::steady_clock::now();
+		if (Now >= Deadline)
+		{
+			break;
+		}
+		// Split the remaining time evenly among the plugins yet to be collected:
+		auto Budget = std::chrono::duration_cast<std::chrono::microseconds>(Deadline - Now) / static_cast<int>(NumPlugins - i);
+		Plugins[(m_GCNextPlugin + i) % NumPlugins]->StepGC(Budget);
+	}
+	m_GCNextPlugin = (m_GCNextPlugin + 1) % NumPlugins;
+}
+
+
+
+
+
+void cPluginManager::LogMemoryStats(cCommandOutputCallback & a_Output)
+{
+	if (m_GCBudget.count() > 0)
+	{
+		a_Output.Out("Plugin memory (GC budget %d usec per server tick):", static_cast<int>(m_GCBudget.count()));
+	}
+	else
+	{
+		a_Output.Out("Plugin memory (Lua's automatic GC):");
+	}
+	for (PluginMap::const_iterator itr = m_Plugins.begin(), end = m_Plugins.end(); itr != end; ++itr)
+	{
+		if (itr->second == nullptr)
+		{
+			continue;
+		}
+		AString Stats = itr->second->GetMemoryStats();
+		if (!Stats.empty())
+		{
+			a_Output.Out("  %s: %s", itr->first.c_str(), Stats.c_str());
+		}
+	}
+}
+
+
+
+
+
 bool cPluginManager::IsValidHookType(int a_HookType)
 {
 	return ((a_HookType >= 0) && (a_HookType <= HOOK_MAX));
@@ -1856,6 +2017,11 @@ void cPluginManager::AddHook(cPlugin * a_Plugin, int a_Hook)
 		LOGWARN("Called cPluginManager::AddHook() with a_Plugin == nullptr");
 		return;
 	}
+	if (!IsValidHookType(a_Hook))
+	{
+		LOGWARN("Called cPluginManager::AddHook() with an invalid hook type %d", a_Hook);
+		return;
+	}
 	PluginList & Plugins = m_Hooks[a_Hook];
 	Plugins.remove(a_Plugin);
 	Plugins.push_back(a_Plugin);
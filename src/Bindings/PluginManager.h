@@ -4,6 +4,8 @@
 
 #include "Defines.h"
 
+#include <atomic>
+
 
 
 class cPlugin;
@@ -51,6 +53,26 @@ class cItems;
 
 
 
+
+
+/** A single player's movement within a world tick, as delivered to the batched HOOK_PLAYERS_MOVED hook. */
+struct sPlayerMove
+{
+	cPlayer * m_Player;
+
+	/** The UniqueID of m_Player, to recognize a player removed from the world during the tick */
+	int m_PlayerID;
+
+	Vector3d m_OldPosition;
+	Vector3d m_NewPosition;
+} ;
+
+typedef std::vector<sPlayerMove> cPlayerMoves;
+
+
+
+
+
 // tolua_begin
 class cPluginManager
 {
@@ -114,6 +136,7 @@ public:
 		HOOK_PLAYER_USED_ITEM,
 		HOOK_PLAYER_USING_BLOCK,
 		HOOK_PLAYER_USING_ITEM,
+		HOOK_PLAYERS_MOVED,
 		HOOK_PLUGIN_MESSAGE,
 		HOOK_PLUGINS_LOADED,
 		HOOK_POST_CRAFTING,
@@ -143,6 +166,18 @@ public:
 	} ;
 	// tolua_end
 
+	/** The call statistics of a single hook type. Only the calls that had any plugin to call are counted. */
+	struct sHookStats
+	{
+		/** Number of the hook calls */
+		std::atomic<UInt64> m_NumCalls;
+
+		/** Total time spent in the plugins' handlers, in microseconds */
+		std::atomic<UInt64> m_TotalUSec;
+
+		sHookStats(void) : m_NumCalls(0), m_TotalUSec(0) {}
+	} ;
+
 	/** Used as a callback for enumerating bound commands */
 	class cCommandEnumCallback
 	{
@@ -176,6 +211,22 @@ public:
 	void AddHook(cPlugin * a_Plugin, int a_HookType);
 
 	size_t GetNumPlugins() const;  // tolua_export
+
+	/** Returns true if any plugin has registered a handler for the specified hook type.
+	Cheap enough to be called before preparing the data for a high-rate or batched hook. */
+	bool IsHookUsed(PluginHook a_HookType) const { return !m_Hooks[a_HookType].empty(); }
+
+	/** Outputs the call counts and times of all the hooks that have been called, used by the "hookstats" console command. */
+	void LogHookStats(cCommandOutputCallback & a_Output);
+
+	/** Runs the plugins' garbage collection, within the budget set in settings.ini ([Plugins] LuaGCBudgetUSec).
+	Called once per server tick from cServer::Tick(), in the same thread that loads and unloads the plugins.
+	The budget is shared by all the plugins, the order in which they are collected rotates so that each gets its turn
+	at the start. If the budget is zero, returns the plugins to Lua's automatic collector. */
+	void StepPluginsGC(void);
+
+	/** Outputs the memory usage and GC statistics of all plugins, used by the "pluginmem" console command. */
+	void LogMemoryStats(cCommandOutputCallback & a_Output);
 	
 	// Calls for individual hooks. Each returns false if the action is to continue or true if the plugin wants to abort
 	bool CallHookBlockSpread              (cWorld & a_World, int a_BlockX, int a_BlockY, int a_BlockZ, eSpreadSource a_Source);
@@ -220,6 +271,7 @@ public:
 	bool CallHookPlayerUsedItem           (cPlayer & a_Player, int a_BlockX, int a_BlockY, int a_BlockZ, char a_BlockFace, int a_CursorX, int a_CursorY, int a_CursorZ);
 	bool CallHookPlayerUsingBlock         (cPlayer & a_Player, int a_BlockX, int a_BlockY, int a_BlockZ, char a_BlockFace, int a_CursorX, int a_CursorY, int a_CursorZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta);
 	bool CallHookPlayerUsingItem          (cPlayer & a_Player, int a_BlockX, int a_BlockY, int a_BlockZ, char a_BlockFace, int a_CursorX, int a_CursorY, int a_CursorZ);
+	bool CallHookPlayersMoved             (cWorld & a_World, const cPlayerMoves & a_Moves);
 	bool CallHookPluginMessage            (cClientHandle & a_Client, const AString & a_Channel, const AString & a_Message);
 	bool CallHookPluginsLoaded            (void);
 	bool CallHookPostCrafting             (cPlayer & a_Player, cCraftingGrid & a_Grid, cCraftingRecipe & a_Recipe);
@@ -311,12 +363,27 @@ private:
 		AString   m_HelpString;
 	} ;
 	
-	typedef std::map<int, cPluginManager::PluginList> HookMap;
 	typedef std::map<AString, cCommandReg> CommandMap;
 
 	PluginList m_DisablePluginList;
 	PluginMap  m_Plugins;
-	HookMap    m_Hooks;
+
+	/** The plugins registered for each hook type, indexed by the hook type */
+	PluginList m_Hooks[HOOK_NUM_HOOKS];
+
+	/** The call statistics of each hook type, indexed by the hook type */
+	sHookStats m_HookStats[HOOK_NUM_HOOKS];
+
+	/** The time that the plugins' garbage collection may take in each server tick. Zero means Lua's automatic GC is used. */
+	std::chrono::microseconds m_GCBudget;
+
+	/** Index of the plugin to be collected first in the next StepPluginsGC() call. */
+	size_t m_GCNextPlugin;
+
+	/** True if StepPluginsGC() has collected the plugins, so they need to be returned to the automatic collector
+	once the budget is set to zero. */
+	bool m_IsManualGC;
+
 	CommandMap m_Commands;
 	CommandMap m_ConsoleCommands;
 
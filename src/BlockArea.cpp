@@ -781,6 +781,166 @@ void cBlockArea::Fill(int a_DataTypes, BLOCKTYPE a_BlockType, NIBBLETYPE a_Block
 
 
 
+int cBlockArea::CountBlocks(BLOCKTYPE a_BlockType, int a_BlockMeta) const
+{
+	if (m_BlockTypes == nullptr)
+	{
+		LOGWARNING("%s: BlockTypes have not been read!", __FUNCTION__);
+		return 0;
+	}
+	
+	int res = 0;
+	size_t BlockCount = GetBlockCount();
+	if (a_BlockMeta < 0)
+	{
+		for (size_t i = 0; i < BlockCount; i++)
+		{
+			if (m_BlockTypes[i] == a_BlockType)
+			{
+				res++;
+			}
+		}
+		return res;
+	}
+	
+	if (m_BlockMetas == nullptr)
+	{
+		LOGWARNING("%s: BlockMetas have not been read!", __FUNCTION__);
+		return 0;
+	}
+	NIBBLETYPE BlockMeta = static_cast<NIBBLETYPE>(a_BlockMeta);
+	for (size_t i = 0; i < BlockCount; i++)
+	{
+		if ((m_BlockTypes[i] == a_BlockType) && (m_BlockMetas[i] == BlockMeta))
+		{
+			res++;
+		}
+	}
+	return res;
+}
+
+
+
+
+
+int cBlockArea::ReplaceBlocks(BLOCKTYPE a_FromBlockType, int a_FromBlockMeta, BLOCKTYPE a_ToBlockType, NIBBLETYPE a_ToBlockMeta)
+{
+	if (m_BlockTypes == nullptr)
+	{
+		LOGWARNING("%s: BlockTypes have not been read!", __FUNCTION__);
+		return 0;
+	}
+	if ((a_FromBlockMeta >= 0) && (m_BlockMetas == nullptr))
+	{
+		LOGWARNING("%s: BlockMetas have not been read!", __FUNCTION__);
+		return 0;
+	}
+	
+	int res = 0;
+	size_t BlockCount = GetBlockCount();
+	for (size_t i = 0; i < BlockCount; i++)
+	{
+		if (
+			(m_BlockTypes[i] != a_FromBlockType) ||
+			((a_FromBlockMeta >= 0) && (m_BlockMetas[i] != static_cast<NIBBLETYPE>(a_FromBlockMeta)))
+		)
+		{
+			continue;
+		}
+		m_BlockTypes[i] = a_ToBlockType;
+		if (m_BlockMetas != nullptr)
+		{
+			m_BlockMetas[i] = a_ToBlockMeta;
+		}
+		res++;
+	}
+	return res;
+}
+
+
+
+
+
+void cBlockArea::FindBlocks(BLOCKTYPE a_BlockType, int a_BlockMeta, size_t a_MaxCount, std::vector<Vector3i> & a_RelCoords) const
+{
+	if (m_BlockTypes == nullptr)
+	{
+		LOGWARNING("%s: BlockTypes have not been read!", __FUNCTION__);
+		return;
+	}
+	if ((a_BlockMeta >= 0) && (m_BlockMetas == nullptr))
+	{
+		LOGWARNING("%s: BlockMetas have not been read!", __FUNCTION__);
+		return;
+	}
+	
+	// Walk the array in its internal order (XZY), computing the coords incrementally:
+	size_t NumFound = 0;
+	size_t idx = 0;
+	for (int y = 0; y < m_Size.y; y++)
+	{
+		for (int z = 0; z < m_Size.z; z++)
+		{
+			for (int x = 0; x < m_Size.x; x++, idx++)
+			{
+				if (
+					(m_BlockTypes[idx] != a_BlockType) ||
+					((a_BlockMeta >= 0) && (m_BlockMetas[idx] != static_cast<NIBBLETYPE>(a_BlockMeta)))
+				)
+				{
+					continue;
+				}
+				a_RelCoords.push_back(Vector3i(x, y, z));
+				NumFound++;
+				if (NumFound >= a_MaxCount)
+				{
+					return;
+				}
+			}  // for x
+		}  // for z
+	}  // for y
+}
+
+
+
+
+
+void cBlockArea::GetBlockTypeHistogram(size_t (& a_Counts)[256]) const
+{
+	memset(a_Counts, 0, sizeof(a_Counts));
+	if (m_BlockTypes == nullptr)
+	{
+		LOGWARNING("%s: BlockTypes have not been read!", __FUNCTION__);
+		return;
+	}
+	
+	size_t BlockCount = GetBlockCount();
+	for (size_t i = 0; i < BlockCount; i++)
+	{
+		a_Counts[m_BlockTypes[i]] += 1;
+	}
+}
+
+
+
+
+
+Byte * cBlockArea::GetDataArray(int a_DataType) const
+{
+	switch (a_DataType)
+	{
+		case baTypes:    return m_BlockTypes;
+		case baMetas:    return m_BlockMetas;
+		case baLight:    return m_BlockLight;
+		case baSkyLight: return m_BlockSkyLight;
+	}
+	return nullptr;
+}
+
+
+
+
+
 void cBlockArea::FillRelCuboid(int a_MinRelX, int a_MaxRelX, int a_MinRelY, int a_MaxRelY, int a_MinRelZ, int a_MaxRelZ,
 	int a_DataTypes, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta,
 	NIBBLETYPE a_BlockLight, NIBBLETYPE a_BlockSkyLight
@@ -228,6 +228,14 @@ public:
 	/** Mirrors the entire area around the YZ plane, doesn't use blockhandlers for block meta */
 	void MirrorYZNoMeta(void);
 	
+	/** Returns the number of blocks of the specified type in the area.
+	If a_BlockMeta is not negative, only the blocks with that meta are counted (the area needs to have the metas). */
+	int CountBlocks(BLOCKTYPE a_BlockType, int a_BlockMeta = -1) const;
+	
+	/** Replaces all the blocks of type a_FromBlockType (and meta a_FromBlockMeta, unless negative) with the specified block.
+	The meta is only written if the area has the metas. Returns the number of blocks replaced. */
+	int ReplaceBlocks(BLOCKTYPE a_FromBlockType, int a_FromBlockMeta, BLOCKTYPE a_ToBlockType, NIBBLETYPE a_ToBlockMeta = 0);
+	
 	// Setters:
 	void SetRelBlockType    (int a_RelX,   int a_RelY,   int a_RelZ,   BLOCKTYPE  a_BlockType);
 	void SetBlockType       (int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE  a_BlockType);
@@ -298,6 +306,17 @@ public:
 	size_t       GetBlockCount(void) const { return (size_t)(m_Size.x * m_Size.y * m_Size.z); }
 	int MakeIndex(int a_RelX, int a_RelY, int a_RelZ) const;
 
+	/** Appends the relative coords of the blocks of the specified type (and meta, unless negative) to a_RelCoords,
+	in the order of the internal arrays. Stops after a_MaxCount blocks have been found. Exported manually. */
+	void FindBlocks(BLOCKTYPE a_BlockType, int a_BlockMeta, size_t a_MaxCount, std::vector<Vector3i> & a_RelCoords) const;
+	
+	/** Fills a_Counts with the number of blocks of each block type in the area. Exported manually. */
+	void GetBlockTypeHistogram(size_t (& a_Counts)[256]) const;
+	
+	/** Returns the internal array for the specified datatype (one of baTypes, baMetas, baLight, baSkyLight),
+	or nullptr if the area doesn't have that datatype. The array has GetBlockCount() bytes, indexed by MakeIndex(). */
+	Byte * GetDataArray(int a_DataType) const;
+
 protected:
 	friend class cChunkDesc;
 	friend class cSchematicFileSerializer;
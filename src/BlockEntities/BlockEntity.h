@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <atomic>
+
 
 
 
@@ -47,7 +49,8 @@ protected:
 		m_RelX(a_BlockX - cChunkDef::Width * FAST_FLOOR_DIV(a_BlockX, cChunkDef::Width)),
 		m_RelZ(a_BlockZ - cChunkDef::Width * FAST_FLOOR_DIV(a_BlockZ, cChunkDef::Width)),
 		m_BlockType(a_BlockType),
-		m_World(a_World)
+		m_World(a_World),
+		m_WakeUpTick(0)
 	{
 	}
 
@@ -116,6 +119,14 @@ public:
 		return false;
 	}
 
+	/** Returns true if the entity is sleeping in the specified world tick; the chunk doesn't tick sleeping entities.
+	An entity puts itself to sleep from within its Tick() when it is idle, using SleepUntil() or SleepIndefinitely(). */
+	bool IsSleeping(Int64 a_WorldAge) const { return (a_WorldAge < m_WakeUpTick); }
+
+	/** Makes the entity tick again from the next chunk tick on.
+	Called by the chunk when something changes around the entity (blocks or neighbors' contents), and by the entity itself on its own changes. */
+	void WakeUp(void) { m_WakeUpTick = 0; }
+
 protected:
 	/// Position in absolute block coordinates
 	int m_PosX, m_PosY, m_PosZ;
@@ -126,6 +137,16 @@ protected:
 	BLOCKTYPE m_BlockType;
 	
 	cWorld * m_World;
+
+	/** The world age at which a sleeping entity starts ticking again; zero if not sleeping.
+	Atomic, because WakeUp() may be called from other threads than the one ticking the chunk. */
+	std::atomic<Int64> m_WakeUpTick;
+
+	/** Stops ticking the entity until the specified world age, unless woken up sooner */
+	void SleepUntil(Int64 a_WorldAge) { m_WakeUpTick = a_WorldAge; }
+
+	/** Stops ticking the entity until it is woken up by a change around it */
+	void SleepIndefinitely(void) { m_WakeUpTick = std::numeric_limits<Int64>::max(); }
 } ;  // tolua_export
 
 
@@ -86,6 +86,9 @@ protected:
 			}
 
 			m_World->MarkChunkDirty(GetChunkX(), GetChunkZ());
+
+			// Wake up this entity and the ones around, such as the hoppers pulling from or pushing into this one:
+			m_World->WakeUpBlockEntitiesAround(m_PosX, m_PosY, m_PosZ);
 		}
 	}
 } ;  // tolua_export
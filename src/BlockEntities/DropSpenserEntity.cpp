@@ -106,6 +106,7 @@ void cDropSpenserEntity::DropSpense(cChunk & a_Chunk)
 void cDropSpenserEntity::Activate(void)
 {
 	m_ShouldDropSpense = true;
+	WakeUp();
 }
 
 
@@ -130,6 +131,8 @@ bool cDropSpenserEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 	UNUSED(a_Dt);
 	if (!m_ShouldDropSpense)
 	{
+		// Nothing to do until activated by redstone or a plugin
+		SleepIndefinitely();
 		return false;
 	}
 	
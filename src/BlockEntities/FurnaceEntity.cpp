@@ -102,6 +102,13 @@ bool cFurnaceEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 		// Reset progressbars, block type, and bail out
 		m_BlockType = E_BLOCK_FURNACE;
 		a_Chunk.FastSetBlock(GetRelX(), m_PosY, GetRelZ(), E_BLOCK_FURNACE, m_BlockMeta);
+		if (m_TimeCooked == 0)
+		{
+			// Fully cooled down, nothing will happen until the contents change:
+			UpdateProgressBars(true);
+			SleepIndefinitely();
+			return false;
+		}
 		UpdateProgressBars();
 		return false;
 	}
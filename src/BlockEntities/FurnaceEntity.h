@@ -93,12 +93,14 @@ public:
 	{
 		m_FuelBurnTime = a_FuelBurnTime;
 		m_TimeBurned = a_TimeBurned;
+		WakeUp();
 	}
 
 	void SetCookTimes(int a_NeedCookTime, int a_TimeCooked)
 	{
 		m_NeedCookTime = a_NeedCookTime;
 		m_TimeCooked = a_TimeCooked;
+		WakeUp();
 	}
 	
 protected:
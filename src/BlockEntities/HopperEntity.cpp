@@ -6,6 +6,7 @@
 #include "Globals.h"
 #include "HopperEntity.h"
 #include "../Chunk.h"
+#include "../BoundingBox.h"
 #include "../Entities/Player.h"
 #include "../Entities/Pickup.h"
 #include "../Bindings/PluginManager.h"
@@ -63,6 +64,19 @@ bool cHopperEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 	res = MoveItemsIn  (a_Chunk, CurrentTick) || res;
 	res = MovePickupsIn(a_Chunk, CurrentTick) || res;
 	res = MoveItemsOut (a_Chunk, CurrentTick) || res;
+
+	// Sleep until the earliest transfer cooldown runs out; if neither direction is cooling down, nothing could be moved
+	// and the hopper sleeps until a neighbor's contents, a block around or a pickup above changes:
+	Int64 WakeUpTick = std::numeric_limits<Int64>::max();
+	if (CurrentTick - m_LastMoveItemsInTick < TICKS_PER_TRANSFER)
+	{
+		WakeUpTick = std::min(WakeUpTick, m_LastMoveItemsInTick + TICKS_PER_TRANSFER);
+	}
+	if (CurrentTick - m_LastMoveItemsOutTick < TICKS_PER_TRANSFER)
+	{
+		WakeUpTick = std::min(WakeUpTick, m_LastMoveItemsOutTick + TICKS_PER_TRANSFER);
+	}
+	SleepUntil(WakeUpTick);
 	return res;
 }
 
@@ -262,8 +276,10 @@ bool cHopperEntity::MovePickupsIn(cChunk & a_Chunk, Int64 a_CurrentTick)
 		cItemGrid & m_Contents;
 	};
 
+	// Only the pickups right above the hopper can be sucked in, look them up in the chunk's pickup index:
 	cHopperPickupSearchCallback HopperPickupSearchCallback(Vector3i(GetPosX(), GetPosY(), GetPosZ()), m_Contents);
-	a_Chunk.ForEachEntity(HopperPickupSearchCallback);
+	cBoundingBox SearchBox(m_PosX, m_PosX + 1, m_PosY + 0.5, m_PosY + 1.5, m_PosZ, m_PosZ + 1);
+	a_Chunk.ForEachPickupInBox(SearchBox, E_ITEM_EMPTY, HopperPickupSearchCallback);
 
 	return HopperPickupSearchCallback.FoundPickupsAbove();
 }
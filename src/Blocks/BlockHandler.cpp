@@ -443,7 +443,7 @@ void cBlockHandler::DropBlock(cChunkInterface & a_ChunkInterface, cWorldInterfac
 
 	if (a_CanDrop)
 	{
-		if ((a_Digger != nullptr) && (a_Digger->GetEquippedWeapon().m_Enchantments.GetLevel(cEnchantments::enchSilkTouch) > 0))
+		if ((a_Digger != nullptr) && (a_Digger->GetEquippedWeapon().GetEnchantments().GetLevel(cEnchantments::enchSilkTouch) > 0))
 		{
 			switch (m_BlockType)
 			{
@@ -31,7 +31,7 @@ public:
 			return;
 		}
 		
-		cEnchantments Enchantments = a_Player->GetInventory().GetEquippedItem().m_Enchantments;
+		cEnchantments Enchantments = a_Player->GetInventory().GetEquippedItem().GetEnchantments();
 		if (Enchantments.GetLevel(cEnchantments::enchSilkTouch) == 0)
 		{
 			BLOCKTYPE BlockBelow = a_ChunkInterface.GetBlock(a_BlockX, a_BlockY - 1, a_BlockZ);
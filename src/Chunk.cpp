@@ -39,6 +39,7 @@
 #include "SetChunkData.h"
 #include "BoundingBox.h"
 #include "Blocks/ChunkInterface.h"
+#include "Map.h"
 
 #include "json/json.h"
 
@@ -66,6 +67,12 @@ sSetBlock::sSetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_Block
 ////////////////////////////////////////////////////////////////////////////////
 // cChunk:
 
+const Byte cChunk::MAP_COLOR_INVALID;
+
+
+
+
+
 cChunk::cChunk(
 	int a_ChunkX, int a_ChunkZ,
 	cChunkMap * a_ChunkMap, cWorld * a_World,
@@ -77,8 +84,13 @@ cChunk::cChunk(
 	m_IsLightValid(false),
 	m_IsDirty(false),
 	m_IsSaving(false),
+	m_IsQueuedForSave(false),
 	m_HasLoadFailed(false),
+	m_DirtySince(0),
+	m_UnusedSince(a_World->GetWorldAge()),
 	m_StayCount(0),
+	m_NumEntityIterations(0),
+	m_HasEmptyEntitySlots(false),
 	m_PosX(a_ChunkX),
 	m_PosZ(a_ChunkZ),
 	m_World(a_World),
@@ -130,13 +142,14 @@ cChunk::~cChunk()
 		delete *itr;
 	}
 	m_BlockEntities.clear();
+	m_BlockEntityIndex.clear();
 
 	// Remove and destroy all entities that are not players:
-	cEntityList Entities;
+	cEntityVector Entities;
 	std::swap(Entities, m_Entities);  // Need another list because cEntity destructors check if they've been removed from chunk
-	for (cEntityList::const_iterator itr = Entities.begin(); itr != Entities.end(); ++itr)
+	for (cEntityVector::const_iterator itr = Entities.begin(); itr != Entities.end(); ++itr)
 	{
-		if (!(*itr)->IsPlayer())
+		if ((*itr != nullptr) && !(*itr)->IsPlayer())
 		{
 			(*itr)->Destroy(false);
 			delete *itr;
@@ -225,6 +238,7 @@ bool cChunk::CanUnload(void)
 void cChunk::MarkSaving(void)
 {
 	m_IsSaving = true;
+	m_IsQueuedForSave = false;
 }
 
 
@@ -284,10 +298,15 @@ void cChunk::GetAllData(cChunkDataCallback & a_Callback)
 
 	a_Callback.ChunkData(m_ChunkData);
 	
-	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
+	BeginEntityIteration();
+	for (size_t i = 0; i < m_Entities.size(); i++)
 	{
-		a_Callback.Entity(*itr);
+		if (m_Entities[i] != nullptr)
+		{
+			a_Callback.Entity(m_Entities[i]);
+		}
 	}
+	EndEntityIteration();
 	
 	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
 	{
@@ -307,6 +326,7 @@ void cChunk::SetAllData(cSetChunkData & a_SetChunkData)
 	
 	memcpy(m_BiomeMap, a_SetChunkData.GetBiomes(), sizeof(m_BiomeMap));
 	memcpy(m_HeightMap, a_SetChunkData.GetHeightMap(), sizeof(m_HeightMap));
+	m_MapColumnColors.clear();
 
 	m_ChunkData.SetBlockTypes(a_SetChunkData.GetBlockTypes());
 	m_ChunkData.SetMetas(a_SetChunkData.GetBlockMetas());
@@ -328,6 +348,7 @@ void cChunk::SetAllData(cSetChunkData & a_SetChunkData)
 	}
 	m_BlockEntities.clear();
 	std::swap(a_SetChunkData.GetBlockEntities(), m_BlockEntities);
+	RebuildBlockEntityIndex();
 
 	// Check that all block entities have a valid blocktype at their respective coords (DEBUG-mode only):
 	#ifdef _DEBUG
@@ -445,18 +466,92 @@ void cChunk::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlock
 /// Returns true if there is a block entity at the coords specified
 bool cChunk::HasBlockEntityAt(int a_BlockX, int a_BlockY, int a_BlockZ)
 {
-	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
+	return (GetBlockEntity(a_BlockX, a_BlockY, a_BlockZ) != nullptr);
+}
+
+
+
+
+
+void cChunk::WakeUpBlockEntitiesInArea(int a_MinBlockX, int a_MaxBlockX, int a_MinBlockY, int a_MaxBlockY, int a_MinBlockZ, int a_MaxBlockZ)
+{
+	// Most chunks have no block entities at all, this is called for each block change:
+	if (m_BlockEntityIndex.empty())
 	{
-		if (
-			((*itr)->GetPosX() == a_BlockX) &&
-			((*itr)->GetPosY() == a_BlockY) &&
-			((*itr)->GetPosZ() == a_BlockZ)
-		)
+		return;
+	}
+
+	// Clip the area to this chunk, in relative coords:
+	int MinRelX = std::max(a_MinBlockX - m_PosX * Width, 0);
+	int MaxRelX = std::min(a_MaxBlockX - m_PosX * Width, Width - 1);
+	int MinRelZ = std::max(a_MinBlockZ - m_PosZ * Width, 0);
+	int MaxRelZ = std::min(a_MaxBlockZ - m_PosZ * Width, Width - 1);
+	int MinY = std::max(a_MinBlockY, 0);
+	int MaxY = std::min(a_MaxBlockY, Height - 1);
+	if ((MinRelX > MaxRelX) || (MinRelZ > MaxRelZ) || (MinY > MaxY))
+	{
+		return;
+	}
+
+	// For large areas, such as a whole chunk border, walking all the block entities is faster than looking up each row:
+	size_t NumRows = static_cast<size_t>((MaxY - MinY + 1) * (MaxRelZ - MinRelZ + 1));
+	if (NumRows > m_BlockEntityIndex.size())
+	{
+		for (std::map<int, cBlockEntity *>::iterator itr = m_BlockEntityIndex.begin(), end = m_BlockEntityIndex.end(); itr != end; ++itr)
 		{
-			return true;
-		}
-	}  // for itr - m_BlockEntities[]
-	return false;
+			cBlockEntity * BlockEntity = itr->second;
+			if (
+				(BlockEntity->GetRelX() >= MinRelX) && (BlockEntity->GetRelX() <= MaxRelX) &&
+				(BlockEntity->GetPosY() >= MinY)    && (BlockEntity->GetPosY() <= MaxY) &&
+				(BlockEntity->GetRelZ() >= MinRelZ) && (BlockEntity->GetRelZ() <= MaxRelZ)
+			)
+			{
+				BlockEntity->WakeUp();
+			}
+		}  // for itr - m_BlockEntityIndex[]
+		return;
+	}
+
+	// Look up each row of X coords in the index:
+	for (int y = MinY; y <= MaxY; y++)
+	{
+		for (int z = MinRelZ; z <= MaxRelZ; z++)
+		{
+			int LastKey = GetBlockEntityKey(MaxRelX, y, z);
+			std::map<int, cBlockEntity *>::iterator itr = m_BlockEntityIndex.lower_bound(GetBlockEntityKey(MinRelX, y, z));
+			for (std::map<int, cBlockEntity *>::iterator end = m_BlockEntityIndex.end(); (itr != end) && (itr->first <= LastKey); ++itr)
+			{
+				itr->second->WakeUp();
+			}
+		}  // for z
+	}  // for y
+}
+
+
+
+
+
+void cChunk::WakeUpBlockEntitiesAround(int a_RelX, int a_RelY, int a_RelZ)
+{
+	// The area spans into the neighbors only near the chunk's borders:
+	int MinNeighborX = (a_RelX < 2) ? -1 : 0;
+	int MaxNeighborX = (a_RelX >= Width - 2) ? 1 : 0;
+	int MinNeighborZ = (a_RelZ < 2) ? -1 : 0;
+	int MaxNeighborZ = (a_RelZ >= Width - 2) ? 1 : 0;
+	int BlockX = m_PosX * Width + a_RelX;
+	int BlockZ = m_PosZ * Width + a_RelZ;
+	for (int z = MinNeighborZ; z <= MaxNeighborZ; z++)
+	{
+		for (int x = MinNeighborX; x <= MaxNeighborX; x++)
+		{
+			cChunk * Chunk = ((x == 0) && (z == 0)) ? this : GetRelNeighborChunk(a_RelX + x * Width, a_RelZ + z * Width);
+			if ((Chunk == nullptr) || !Chunk->IsValid())
+			{
+				continue;
+			}
+			Chunk->WakeUpBlockEntitiesInArea(BlockX - 2, BlockX + 2, a_RelY - 1, a_RelY + 1, BlockZ - 2, BlockZ + 2);
+		}  // for x - neighbors
+	}  // for z - neighbors
 }
 
 
@@ -467,6 +562,10 @@ void cChunk::Stay(bool a_Stay)
 {
 	m_StayCount += (a_Stay ? 1 : -1);
 	ASSERT(m_StayCount >= 0);
+	if (IsUnused())
+	{
+		m_UnusedSince = m_World->GetWorldAge();
+	}
 }
 
 
@@ -484,10 +583,10 @@ void cChunk::CollectMobCensus(cMobCensus& toFill)
 	}
 
 	Vector3d currentPosition;
-	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
+	for (cEntityVector::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
 	{
 		// LOGD("Counting entity #%i (%s)", (*itr)->GetUniqueID(), (*itr)->GetClass());
-		if ((*itr)->IsMob())
+		if ((*itr != nullptr) && (*itr)->IsMob())
 		{
 			cMonster& Monster = (cMonster&)(**itr);
 			currentPosition = Monster.GetPosition();
@@ -615,50 +714,88 @@ void cChunk::Tick(std::chrono::milliseconds a_Dt)
 	
 	TickBlocks();
 
-	// Tick all block entities in this chunk:
+	// The pickups have moved since the last tick, the pickup index needs rebuilding before use:
+	m_PickupIndex.Invalidate();
+
+	// Tick all block entities in this chunk, except for the sleeping ones:
+	Int64 WorldAge = m_World->GetWorldAge();
 	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
 	{
+		if ((*itr)->IsSleeping(WorldAge))
+		{
+			continue;
+		}
 		m_IsDirty = (*itr)->Tick(a_Dt, *this) | m_IsDirty;
 	}
 	
-	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end();)
+	// The destroyed entities are deleted only after all entities have ticked, so that the pickup index stays valid during the loop:
+	cEntityVector ToDelete;
+	bool HasRemovedEntities = false;
+	BeginEntityIteration();
+	for (size_t i = 0; i < m_Entities.size(); i++)
 	{
-		if (!((*itr)->IsMob()))  // Mobs are ticked inside cWorld::TickMobs() (as we don't have to tick them if they are far away from players)
+		cEntity * Entity = m_Entities[i];
+		if (Entity == nullptr)
+		{
+			continue;
+		}
+
+		if (!(Entity->IsMob()))  // Mobs are ticked inside cWorld::TickMobs() (as we don't have to tick them if they are far away from players)
 		{
 			// Tick all entities in this chunk (except mobs):
-			(*itr)->Tick(a_Dt, *this);
+			Entity->Tick(a_Dt, *this);
+			if (m_Entities[i] == nullptr)
+			{
+				// The entity has removed itself from the chunk while ticking
+				continue;
+			}
 		}
 
-		if ((*itr)->IsDestroyed())  // Remove all entities that were scheduled for removal:
+		if (Entity->IsDestroyed())  // Remove all entities that were scheduled for removal:
 		{
-			LOGD("Destroying entity #%i (%s)", (*itr)->GetUniqueID(), (*itr)->GetClass());
+			LOGD("Destroying entity #%i (%s)", Entity->GetUniqueID(), Entity->GetClass());
 			MarkDirty();
-			cEntity * ToDelete = *itr;
-			itr = m_Entities.erase(itr);
-			delete ToDelete;
+			m_Entities[i] = nullptr;
+			m_HasEmptyEntitySlots = true;
+			HasRemovedEntities = true;
+			ToDelete.push_back(Entity);
 		}
-		else if ((*itr)->IsWorldTravellingFrom(m_World))
+		else if (Entity->IsWorldTravellingFrom(m_World))
 		{
 			// Remove all entities that are travelling to another world
 			MarkDirty();
-			(*itr)->SetWorldTravellingFrom(nullptr);
-			itr = m_Entities.erase(itr);
+			Entity->SetWorldTravellingFrom(nullptr);
+			m_Entities[i] = nullptr;
+			m_HasEmptyEntitySlots = true;
+			HasRemovedEntities = true;
 		}
 		else if (
-			((*itr)->GetChunkX() != m_PosX) ||
-			((*itr)->GetChunkZ() != m_PosZ)
+			(Entity->GetChunkX() != m_PosX) ||
+			(Entity->GetChunkZ() != m_PosZ)
 		)
 		{
 			// The entity moved out of the chunk, move it to the neighbor
 			MarkDirty();
-			MoveEntityToNewChunk(*itr);
-			itr = m_Entities.erase(itr);
+			m_Entities[i] = nullptr;
+			m_HasEmptyEntitySlots = true;
+			HasRemovedEntities = true;
+			MoveEntityToNewChunk(Entity);
 		}
-		else
+	}  // for i - m_Entitites[]
+	EndEntityIteration();
+
+	// The removed entities may be deleted by their new chunk or world at any time, they mustn't stay in the pickup index:
+	if (HasRemovedEntities)
+	{
+		m_PickupIndex.Invalidate();
+	}
+	if (!ToDelete.empty())
+	{
+		for (cEntityVector::iterator itr = ToDelete.begin(); itr != ToDelete.end(); ++itr)
 		{
-			++itr;
+			delete *itr;
 		}
-	}  // for itr - m_Entitites[]
+	}
 	
 	ApplyWeatherToTop();
 }
@@ -1323,6 +1460,40 @@ int cChunk::GetHeight(int a_X, int a_Z)
 
 
 
+
+Byte cChunk::GetMapColumnColor(int a_RelX, int a_RelZ)
+{
+	ASSERT((a_RelX >= 0) && (a_RelX < Width) && (a_RelZ >= 0) && (a_RelZ < Width));
+
+	if (m_MapColumnColors.empty())
+	{
+		m_MapColumnColors.assign(Width * Width, MAP_COLOR_INVALID);
+	}
+	Byte & Color = m_MapColumnColors[static_cast<size_t>(a_RelX + a_RelZ * Width)];
+	if (Color != MAP_COLOR_INVALID)
+	{
+		return Color;
+	}
+
+	// Walk down from the heightmap to the first non-air block:
+	BLOCKTYPE BlockType = E_BLOCK_AIR;
+	NIBBLETYPE BlockMeta = 0;
+	for (int y = m_HeightMap[a_RelX + a_RelZ * Width]; y > 0; --y)
+	{
+		GetBlockTypeMeta(a_RelX, y, a_RelZ, BlockType, BlockMeta);
+		if (BlockType != E_BLOCK_AIR)
+		{
+			break;
+		}
+	}
+	Color = cMap::GetBlockColor(BlockType, BlockMeta);
+	return Color;
+}
+
+
+
+
+
 void cChunk::CreateBlockEntities(void)
 {
 	for (int x = 0; x < Width; x++)
@@ -1354,10 +1525,12 @@ void cChunk::CreateBlockEntities(void)
 					{
 						if (!HasBlockEntityAt(x + m_PosX * Width, y, z + m_PosZ * Width))
 						{
-							m_BlockEntities.push_back(cBlockEntity::CreateByBlockType(
+							cBlockEntity * BlockEntity = cBlockEntity::CreateByBlockType(
 								BlockType, GetMeta(x, y, z),
 								x + m_PosX * Width, y, z + m_PosZ * Width, m_World
-							));
+							);
+							m_BlockEntities.push_back(BlockEntity);
+							m_BlockEntityIndex[GetBlockEntityKey(x, y, z)] = BlockEntity;
 						}
 						break;
 					}
@@ -1371,6 +1544,15 @@ void cChunk::CreateBlockEntities(void)
 
 
 
+void cChunk::StartDirtyPeriod(void)
+{
+	m_DirtySince = m_World->GetWorldAge();
+}
+
+
+
+
+
 void cChunk::WakeUpSimulators(void)
 {
 	cSimulator * WaterSimulator = m_World->GetWaterSimulator();
@@ -1563,6 +1745,11 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 
 	MarkDirty();
 	m_IsRedstoneDirty = true;
+	InvalidateMapColumnColor(a_RelX, a_RelZ);
+
+	// Let the block entities around react to the change, such as hoppers getting a new container to pull from.
+	// All the block writes (SetBlock(), explosions, block areas) end up here:
+	WakeUpBlockEntitiesAround(a_RelX, a_RelY, a_RelZ);
 
 	m_ChunkData.SetBlock(a_RelX, a_RelY, a_RelZ, a_BlockType);
 
@@ -1657,6 +1844,7 @@ void cChunk::AddBlockEntity(cBlockEntity * a_BlockEntity)
 {
 	MarkDirty();
 	m_BlockEntities.push_back(a_BlockEntity);
+	m_BlockEntityIndex[GetBlockEntityKey(a_BlockEntity->GetRelX(), a_BlockEntity->GetPosY(), a_BlockEntity->GetRelZ())] = a_BlockEntity;
 }
 
 
@@ -1671,19 +1859,12 @@ cBlockEntity * cChunk::GetBlockEntity(int a_BlockX, int a_BlockY, int a_BlockZ)
 	ASSERT(a_BlockZ >= m_PosZ * cChunkDef::Width);
 	ASSERT(a_BlockZ < m_PosZ * cChunkDef::Width + cChunkDef::Width);
 
-	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
+	if ((a_BlockY < 0) || (a_BlockY >= Height))
 	{
-		if (
-			((*itr)->GetPosX() == a_BlockX) &&
-			((*itr)->GetPosY() == a_BlockY) &&
-			((*itr)->GetPosZ() == a_BlockZ)
-		)
-		{
-			return *itr;
-		}
-	}  // for itr - m_BlockEntities[]
-	
-	return nullptr;
+		return nullptr;
+	}
+	std::map<int, cBlockEntity *>::const_iterator itr = m_BlockEntityIndex.find(GetBlockEntityKey(a_BlockX - m_PosX * Width, a_BlockY, a_BlockZ - m_PosZ * Width));
+	return (itr == m_BlockEntityIndex.end()) ? nullptr : itr->second;
 }
 
 
@@ -1766,42 +1947,45 @@ void cChunk::CollectPickupsByPlayer(cPlayer & a_Player)
 	double PosY = a_Player.GetPosY();
 	double PosZ = a_Player.GetPosZ();
 	
-	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
+	BeginEntityIteration();
+	for (size_t i = 0; i < m_Entities.size(); i++)
 	{
-		if ((!(*itr)->IsPickup()) && (!(*itr)->IsProjectile()))
+		cEntity * Entity = m_Entities[i];
+		if ((Entity == nullptr) || ((!Entity->IsPickup()) && (!Entity->IsProjectile())))
 		{
 			continue;  // Only pickups and projectiles can be picked up
 		}
-		float DiffX = (float)((*itr)->GetPosX() - PosX);
-		float DiffY = (float)((*itr)->GetPosY() - PosY);
-		float DiffZ = (float)((*itr)->GetPosZ() - PosZ);
+		float DiffX = (float)(Entity->GetPosX() - PosX);
+		float DiffY = (float)(Entity->GetPosY() - PosY);
+		float DiffZ = (float)(Entity->GetPosZ() - PosZ);
 		float SqrDist = DiffX * DiffX + DiffY * DiffY + DiffZ * DiffZ;
 		if (SqrDist < 1.5f * 1.5f)  // 1.5 block
 		{
 			/*
 			LOG("Pickup %d being collected by player \"%s\", distance %f",
-				(*itr)->GetUniqueID(), a_Player->GetName().c_str(), SqrDist
+				Entity->GetUniqueID(), a_Player->GetName().c_str(), SqrDist
 			);
 			*/
 			MarkDirty();
-			if ((*itr)->IsPickup())
+			if (Entity->IsPickup())
 			{
-				(reinterpret_cast<cPickup *>(*itr))->CollectedBy(a_Player);
+				(reinterpret_cast<cPickup *>(Entity))->CollectedBy(a_Player);
 			}
 			else
 			{
-				(reinterpret_cast<cProjectileEntity *>(*itr))->CollectedBy(a_Player);
+				(reinterpret_cast<cProjectileEntity *>(Entity))->CollectedBy(a_Player);
 			}
 		}
 		else if (SqrDist < 5 * 5)
 		{
 			/*
 			LOG("Pickup %d close to player \"%s\", but still too far to collect: %f",
-				(*itr)->GetUniqueID(), a_Player->GetName().c_str(), SqrDist
+				Entity->GetUniqueID(), a_Player->GetName().c_str(), SqrDist
 			);
 			*/
 		}
-	}
+	}  // for i - m_Entities[]
+	EndEntityIteration();
 }
 
 
@@ -1840,6 +2024,24 @@ void cChunk::RemoveBlockEntity( cBlockEntity* a_BlockEntity)
 {
 	MarkDirty();
 	m_BlockEntities.remove(a_BlockEntity);
+	std::map<int, cBlockEntity *>::iterator itr = m_BlockEntityIndex.find(GetBlockEntityKey(a_BlockEntity->GetRelX(), a_BlockEntity->GetPosY(), a_BlockEntity->GetRelZ()));
+	if ((itr != m_BlockEntityIndex.end()) && (itr->second == a_BlockEntity))
+	{
+		m_BlockEntityIndex.erase(itr);
+	}
+}
+
+
+
+
+
+void cChunk::RebuildBlockEntityIndex(void)
+{
+	m_BlockEntityIndex.clear();
+	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(), end = m_BlockEntities.end(); itr != end; ++itr)
+	{
+		m_BlockEntityIndex[GetBlockEntityKey((*itr)->GetRelX(), (*itr)->GetPosY(), (*itr)->GetRelZ())] = *itr;
+	}
 }
 
 
@@ -1858,8 +2060,12 @@ bool cChunk::AddClient(cClientHandle * a_Client)
 	}
 	m_LoadedByClient.push_back( a_Client);
 
-	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
+	for (cEntityVector::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
 	{
+		if (*itr == nullptr)
+		{
+			continue;
+		}
 		/*
 		// DEBUG:
 		LOGD("cChunk: Entity #%d (%s) at [%i, %i, %i] spawning for player \"%s\"",
@@ -1887,11 +2093,19 @@ void cChunk::RemoveClient(cClientHandle * a_Client)
 		}
 
 		m_LoadedByClient.erase(itrC);
+		if (IsUnused())
+		{
+			m_UnusedSince = m_World->GetWorldAge();
+		}
 
 		if (!a_Client->IsDestroyed())
 		{
-			for (cEntityList::iterator itrE = m_Entities.begin(); itrE != m_Entities.end(); ++itrE)
+			for (cEntityVector::iterator itrE = m_Entities.begin(); itrE != m_Entities.end(); ++itrE)
 			{
+				if (*itrE == nullptr)
+				{
+					continue;
+				}
 				/*
 				// DEBUG:
 				LOGD("chunk [%i, %i] destroying entity #%i for player \"%s\"",
@@ -1945,6 +2159,10 @@ void cChunk::AddEntity(cEntity * a_Entity)
 	ASSERT(std::find(m_Entities.begin(), m_Entities.end(), a_Entity) == m_Entities.end());  // Not there already
 
 	m_Entities.push_back(a_Entity);
+	if (a_Entity->IsPickup())
+	{
+		m_PickupIndex.Invalidate();
+	}
 }
 
 
@@ -1953,7 +2171,24 @@ void cChunk::AddEntity(cEntity * a_Entity)
 
 void cChunk::RemoveEntity(cEntity * a_Entity)
 {
-	m_Entities.remove(a_Entity);
+	cEntityVector::iterator itr = std::find(m_Entities.begin(), m_Entities.end(), a_Entity);
+	if (itr != m_Entities.end())
+	{
+		if (a_Entity->IsPickup())
+		{
+			m_PickupIndex.Invalidate();
+		}
+		if (m_NumEntityIterations > 0)
+		{
+			// The entities are being iterated, only empty the slot, EndEntityIteration() will erase it:
+			*itr = nullptr;
+			m_HasEmptyEntitySlots = true;
+		}
+		else
+		{
+			m_Entities.erase(itr);
+		}
+	}
 
 	// Mark as dirty if it was a server-generated entity:
 	if (!a_Entity->IsPlayer())
@@ -1966,11 +2201,26 @@ void cChunk::RemoveEntity(cEntity * a_Entity)
 
 
 
+void cChunk::EndEntityIteration(void)
+{
+	ASSERT(m_NumEntityIterations > 0);
+	m_NumEntityIterations -= 1;
+	if ((m_NumEntityIterations == 0) && m_HasEmptyEntitySlots)
+	{
+		m_Entities.erase(std::remove(m_Entities.begin(), m_Entities.end(), nullptr), m_Entities.end());
+		m_HasEmptyEntitySlots = false;
+	}
+}
+
+
+
+
+
 bool cChunk::HasEntity(int a_EntityID)
 {
-	for (cEntityList::const_iterator itr = m_Entities.begin(), end = m_Entities.end(); itr != end; ++itr)
+	for (cEntityVector::const_iterator itr = m_Entities.begin(), end = m_Entities.end(); itr != end; ++itr)
 	{
-		if ((*itr)->GetUniqueID() == a_EntityID)
+		if ((*itr != nullptr) && ((*itr)->GetUniqueID() == a_EntityID))
 		{
 			return true;
 		}
@@ -1985,15 +2235,18 @@ bool cChunk::HasEntity(int a_EntityID)
 bool cChunk::ForEachEntity(cEntityCallback & a_Callback)
 {
 	// The entity list is locked by the parent chunkmap's CS
-	for (cEntityList::iterator itr = m_Entities.begin(), itr2 = itr; itr != m_Entities.end(); itr = itr2)
+	bool Result = true;
+	BeginEntityIteration();
+	for (size_t i = 0; i < m_Entities.size(); i++)
 	{
-		++itr2;
-		if (a_Callback.Item(*itr))
+		if ((m_Entities[i] != nullptr) && a_Callback.Item(m_Entities[i]))
 		{
-			return false;
+			Result = false;
+			break;
 		}
-	}  // for itr - m_Entitites[]
-	return true;
+	}  // for i - m_Entitites[]
+	EndEntityIteration();
+	return Result;
 }
 
 
@@ -2003,20 +2256,60 @@ bool cChunk::ForEachEntity(cEntityCallback & a_Callback)
 bool cChunk::ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback & a_Callback)
 {
 	// The entity list is locked by the parent chunkmap's CS
-	for (cEntityList::iterator itr = m_Entities.begin(), itr2 = itr; itr != m_Entities.end(); itr = itr2)
+	bool Result = true;
+	BeginEntityIteration();
+	for (size_t i = 0; i < m_Entities.size(); i++)
 	{
-		++itr2;
-		cBoundingBox EntBox((*itr)->GetPosition(), (*itr)->GetWidth() / 2, (*itr)->GetHeight());
+		cEntity * Entity = m_Entities[i];
+		if (Entity == nullptr)
+		{
+			continue;
+		}
+		cBoundingBox EntBox(Entity->GetPosition(), Entity->GetWidth() / 2, Entity->GetHeight());
 		if (!EntBox.DoesIntersect(a_Box))
 		{
 			// The entity is not in the specified box
 			continue;
 		}
-		if (a_Callback.Item(*itr))
+		if (a_Callback.Item(Entity))
 		{
-			return false;
+			Result = false;
+			break;
 		}
-	}  // for itr - m_Entitites[]
+	}  // for i - m_Entitites[]
+	EndEntityIteration();
+	return Result;
+}
+
+
+
+
+
+bool cChunk::ForEachPickupInBox(const cBoundingBox & a_Box, short a_ItemType, cEntityCallback & a_Callback)
+{
+	// The box may reach into the neighboring chunks, query the index of each of them:
+	int MinChunkX, MinChunkZ, MaxChunkX, MaxChunkZ;
+	cChunkDef::BlockToChunk(FloorC(a_Box.GetMinX()), FloorC(a_Box.GetMinZ()), MinChunkX, MinChunkZ);
+	cChunkDef::BlockToChunk(FloorC(a_Box.GetMaxX()), FloorC(a_Box.GetMaxZ()), MaxChunkX, MaxChunkZ);
+	for (int z = MinChunkZ; z <= MaxChunkZ; z++)
+	{
+		for (int x = MinChunkX; x <= MaxChunkX; x++)
+		{
+			cChunk * Chunk = GetNeighborChunk(x * cChunkDef::Width, z * cChunkDef::Width);
+			if ((Chunk == nullptr) || !Chunk->IsValid())
+			{
+				continue;
+			}
+			if (!Chunk->m_PickupIndex.IsValid())
+			{
+				Chunk->m_PickupIndex.Rebuild(Chunk->m_Entities);
+			}
+			if (!Chunk->m_PickupIndex.ForEachPickupInBox(a_Box, a_ItemType, a_Callback))
+			{
+				return false;
+			}
+		}  // for x
+	}  // for z
 	return true;
 }
 
@@ -2027,14 +2320,17 @@ bool cChunk::ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback & a_
 bool cChunk::DoWithEntityByID(int a_EntityID, cEntityCallback & a_Callback, bool & a_CallbackResult)
 {
 	// The entity list is locked by the parent chunkmap's CS
-	for (cEntityList::iterator itr = m_Entities.begin(), end = m_Entities.end(); itr != end; ++itr)
+	for (size_t i = 0; i < m_Entities.size(); i++)
 	{
-		if ((*itr)->GetUniqueID() == a_EntityID)
+		cEntity * Entity = m_Entities[i];
+		if ((Entity != nullptr) && (Entity->GetUniqueID() == a_EntityID))
 		{
-			a_CallbackResult = a_Callback.Item(*itr);
+			BeginEntityIteration();
+			a_CallbackResult = a_Callback.Item(Entity);
+			EndEntityIteration();
 			return true;
 		}
-	}  // for itr - m_Entitites[]
+	}  // for i - m_Entitites[]
 	return false;
 }
 
@@ -2977,6 +3273,23 @@ void cChunk::BroadcastEntityMetadata(const cEntity & a_Entity, const cClientHand
 
 
 
+void cChunk::BroadcastEntityMovement(const cEntity & a_Entity, cEntityTracker & a_Tracker, const cClientHandle * a_Exclude)
+{
+	Int64 WorldAge = m_World->GetWorldAge();
+	for (cClientHandleList::const_iterator itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
+	{
+		if (*itr == a_Exclude)
+		{
+			continue;
+		}
+		a_Tracker.UpdateClient(a_Entity, **itr, WorldAge);
+	}  // for itr - LoadedByClient[]
+}
+
+
+
+
+
 void cChunk::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
 	for (cClientHandleList::const_iterator itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
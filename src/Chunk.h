@@ -4,6 +4,7 @@
 #include "Entities/Entity.h"
 #include "ChunkDef.h"
 #include "ChunkData.h"
+#include "PickupIndex.h"
 
 #include "Simulator/FireSimulator.h"
 #include "Simulator/SandSimulator.h"
@@ -50,6 +51,7 @@ class cMobCensus;
 class cMobSpawner;
 class cRedstonePoweredEntity;
 class cSetChunkData;
+class cEntityTracker;
 
 typedef std::list<cClientHandle *>         cClientHandleList;
 typedef cItemCallback<cEntity>             cEntityCallback;
@@ -108,7 +110,26 @@ public:
 	/** Returns true iff the chunk has changed since it was last saved. */
 	bool IsDirty(void) const {return m_IsDirty; }
 
+	/** Returns the world age (in ticks) when the chunk last became dirty. Only meaningful if IsDirty(). */
+	Int64 GetDirtySince(void) const { return m_DirtySince; }
+
+	/** Returns true if the chunk has been queued in the storage for saving and the saving hasn't started yet. */
+	bool IsQueuedForSave(void) const { return m_IsQueuedForSave; }
+
+	/** Returns true if the storage has started saving the chunk and the chunk hasn't changed since. */
+	bool IsSaving(void) const { return m_IsSaving; }
+
+	/** Remembers that the chunk has been queued for saving, so that it isn't queued again; reset by MarkSaving(). */
+	void MarkQueuedForSave(void) { m_IsQueuedForSave = true; }
+
 	bool CanUnload(void);
+
+	/** Returns true if the chunk is used neither by any client nor by any chunkstay, so it may unload once it is saved */
+	bool IsUnused(void) const { return (m_LoadedByClient.empty() && (m_StayCount == 0)); }
+
+	/** Returns the world age (in ticks) when the chunk was last used by any client or chunkstay; only meaningful if IsUnused().
+	Used by the unload governor to unload the least recently used chunks first. */
+	Int64 GetUnusedSince(void) const { return m_UnusedSince; }
 	
 	bool IsLightValid(void) const {return m_IsLightValid; }
 	
@@ -148,6 +169,14 @@ public:
 
 	/** Returns true if there is a block entity at the coords specified */
 	bool HasBlockEntityAt(int a_BlockX, int a_BlockY, int a_BlockZ);
+
+	/** Wakes up all the sleeping block entities of this chunk within the specified area (absolute block coords, inclusive) */
+	void WakeUpBlockEntitiesInArea(int a_MinBlockX, int a_MaxBlockX, int a_MinBlockY, int a_MaxBlockY, int a_MinBlockZ, int a_MaxBlockZ);
+
+	/** Wakes up the sleeping block entities that may react to a change at the specified block, in this chunk and its neighbors.
+	That is all the block entities up to 2 blocks away horizontally and 1 block vertically, see cChunkMap::WakeUpBlockEntitiesAround().
+	Called for each block change, from all the block-writing paths. */
+	void WakeUpBlockEntitiesAround(int a_RelX, int a_RelY, int a_RelZ);
 	
 	/** Sets or resets the internal flag that prevents chunk from being unloaded.
 	The flag is cumulative - it can be set multiple times and then needs to be un-set that many times
@@ -225,6 +254,10 @@ public:
 
 	int  GetHeight( int a_X, int a_Z);
 
+	/** Returns the map color (cMap::ColorID) of the topmost non-air block in the specified column.
+	The colors are cached per column, until a block in the column changes. */
+	Byte GetMapColumnColor(int a_RelX, int a_RelZ);
+
 	void SendBlockTo(int a_RelX, int a_RelY, int a_RelZ, cClientHandle * a_Client);
 
 	/** Adds a client to the chunk; returns true if added, false if already there */
@@ -250,6 +283,12 @@ public:
 	Returns true if all entities processed, false if the callback aborted by returning true. */
 	bool ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback & a_Callback);  // Lua-accessible
 
+	/** Calls the callback for each pickup in the specified box, including the pickups in the neighboring chunks.
+	Only the pickups of a_ItemType are processed, unless a_ItemType is E_ITEM_EMPTY.
+	Uses the chunks' pickup indices, see cPickupIndex; the callback needs to check the exact pickup position.
+	Returns true if all pickups processed, false if the callback aborted by returning true. */
+	bool ForEachPickupInBox(const cBoundingBox & a_Box, short a_ItemType, cEntityCallback & a_Callback);
+
 	/** Calls the callback if the entity with the specified ID is found, with the entity object as the callback param. Returns true if entity found. */
 	bool DoWithEntityByID(int a_EntityID, cEntityCallback & a_Callback, bool & a_CallbackResult);  // Lua-accessible
 
@@ -327,6 +366,7 @@ public:
 	void BroadcastEntityHeadLook     (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityLook         (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityMetadata     (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
+	void BroadcastEntityMovement     (const cEntity & a_Entity, cEntityTracker & a_Tracker, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMove      (const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMoveLook  (const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityStatus       (const cEntity & a_Entity, char a_Status, const cClientHandle * a_Exclude = nullptr);
@@ -352,6 +392,12 @@ public:
 
 	inline void MarkDirty(void)
 	{
+		// A chunk modified while being saved, or re-dirtied after a failed save, still holds the changes since
+		// it first became dirty, so the dirty period continues:
+		if (!m_IsDirty)
+		{
+			StartDirtyPeriod();
+		}
 		m_IsDirty = true;
 		m_IsSaving = false;
 	}
@@ -377,6 +423,10 @@ public:
 				m_IsRedstoneDirty = true;
 				
 				m_PendingSendBlocks.push_back(sSetBlock(m_PosX, m_PosZ, a_RelX, a_RelY, a_RelZ, GetBlock(a_RelX, a_RelY, a_RelZ), a_Meta));
+				InvalidateMapColumnColor(a_RelX, a_RelZ);
+
+				// Same as in FastSetBlock(), the block entities around may react to the change:
+				WakeUpBlockEntitiesAround(a_RelX, a_RelY, a_RelZ);
 			}
 	}
 
@@ -469,7 +519,14 @@ private:
 	bool m_IsLightValid;   // True if the blocklight and skylight are calculated
 	bool m_IsDirty;        // True if the chunk has changed since it was last saved
 	bool m_IsSaving;       // True if the chunk is being saved
+	bool m_IsQueuedForSave;  // True if the chunk is in the storage's save queue
 	bool m_HasLoadFailed;  // True if chunk failed to load and hasn't been generated yet since then
+
+	/** The world age (in ticks) when the chunk became dirty after being clean, used by the autosave scheduler to save the oldest changes first */
+	Int64 m_DirtySince;
+
+	/** The world age (in ticks) when the last client or chunkstay stopped using the chunk, or when the chunk was created */
+	Int64 m_UnusedSince;
 	
 	std::vector<Vector3i> m_ToTickBlocks;
 	sSetBlockVector       m_PendingSendBlocks;  ///< Blocks that have changed and need to be sent to all clients
@@ -478,12 +535,26 @@ private:
 	
 	// A critical section is not needed, because all chunk access is protected by its parent ChunkMap's csLayers
 	cClientHandleList  m_LoadedByClient;
-	cEntityList        m_Entities;
+	cEntityVector      m_Entities;  // Contiguous, for cache-friendly iteration; may contain nullptr slots, see m_NumEntityIterations
 	cBlockEntityList   m_BlockEntities;
+
+	/** The block entities of m_BlockEntities keyed by their position, see GetBlockEntityKey(); for the lookups by position */
+	std::map<int, cBlockEntity *> m_BlockEntityIndex;
 	
 	/** Number of times the chunk has been requested to stay (by various cChunkStay objects); if zero, the chunk can be unloaded */
 	int m_StayCount;
 
+	/** Number of loops over m_Entities currently in progress; the loops may nest through the callbacks.
+	While non-zero, RemoveEntity() only sets the entity's slot to nullptr so that the running loops stay valid;
+	the empty slots are erased when the outermost loop ends. All loops over m_Entities need to skip the nullptr slots. */
+	int m_NumEntityIterations;
+
+	/** Set when there are nullptr slots in m_Entities that need erasing */
+	bool m_HasEmptyEntitySlots;
+
+	/** The pickups in m_Entities, by their position and item type. Invalidated at the start of each tick and whenever a pickup is added or removed. */
+	cPickupIndex m_PickupIndex;
+
 	int m_PosX, m_PosZ;
 	cWorld *    m_World;
 	cChunkMap * m_ChunkMap;
@@ -491,6 +562,10 @@ private:
 	cChunkData m_ChunkData;
 
 	cChunkDef::HeightMap m_HeightMap;
+
+	/** The cached map colors of the block columns, see GetMapColumnColor(); MAP_COLOR_INVALID for columns not calculated yet.
+	Empty until the chunk is first drawn on a map. */
+	std::vector<Byte> m_MapColumnColors;
 	cChunkDef::BiomeMap  m_BiomeMap;
 
 	int m_BlockTickX, m_BlockTickY, m_BlockTickZ;
@@ -525,11 +600,24 @@ private:
 	void RemoveBlockEntity(cBlockEntity * a_BlockEntity);
 	void AddBlockEntity   (cBlockEntity * a_BlockEntity);
 
+	/** Rebuilds m_BlockEntityIndex from m_BlockEntities, after the list has been replaced as a whole */
+	void RebuildBlockEntityIndex(void);
+
+	/** Returns the key of the specified position in m_BlockEntityIndex. The X coord varies fastest,
+	so that the block entities in a row of X coords are next to each other in the index, regardless of AXIS_ORDER. */
+	static int GetBlockEntityKey(int a_RelX, int a_RelY, int a_RelZ)
+	{
+		return a_RelX + a_RelZ * cChunkDef::Width + a_RelY * cChunkDef::Width * cChunkDef::Width;
+	}
+
 	/** Creates a block entity for each block that needs a block entity and doesn't have one in the list */
 	void CreateBlockEntities(void);
 	
 	/** Wakes up each simulator for its specific blocks; through all the blocks in the chunk */
 	void WakeUpSimulators(void);
+
+	/** Called by MarkDirty() when a clean chunk (saved, loaded or generated) becomes dirty; remembers the current world age */
+	void StartDirtyPeriod(void);
 	
 	// Makes a copy of the list
 	cClientHandleList GetAllClients(void) const {return m_LoadedByClient; }
@@ -560,6 +648,24 @@ private:
 	
 	/** Processes all blocks that have been scheduled for replacement by the QueueSetBlock() function */
 	void ProcessQueuedSetBlocks(void);
+
+	/** Marks the start of a loop over m_Entities that calls out to other code, see m_NumEntityIterations. */
+	void BeginEntityIteration(void) { m_NumEntityIterations += 1; }
+
+	/** Marks the end of a loop over m_Entities; erases the empty slots once the outermost loop ends. */
+	void EndEntityIteration(void);
+
+	/** Value in m_MapColumnColors for the columns whose color needs calculating; not a valid map color */
+	static const Byte MAP_COLOR_INVALID = 0xff;
+
+	/** Marks the cached map color of the specified column for recalculation, called whenever a block in the column changes. */
+	void InvalidateMapColumnColor(int a_RelX, int a_RelZ)
+	{
+		if (!m_MapColumnColors.empty())
+		{
+			m_MapColumnColors[static_cast<size_t>(a_RelX + a_RelZ * Width)] = MAP_COLOR_INVALID;
+		}
+	}
 };
 
 typedef cChunk * cChunkPtr;
@@ -0,0 +1,204 @@
+// ChunkCursor.cpp
+
+// Implements the cChunkCursor class providing fast repeated block lookups in world coords
+
+#include "Globals.h"
+#include "ChunkCursor.h"
+#include "World.h"
+#include "ChunkMap.h"
+#include "Chunk.h"
+
+
+
+
+
+cChunkCursor::cChunkCursor(cWorld & a_World, bool a_ShouldHoldLock) :
+	m_ChunkMap(*a_World.GetChunkMap()),
+	m_Lock(m_ChunkMap.GetCS()),
+	m_ShouldHoldLock(a_ShouldHoldLock),
+	m_NumChunksDeleted(m_ChunkMap.m_NumChunksDeleted),
+	m_Chunk(nullptr),
+	m_NumLookups(0),
+	m_NumChunkSwitches(0)
+{
+	if (!m_ShouldHoldLock)
+	{
+		m_Lock.Unlock();
+	}
+}
+
+
+
+
+
+cChunkCursor::cChunkCursor(cChunkMap & a_ChunkMap, cChunk * a_StartChunk) :
+	m_ChunkMap(a_ChunkMap),
+	m_Lock(m_ChunkMap.GetCS()),
+	m_ShouldHoldLock(true),
+	m_NumChunksDeleted(m_ChunkMap.m_NumChunksDeleted),
+	m_Chunk(a_StartChunk),
+	m_NumLookups(0),
+	m_NumChunkSwitches(0)
+{
+}
+
+
+
+
+
+bool cChunkCursor::GetBlockTypeMeta(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta)
+{
+	cLookupLock Lock(*this);
+	int RelX, RelZ;
+	cChunk * Chunk = GetChunkForBlock(a_BlockX, a_BlockY, a_BlockZ, RelX, RelZ);
+	if (Chunk == nullptr)
+	{
+		return false;
+	}
+	Chunk->GetBlockTypeMeta(RelX, a_BlockY, RelZ, a_BlockType, a_BlockMeta);
+	return true;
+}
+
+
+
+
+
+bool cChunkCursor::GetBlockInfo(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_Meta, NIBBLETYPE & a_SkyLight, NIBBLETYPE & a_BlockLight)
+{
+	cLookupLock Lock(*this);
+	int RelX, RelZ;
+	cChunk * Chunk = GetChunkForBlock(a_BlockX, a_BlockY, a_BlockZ, RelX, RelZ);
+	if (Chunk == nullptr)
+	{
+		return false;
+	}
+	Chunk->GetBlockInfo(RelX, a_BlockY, RelZ, a_BlockType, a_Meta, a_SkyLight, a_BlockLight);
+	return true;
+}
+
+
+
+
+
+BLOCKTYPE cChunkCursor::GetBlock(int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+	cLookupLock Lock(*this);
+	int RelX, RelZ;
+	cChunk * Chunk = GetChunkForBlock(a_BlockX, a_BlockY, a_BlockZ, RelX, RelZ);
+	if (Chunk == nullptr)
+	{
+		return E_BLOCK_AIR;
+	}
+	return Chunk->GetBlock(RelX, a_BlockY, RelZ);
+}
+
+
+
+
+
+NIBBLETYPE cChunkCursor::GetBlockMeta(int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+	cLookupLock Lock(*this);
+	int RelX, RelZ;
+	cChunk * Chunk = GetChunkForBlock(a_BlockX, a_BlockY, a_BlockZ, RelX, RelZ);
+	if (Chunk == nullptr)
+	{
+		return 0;
+	}
+	return Chunk->GetMeta(RelX, a_BlockY, RelZ);
+}
+
+
+
+
+
+bool cChunkCursor::IsBlockValid(int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+	cLookupLock Lock(*this);
+	int RelX, RelZ;
+	return (GetChunkForBlock(a_BlockX, a_BlockY, a_BlockZ, RelX, RelZ) != nullptr);
+}
+
+
+
+
+
+cChunk * cChunkCursor::GetChunkForBlock(int a_BlockX, int a_BlockY, int a_BlockZ, int & a_RelX, int & a_RelZ)
+{
+	m_NumLookups += 1;
+	if ((a_BlockY < 0) || (a_BlockY >= cChunkDef::Height))
+	{
+		return nullptr;
+	}
+
+	if (m_Chunk != nullptr)
+	{
+		// Try the last used chunk first, then walk its neighbors (falls back to the chunkmap if needed):
+		a_RelX = a_BlockX - m_Chunk->GetPosX() * cChunkDef::Width;
+		a_RelZ = a_BlockZ - m_Chunk->GetPosZ() * cChunkDef::Width;
+		if (
+			(a_RelX < 0) || (a_RelX >= cChunkDef::Width) ||
+			(a_RelZ < 0) || (a_RelZ >= cChunkDef::Width)
+		)
+		{
+			m_Chunk = m_Chunk->GetRelNeighborChunkAdjustCoords(a_RelX, a_RelZ);
+			m_NumChunkSwitches += 1;
+		}
+	}
+	else
+	{
+		// No chunk to start from, query the chunkmap:
+		int ChunkX, ChunkZ;
+		cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
+		m_Chunk = m_ChunkMap.FindChunk(ChunkX, ChunkZ);
+		a_RelX = a_BlockX - ChunkX * cChunkDef::Width;
+		a_RelZ = a_BlockZ - ChunkZ * cChunkDef::Width;
+		m_NumChunkSwitches += 1;
+	}
+
+	if ((m_Chunk == nullptr) || !m_Chunk->IsValid())
+	{
+		return nullptr;
+	}
+	return m_Chunk;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunkCursor::cLookupLock:
+
+cChunkCursor::cLookupLock::cLookupLock(cChunkCursor & a_Cursor) :
+	m_Cursor(a_Cursor)
+{
+	if (m_Cursor.m_ShouldHoldLock)
+	{
+		return;
+	}
+	m_Cursor.m_Lock.Lock();
+
+	// The remembered chunk may have been deleted while the chunkmap was not locked:
+	if (m_Cursor.m_NumChunksDeleted != m_Cursor.m_ChunkMap.m_NumChunksDeleted)
+	{
+		m_Cursor.m_NumChunksDeleted = m_Cursor.m_ChunkMap.m_NumChunksDeleted;
+		m_Cursor.m_Chunk = nullptr;
+	}
+}
+
+
+
+
+
+cChunkCursor::cLookupLock::~cLookupLock()
+{
+	if (!m_Cursor.m_ShouldHoldLock)
+	{
+		m_Cursor.m_Lock.Unlock();
+	}
+}
+
+
+
+
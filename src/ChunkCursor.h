@@ -0,0 +1,122 @@
+
+// ChunkCursor.h
+
+// Declares the cChunkCursor class providing fast repeated block lookups in world coords
+
+
+
+
+
+#pragma once
+
+
+
+
+
+// fwd:
+class cWorld;
+class cChunk;
+class cChunkMap;
+
+
+
+
+
+/** Serves many block lookups specified in absolute world coords without re-locking and re-resolving the chunk for each one.
+The cursor remembers the chunk used by the last lookup. Following lookups into the same chunk are served directly,
+lookups into other chunks walk the chunk neighbors and only fall back to the chunkmap when the target cannot be
+reached that way.
+By default the cursor locks the chunkmap for its entire lifetime. A cursor created with a_ShouldHoldLock set to false
+locks the chunkmap only for each lookup, so that the code between the lookups can call anything, including code
+waiting for other threads that need the chunkmap; such a cursor forgets its remembered chunk whenever any chunk has
+been deleted from the chunkmap since its last lookup. Lua plugins get such a cursor through cWorld:DoWithChunkCursor().
+The cursor never loads or generates chunks; lookups into chunks that are not valid fail.
+Note that the cursor doesn't see blocks queued by cWorld::FastSetBlock() that haven't been applied yet.
+Intended to be used as a short-lived object on the stack, around a batch of lookups. Since the chunkmap may be locked,
+the object must not be kept around across ticks. */
+// tolua_begin
+class cChunkCursor
+{
+	// tolua_end
+	DISALLOW_COPY_AND_ASSIGN(cChunkCursor);
+	// tolua_begin
+
+public:
+	// tolua_end
+
+	/** Creates a cursor over the specified world's chunkmap.
+	If a_ShouldHoldLock is false, the chunkmap is locked only for each lookup, see the class description. */
+	cChunkCursor(cWorld & a_World, bool a_ShouldHoldLock = true);
+
+	/** Creates a cursor over the specified chunkmap, starting the lookups at the specified chunk (may be nullptr).
+	Use this from within a chunk's or entity's Tick(), to avoid the initial chunkmap lookup. */
+	cChunkCursor(cChunkMap & a_ChunkMap, cChunk * a_StartChunk);
+
+	/** Retrieves the block type and meta at the specified coords. Returns false if the chunk is not valid, or the coords are outside the world. */
+	bool GetBlockTypeMeta(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta);  // Exported in ManualBindings.cpp
+
+	/** Retrieves all the block information at the specified coords. Returns false if the chunk is not valid, or the coords are outside the world. */
+	bool GetBlockInfo(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_Meta, NIBBLETYPE & a_SkyLight, NIBBLETYPE & a_BlockLight);  // Exported in ManualBindings.cpp
+
+	// tolua_begin
+
+	/** Returns the block type at the specified coords, or E_BLOCK_AIR if the chunk is not valid (same as cWorld::GetBlock()). */
+	BLOCKTYPE GetBlock(int a_BlockX, int a_BlockY, int a_BlockZ);
+
+	/** Returns the block meta at the specified coords, or 0 if the chunk is not valid (same as cWorld::GetBlockMeta()). */
+	NIBBLETYPE GetBlockMeta(int a_BlockX, int a_BlockY, int a_BlockZ);
+
+	/** Returns true if the chunk containing the specified block is loaded and valid. */
+	bool IsBlockValid(int a_BlockX, int a_BlockY, int a_BlockZ);
+
+	/** Returns the number of lookups served by this cursor so far. */
+	int GetNumLookups(void) const { return m_NumLookups; }
+
+	/** Returns the number of lookups that had to switch to a different chunk than the previous lookup. */
+	int GetNumChunkSwitches(void) const { return m_NumChunkSwitches; }
+
+	// tolua_end
+
+	/** Returns the chunk containing the specified block, with a_RelX and a_RelZ set to the coords relative to it.
+	Returns nullptr if the chunk is not valid or the coords are outside the world.
+	Only for the cursors holding the lock, the returned chunk is only safe to use while the chunkmap is locked. */
+	cChunk * GetChunkForBlock(int a_BlockX, int a_BlockY, int a_BlockZ, int & a_RelX, int & a_RelZ);
+
+protected:
+	/** Locks the chunkmap for a single lookup, if the cursor doesn't hold the lock for its lifetime. */
+	class cLookupLock
+	{
+	public:
+		cLookupLock(cChunkCursor & a_Cursor);
+		~cLookupLock();
+
+	protected:
+		cChunkCursor & m_Cursor;
+	} ;
+
+
+
+	/** The chunkmap used for the initial lookup and as a fallback when the neighbors cannot be walked. */
+	cChunkMap & m_ChunkMap;
+
+	/** Keeps the chunkmap locked for the lifetime of the cursor, or for each lookup, see m_ShouldHoldLock. */
+	cCSLock m_Lock;
+
+	/** If true, m_Lock is held for the lifetime of the cursor; if false, only for each lookup. */
+	bool m_ShouldHoldLock;
+
+	/** The chunkmap's count of deleted chunks as of the last lookup, see cChunkMap::m_NumChunksDeleted.
+	Only used if not m_ShouldHoldLock, to detect that m_Chunk may have been deleted while not locked. */
+	UInt64 m_NumChunksDeleted;
+
+	/** The chunk used by the last lookup; may be nullptr or an invalid chunk. */
+	cChunk * m_Chunk;
+
+	/** Statistics, see GetNumLookups() and GetNumChunkSwitches(). */
+	int m_NumLookups;
+	int m_NumChunkSwitches;
+} ;  // tolua_export
+
+
+
+
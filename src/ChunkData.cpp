@@ -196,6 +196,7 @@ void cChunkData::SetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_Block)
 		}
 		ZeroSection(m_Sections[Section]);
 	}
+	UnshareSection(static_cast<size_t>(Section));
 	int Index = cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY - (Section * SectionHeight), a_RelZ);
 	m_Sections[Section]->m_BlockTypes[Index] = a_Block;
 }
@@ -257,6 +258,7 @@ bool cChunkData::SetMeta(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Nibble
 		}
 		ZeroSection(m_Sections[Section]);
 	}
+	UnshareSection(static_cast<size_t>(Section));
 	int Index = cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY - (Section * SectionHeight), a_RelZ);
 	NIBBLETYPE oldval = m_Sections[Section]->m_BlockMetas[Index / 2] >> ((Index & 1) * 4) & 0xf;
 	m_Sections[Section]->m_BlockMetas[Index / 2] = static_cast<NIBBLETYPE>(
@@ -328,7 +330,7 @@ cChunkData cChunkData::Copy(void) const
 		if (m_Sections[i] != nullptr)
 		{
 			copy.m_Sections[i] = copy.Allocate();
-			*copy.m_Sections[i] = *m_Sections[i];
+			CopySection(copy.m_Sections[i], m_Sections[i]);
 		}
 	}
 	return copy;
@@ -338,6 +340,24 @@ cChunkData cChunkData::Copy(void) const
 
 
 
+cChunkData cChunkData::Snapshot(void) const
+{
+	cChunkData snapshot(m_Pool);
+	for (size_t i = 0; i < NumSections; i++)
+	{
+		if (m_Sections[i] != nullptr)
+		{
+			m_Sections[i]->m_RefCount += 1;
+			snapshot.m_Sections[i] = m_Sections[i];
+		}
+	}
+	return snapshot;
+}
+
+
+
+
+
 void cChunkData::CopyBlockTypes(BLOCKTYPE * a_Dest, size_t a_Idx, size_t a_Length) const
 {
 	size_t ToSkip = a_Idx;
@@ -437,6 +457,7 @@ void cChunkData::SetBlockTypes(const BLOCKTYPE * a_Src)
 		// If the section is already allocated, copy the data into it:
 		if (m_Sections[i] != nullptr)
 		{
+			UnshareSection(i);
 			memcpy(m_Sections[i]->m_BlockTypes, &a_Src[i * SectionBlockCount], sizeof(m_Sections[i]->m_BlockTypes));
 			continue;
 		}
@@ -469,6 +490,7 @@ void cChunkData::SetMetas(const NIBBLETYPE * a_Src)
 		// If the section is already allocated, copy the data into it:
 		if (m_Sections[i] != nullptr)
 		{
+			UnshareSection(i);
 			memcpy(m_Sections[i]->m_BlockMetas, &a_Src[i * SectionBlockCount / 2], sizeof(m_Sections[i]->m_BlockMetas));
 			continue;
 		}
@@ -505,6 +527,7 @@ void cChunkData::SetBlockLight(const NIBBLETYPE * a_Src)
 		// If the section is already allocated, copy the data into it:
 		if (m_Sections[i] != nullptr)
 		{
+			UnshareSection(i);
 			memcpy(m_Sections[i]->m_BlockLight, &a_Src[i * SectionBlockCount / 2], sizeof(m_Sections[i]->m_BlockLight));
 			continue;
 		}
@@ -540,6 +563,7 @@ void cChunkData::SetSkyLight(const NIBBLETYPE * a_Src)
 		// If the section is already allocated, copy the data into it:
 		if (m_Sections[i] != nullptr)
 		{
+			UnshareSection(i);
 			memcpy(m_Sections[i]->m_BlockSkyLight, &a_Src[i * SectionBlockCount / 2], sizeof(m_Sections[i]->m_BlockSkyLight));
 			continue;
 		}
@@ -566,7 +590,12 @@ void cChunkData::SetSkyLight(const NIBBLETYPE * a_Src)
 
 cChunkData::sChunkSection * cChunkData::Allocate(void)
 {
-	return m_Pool.Allocate();
+	sChunkSection * Section = m_Pool.Allocate();
+	if (Section != nullptr)
+	{
+		Section->m_RefCount = 1;
+	}
+	return Section;
 }
 
 
@@ -575,7 +604,44 @@ cChunkData::sChunkSection * cChunkData::Allocate(void)
 
 void cChunkData::Free(cChunkData::sChunkSection * a_Section)
 {
-	m_Pool.Free(a_Section);
+	if (a_Section == nullptr)
+	{
+		return;
+	}
+	if (--(a_Section->m_RefCount) == 0)
+	{
+		m_Pool.Free(a_Section);
+	}
+}
+
+
+
+
+
+void cChunkData::UnshareSection(size_t a_SectionIdx)
+{
+	sChunkSection * Shared = m_Sections[a_SectionIdx];
+	if ((Shared == nullptr) || (Shared->m_RefCount == 1))
+	{
+		// Not shared, only this object references the section, so no-one else can start sharing it meanwhile
+		return;
+	}
+	sChunkSection * Private = Allocate();
+	CopySection(Private, Shared);
+	m_Sections[a_SectionIdx] = Private;
+	Free(Shared);
+}
+
+
+
+
+
+void cChunkData::CopySection(sChunkSection * a_Dst, const sChunkSection * a_Src)
+{
+	memcpy(a_Dst->m_BlockTypes,    a_Src->m_BlockTypes,    sizeof(a_Dst->m_BlockTypes));
+	memcpy(a_Dst->m_BlockMetas,    a_Src->m_BlockMetas,    sizeof(a_Dst->m_BlockMetas));
+	memcpy(a_Dst->m_BlockLight,    a_Src->m_BlockLight,    sizeof(a_Dst->m_BlockLight));
+	memcpy(a_Dst->m_BlockSkyLight, a_Src->m_BlockSkyLight, sizeof(a_Dst->m_BlockSkyLight));
 }
 
 
@@ -11,6 +11,7 @@
 
 
 #include <cstring>
+#include <atomic>
 
 
 #include "ChunkDef.h"
@@ -63,6 +64,13 @@ public:
 	/** Creates a (deep) copy of self. */
 	cChunkData Copy(void) const;
 
+	/** Creates a copy-on-write snapshot of self.
+	The snapshot shares the sections with this object, so creating it is cheap; whichever of the two objects
+	writes into a shared section first gets its own copy of that section. The snapshot can be read and destroyed
+	in another thread than the one that writes into this object, as long as the pool is thread-safe.
+	Used for saving the chunks, so that the storage thread needn't hold the chunkmap lock while serializing. */
+	cChunkData Snapshot(void) const;
+
 	/** Copies the blocktype data into the specified flat array.
 	Optionally, only a part of the data is copied, as specified by the a_Idx and a_Length parameters. */
 	void CopyBlockTypes(BLOCKTYPE * a_Dest, size_t a_Idx = 0, size_t a_Length = cChunkDef::NumBlocks) const;
@@ -102,6 +110,9 @@ public:
 		NIBBLETYPE m_BlockMetas   [SectionHeight * 16 * 16 / 2];
 		NIBBLETYPE m_BlockLight   [SectionHeight * 16 * 16 / 2];
 		NIBBLETYPE m_BlockSkyLight[SectionHeight * 16 * 16 / 2];
+
+		/** Number of cChunkData objects (the chunk and its snapshots) that share this section */
+		std::atomic<int> m_RefCount;
 	};
 	
 private:
@@ -117,9 +128,17 @@ private:
 	/** Allocates a new section. Entry-point to custom allocators. */
 	sChunkSection * Allocate(void);
 
-	/** Frees the specified section, previously allocated using Allocate().
+	/** Releases this object's reference to the specified section, previously allocated using Allocate();
+	frees the section once it's not shared with any other object.
 	Note that a_Section may be nullptr. */
 	void Free(sChunkSection * a_Section);
+
+	/** Makes sure that the specified section is not shared with a snapshot, so that it can be written to.
+	If shared, replaces the section with a private copy. */
+	void UnshareSection(size_t a_SectionIdx);
+
+	/** Copies the block data (but not the reference count) from a_Src to a_Dst. */
+	static void CopySection(sChunkSection * a_Dst, const sChunkSection * a_Src);
 	
 	/** Sets the data in the specified section to their default values. */
 	void ZeroSection(sChunkSection * a_Section) const;
@@ -8,6 +8,11 @@
 #include "Item.h"
 #include "Entities/Pickup.h"
 #include "Chunk.h"
+#include "ChunkCursor.h"
+#include "ChunkSectionPool.h"
+#include "AutosaveScheduler.h"
+#include "UnloadGovernor.h"
+#include "ExplosionEngine.h"
 #include "Generating/Trees.h"  // used in cChunkMap::ReplaceTreeBlocks() for tree block discrimination
 #include "BlockArea.h"
 #include "Bindings/PluginManager.h"
@@ -35,14 +40,9 @@
 // cChunkMap:
 
 cChunkMap::cChunkMap(cWorld * a_World) :
+	m_NumChunksDeleted(0),
 	m_World(a_World),
-	m_Pool(
-		new cListAllocationPool<cChunkData::sChunkSection, 1600>(
-			std::auto_ptr<cAllocationPool<cChunkData::sChunkSection>::cStarvationCallbacks>(
-				new cStarvationCallbacks()
-			)
-		)
-	)
+	m_Explosions(new cExplosionEngine(*a_World, *this))
 {
 
 }
@@ -87,7 +87,7 @@ cChunkMap::cChunkLayer * cChunkMap::GetLayer(int a_LayerX, int a_LayerZ)
 	}
 	
 	// Not found, create new:
-	cChunkLayer * Layer = new cChunkLayer(a_LayerX, a_LayerZ, this, *m_Pool);
+	cChunkLayer * Layer = new cChunkLayer(a_LayerX, a_LayerZ, this, cChunkSectionPool::Get());
 	if (Layer == nullptr)
 	{
 		LOGERROR("cChunkMap: Cannot create new layer, server out of memory?");
@@ -537,6 +537,22 @@ void cChunkMap::BroadcastEntityMetadata(const cEntity & a_Entity, const cClientH
 
 
 
+void cChunkMap::BroadcastEntityMovement(const cEntity & a_Entity, cEntityTracker & a_Tracker, const cClientHandle * a_Exclude)
+{
+	cCSLock Lock(m_CSLayers);
+	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), a_Entity.GetChunkZ());
+	if (Chunk == nullptr)
+	{
+		return;
+	}
+	// It's perfectly legal to broadcast packets even to invalid chunks!
+	Chunk->BroadcastEntityMovement(a_Entity, a_Tracker, a_Exclude);
+}
+
+
+
+
+
 void cChunkMap::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
 	cCSLock Lock(m_CSLayers);
@@ -854,6 +870,30 @@ void cChunkMap::WakeUpSimulatorsInArea(int a_MinBlockX, int a_MaxBlockX, int a_M
 
 
 
+void cChunkMap::WakeUpBlockEntitiesAround(int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+	int MinChunkX, MinChunkZ, MaxChunkX, MaxChunkZ;
+	cChunkDef::BlockToChunk(a_BlockX - 2, a_BlockZ - 2, MinChunkX, MinChunkZ);
+	cChunkDef::BlockToChunk(a_BlockX + 2, a_BlockZ + 2, MaxChunkX, MaxChunkZ);
+	cCSLock Lock(m_CSLayers);
+	for (int z = MinChunkZ; z <= MaxChunkZ; z++)
+	{
+		for (int x = MinChunkX; x <= MaxChunkX; x++)
+		{
+			cChunkPtr Chunk = GetChunkNoGen(x, z);
+			if ((Chunk == nullptr) || !Chunk->IsValid())
+			{
+				continue;
+			}
+			Chunk->WakeUpBlockEntitiesInArea(a_BlockX - 2, a_BlockX + 2, a_BlockY - 1, a_BlockY + 1, a_BlockZ - 2, a_BlockZ + 2);
+		}  // for x - chunks
+	}  // for z - chunks
+}
+
+
+
+
+
 void cChunkMap::MarkRedstoneDirty(int a_ChunkX, int a_ChunkZ)
 {
 	cCSLock Lock(m_CSLayers);
@@ -935,6 +975,21 @@ void cChunkMap::SetChunkData(cSetChunkData & a_SetChunkData)
 		{
 			Chunk->MarkDirty();
 		}
+
+		// Wake up the block entities along the neighbors' borders, they may have gone to sleep while this chunk was missing:
+		int MinBlockX = ChunkX * cChunkDef::Width, MaxBlockX = MinBlockX + cChunkDef::Width - 1;
+		int MinBlockZ = ChunkZ * cChunkDef::Width, MaxBlockZ = MinBlockZ + cChunkDef::Width - 1;
+		for (int z = ChunkZ - 1; z <= ChunkZ + 1; z++)
+		{
+			for (int x = ChunkX - 1; x <= ChunkX + 1; x++)
+			{
+				cChunkPtr Neighbor = GetChunkNoLoad(x, z);
+				if ((Neighbor != nullptr) && (Neighbor != Chunk) && Neighbor->IsValid())
+				{
+					Neighbor->WakeUpBlockEntitiesInArea(MinBlockX - 2, MaxBlockX + 2, 0, cChunkDef::Height - 1, MinBlockZ - 2, MaxBlockZ + 2);
+				}
+			}
+		}
 		
 		// Notify relevant ChunkStays:
 		cChunkStays ToBeDisabled;
@@ -1047,6 +1102,22 @@ bool cChunkMap::HasChunkAnyClients(int a_ChunkX, int a_ChunkZ)
 
 
 
+void cChunkMap::GetChunkClients(int a_ChunkX, int a_ChunkZ, cClientHandleList & a_Clients)
+{
+	cCSLock Lock(m_CSLayers);
+	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, a_ChunkZ);
+	if (Chunk == nullptr)
+	{
+		return;
+	}
+	cClientHandleList Clients = Chunk->GetAllClients();
+	a_Clients.splice(a_Clients.end(), Clients);
+}
+
+
+
+
+
 int  cChunkMap::GetHeight(int a_BlockX, int a_BlockZ)
 {
 	for (;;)
@@ -1862,124 +1933,10 @@ void cChunkMap::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_
 		return;
 	}
 
-	bool ShouldDestroyBlocks = true;
-
-	// Don't explode if the explosion center is inside a liquid block:
-	if (IsBlockLiquid(m_World->GetBlock((int)floor(a_BlockX), (int)floor(a_BlockY), (int)floor(a_BlockZ))))
-	{
-		ShouldDestroyBlocks = false;
-	}
-
 	int ExplosionSizeInt = (int)ceil(a_ExplosionSize);
-	int ExplosionSizeSq = ExplosionSizeInt * ExplosionSizeInt;
-
-	int bx = (int)floor(a_BlockX);
-	int by = (int)floor(a_BlockY);
-	int bz = (int)floor(a_BlockZ);
-
-	int MinY = std::max((int)floor(a_BlockY - ExplosionSizeInt), 0);
-	int MaxY = std::min((int)ceil(a_BlockY + ExplosionSizeInt), cChunkDef::Height - 1);
-
-	if (ShouldDestroyBlocks)
-	{
-		cBlockArea area;
-
-		a_BlocksAffected.reserve(8 * ExplosionSizeInt * ExplosionSizeInt * ExplosionSizeInt);
-
-		area.Read(m_World, bx - ExplosionSizeInt, (int)ceil(a_BlockX + ExplosionSizeInt), MinY, MaxY, bz - ExplosionSizeInt, (int)ceil(a_BlockZ + ExplosionSizeInt));
-		for (int x = -ExplosionSizeInt; x < ExplosionSizeInt; x++)
-		{
-			for (int y = -ExplosionSizeInt; y < ExplosionSizeInt; y++)
-			{
-				if ((by + y >= cChunkDef::Height) || (by + y < 0))
-				{
-					// Outside of the world
-					continue;
-				}
-				for (int z = -ExplosionSizeInt; z < ExplosionSizeInt; z++)
-				{
-					if ((x * x + y * y + z * z) > ExplosionSizeSq)
-					{
-						// Too far away
-						continue;
-					}
 
-					BLOCKTYPE Block = area.GetBlockType(bx + x, by + y, bz + z);
-					switch (Block)
-					{
-						case E_BLOCK_TNT:
-						{
-							// Activate the TNT, with a random fuse between 10 to 30 game ticks
-							int FuseTime = 10 + m_World->GetTickRandomNumber(20);
-							m_World->SpawnPrimedTNT(a_BlockX + x + 0.5, a_BlockY + y + 0.5, a_BlockZ + z + 0.5, FuseTime);
-							area.SetBlockTypeMeta(bx + x, by + y, bz + z, E_BLOCK_AIR, 0);
-							a_BlocksAffected.push_back(Vector3i(bx + x, by + y, bz + z));
-							break;
-						}
-						
-						case E_BLOCK_OBSIDIAN:
-						case E_BLOCK_BEACON:
-						case E_BLOCK_BEDROCK:
-						case E_BLOCK_BARRIER:
-						case E_BLOCK_WATER:
-						case E_BLOCK_LAVA:
-						{
-							// These blocks are not affected by explosions
-							break;
-						}
-
-						case E_BLOCK_STATIONARY_WATER:
-						{
-							// Turn into simulated water:
-							area.SetBlockType(bx + x, by + y, bz + z, E_BLOCK_WATER);
-							break;
-						}
-
-						case E_BLOCK_STATIONARY_LAVA:
-						{
-							// Turn into simulated lava:
-							area.SetBlockType(bx + x, by + y, bz + z, E_BLOCK_LAVA);
-							break;
-						}
-
-						case E_BLOCK_AIR:
-						{
-							// No pickups for air
-							break;
-						}
-
-						default:
-						{
-							if (m_World->GetTickRandomNumber(100) <= 25)  // 25% chance of pickups
-							{
-								cItems Drops;
-								cBlockHandler * Handler = BlockHandler(Block);
-
-								Handler->ConvertToPickups(Drops, area.GetBlockMeta(bx + x, by + y, bz + z));  // Stone becomes cobblestone, coal ore becomes coal, etc.
-								m_World->SpawnItemPickups(Drops, bx + x, by + y, bz + z);
-							}
-							else if ((m_World->GetTNTShrapnelLevel() > slNone) && (m_World->GetTickRandomNumber(100) < 20))  // 20% chance of flinging stuff around
-							{
-								// If the block is shrapnel-able, make a falling block entity out of it:
-								if (
-									((m_World->GetTNTShrapnelLevel() == slAll) && cBlockInfo::FullyOccupiesVoxel(Block)) ||
-									((m_World->GetTNTShrapnelLevel() == slGravityAffectedOnly) && ((Block == E_BLOCK_SAND) || (Block == E_BLOCK_GRAVEL)))
-								)
-								{
-									m_World->SpawnFallingBlock(bx + x, by + y + 5, bz + z, Block, area.GetBlockMeta(bx + x, by + y, bz + z));
-								}
-							}
-
-							area.SetBlockTypeMeta(bx + x, by + y, bz + z, E_BLOCK_AIR, 0);
-							a_BlocksAffected.push_back(Vector3i(bx + x, by + y, bz + z));
-							break;
-						}
-					}  // switch (BlockType)
-				}  // for z
-			}  // for y
-		}  // for x
-		area.Write(m_World, bx - ExplosionSizeInt, MinY, bz - ExplosionSizeInt);
-	}
+	// Destroy the blocks; the changes are written into the chunks in FlushExplosions():
+	m_Explosions->Explode(a_ExplosionSize, a_BlockX, a_BlockY, a_BlockZ, a_BlocksAffected);
 
 	class cTNTDamageCallback :
 		public cEntityCallback
@@ -2032,16 +1989,19 @@ void cChunkMap::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_
 	cBoundingBox bbTNT(Vector3d(a_BlockX, a_BlockY, a_BlockZ), 0.5, 1);
 	bbTNT.Expand(ExplosionSizeInt * 2, ExplosionSizeInt * 2, ExplosionSizeInt * 2);
 
-
+	// Damage and push the entities near the explosion:
 	cTNTDamageCallback TNTDamageCallback(bbTNT, Vector3d(a_BlockX, a_BlockY, a_BlockZ), ExplosionSizeInt);
-	ForEachEntity(TNTDamageCallback);
+	ForEachEntityInBox(bbTNT, TNTDamageCallback);
+}
+
 
-	// Wake up all simulators for the area, so that water and lava flows and sand falls into the blasted holes (FS #391):
-	WakeUpSimulatorsInArea(
-		bx - ExplosionSizeInt - 1, bx + ExplosionSizeInt + 1,
-		MinY, MaxY,
-		bz - ExplosionSizeInt - 1, bz + ExplosionSizeInt + 1
-	);
+
+
+
+void cChunkMap::FlushExplosions(void)
+{
+	cCSLock Lock(m_CSLayers);
+	m_Explosions->Flush();
 }
 
 
@@ -2727,6 +2687,9 @@ void cChunkMap::Tick(std::chrono::milliseconds a_Dt)
 	{
 		(*itr)->Tick(a_Dt);
 	}  // for itr - m_Layers
+
+	// Apply all the explosions from this tick in a single pass:
+	m_Explosions->Flush();
 }
 
 
@@ -2776,6 +2739,73 @@ void cChunkMap::SaveAllChunks(void)
 
 
 
+void cChunkMap::CollectAutosaveCandidates(cAutosaveCandidates & a_Candidates)
+{
+	cCSLock Lock(m_CSLayers);
+	for (cChunkLayerList::iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
+	{
+		(*itr)->CollectAutosaveCandidates(a_Candidates);
+	}  // for itr - m_Layers[]
+}
+
+
+
+
+
+int cChunkMap::QueueChunksForSave(const cAutosaveCandidates & a_Chunks)
+{
+	cCSLock Lock(m_CSLayers);
+	int NumQueued = 0;
+	for (cAutosaveCandidates::const_iterator itr = a_Chunks.begin(), end = a_Chunks.end(); itr != end; ++itr)
+	{
+		cChunkPtr Chunk = GetChunkNoLoad(itr->m_ChunkX, itr->m_ChunkZ);
+		if ((Chunk == nullptr) || !Chunk->IsValid() || !Chunk->IsDirty() || Chunk->IsQueuedForSave() || Chunk->IsSaving())
+		{
+			continue;
+		}
+		Chunk->MarkQueuedForSave();
+		m_World->GetStorage().QueueSaveChunk(itr->m_ChunkX, itr->m_ChunkZ);
+		NumQueued += 1;
+	}  // for itr - a_Chunks[]
+	return NumQueued;
+}
+
+
+
+
+
+void cChunkMap::CollectUnloadCandidates(cUnloadCandidates & a_Candidates)
+{
+	cCSLock Lock(m_CSLayers);
+	for (cChunkLayerList::iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
+	{
+		(*itr)->CollectUnloadCandidates(a_Candidates);
+	}  // for itr - m_Layers[]
+}
+
+
+
+
+
+int cChunkMap::UnloadChunks(const cUnloadCandidates & a_Chunks)
+{
+	cCSLock Lock(m_CSLayers);
+	int NumUnloaded = 0;
+	for (cUnloadCandidates::const_iterator itr = a_Chunks.begin(), end = a_Chunks.end(); itr != end; ++itr)
+	{
+		cChunkLayer * Layer = FindLayerForChunk(itr->m_ChunkX, itr->m_ChunkZ);
+		if ((Layer != nullptr) && Layer->UnloadChunk(itr->m_ChunkX, itr->m_ChunkZ))
+		{
+			NumUnloaded += 1;
+		}
+	}  // for itr - a_Chunks[]
+	return NumUnloaded;
+}
+
+
+
+
+
 int cChunkMap::GetNumChunks(void)
 {
 	cCSLock Lock(m_CSLayers);
@@ -2857,6 +2887,10 @@ cChunkMap::cChunkLayer::~cChunkLayer()
 {
 	for (size_t i = 0; i < ARRAYCOUNT(m_Chunks); ++i)
 	{
+		if (m_Chunks[i] != nullptr)
+		{
+			m_Parent->m_NumChunksDeleted += 1;
+		}
 		delete m_Chunks[i];
 		m_Chunks[i] = nullptr;  // Must zero out, because further chunk deletions query the chunkmap for entities and that would touch deleted data
 	}  // for i - m_Chunks[]
@@ -3084,8 +3118,9 @@ void cChunkMap::cChunkLayer::Save(void)
 	cWorld * World = m_Parent->GetWorld();
 	for (size_t i = 0; i < ARRAYCOUNT(m_Chunks); ++i)
 	{
-		if ((m_Chunks[i] != nullptr) && m_Chunks[i]->IsValid() && m_Chunks[i]->IsDirty())
+		if ((m_Chunks[i] != nullptr) && m_Chunks[i]->IsValid() && m_Chunks[i]->IsDirty() && !m_Chunks[i]->IsQueuedForSave())
 		{
+			m_Chunks[i]->MarkQueuedForSave();
 			World->GetStorage().QueueSaveChunk(m_Chunks[i]->GetPosX(), m_Chunks[i]->GetPosZ());
 		}
 	}  // for i - m_Chunks[]
@@ -3095,6 +3130,81 @@ void cChunkMap::cChunkLayer::Save(void)
 
 
 
+void cChunkMap::cChunkLayer::CollectAutosaveCandidates(cAutosaveCandidates & a_Candidates) const
+{
+	for (size_t i = 0; i < ARRAYCOUNT(m_Chunks); ++i)
+	{
+		const cChunk * Chunk = m_Chunks[i];
+		if (
+			(Chunk == nullptr) || !Chunk->IsValid() || !Chunk->IsDirty() ||
+			Chunk->IsQueuedForSave() || Chunk->IsSaving()
+		)
+		{
+			continue;
+		}
+		sAutosaveCandidate Candidate;
+		Candidate.m_ChunkX = Chunk->GetPosX();
+		Candidate.m_ChunkZ = Chunk->GetPosZ();
+		Candidate.m_DirtySince = Chunk->GetDirtySince();
+		Candidate.m_IsUnused = Chunk->IsUnused();
+		a_Candidates.push_back(Candidate);
+	}  // for i - m_Chunks[]
+}
+
+
+
+
+
+void cChunkMap::cChunkLayer::CollectUnloadCandidates(cUnloadCandidates & a_Candidates) const
+{
+	for (size_t i = 0; i < ARRAYCOUNT(m_Chunks); ++i)
+	{
+		const cChunk * Chunk = m_Chunks[i];
+		if ((Chunk == nullptr) || !Chunk->IsUnused() || Chunk->IsQueued())
+		{
+			continue;
+		}
+		sUnloadCandidate Candidate;
+		Candidate.m_ChunkX = Chunk->GetPosX();
+		Candidate.m_ChunkZ = Chunk->GetPosZ();
+		Candidate.m_UnusedSince = Chunk->GetUnusedSince();
+		Candidate.m_DirtySince = Chunk->GetDirtySince();
+		Candidate.m_IsDirty = Chunk->IsDirty();
+		Candidate.m_IsSaving = Chunk->IsQueuedForSave() || Chunk->IsSaving();
+		a_Candidates.push_back(Candidate);
+	}  // for i - m_Chunks[]
+}
+
+
+
+
+
+bool cChunkMap::cChunkLayer::UnloadChunk(int a_ChunkX, int a_ChunkZ)
+{
+	const int LocalX = a_ChunkX - m_LayerX * LAYER_SIZE;
+	const int LocalZ = a_ChunkZ - m_LayerZ * LAYER_SIZE;
+	ASSERT((LocalX >= 0) && (LocalX < LAYER_SIZE) && (LocalZ >= 0) && (LocalZ < LAYER_SIZE));
+	int Index = LocalX + LocalZ * LAYER_SIZE;
+	if (
+		(m_Chunks[Index] == nullptr) ||
+		!m_Chunks[Index]->CanUnload() ||
+		cPluginManager::Get()->CallHookChunkUnloading(*(m_Parent->GetWorld()), a_ChunkX, a_ChunkZ)
+	)
+	{
+		return false;
+	}
+
+	// First delete, then nullptrify, see UnloadUnusedChunks() below:
+	m_Parent->m_NumChunksDeleted += 1;
+	delete m_Chunks[Index];
+	m_Chunks[Index] = nullptr;
+	return true;
+}
+
+
+
+
+
 void cChunkMap::cChunkLayer::UnloadUnusedChunks(void)
 {
 	for (size_t i = 0; i < ARRAYCOUNT(m_Chunks); i++)
@@ -3108,6 +3218,7 @@ void cChunkMap::cChunkLayer::UnloadUnusedChunks(void)
 			// The cChunk destructor calls our GetChunk() while removing its entities
 			// so we still need to be able to return the chunk. Therefore we first delete, then nullptrify
 			// Doing otherwise results in bug http://forum.mc-server.org/showthread.php?tid=355
+			m_Parent->m_NumChunksDeleted += 1;
 			delete m_Chunks[i];
 			m_Chunks[i] = nullptr;
 		}
@@ -37,6 +37,10 @@ class cMobCensus;
 class cMobSpawner;
 class cSetChunkData;
 class cBoundingBox;
+class cExplosionEngine;
+class cEntityTracker;
+struct sAutosaveCandidate;
+struct sUnloadCandidate;
 
 typedef std::list<cClientHandle *>         cClientHandleList;
 typedef cChunk *                           cChunkPtr;
@@ -53,6 +57,8 @@ typedef cItemCallback<cNoteEntity>         cNoteBlockCallback;
 typedef cItemCallback<cCommandBlockEntity> cCommandBlockCallback;
 typedef cItemCallback<cMobHeadEntity>      cMobHeadCallback;
 typedef cItemCallback<cChunk>              cChunkCallback;
+typedef std::vector<sAutosaveCandidate>    cAutosaveCandidates;
+typedef std::vector<sUnloadCandidate>      cUnloadCandidates;
 
 
 
@@ -82,6 +88,7 @@ public:
 	void BroadcastEntityHeadLook(const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityLook(const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityMetadata(const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
+	void BroadcastEntityMovement(const cEntity & a_Entity, cEntityTracker & a_Tracker, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMoveLook(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityStatus(const cEntity & a_Entity, char a_Status, const cClientHandle * a_Exclude = nullptr);
@@ -110,6 +117,11 @@ public:
 	/** Wakes up the simulators for the specified area of blocks */
 	void WakeUpSimulatorsInArea(int a_MinBlockX, int a_MaxBlockX, int a_MinBlockY, int a_MaxBlockY, int a_MinBlockZ, int a_MaxBlockZ);
 
+	/** Wakes up the sleeping block entities that may react to a change at the specified block.
+	That is all the block entities up to 2 blocks away horizontally and 1 block vertically, so that hoppers
+	next to either half of a double chest get woken up, too. */
+	void WakeUpBlockEntitiesAround(int a_BlockX, int a_BlockY, int a_BlockZ);
+
 	void MarkRedstoneDirty  (int a_ChunkX, int a_ChunkZ);
 	void MarkChunkDirty     (int a_ChunkX, int a_ChunkZ, bool a_MarkRedstoneDirty = false);
 	void MarkChunkSaving    (int a_ChunkX, int a_ChunkZ);
@@ -138,6 +150,10 @@ public:
 
 	bool      IsChunkValid       (int a_ChunkX, int a_ChunkZ);
 	bool      HasChunkAnyClients (int a_ChunkX, int a_ChunkZ);
+
+	/** Appends all the clients that have the specified chunk loaded to a_Clients. */
+	void GetChunkClients(int a_ChunkX, int a_ChunkZ, cClientHandleList & a_Clients);
+
 	int       GetHeight          (int a_BlockX, int a_BlockZ);  // Waits for the chunk to get loaded / generated
 	bool      TryGetHeight       (int a_BlockX, int a_BlockZ, int & a_Height);  // Returns false if chunk not loaded / generated
 	void FastSetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta);
@@ -233,8 +249,13 @@ public:
 	If any chunk in the box is missing, ignores the entities in that chunk silently. */
 	bool ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback & a_Callback);  // Lua-accessible
 
-	/** Destroys and returns a list of blocks destroyed in the explosion at the specified coordinates */
+	/** Destroys and returns a list of blocks destroyed in the explosion at the specified coordinates.
+	The blocks are destroyed in the explosion snapshot and written into the chunks by FlushExplosions() at the end of the tick. */
 	void DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_BlockY, double a_BlockZ, cVector3iArray & a_BlockAffected);
+
+	/** Writes the blocks destroyed by the explosions since the last flush into the chunks and wakes up the simulators around them.
+	Called at the end of each Tick(); exposed so that the changes can be applied right away when needed. */
+	void FlushExplosions(void);
 	
 	/** Calls the callback if the entity with the specified ID is found, with the entity object as the callback param. Returns true if entity found and callback returned false. */
 	bool DoWithEntityByID(int a_UniqueID, cEntityCallback & a_Callback);  // Lua-accessible
@@ -356,6 +377,20 @@ public:
 	void UnloadUnusedChunks(void);
 	void SaveAllChunks(void);
 
+	/** Adds all the dirty chunks that are neither queued for saving nor being saved into a_Candidates. Used by the autosave scheduler. */
+	void CollectAutosaveCandidates(cAutosaveCandidates & a_Candidates);
+
+	/** Queues the specified chunks in the storage for saving; skips those that are no longer valid or dirty, or are already queued.
+	Returns the number of chunks queued. */
+	int QueueChunksForSave(const cAutosaveCandidates & a_Chunks);
+
+	/** Adds all the chunks that are used by no client nor chunkstay, and are neither queued for loading nor being saved,
+	into a_Candidates. Used by the unload governor. */
+	void CollectUnloadCandidates(cUnloadCandidates & a_Candidates);
+
+	/** Unloads the specified chunks, if they still can be unloaded and the plugins agree. Returns the number of chunks unloaded. */
+	int UnloadChunks(const cUnloadCandidates & a_Chunks);
+
 	cWorld * GetWorld(void) { return m_World; }
 
 	int GetNumChunks(void);
@@ -383,6 +418,9 @@ private:
 	// The chunkstay can (de-)register itself using AddChunkStay() and DelChunkStay()
 	friend class cChunkStay;
 	
+	// The chunk cursor looks up chunks directly using FindChunk()
+	friend class cChunkCursor;
+	
 
 	class cChunkLayer
 	{
@@ -409,6 +447,15 @@ private:
 		
 		void Save(void);
 		void UnloadUnusedChunks(void);
+
+		/** Adds the layer's dirty chunks that can be queued for saving into a_Candidates */
+		void CollectAutosaveCandidates(cAutosaveCandidates & a_Candidates) const;
+
+		/** Adds the layer's unused chunks that may be unloaded (now or once saved) into a_Candidates */
+		void CollectUnloadCandidates(cUnloadCandidates & a_Candidates) const;
+
+		/** Unloads the specified chunk, if it can be unloaded and the plugins agree. Returns true if unloaded. */
+		bool UnloadChunk(int a_ChunkX, int a_ChunkZ);
 		
 		/** Collect a mob census, of all mobs, their megatype, their chunk and their distance o closest player */
 		void CollectMobCensus(cMobCensus& a_ToFill);
@@ -439,23 +486,6 @@ private:
 		cAllocationPool<cChunkData::sChunkSection> & m_Pool;
 	};
 	
-	class cStarvationCallbacks
-		: public cAllocationPool<cChunkData::sChunkSection>::cStarvationCallbacks
-	{
-		virtual void OnStartUsingReserve() override
-		{
-			LOG("Using backup memory buffer");
-		}
-		virtual void OnEndUsingReserve() override
-		{
-			LOG("Stoped using backup memory buffer");
-		}
-		virtual void OnOutOfReserve() override
-		{
-			LOG("Out of Memory");
-		}
-	};
-	
 	typedef std::list<cChunkLayer *> cChunkLayerList;
 	
 	typedef std::list<cChunkStay *> cChunkStays;
@@ -478,6 +508,10 @@ private:
 	cChunkLayerList  m_Layers;
 	cEvent           m_evtChunkValid;  // Set whenever any chunk becomes valid, via ChunkValidated()
 
+	/** Incremented whenever a chunk object is deleted, protected by m_CSLayers.
+	Lets the cChunkCursor that doesn't hold the lock detect that its remembered chunk may be gone. */
+	UInt64 m_NumChunksDeleted;
+
 	cWorld * m_World;
 	
 	cCriticalSection m_CSFastSetBlock;
@@ -486,7 +520,8 @@ private:
 	/** The cChunkStay descendants that are currently enabled in this chunkmap */
 	cChunkStays m_ChunkStays;
 
-	std::auto_ptr<cAllocationPool<cChunkData::sChunkSection> > m_Pool;
+	/** Computes the blocks destroyed by explosions, merges all explosions within a tick into a single write */
+	std::unique_ptr<cExplosionEngine> m_Explosions;
 
 	cChunkPtr GetChunk      (int a_ChunkX, int a_ChunkZ);  // Also queues the chunk for loading / generating if not valid
 	cChunkPtr GetChunkNoGen (int a_ChunkX, int a_ChunkZ);  // Also queues the chunk for loading if not valid; doesn't generate
@@ -0,0 +1,573 @@
+
+// ChunkSectionPool.cpp
+
+// Implements the cChunkSectionPool class, the slab allocator for the chunk sections shared by all the worlds
+
+#include "Globals.h"
+#include "ChunkSectionPool.h"
+#include "CommandOutput.h"
+#include "Metrics.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+		#define MAP_ANONYMOUS MAP_ANON
+	#endif
+#endif
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunkSectionPool:
+
+THREAD_LOCAL cChunkSectionPool::sThreadCache cChunkSectionPool::s_ThreadCache;
+
+
+
+
+
+cChunkSectionPool::cChunkSectionPool(void) :
+	m_PartialSlabs(nullptr),
+	m_EmptySlabs(nullptr),
+	m_IsUsingReserve(false),
+	m_NumSlabsFull(0),
+	m_NumSlabsPartial(0),
+	m_NumSlabsEmpty(0),
+	m_NumSlabsHugePages(0),
+	m_NumSectionsUsed(0),
+	m_NumSectionsInUse(0),
+	m_UseHugePages(false)
+{
+	static_assert(sizeof(sChunkSection) >= sizeof(sFreeElement), "The section is too small to hold the free list link");
+
+	#ifdef _WIN32
+		m_ThreadExitSlot = FlsAlloc(OnThreadExit);
+		if (m_ThreadExitSlot == FLS_OUT_OF_INDEXES)
+		{
+			LOGWARNING("Cannot register the chunk section caches for the thread exit, the exiting threads will leak up to " SIZE_T_FMT " sections each", THREAD_CACHE_SIZE);
+		}
+	#else
+		if (pthread_key_create(&m_ThreadExitKey, OnThreadExit) != 0)
+		{
+			LOGWARNING("Cannot register the chunk section caches for the thread exit, the exiting threads will leak up to " SIZE_T_FMT " sections each", THREAD_CACHE_SIZE);
+		}
+	#endif
+
+	// Map the reserve upfront, while there is memory:
+	cCSLock Lock(m_CS);
+	for (size_t i = 0; i < MAX_RESERVE_SLABS; i++)
+	{
+		sSlab * Slab = CreateSlab();
+		if (Slab == nullptr)
+		{
+			LOGWARNING("Cannot allocate the reserve for the chunk sections, only " SIZE_T_FMT " of " SIZE_T_FMT " slabs are available", i, MAX_RESERVE_SLABS);
+			break;
+		}
+		LinkSlab(m_EmptySlabs, Slab);
+		m_NumSlabsEmpty += 1;
+	}
+}
+
+
+
+
+
+cChunkSectionPool::~cChunkSectionPool()
+{
+	// Only the reserve slabs can be released; any remaining used sections belong to chunks that were never unloaded:
+	while (m_EmptySlabs != nullptr)
+	{
+		sSlab * Slab = m_EmptySlabs;
+		UnlinkSlab(m_EmptySlabs, Slab);
+		ReleaseSlab(Slab);
+	}
+}
+
+
+
+
+
+cChunkSectionPool & cChunkSectionPool::Get(void)
+{
+	static cChunkSectionPool Instance;
+	return Instance;
+}
+
+
+
+
+
+void cChunkSectionPool::SetUseHugePages(bool a_UseHugePages)
+{
+	cCSLock Lock(m_CS);
+	m_UseHugePages = a_UseHugePages;
+}
+
+
+
+
+
+cChunkSectionPool::sStats cChunkSectionPool::GetStats(void)
+{
+	cCSLock Lock(m_CS);
+	sStats Stats;
+	Stats.m_NumSlabsFull = m_NumSlabsFull;
+	Stats.m_NumSlabsPartial = m_NumSlabsPartial;
+	Stats.m_NumSlabsEmpty = m_NumSlabsEmpty;
+	Stats.m_NumSlabsHugePages = m_NumSlabsHugePages;
+	// The threads may be just moving sections into or out of their caches, so the in-use count may be momentarily off:
+	Stats.m_NumSectionsUsed = std::min(m_NumSectionsInUse.load(std::memory_order_relaxed), m_NumSectionsUsed);
+	Stats.m_NumSectionsCached = m_NumSectionsUsed - Stats.m_NumSectionsUsed;
+	Stats.m_NumSectionsFreeEmpty = m_NumSlabsEmpty * GetSectionsPerSlab();
+	Stats.m_NumSectionsFreePartial = (m_NumSlabsFull + m_NumSlabsPartial) * GetSectionsPerSlab() - m_NumSectionsUsed;
+	return Stats;
+}
+
+
+
+
+
+size_t cChunkSectionPool::GetUsedMemory(void)
+{
+	cCSLock Lock(m_CS);
+	size_t SlabOverhead = SLAB_SIZE - GetSectionsPerSlab() * sizeof(sChunkSection);
+	return m_NumSectionsUsed * sizeof(sChunkSection) + (m_NumSlabsFull + m_NumSlabsPartial) * SlabOverhead;
+}
+
+
+
+
+
+void cChunkSectionPool::LogStats(cCommandOutputCallback & a_Output)
+{
+	sStats Stats = GetStats();
+	size_t NumSlabs = Stats.m_NumSlabsFull + Stats.m_NumSlabsPartial + Stats.m_NumSlabsEmpty;
+	a_Output.Out("Chunk section pool:");
+	a_Output.Out("  Slabs: " SIZE_T_FMT " (" SIZE_T_FMT " MiB), " SIZE_T_FMT " full, " SIZE_T_FMT " partial, " SIZE_T_FMT " empty, " SIZE_T_FMT " on huge pages",
+		NumSlabs, NumSlabs * SLAB_SIZE / (1024 * 1024), Stats.m_NumSlabsFull, Stats.m_NumSlabsPartial, Stats.m_NumSlabsEmpty, Stats.m_NumSlabsHugePages
+	);
+	a_Output.Out("  Sections: " SIZE_T_FMT " used, " SIZE_T_FMT " cached by threads, " SIZE_T_FMT " free in partial slabs, " SIZE_T_FMT " free in empty slabs",
+		Stats.m_NumSectionsUsed, Stats.m_NumSectionsCached, Stats.m_NumSectionsFreePartial, Stats.m_NumSectionsFreeEmpty
+	);
+}
+
+
+
+
+
+void cChunkSectionPool::CollectMetrics(cMetricsWriter & a_Writer)
+{
+	sStats Stats = GetStats();
+	a_Writer.BeginFamily("mcserver_chunk_section_pool_slabs", "Number of slabs in the chunk section pool, by their occupancy", "gauge");
+	a_Writer.Sample("mcserver_chunk_section_pool_slabs", cMetricsWriter::Label("state", "full"),    static_cast<UInt64>(Stats.m_NumSlabsFull));
+	a_Writer.Sample("mcserver_chunk_section_pool_slabs", cMetricsWriter::Label("state", "partial"), static_cast<UInt64>(Stats.m_NumSlabsPartial));
+	a_Writer.Sample("mcserver_chunk_section_pool_slabs", cMetricsWriter::Label("state", "empty"),   static_cast<UInt64>(Stats.m_NumSlabsEmpty));
+	a_Writer.BeginFamily("mcserver_chunk_section_pool_huge_page_slabs", "Number of slabs in the chunk section pool backed by explicit huge pages", "gauge");
+	a_Writer.Sample("mcserver_chunk_section_pool_huge_page_slabs", "", static_cast<UInt64>(Stats.m_NumSlabsHugePages));
+	a_Writer.BeginFamily("mcserver_chunk_section_pool_sections", "Number of sections in the chunk section pool, by their state", "gauge");
+	a_Writer.Sample("mcserver_chunk_section_pool_sections", cMetricsWriter::Label("state", "used"),         static_cast<UInt64>(Stats.m_NumSectionsUsed));
+	a_Writer.Sample("mcserver_chunk_section_pool_sections", cMetricsWriter::Label("state", "cached"),       static_cast<UInt64>(Stats.m_NumSectionsCached));
+	a_Writer.Sample("mcserver_chunk_section_pool_sections", cMetricsWriter::Label("state", "free_partial"), static_cast<UInt64>(Stats.m_NumSectionsFreePartial));
+	a_Writer.Sample("mcserver_chunk_section_pool_sections", cMetricsWriter::Label("state", "free_empty"),   static_cast<UInt64>(Stats.m_NumSectionsFreeEmpty));
+}
+
+
+
+
+
+cChunkSectionPool::sChunkSection * cChunkSectionPool::Allocate()
+{
+	sThreadCache & Cache = GetThreadCache();
+	if (Cache.m_NumSections == 0)
+	{
+		RefillThreadCache(Cache, THREAD_CACHE_SIZE / 2);
+	}
+	Cache.m_NumSections -= 1;
+	m_NumSectionsInUse.fetch_add(1, std::memory_order_relaxed);
+	return new(Cache.m_Sections[Cache.m_NumSections]) sChunkSection;
+}
+
+
+
+
+
+void cChunkSectionPool::Free(sChunkSection * a_Section)
+{
+	if (a_Section == nullptr)
+	{
+		return;
+	}
+	a_Section->~sChunkSection();
+	m_NumSectionsInUse.fetch_sub(1, std::memory_order_relaxed);
+
+	sThreadCache & Cache = GetThreadCache();
+	if (Cache.m_NumSections == THREAD_CACHE_SIZE)
+	{
+		FlushThreadCache(Cache, THREAD_CACHE_SIZE / 2);
+	}
+	Cache.m_Sections[Cache.m_NumSections] = a_Section;
+	Cache.m_NumSections += 1;
+}
+
+
+
+
+
+cChunkSectionPool::sThreadCache & cChunkSectionPool::GetThreadCache(void)
+{
+	sThreadCache & Cache = s_ThreadCache;
+	if (!Cache.m_IsRegisteredForExit)
+	{
+		// The OS calls OnThreadExit() with the registered non-null value when the thread exits:
+		#ifdef _WIN32
+			if (m_ThreadExitSlot != FLS_OUT_OF_INDEXES)
+			{
+				FlsSetValue(m_ThreadExitSlot, &Cache);
+			}
+		#else
+			pthread_setspecific(m_ThreadExitKey, &Cache);
+		#endif
+		Cache.m_IsRegisteredForExit = true;
+	}
+	return Cache;
+}
+
+
+
+
+
+#ifdef _WIN32
+	void WINAPI cChunkSectionPool::OnThreadExit(void * a_Cache)
+#else
+	void cChunkSectionPool::OnThreadExit(void * a_Cache)
+#endif
+{
+	sThreadCache & Cache = *static_cast<sThreadCache *>(a_Cache);
+	if (Cache.m_NumSections > 0)
+	{
+		Get().FlushThreadCache(Cache, Cache.m_NumSections);
+	}
+}
+
+
+
+
+
+void cChunkSectionPool::RefillThreadCache(sThreadCache & a_Cache, size_t a_Count)
+{
+	ASSERT(a_Cache.m_NumSections + a_Count <= THREAD_CACHE_SIZE);
+
+	{
+		cCSLock Lock(m_CS);
+		while (a_Count > 0)
+		{
+			sChunkSection * Section = TakeSection();
+			if (Section == nullptr)
+			{
+				break;
+			}
+			a_Cache.m_Sections[a_Cache.m_NumSections] = Section;
+			a_Cache.m_NumSections += 1;
+			a_Count -= 1;
+		}
+	}
+	if (a_Cache.m_NumSections > 0)
+	{
+		return;
+	}
+
+	// Both the OS and the reserve are out of memory. Waiting for the memory to be freed could hang the server, since the
+	// callers usually hold the chunkmap locks; report the failure instead:
+	LOGERROR("Out of memory for the chunk sections, including the reserve");
+	throw std::bad_alloc();
+}
+
+
+
+
+
+void cChunkSectionPool::FlushThreadCache(sThreadCache & a_Cache, size_t a_Count)
+{
+	ASSERT(a_Count <= a_Cache.m_NumSections);
+
+	cCSLock Lock(m_CS);
+	for (size_t i = 0; i < a_Count; i++)
+	{
+		a_Cache.m_NumSections -= 1;
+		ReturnSection(a_Cache.m_Sections[a_Cache.m_NumSections]);
+	}
+}
+
+
+
+
+
+cChunkSectionPool::sChunkSection * cChunkSectionPool::TakeSection(void)
+{
+	ASSERT(m_CS.IsLockedByCurrentThread());
+
+	// Use the partially used slabs first, then ask the OS for more memory, and only then use the reserve:
+	sSlab * Slab = m_PartialSlabs;
+	if (Slab == nullptr)
+	{
+		for (int i = 0; (i < NUM_SLAB_ALLOC_ATTEMPTS) && (Slab == nullptr); i++)
+		{
+			Slab = CreateSlab();
+		}
+		if (Slab == nullptr)
+		{
+			Slab = m_EmptySlabs;
+			if (Slab == nullptr)
+			{
+				return nullptr;
+			}
+			if (!m_IsUsingReserve)
+			{
+				LOGWARNING("Out of memory for the chunk sections, using the reserve");
+				m_IsUsingReserve = true;
+			}
+			UnlinkSlab(m_EmptySlabs, Slab);
+			m_NumSlabsEmpty -= 1;
+		}
+		LinkSlab(m_PartialSlabs, Slab);
+		m_NumSlabsPartial += 1;
+	}
+
+	void * Section;
+	if (Slab->m_FreeList != nullptr)
+	{
+		Section = Slab->m_FreeList;
+		Slab->m_FreeList = Slab->m_FreeList->m_Next;
+	}
+	else
+	{
+		ASSERT(Slab->m_NumCarved < GetSectionsPerSlab());
+		Section = reinterpret_cast<char *>(Slab) + GetFirstSectionOffset() + Slab->m_NumCarved * sizeof(sChunkSection);
+		Slab->m_NumCarved += 1;
+	}
+	Slab->m_NumUsed += 1;
+	m_NumSectionsUsed += 1;
+
+	if (Slab->m_NumUsed == GetSectionsPerSlab())
+	{
+		// The slab is now full, it doesn't need to be in any list:
+		UnlinkSlab(m_PartialSlabs, Slab);
+		m_NumSlabsPartial -= 1;
+		m_NumSlabsFull += 1;
+	}
+	return reinterpret_cast<sChunkSection *>(Section);
+}
+
+
+
+
+
+void cChunkSectionPool::ReturnSection(sChunkSection * a_Section)
+{
+	ASSERT(m_CS.IsLockedByCurrentThread());
+
+	sSlab * Slab = GetSlab(a_Section);
+	ASSERT(Slab->m_NumUsed > 0);
+	if (Slab->m_NumUsed == GetSectionsPerSlab())
+	{
+		// The slab was full, now it is partially used:
+		LinkSlab(m_PartialSlabs, Slab);
+		m_NumSlabsFull -= 1;
+		m_NumSlabsPartial += 1;
+	}
+
+	sFreeElement * Element = reinterpret_cast<sFreeElement *>(a_Section);
+	Element->m_Next = Slab->m_FreeList;
+	Slab->m_FreeList = Element;
+	Slab->m_NumUsed -= 1;
+	m_NumSectionsUsed -= 1;
+
+	if (Slab->m_NumUsed == 0)
+	{
+		// The slab is now empty, keep it as the reserve or return it to the OS:
+		UnlinkSlab(m_PartialSlabs, Slab);
+		m_NumSlabsPartial -= 1;
+		if (m_NumSlabsEmpty < MAX_RESERVE_SLABS)
+		{
+			LinkSlab(m_EmptySlabs, Slab);
+			m_NumSlabsEmpty += 1;
+			if (m_IsUsingReserve && (m_NumSlabsEmpty == MAX_RESERVE_SLABS))
+			{
+				LOG("The reserve for the chunk sections has been refilled");
+				m_IsUsingReserve = false;
+			}
+		}
+		else
+		{
+			ReleaseSlab(Slab);
+		}
+	}
+}
+
+
+
+
+
+cChunkSectionPool::sSlab * cChunkSectionPool::CreateSlab(void)
+{
+	ASSERT(m_CS.IsLockedByCurrentThread());
+
+	void * RawMemory = nullptr;
+	void * Memory = nullptr;
+	bool IsHugePage = false;
+
+	#ifdef _WIN32
+		// Reserve twice the size, so that an aligned slab fits in, then commit only the aligned slab:
+		RawMemory = VirtualAlloc(nullptr, 2 * SLAB_SIZE, MEM_RESERVE, PAGE_NOACCESS);
+		if (RawMemory == nullptr)
+		{
+			return nullptr;
+		}
+		uintptr_t Aligned = (reinterpret_cast<uintptr_t>(RawMemory) + SLAB_SIZE - 1) & ~static_cast<uintptr_t>(SLAB_SIZE - 1);
+		Memory = VirtualAlloc(reinterpret_cast<void *>(Aligned), SLAB_SIZE, MEM_COMMIT, PAGE_READWRITE);
+		if (Memory == nullptr)
+		{
+			VirtualFree(RawMemory, 0, MEM_RELEASE);
+			return nullptr;
+		}
+	#else
+		#ifdef MAP_HUGETLB
+			if (m_UseHugePages)
+			{
+				// The explicit huge pages are aligned to their size; they fail if the admin hasn't reserved any:
+				Memory = mmap(nullptr, SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+				if (Memory == MAP_FAILED)
+				{
+					Memory = nullptr;
+				}
+				else
+				{
+					IsHugePage = true;
+				}
+			}
+		#endif
+		if (Memory == nullptr)
+		{
+			// Map twice the size, then unmap the parts before and after the aligned slab:
+			void * Mapped = mmap(nullptr, 2 * SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (Mapped == MAP_FAILED)
+			{
+				return nullptr;
+			}
+			uintptr_t Start = reinterpret_cast<uintptr_t>(Mapped);
+			uintptr_t Aligned = (Start + SLAB_SIZE - 1) & ~static_cast<uintptr_t>(SLAB_SIZE - 1);
+			if (Aligned > Start)
+			{
+				munmap(Mapped, Aligned - Start);
+			}
+			if (Start + SLAB_SIZE > Aligned)
+			{
+				munmap(reinterpret_cast<void *>(Aligned + SLAB_SIZE), Start + SLAB_SIZE - Aligned);
+			}
+			Memory = reinterpret_cast<void *>(Aligned);
+			#ifdef MADV_HUGEPAGE
+				if (m_UseHugePages)
+				{
+					madvise(Memory, SLAB_SIZE, MADV_HUGEPAGE);
+				}
+			#endif
+		}
+		RawMemory = Memory;
+	#endif
+
+	sSlab * Slab = new(Memory) sSlab;
+	Slab->m_Prev = nullptr;
+	Slab->m_Next = nullptr;
+	Slab->m_FreeList = nullptr;
+	Slab->m_NumUsed = 0;
+	Slab->m_NumCarved = 0;
+	Slab->m_RawMemory = RawMemory;
+	Slab->m_IsHugePage = IsHugePage;
+	if (IsHugePage)
+	{
+		m_NumSlabsHugePages += 1;
+	}
+	return Slab;
+}
+
+
+
+
+
+void cChunkSectionPool::ReleaseSlab(sSlab * a_Slab)
+{
+	if (a_Slab->m_IsHugePage)
+	{
+		m_NumSlabsHugePages -= 1;
+	}
+	#ifdef _WIN32
+		VirtualFree(a_Slab->m_RawMemory, 0, MEM_RELEASE);
+	#else
+		munmap(a_Slab->m_RawMemory, SLAB_SIZE);
+	#endif
+}
+
+
+
+
+
+void cChunkSectionPool::LinkSlab(sSlab *& a_List, sSlab * a_Slab)
+{
+	a_Slab->m_Prev = nullptr;
+	a_Slab->m_Next = a_List;
+	if (a_List != nullptr)
+	{
+		a_List->m_Prev = a_Slab;
+	}
+	a_List = a_Slab;
+}
+
+
+
+
+
+void cChunkSectionPool::UnlinkSlab(sSlab *& a_List, sSlab * a_Slab)
+{
+	if (a_Slab->m_Prev != nullptr)
+	{
+		a_Slab->m_Prev->m_Next = a_Slab->m_Next;
+	}
+	else
+	{
+		ASSERT(a_List == a_Slab);
+		a_List = a_Slab->m_Next;
+	}
+	if (a_Slab->m_Next != nullptr)
+	{
+		a_Slab->m_Next->m_Prev = a_Slab->m_Prev;
+	}
+	a_Slab->m_Prev = nullptr;
+	a_Slab->m_Next = nullptr;
+}
+
+
+
+
+
+size_t cChunkSectionPool::GetFirstSectionOffset(void)
+{
+	// Start the sections at a cache line boundary:
+	return (sizeof(sSlab) + 63) & ~static_cast<size_t>(63);
+}
+
+
+
+
+
+size_t cChunkSectionPool::GetSectionsPerSlab(void)
+{
+	return (SLAB_SIZE - GetFirstSectionOffset()) / sizeof(sChunkSection);
+}
+
+
+
+
@@ -0,0 +1,252 @@
+
+// ChunkSectionPool.h
+
+// Declares the cChunkSectionPool class, the slab allocator for the chunk sections shared by all the worlds
+
+/*
+A loaded chunk stores its blocks in up to 16 cChunkData::sChunkSection objects of about 10 KiB each; a large server
+holds hundreds of thousands of them. Allocating each section from the heap separately scatters them all over the
+address space, so walking the chunks (lighting, saving, sending) keeps missing the TLB.
+This pool allocates the sections from slabs instead: contiguous, SLAB_SIZE-aligned blocks of memory, each holding
+the slab header followed by as many sections as fit. The alignment makes the slab of any section a single masking
+operation away, and lets the kernel back the slab with a single huge page, if enabled in the settings (explicit
+huge pages are tried first, transparent huge pages are the fallback; on Windows the slabs always use normal pages).
+Each slab keeps its own intrusive free list, the sections are allocated from the partially used slabs first, so
+that the slabs fill up and the completely free slabs can be returned to the OS. A few free slabs are mapped upfront
+and kept as the reserve for when the OS runs out of memory, the same way the old cListAllocationPool kept its backup
+buffer: the reserve is only used when the OS refuses a new slab, and the slabs that become free refill it first.
+If even the reserve runs out, Allocate() throws std::bad_alloc; it never waits for the memory, since its callers
+usually hold the chunkmap locks.
+Each thread keeps a small cache of the free sections; the sections are moved between the thread's cache and the
+slabs in batches, so most of the allocations and frees don't lock the pool at all. The cache is returned to the slabs
+when the thread exits, from an OS thread-exit callback (pthread key destructor / fiber-local storage callback). This helps especially the storage
+thread, which frees the sections of the chunk snapshots after saving them, while the tick thread allocates them.
+The pool is shared by all the worlds, so that the cache of a thread is never bound to a world that is being unloaded.
+*/
+
+
+
+
+
+#pragma once
+
+#include "ChunkData.h"
+
+
+
+
+
+// fwd:
+class cCommandOutputCallback;
+class cMetricsWriter;
+
+
+
+
+
+class cChunkSectionPool :
+	public cAllocationPool<cChunkData::sChunkSection>
+{
+public:
+	typedef cChunkData::sChunkSection sChunkSection;
+
+	/** Size of a single slab, in bytes; also the slab alignment. The size of a huge page on x86. */
+	static const size_t SLAB_SIZE = 2 * 1024 * 1024;
+
+	/** Maximum number of free sections kept by each thread */
+	static const size_t THREAD_CACHE_SIZE = 32;
+
+	/** Number of completely free slabs kept as the reserve for when the OS runs out of memory, the further free slabs
+	are returned to the OS */
+	static const size_t MAX_RESERVE_SLABS = 8;
+
+	/** Number of times a new slab is requested from the OS before falling back to the reserve */
+	static const int NUM_SLAB_ALLOC_ATTEMPTS = 3;
+
+	/** The statistics of the pool */
+	struct sStats
+	{
+		/** Number of slabs, by their occupancy */
+		size_t m_NumSlabsFull;
+		size_t m_NumSlabsPartial;
+		size_t m_NumSlabsEmpty;
+
+		/** Number of the slabs backed by huge pages (explicit huge pages only, the transparent ones cannot be detected) */
+		size_t m_NumSlabsHugePages;
+
+		/** Number of sections used by the chunks */
+		size_t m_NumSectionsUsed;
+
+		/** Number of free sections held in the threads' caches */
+		size_t m_NumSectionsCached;
+
+		/** Number of free sections in the partially used slabs; this is the fragmentation of the pool */
+		size_t m_NumSectionsFreePartial;
+
+		/** Number of free sections in the empty slabs kept as the reserve */
+		size_t m_NumSectionsFreeEmpty;
+	} ;
+
+
+	/** Returns the single instance of the pool. */
+	static cChunkSectionPool & Get(void);
+
+	/** Sets whether the newly allocated slabs should be backed by huge pages. */
+	void SetUseHugePages(bool a_UseHugePages);
+
+	/** Returns the current statistics of the pool. */
+	sStats GetStats(void);
+
+	/** Returns the memory taken by the used sections, including those in the threads' caches, plus the overhead of
+	the slabs holding them (the slab header and the unusable tail of each non-empty slab), in bytes.
+	The free sections in the partially used slabs and the reserve slabs are not counted. */
+	size_t GetUsedMemory(void);
+
+	/** Outputs the statistics of the pool, used by the "chunkstats" console command. */
+	void LogStats(cCommandOutputCallback & a_Output);
+
+	/** Writes the statistics of the pool as metric families, used by the metrics export. */
+	void CollectMetrics(cMetricsWriter & a_Writer);
+
+	// cAllocationPool overrides:
+	virtual sChunkSection * Allocate() override;
+	virtual void Free(sChunkSection * a_Section) override;
+
+protected:
+	/** The link stored in each free section within a slab */
+	struct sFreeElement
+	{
+		sFreeElement * m_Next;
+	} ;
+
+	/** The header at the start of each slab */
+	struct sSlab
+	{
+		/** Links in the list of the partially used slabs, or the list of the empty slabs; unused for full slabs */
+		sSlab * m_Prev;
+		sSlab * m_Next;
+
+		/** The free sections that have been used before */
+		sFreeElement * m_FreeList;
+
+		/** Number of the sections allocated from this slab, including those held in the threads' caches */
+		size_t m_NumUsed;
+
+		/** Number of sections from the start of the slab that have ever been handed out; the rest of the slab is
+		handed out sequentially, so that the memory isn't touched before it is needed. */
+		size_t m_NumCarved;
+
+		/** The memory as allocated from the OS, to be released */
+		void * m_RawMemory;
+
+		/** True if the slab is backed by explicit huge pages */
+		bool m_IsHugePage;
+	} ;
+
+	/** The free sections held by a single thread.
+	Kept trivially constructible and destructible, so that it can be THREAD_LOCAL; starts zero-initialized. */
+	struct sThreadCache
+	{
+		size_t m_NumSections;
+		sChunkSection * m_Sections[THREAD_CACHE_SIZE];
+
+		/** Set once the cache is registered with the OS for flushing at the thread's exit */
+		bool m_IsRegisteredForExit;
+	} ;
+
+	/** The free sections cached by the current thread */
+	static THREAD_LOCAL sThreadCache s_ThreadCache;
+
+
+	/** Protects all the slabs and the lists and counters below, except m_NumSectionsInUse.
+	The threads' caches are only accessed by their own threads. */
+	cCriticalSection m_CS;
+
+	/** The slabs that have both used and free sections, the sections are allocated from these first */
+	sSlab * m_PartialSlabs;
+
+	/** The completely free slabs kept as the reserve */
+	sSlab * m_EmptySlabs;
+
+	/** True while the reserve is being used, between the first failure of the OS and the reserve refilling */
+	bool m_IsUsingReserve;
+
+	size_t m_NumSlabsFull;
+	size_t m_NumSlabsPartial;
+	size_t m_NumSlabsEmpty;
+	size_t m_NumSlabsHugePages;
+
+	/** Number of sections allocated from the slabs, including those held in the threads' caches */
+	size_t m_NumSectionsUsed;
+
+	/** Number of sections handed out to the chunks; the rest of m_NumSectionsUsed is held in the threads' caches.
+	Updated without locking, as each allocation and free changes it. */
+	std::atomic<size_t> m_NumSectionsInUse;
+
+	bool m_UseHugePages;
+
+	#ifdef _WIN32
+		/** The fiber-local storage slot whose callback returns the cache of an exiting thread */
+		DWORD m_ThreadExitSlot;
+	#else
+		/** The thread-specific key whose destructor returns the cache of an exiting thread */
+		pthread_key_t m_ThreadExitKey;
+	#endif
+
+
+	cChunkSectionPool(void);
+	virtual ~cChunkSectionPool();
+
+	/** Returns the calling thread's cache, registering it to be flushed at the thread's exit on the first use. */
+	sThreadCache & GetThreadCache(void);
+
+	/** Returns all the sections in the cache of an exiting thread to the slabs. Called by the OS on thread exit. */
+	#ifdef _WIN32
+		static void WINAPI OnThreadExit(void * a_Cache);
+	#else
+		static void OnThreadExit(void * a_Cache);
+	#endif
+
+	/** Fills the thread's cache with up to a_Count sections from the slabs. Allocates new slabs as needed.
+	Throws std::bad_alloc if not even a single section is available. */
+	void RefillThreadCache(sThreadCache & a_Cache, size_t a_Count);
+
+	/** Returns a_Count sections from the end of the thread's cache into their slabs. */
+	void FlushThreadCache(sThreadCache & a_Cache, size_t a_Count);
+
+	/** Takes a single free section from the slabs: the partially used slabs first, then a new slab from the OS, and
+	the reserve only if the OS fails. Returns nullptr if out of memory. Assumes m_CS is held. */
+	sChunkSection * TakeSection(void);
+
+	/** Returns a single section to its slab, releasing the slab if it becomes free and there are enough reserve slabs.
+	Assumes m_CS is held. */
+	void ReturnSection(sChunkSection * a_Section);
+
+	/** Returns a new slab, with all its sections free. Returns nullptr if out of memory. Assumes m_CS is held. */
+	sSlab * CreateSlab(void);
+
+	/** Returns the slab's memory to the OS. */
+	void ReleaseSlab(sSlab * a_Slab);
+
+	/** Adds the slab to the front of the specified list. */
+	static void LinkSlab(sSlab *& a_List, sSlab * a_Slab);
+
+	/** Removes the slab from the specified list. */
+	static void UnlinkSlab(sSlab *& a_List, sSlab * a_Slab);
+
+	/** Returns the byte offset of the first section within a slab. */
+	static size_t GetFirstSectionOffset(void);
+
+	/** Returns the number of sections that fit in a single slab. */
+	static size_t GetSectionsPerSlab(void);
+
+	/** Returns the slab that contains the specified section. */
+	static sSlab * GetSlab(sChunkSection * a_Section)
+	{
+		return reinterpret_cast<sSlab *>(reinterpret_cast<uintptr_t>(a_Section) & ~static_cast<uintptr_t>(SLAB_SIZE - 1));
+	}
+} ;
+
+
+
+
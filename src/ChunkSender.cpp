@@ -18,6 +18,13 @@
 
 
 
+/** How long to wait before re-checking the clients, when all the queued chunks are for clients that are saturated */
+static const unsigned THROTTLE_WAIT_MSEC = 10;
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cNotifyChunkSender:
 
@@ -218,23 +225,25 @@ void cChunkSender::Execute(void)
 			
 			SendChunk(Coords.m_ChunkX, Coords.m_ChunkZ, nullptr);
 		}
-		else if (!m_SendChunksMediumPriority.empty())
-		{
-			// Take one from the queue:
-			sSendChunk Chunk(m_SendChunksMediumPriority.front());
-			m_SendChunksMediumPriority.pop_front();
-			Lock.Unlock();
-
-			SendChunk(Chunk.m_ChunkX, Chunk.m_ChunkZ, Chunk.m_Client);
-		}
 		else
 		{
-			// Take one from the queue:
-			sSendChunk Chunk(m_SendChunksLowPriority.front());
-			m_SendChunksLowPriority.pop_front();
-			Lock.Unlock();
-
-			SendChunk(Chunk.m_ChunkX, Chunk.m_ChunkZ, Chunk.m_Client);
+			// Take one from the queues, skipping the clients that haven't received the previous chunks yet:
+			int ChunkX, ChunkZ;
+			cClientHandle * Client;
+			if (
+				TakeUnsaturatedRequest(m_SendChunksMediumPriority, ChunkX, ChunkZ, Client) ||
+				TakeUnsaturatedRequest(m_SendChunksLowPriority, ChunkX, ChunkZ, Client)
+			)
+			{
+				Lock.Unlock();
+				SendChunk(ChunkX, ChunkZ, Client);
+			}
+			else
+			{
+				// All the waiting chunks are for saturated clients, give their connections some time (or wait for more work):
+				Lock.Unlock();
+				m_evtQueue.Wait(THROTTLE_WAIT_MSEC);
+			}
 		}
 		Lock.Lock();
 		int RemoveCount = m_RemoveCount;
@@ -288,8 +297,11 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Clien
 	cChunkDataSerializer Data(m_BlockTypes, m_BlockMetas, m_BlockLight, m_BlockSkyLight, m_BiomeMap);
 
 	// Send:
+	cClientHandleList Clients;
 	if (a_Client == nullptr)
 	{
+		// Remember the clients to flush; they cannot be deleted before this function returns, because RemoveClient() waits for it:
+		m_World->GetChunkClients(a_ChunkX, a_ChunkZ, Clients);
 		m_World->BroadcastChunkData(a_ChunkX, a_ChunkZ, Data);
 	}
 	else
@@ -311,6 +323,16 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Clien
 	}  // for itr - m_Packets[]
 	m_BlockEntities.clear();
 
+	// Don't let the chunk wait in the clients' buffers until the next tick:
+	if (a_Client != nullptr)
+	{
+		a_Client->FlushOutgoingData();
+	}
+	for (cClientHandleList::iterator itr = Clients.begin(), end = Clients.end(); itr != end; ++itr)
+	{
+		(*itr)->FlushOutgoingData();
+	}
+
 	// TODO: Send entity spawn packets
 }
 
@@ -355,3 +377,24 @@ void cChunkSender::BiomeData(const cChunkDef::BiomeMap * a_BiomeMap)
 
 
 
+
+bool cChunkSender::TakeUnsaturatedRequest(sSendChunkList & a_List, int & a_ChunkX, int & a_ChunkZ, cClientHandle * & a_Client)
+{
+	for (sSendChunkList::iterator itr = a_List.begin(), end = a_List.end(); itr != end; ++itr)
+	{
+		if (itr->m_Client->IsSendQueueSaturated())
+		{
+			continue;
+		}
+		a_ChunkX = itr->m_ChunkX;
+		a_ChunkZ = itr->m_ChunkZ;
+		a_Client = itr->m_Client;
+		a_List.erase(itr);
+		return true;
+	}
+	return false;
+}
+
+
+
+
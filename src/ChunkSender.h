@@ -169,6 +169,10 @@ protected:
 
 	/// Sends the specified chunk to a_Client, or to all chunk clients if a_Client == nullptr
 	void SendChunk(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client);
+
+	/** Takes out the first request from a_List whose client can take more data (cClientHandle::IsSendQueueSaturated()).
+	Returns false if there's no such request. Must be called with m_CS locked. */
+	bool TakeUnsaturatedRequest(sSendChunkList & a_List, int & a_ChunkX, int & a_ChunkZ, cClientHandle * & a_Client);
 } ;
 
 
@@ -4,6 +4,9 @@
 #include "Server.h"
 #include "World.h"
 #include "Entities/Pickup.h"
+#include "Entities/Painting.h"
+#include "Entities/ExpOrb.h"
+#include "Entities/FallingBlock.h"
 #include "Bindings/PluginManager.h"
 #include "Entities/Player.h"
 #include "Inventory.h"
@@ -25,9 +28,12 @@
 #include "Protocol/Authenticator.h"
 #include "Protocol/ProtocolRecognizer.h"
 #include "CompositeChat.h"
+#include "EntityTracker.h"
 #include "Items/ItemSword.h"
+#include "Metrics.h"
 
 #include "polarssl/md5.h"
+#include <unordered_set>
 
 
 
@@ -41,6 +47,31 @@
 Vanilla sends one ping every 1 second. */
 static const std::chrono::milliseconds PING_TIME_MS = std::chrono::milliseconds(1000);
 
+/** The client is considered saturated (IsSendQueueSaturated()) when more than this many bytes wait for being sent. */
+static const size_t MAX_OUTGOING_QUEUE_SIZE = 512 * 1024;
+
+
+
+
+
+/** Returns the counter of the bytes sent to all the clients, registered on first use. */
+static cMetricCounter & GetBytesSentMetric(void)
+{
+	static cMetricCounter & Counter = cMetricsRegistry::Get().AddCounter("mcserver_network_bytes_sent_total", "Total number of bytes sent to the clients");
+	return Counter;
+}
+
+
+
+
+
+/** Returns the counter of the bytes received from all the clients, registered on first use. */
+static cMetricCounter & GetBytesReceivedMetric(void)
+{
+	static cMetricCounter & Counter = cMetricsRegistry::Get().AddCounter("mcserver_network_bytes_received_total", "Total number of bytes received from the clients");
+	return Counter;
+}
+
 
 
 
@@ -58,9 +89,11 @@ int cClientHandle::s_ClientCount = 0;
 cClientHandle::cClientHandle(const AString & a_IPString, int a_ViewDistance) :
 	m_CurrentViewDistance(a_ViewDistance),
 	m_RequestedViewDistance(a_ViewDistance),
+	m_ViewDistanceLimit(cClientHandle::MAX_VIEW_DISTANCE),
 	m_IPString(a_IPString),
 	m_Player(nullptr),
 	m_HasSentDC(false),
+	m_HasSocketClosed(false),
 	m_LastStreamedChunkX(0x7fffffff),  // bogus chunk coords to force streaming upon login
 	m_LastStreamedChunkZ(0x7fffffff),
 	m_TicksSinceLastPacket(0),
@@ -83,7 +116,9 @@ cClientHandle::cClientHandle(const AString & a_IPString, int a_ViewDistance) :
 	m_HasSentPlayerChunk(false),
 	m_Locale("en_GB"),
 	m_LastPlacedSign(0, -1, 0),
-	m_ProtocolVersion(0)
+	m_ProtocolVersion(0),
+	m_NumBytesSent(0),
+	m_NumBytesReceived(0)
 {
 	m_Protocol = new cProtocolRecognizer(this);
 	
@@ -556,6 +591,12 @@ void cClientHandle::UnloadOutOfRangeChunks(void)
 		m_Player->GetWorld()->RemoveChunkClient(itr->m_ChunkX, itr->m_ChunkZ, this);
 		SendUnloadChunk(itr->m_ChunkX, itr->m_ChunkZ);
 	}
+
+	// The client has dropped the entities in the unloaded chunks, they will be spawned anew if the chunks come back:
+	if (!ChunksToRemove.empty())
+	{
+		UntrackEntitiesInChunks(ChunksToRemove);
+	}
 }
 
 
@@ -1823,6 +1864,9 @@ void cClientHandle::SendData(const char * a_Data, size_t a_Size)
 		return;
 	}
 
+	m_NumBytesSent.fetch_add(a_Size, std::memory_order_relaxed);
+	GetBytesSentMetric().Inc(a_Size);
+
 	cCSLock Lock(m_CSOutgoingData);
 	m_OutgoingData.append(a_Data, a_Size);
 }
@@ -1831,6 +1875,56 @@ void cClientHandle::SendData(const char * a_Data, size_t a_Size)
 
 
 
+void cClientHandle::FlushOutgoingData(void)
+{
+	// Keep the data in order if multiple threads flush at once:
+	cCSLock SendingLock(m_CSSendingData);
+
+	cTCPLinkPtr Link;
+	{
+		cCSLock Lock(m_CSOutgoingData);
+		if (m_Link == nullptr)
+		{
+			// The link is gone, nobody will receive the data
+			m_OutgoingData.clear();
+			return;
+		}
+		if (m_OutgoingData.empty())
+		{
+			return;
+		}
+		Link = m_Link;
+		std::swap(m_OutgoingData, m_SendingData);
+	}
+
+	// The link is called without m_CSOutgoingData held, because the link's callbacks need it while holding the link's lock:
+	Link->SendOwned(m_SendingData);
+}
+
+
+
+
+
+bool cClientHandle::IsSendQueueSaturated(void)
+{
+	cTCPLinkPtr Link;
+	size_t QueuedSize;
+	{
+		cCSLock Lock(m_CSOutgoingData);
+		Link = m_Link;
+		QueuedSize = m_OutgoingData.size();
+	}
+	if (Link == nullptr)
+	{
+		return false;
+	}
+	return (QueuedSize + Link->GetOutgoingQueueSize() > MAX_OUTGOING_QUEUE_SIZE);
+}
+
+
+
+
+
 void cClientHandle::RemoveFromWorld(void)
 {
 	// Remove all associated chunks:
@@ -1845,6 +1939,15 @@ void cClientHandle::RemoveFromWorld(void)
 		m_Protocol->SendUnloadChunk(itr->m_ChunkX, itr->m_ChunkZ);
 	}  // for itr - Chunks[]
 
+	// The client has dropped all the entities along with the chunks:
+	{
+		cCSLock Lock(m_CSTrackedEntities);
+		m_TrackedEntities.clear();
+	}
+
+	// The view distance limit was set by the old world's unload governor, the new world's doesn't know about it:
+	SetViewDistanceLimit(cClientHandle::MAX_VIEW_DISTANCE);
+
 	// Here, we set last streamed values to bogus ones so everything is resent
 	m_LastStreamedChunkX = 0x7fffffff;
 	m_LastStreamedChunkZ = 0x7fffffff;
@@ -1875,6 +1978,12 @@ bool cClientHandle::CheckBlockInteractionsRate(void)
 
 void cClientHandle::Tick(float a_Dt)
 {
+	if (m_HasSocketClosed)
+	{
+		Destroy();
+		return;
+	}
+
 	// Process received network data:
 	AString IncomingData;
 	{
@@ -1886,16 +1995,8 @@ void cClientHandle::Tick(float a_Dt)
 		m_Protocol->DataReceived(IncomingData.data(), IncomingData.size());
 	}
 
-	// Send any queued outgoing data:
-	AString OutgoingData;
-	{
-		cCSLock Lock(m_CSOutgoingData);
-		std::swap(OutgoingData, m_OutgoingData);
-	}
-	if ((m_Link != nullptr) && !OutgoingData.empty())
-	{
-		m_Link->Send(OutgoingData.data(), OutgoingData.size());
-	}
+	// Send any outgoing data still waiting:
+	FlushOutgoingData();
 	
 	m_TicksSinceLastPacket += 1;
 	if (m_TicksSinceLastPacket > 600)  // 30 seconds time-out
@@ -1973,6 +2074,12 @@ void cClientHandle::Tick(float a_Dt)
 
 void cClientHandle::ServerTick(float a_Dt)
 {
+	if (m_HasSocketClosed)
+	{
+		Destroy();
+		return;
+	}
+
 	// Process received network data:
 	AString IncomingData;
 	{
@@ -1984,16 +2091,8 @@ void cClientHandle::ServerTick(float a_Dt)
 		m_Protocol->DataReceived(IncomingData.data(), IncomingData.size());
 	}
 	
-	// Send any queued outgoing data:
-	AString OutgoingData;
-	{
-		cCSLock Lock(m_CSOutgoingData);
-		std::swap(OutgoingData, m_OutgoingData);
-	}
-	if ((m_Link != nullptr) && !OutgoingData.empty())
-	{
-		m_Link->Send(OutgoingData.data(), OutgoingData.size());
-	}
+	// Send any outgoing data still waiting:
+	FlushOutgoingData();
 	
 	if (m_State == csAuthenticated)
 	{
@@ -2172,6 +2271,7 @@ void cClientHandle::SendCollectEntity(const cEntity & a_Entity, const cPlayer &
 
 void cClientHandle::SendDestroyEntity(const cEntity & a_Entity)
 {
+	UntrackEntity(a_Entity);
 	m_Protocol->SendDestroyEntity(a_Entity);
 }
 
@@ -2375,6 +2475,7 @@ void cClientHandle::SendParticleEffect(const AString & a_ParticleName, float a_S
 
 void cClientHandle::SendPickupSpawn(const cPickup & a_Pickup)
 {
+	UntrackEntity(a_Pickup);
 	m_Protocol->SendPickupSpawn(a_Pickup);
 }
 
@@ -2383,6 +2484,7 @@ void cClientHandle::SendPickupSpawn(const cPickup & a_Pickup)
 
 void cClientHandle::SendPaintingSpawn(const cPainting & a_Painting)
 {
+	UntrackEntity(a_Painting);
 	m_Protocol->SendPaintingSpawn(a_Painting);
 }
 
@@ -2492,6 +2594,7 @@ void cClientHandle::SendPlayerSpawn(const cPlayer & a_Player)
 		// Do NOT send this packet to myself
 		return;
 	}
+	UntrackEntity(a_Player);
 	
 	LOGD("Spawning player \"%s\" on client \"%s\" @ %s",
 		a_Player.GetName().c_str(), GetPlayer()->GetName().c_str(), GetIPString().c_str()
@@ -2542,6 +2645,7 @@ void cClientHandle::SendExperience(void)
 
 void cClientHandle::SendExperienceOrb(const cExpOrb & a_ExpOrb)
 {
+	UntrackEntity(a_ExpOrb);
 	m_Protocol->SendExperienceOrb(a_ExpOrb);
 }
 
@@ -2596,6 +2700,7 @@ void cClientHandle::SendSoundParticleEffect(int a_EffectID, int a_SrcX, int a_Sr
 
 void cClientHandle::SendSpawnFallingBlock(const cFallingBlock & a_FallingBlock)
 {
+	UntrackEntity(a_FallingBlock);
 	m_Protocol->SendSpawnFallingBlock(a_FallingBlock);
 }
 
@@ -2605,6 +2710,7 @@ void cClientHandle::SendSpawnFallingBlock(const cFallingBlock & a_FallingBlock)
 
 void cClientHandle::SendSpawnMob(const cMonster & a_Mob)
 {
+	UntrackEntity(a_Mob);
 	m_Protocol->SendSpawnMob(a_Mob);
 }
 
@@ -2614,6 +2720,7 @@ void cClientHandle::SendSpawnMob(const cMonster & a_Mob)
 
 void cClientHandle::SendSpawnObject(const cEntity & a_Entity, char a_ObjectType, int a_ObjectData, Byte a_Yaw, Byte a_Pitch)
 {
+	UntrackEntity(a_Entity);
 	m_Protocol->SendSpawnObject(a_Entity, a_ObjectType, a_ObjectData, a_Yaw, a_Pitch);
 }
 
@@ -2623,6 +2730,7 @@ void cClientHandle::SendSpawnObject(const cEntity & a_Entity, char a_ObjectType,
 
 void cClientHandle::SendSpawnVehicle(const cEntity & a_Vehicle, char a_VehicleType, char a_VehicleSubType)  // VehicleSubType is specific to Minecarts
 {
+	UntrackEntity(a_Vehicle);
 	m_Protocol->SendSpawnVehicle(a_Vehicle, a_VehicleType, a_VehicleSubType);
 }
 
@@ -2766,6 +2874,128 @@ void cClientHandle::SendWindowProperty(const cWindow & a_Window, short a_Propert
 
 
 
+size_t cClientHandle::SendEntityMovementUpdate(const cEntity & a_Entity)
+{
+	ASSERT(a_Entity.GetUniqueID() != m_Player->GetUniqueID());  // Must not send for self
+
+	// Quantize the current state the same way the packets do:
+	sTrackedEntity Current;
+	Current.m_PosX = FloorC(a_Entity.GetPosX() * 32);
+	Current.m_PosY = FloorC(a_Entity.GetPosY() * 32);
+	Current.m_PosZ = FloorC(a_Entity.GetPosZ() * 32);
+	Current.m_Yaw     = static_cast<char>(255 * a_Entity.GetYaw() / 360);
+	Current.m_Pitch   = static_cast<char>(255 * a_Entity.GetPitch() / 360);
+	Current.m_HeadYaw = static_cast<char>(255 * a_Entity.GetHeadYaw() / 360);
+	Current.m_SpeedX = static_cast<short>(a_Entity.GetSpeedX() * 400);
+	Current.m_SpeedY = static_cast<short>(a_Entity.GetSpeedY() * 400);
+	Current.m_SpeedZ = static_cast<short>(a_Entity.GetSpeedZ() * 400);
+
+	cCSLock Lock(m_CSTrackedEntities);
+	cTrackedEntities::iterator itr = m_TrackedEntities.find(a_Entity.GetUniqueID());
+	if (itr == m_TrackedEntities.end())
+	{
+		// The first update since the entity was spawned on this client, its state on the client is not known; send it all in absolute values:
+		m_TrackedEntities[a_Entity.GetUniqueID()] = Current;
+		m_Protocol->SendTeleportEntity(a_Entity);
+		m_Protocol->SendEntityVelocity(a_Entity);
+		size_t NumBytes = cEntityTracker::PACKET_SIZE_TELEPORT + cEntityTracker::PACKET_SIZE_VELOCITY;
+		if (a_Entity.IsPawn())
+		{
+			m_Protocol->SendEntityHeadLook(a_Entity);
+			NumBytes += cEntityTracker::PACKET_SIZE_HEADLOOK;
+		}
+		return NumBytes;
+	}
+	sTrackedEntity & Sent = itr->second;
+	size_t NumBytes = 0;
+
+	bool HasSpeedChanged = ((Current.m_SpeedX != Sent.m_SpeedX) || (Current.m_SpeedY != Sent.m_SpeedY) || (Current.m_SpeedZ != Sent.m_SpeedZ));
+	if (HasSpeedChanged)
+	{
+		m_Protocol->SendEntityVelocity(a_Entity);
+		NumBytes += cEntityTracker::PACKET_SIZE_VELOCITY;
+	}
+	bool HasStopped = (HasSpeedChanged && (Current.m_SpeedX == 0) && (Current.m_SpeedY == 0) && (Current.m_SpeedZ == 0));
+
+	// All the movement since the last update sent to this client is coalesced into a single packet:
+	int DiffX = Current.m_PosX - Sent.m_PosX;
+	int DiffY = Current.m_PosY - Sent.m_PosY;
+	int DiffZ = Current.m_PosZ - Sent.m_PosZ;
+	bool HasMoved = ((DiffX != 0) || (DiffY != 0) || (DiffZ != 0));
+	bool HasTurned = ((Current.m_Yaw != Sent.m_Yaw) || (Current.m_Pitch != Sent.m_Pitch));
+	if (HasStopped || (std::abs(DiffX) > 127) || (std::abs(DiffY) > 127) || (std::abs(DiffZ) > 127))
+	{
+		// The movement doesn't fit into a relative move packet, or the entity has come to rest and the client's position
+		// (which the client also moves by the velocity) needs to be synced
+		m_Protocol->SendTeleportEntity(a_Entity);
+		NumBytes += cEntityTracker::PACKET_SIZE_TELEPORT;
+	}
+	else if (HasMoved && HasTurned)
+	{
+		m_Protocol->SendEntityRelMoveLook(a_Entity, static_cast<char>(DiffX), static_cast<char>(DiffY), static_cast<char>(DiffZ));
+		NumBytes += cEntityTracker::PACKET_SIZE_RELMOVELOOK;
+	}
+	else if (HasMoved)
+	{
+		m_Protocol->SendEntityRelMove(a_Entity, static_cast<char>(DiffX), static_cast<char>(DiffY), static_cast<char>(DiffZ));
+		NumBytes += cEntityTracker::PACKET_SIZE_RELMOVE;
+	}
+	else if (HasTurned)
+	{
+		m_Protocol->SendEntityLook(a_Entity);
+		NumBytes += cEntityTracker::PACKET_SIZE_LOOK;
+	}
+
+	if (Current.m_HeadYaw != Sent.m_HeadYaw)
+	{
+		m_Protocol->SendEntityHeadLook(a_Entity);
+		NumBytes += cEntityTracker::PACKET_SIZE_HEADLOOK;
+	}
+
+	Sent = Current;
+	return NumBytes;
+}
+
+
+
+
+
+void cClientHandle::UntrackEntity(const cEntity & a_Entity)
+{
+	cCSLock Lock(m_CSTrackedEntities);
+	m_TrackedEntities.erase(a_Entity.GetUniqueID());
+}
+
+
+
+
+
+void cClientHandle::UntrackEntitiesInChunks(const cChunkCoordsList & a_Chunks)
+{
+	std::unordered_set<cChunkCoords, cChunkCoordsHash> Chunks(a_Chunks.begin(), a_Chunks.end());
+	cCSLock Lock(m_CSTrackedEntities);
+	for (cTrackedEntities::iterator itr = m_TrackedEntities.begin(); itr != m_TrackedEntities.end();)
+	{
+		// The client places the entity by the position it was last sent:
+		int ChunkX, ChunkZ;
+		int BlockX = FloorC(static_cast<double>(itr->second.m_PosX) / 32);
+		int BlockZ = FloorC(static_cast<double>(itr->second.m_PosZ) / 32);
+		cChunkDef::BlockToChunk(BlockX, BlockZ, ChunkX, ChunkZ);
+		if (Chunks.find(cChunkCoords(ChunkX, ChunkZ)) != Chunks.end())
+		{
+			itr = m_TrackedEntities.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+
+
+
+
 const AString & cClientHandle::GetUsername(void) const
 {
 	return m_Username;
@@ -2793,7 +3023,35 @@ void cClientHandle::SetViewDistance(int a_ViewDistance)
 	cWorld * world = m_Player->GetWorld();
 	if (world != nullptr)
 	{
-		m_CurrentViewDistance = Clamp(a_ViewDistance, cClientHandle::MIN_VIEW_DISTANCE, world->GetMaxViewDistance());
+		m_CurrentViewDistance = Clamp(a_ViewDistance, cClientHandle::MIN_VIEW_DISTANCE, std::min(world->GetMaxViewDistance(), m_ViewDistanceLimit));
+	}
+}
+
+
+
+
+
+void cClientHandle::SetViewDistanceLimit(int a_ViewDistanceLimit)
+{
+	if (a_ViewDistanceLimit == m_ViewDistanceLimit)
+	{
+		return;
+	}
+	bool IsRaised = (a_ViewDistanceLimit > m_ViewDistanceLimit);
+	m_ViewDistanceLimit = a_ViewDistanceLimit;
+
+	cWorld * world = (m_Player == nullptr) ? nullptr : m_Player->GetWorld();
+	if (world != nullptr)
+	{
+		m_CurrentViewDistance = Clamp(m_RequestedViewDistance, cClientHandle::MIN_VIEW_DISTANCE, std::min(world->GetMaxViewDistance(), m_ViewDistanceLimit));
+	}
+
+	// The chunks out of the lowered range are unloaded in the next few ticks by UnloadOutOfRangeChunks();
+	// when raised, the streaming needs to start over to send the newly visible chunks:
+	if (IsRaised)
+	{
+		m_LastStreamedChunkX = 0x7fffffff;
+		m_LastStreamedChunkZ = 0x7fffffff;
 	}
 }
 
@@ -2891,7 +3149,9 @@ void cClientHandle::SocketClosed(void)
 		cRoot::Get()->GetPluginManager()->CallHookDisconnect(*this, "Player disconnected");
 	}
 
-	Destroy();
+	// This is called from the link's callbacks, with the link locked. Destroy() waits for the chunk sender,
+	// which may be sending data into the link, so leave the destroying to the next Tick() / ServerTick():
+	m_HasSocketClosed = true;
 }
 
 
@@ -2922,6 +3182,9 @@ void cClientHandle::OnReceivedData(const char * a_Data, size_t a_Length)
 	// Reset the timeout:
 	m_TicksSinceLastPacket = 0;
 
+	m_NumBytesReceived.fetch_add(a_Length, std::memory_order_relaxed);
+	GetBytesReceivedMetric().Inc(a_Length);
+
 	// Queue the incoming data to be processed in the tick thread:
 	cCSLock Lock(m_CSIncomingData);
 	m_IncomingData.append(a_Data, a_Length);
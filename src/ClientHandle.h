@@ -20,6 +20,7 @@
 #include "UI/SlotArea.h"
 #include "json/json.h"
 #include "ChunkSender.h"
+#include <atomic>
 
 
 
@@ -214,6 +215,11 @@ public:  // tolua_export
 	void SendWindowOpen                 (const cWindow & a_Window);
 	void SendWindowProperty             (const cWindow & a_Window, short a_Property, short a_Value);
 
+	/** Sends the movement of a_Entity that this client hasn't been sent yet: a single relative move (or a teleport)
+	covering all the movement since the last update sent to this client, and the velocity, look and head look only
+	if they have changed. Returns the approximate number of bytes sent. Used by cEntityTracker. */
+	size_t SendEntityMovementUpdate(const cEntity & a_Entity);
+
 	// tolua_begin
 	const AString & GetUsername(void) const;
 	void SetUsername( const AString & a_Username);
@@ -330,7 +336,18 @@ public:  // tolua_export
 	*/
 	bool HandleLogin(int a_ProtocolVersion, const AString & a_Username);
 	
+	/** Queues the data for sending. The data is handed over to the link in FlushOutgoingData().
+	The link isn't called directly, because SendData() is called with various locks held (such as the chunkmap's)
+	and the link's callbacks may need those locks while holding the link's own lock. */
 	void SendData(const char * a_Data, size_t a_Size);
+
+	/** Hands all the queued outgoing data over to the link.
+	Called at the end of each batch of packets (world tick, chunk sent), so that the packets don't wait for the next tick. */
+	void FlushOutgoingData(void);
+
+	/** Returns true if the client isn't reading the data as fast as it is produced and there's too much of it waiting.
+	Used by the chunk sender to hold back the chunks until the client catches up. */
+	bool IsSendQueueSaturated(void);
 	
 	/** Called when the player moves into a different world.
 	Sends an UnloadChunk packet for each loaded chunk and resets the streamed chunks. */
@@ -341,6 +358,19 @@ public:  // tolua_export
 
 	/** Returns the protocol version number of the protocol that the client is talking. Returns zero if the protocol version is not (yet) known. */
 	UInt32 GetProtocolVersion(void) const { return m_ProtocolVersion; }  // tolua_export
+
+	/** Returns the total number of bytes sent to the client, for the metrics. */
+	UInt64 GetNumBytesSent(void) const { return m_NumBytesSent.load(std::memory_order_relaxed); }
+
+	/** Returns the total number of bytes received from the client, for the metrics. */
+	UInt64 GetNumBytesReceived(void) const { return m_NumBytesReceived.load(std::memory_order_relaxed); }
+
+	/** Limits the view distance below the requested one, so that fewer chunks are kept loaded for the client.
+	Used by the world's unload governor for idle players under memory pressure; MAX_VIEW_DISTANCE removes the limit. */
+	void SetViewDistanceLimit(int a_ViewDistanceLimit);
+
+	/** Returns the view distance limit set by SetViewDistanceLimit(). */
+	int GetViewDistanceLimit(void) const { return m_ViewDistanceLimit; }
 	
 private:
 
@@ -350,12 +380,26 @@ private:
 	/** The type used for storing the names of registered plugin channels. */
 	typedef std::set<AString> cChannels;
 
-	/** The actual view distance used, the minimum of client's requested view distance and world's max view distance. */
+	/** The state of an entity, as it was last sent to this client, in the packets' units. */
+	struct sTrackedEntity
+	{
+		int m_PosX, m_PosY, m_PosZ;  // In 1/32 of a block
+		char m_Yaw, m_Pitch, m_HeadYaw;
+		short m_SpeedX, m_SpeedY, m_SpeedZ;
+	} ;
+
+	typedef std::map<int, sTrackedEntity> cTrackedEntities;
+
+	/** The actual view distance used, the minimum of client's requested view distance, world's max view distance
+	and the view distance limit. */
 	int m_CurrentViewDistance;
 
 	/** The requested view distance from the player. It isn't clamped with 1 and the max view distance of the world. */
 	int m_RequestedViewDistance;
 
+	/** The limit imposed by the world's unload governor on idle players under memory pressure; MAX_VIEW_DISTANCE if none */
+	int m_ViewDistanceLimit;
+
 	AString m_IPString;
 
 	AString m_Username;
@@ -369,6 +413,13 @@ private:
 
 	cProtocol * m_Protocol;
 
+	/** Protects m_TrackedEntities */
+	cCriticalSection m_CSTrackedEntities;
+
+	/** The entities whose movement has been sent to this client, by their ID; see SendEntityMovementUpdate().
+	An entity is removed when it is spawned or destroyed on the client, or when the chunk in which it was last sent is unloaded from the client. */
+	cTrackedEntities m_TrackedEntities;
+
 	/** Protects m_IncomingData against multithreaded access. */
 	cCriticalSection m_CSIncomingData;
 
@@ -379,16 +430,27 @@ private:
 	/** Protects m_OutgoingData against multithreaded access. */
 	cCriticalSection m_CSOutgoingData;
 
-	/** Buffer for storing outgoing data from any thread; will get sent in Tick() (to prevent deadlocks).
+	/** Buffer for storing outgoing data from any thread, until it is handed over to m_Link by FlushOutgoingData().
 	Protected by m_CSOutgoingData. */
 	AString m_OutgoingData;
 
+	/** Serializes FlushOutgoingData(), so that the data from concurrent flushes reaches the link in order.
+	Never held by the link's callbacks. */
+	cCriticalSection m_CSSendingData;
+
+	/** The data being handed over to the link by FlushOutgoingData(), swapped with m_OutgoingData so that the buffers are reused.
+	Protected by m_CSSendingData. */
+	AString m_SendingData;
+
 	Vector3d m_ConfirmPosition;
 
 	cPlayer * m_Player;
 	
 	bool m_HasSentDC;  ///< True if a D/C packet has been sent in either direction
 
+	/** Set by SocketClosed() when the link is gone; the client is then destroyed in the next Tick() or ServerTick(). */
+	std::atomic<bool> m_HasSocketClosed;
+
 	// Chunk position when the last StreamChunks() was called; used to avoid re-streaming while in the same chunk
 	int m_LastStreamedChunkX;
 	int m_LastStreamedChunkZ;
@@ -472,6 +534,12 @@ private:
 	/** The version of the protocol that the client is talking, or 0 if unknown. */
 	UInt32 m_ProtocolVersion;
 
+	/** Number of bytes queued for sending to the client; atomic so that the metrics can read it without locking */
+	std::atomic<UInt64> m_NumBytesSent;
+
+	/** Number of bytes received from the client; atomic so that the metrics can read it without locking */
+	std::atomic<UInt64> m_NumBytesReceived;
+
 	/** The link that is used for network communication.
 	m_CSOutgoingData is used to synchronize access for sending data. */
 	cTCPLinkPtr m_Link;
@@ -483,6 +551,13 @@ private:
 	/** Returns true if the rate block interactions is within a reasonable limit (bot protection) */
 	bool CheckBlockInteractionsRate(void);
 	
+	/** Forgets the state of the entity sent to this client, so that its next movement update is sent in absolute values.
+	Called when the entity is spawned or destroyed on the client. */
+	void UntrackEntity(const cEntity & a_Entity);
+
+	/** Forgets the state of all the entities last sent within the specified chunks; called when the chunks are unloaded from the client. */
+	void UntrackEntitiesInChunks(const cChunkCoordsList & a_Chunks);
+
 	/** Adds a single chunk to be streamed to the client; used by StreamChunks() */
 	void StreamChunk(int a_ChunkX, int a_ChunkZ, cChunkSender::eChunkPriority a_Priority);
 	
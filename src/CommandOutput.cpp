@@ -42,7 +42,7 @@ void cLogCommandOutputCallback::Out(const AString & a_Text)
 
 void cLogCommandOutputCallback::Finished(void)
 {
-	// Log each line separately:
+	// Log each line separately; the repeated lines are a part of the output, so they are not collapsed by the logger:
 	size_t len = m_Buffer.length();
 	size_t last = 0;
 	for (size_t i = 0; i < len; i++)
@@ -51,7 +51,7 @@ void cLogCommandOutputCallback::Finished(void)
 		{
 			case '\n':
 			{
-				LOG("%s", m_Buffer.substr(last, i - last).c_str());
+				cLogger::GetInstance().LogSimple(m_Buffer.substr(last, i - last), cLogger::llRegular, false);
 				last = i + 1;
 				break;
 			}
@@ -59,7 +59,7 @@ void cLogCommandOutputCallback::Finished(void)
 	}  // for i - m_Buffer[]
 	if (last < len)
 	{
-		LOG("%s", m_Buffer.substr(last).c_str());
+		cLogger::GetInstance().LogSimple(m_Buffer.substr(last), cLogger::llRegular, false);
 	}
 	
 	// Clear the buffer for the next command output:
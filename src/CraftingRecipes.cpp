@@ -798,13 +798,13 @@ void cCraftingRecipes::HandleFireworks(const cItem * a_CraftingGrid, cCraftingRe
 				{
 					// Result was a rocket, found a star - copy star data to rocket data
 					int GridID = (itr->x + a_OffsetX) + a_GridStride * (itr->y + a_OffsetY);
-					a_Recipe->m_Result.m_FireworkItem.CopyFrom(a_CraftingGrid[GridID].m_FireworkItem);
+					a_Recipe->m_Result.ModifyFireworkItem().CopyFrom(a_CraftingGrid[GridID].GetFireworkItem());
 					break;
 				}
 				case E_ITEM_GUNPOWDER:
 				{
 					// Gunpowder - increase flight time
-					a_Recipe->m_Result.m_FireworkItem.m_FlightTimeInTicks += 20;
+					a_Recipe->m_Result.ModifyFireworkItem().m_FlightTimeInTicks += 20;
 					break;
 				}
 				case E_ITEM_PAPER: break;
@@ -826,7 +826,7 @@ void cCraftingRecipes::HandleFireworks(const cItem * a_CraftingGrid, cCraftingRe
 					// Result was star, found another star - probably adding fade colours, but copy data over anyhow
 					FoundStar = true;
 					int GridID = (itr->x + a_OffsetX) + a_GridStride * (itr->y + a_OffsetY);
-					a_Recipe->m_Result.m_FireworkItem.CopyFrom(a_CraftingGrid[GridID].m_FireworkItem);
+					a_Recipe->m_Result.ModifyFireworkItem().CopyFrom(a_CraftingGrid[GridID].GetFireworkItem());
 					break;
 				}
 				case E_ITEM_DYE:
@@ -836,13 +836,13 @@ void cCraftingRecipes::HandleFireworks(const cItem * a_CraftingGrid, cCraftingRe
 					break;
 				}
 				case E_ITEM_GUNPOWDER: break;
-				case E_ITEM_DIAMOND: a_Recipe->m_Result.m_FireworkItem.m_HasTrail = true; break;
-				case E_ITEM_GLOWSTONE_DUST: a_Recipe->m_Result.m_FireworkItem.m_HasFlicker = true; break;
+				case E_ITEM_DIAMOND: a_Recipe->m_Result.ModifyFireworkItem().m_HasTrail = true; break;
+				case E_ITEM_GLOWSTONE_DUST: a_Recipe->m_Result.ModifyFireworkItem().m_HasFlicker = true; break;
 
-				case E_ITEM_FIRE_CHARGE: a_Recipe->m_Result.m_FireworkItem.m_Type = 1; break;
-				case E_ITEM_GOLD_NUGGET: a_Recipe->m_Result.m_FireworkItem.m_Type = 2; break;
-				case E_ITEM_FEATHER: a_Recipe->m_Result.m_FireworkItem.m_Type = 4; break;
-				case E_ITEM_HEAD: a_Recipe->m_Result.m_FireworkItem.m_Type = 3; break;
+				case E_ITEM_FIRE_CHARGE: a_Recipe->m_Result.ModifyFireworkItem().m_Type = 1; break;
+				case E_ITEM_GOLD_NUGGET: a_Recipe->m_Result.ModifyFireworkItem().m_Type = 2; break;
+				case E_ITEM_FEATHER: a_Recipe->m_Result.ModifyFireworkItem().m_Type = 4; break;
+				case E_ITEM_HEAD: a_Recipe->m_Result.ModifyFireworkItem().m_Type = 3; break;
 				default: LOG("Unexpected item in firework star recipe, was the crafting file's fireworks section changed?"); break;  // ermahgerd BARD ardmins
 			}
 		}
@@ -850,12 +850,12 @@ void cCraftingRecipes::HandleFireworks(const cItem * a_CraftingGrid, cCraftingRe
 		if (FoundStar && (!DyeColours.empty()))
 		{
 			// Found a star and a dye? Fade colours.
-			a_Recipe->m_Result.m_FireworkItem.m_FadeColours = DyeColours;
+			a_Recipe->m_Result.ModifyFireworkItem().m_FadeColours = DyeColours;
 		}
 		else if (!DyeColours.empty())
 		{
 			// Only dye? Normal colours.
-			a_Recipe->m_Result.m_FireworkItem.m_Colours = DyeColours;
+			a_Recipe->m_Result.ModifyFireworkItem().m_Colours = DyeColours;
 		}
 	}
 }
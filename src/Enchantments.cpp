@@ -84,7 +84,7 @@ void cEnchantments::AddFromString(const AString & a_StringSpec)
 
 
 
-size_t cEnchantments::Count(void)
+size_t cEnchantments::Count(void) const
 {
 	return m_Enchantments.size();
 }
@@ -2,12 +2,38 @@
 
 #include "Player.h"
 #include "ArrowEntity.h"
+#include "EntityPool.h"
 #include "../Chunk.h"
 
 
 
 
 
+/** The pool for all the cArrowEntity objects */
+static cEntityPool<cArrowEntity> g_ArrowEntityPool("cArrowEntity");
+
+
+
+
+
+void * cArrowEntity::operator new(size_t a_Size)
+{
+	return g_ArrowEntityPool.Allocate(a_Size);
+}
+
+
+
+
+
+void cArrowEntity::operator delete(void * a_Ptr, size_t a_Size)
+{
+	g_ArrowEntityPool.Free(a_Ptr, a_Size);
+}
+
+
+
+
+
 cArrowEntity::cArrowEntity(cEntity * a_Creator, double a_X, double a_Y, double a_Z, const Vector3d & a_Speed) :
 	super(pkArrow, a_Creator, a_X, a_Y, a_Z, 0.5, 0.5),
 	m_PickupState(psNoPickup),
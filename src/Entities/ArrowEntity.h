@@ -41,6 +41,10 @@ public:
 	
 	/** Creates a new arrow as shot by a player, initializes it from the player object */
 	cArrowEntity(cPlayer & a_Player, double a_Force);
+
+	/** Arrows are allocated from a memory pool, see EntityPool.h */
+	static void * operator new(size_t a_Size);
+	static void operator delete(void * a_Ptr, size_t a_Size);
 	
 	// tolua_begin
 	
@@ -31,9 +31,6 @@ cEntity::cEntity(eEntityType a_EntityType, double a_X, double a_Y, double a_Z, d
 	, m_MaxHealth(1)
 	, m_AttachedTo(nullptr)
 	, m_Attachee(nullptr)
-	, m_bDirtyHead(true)
-	, m_bDirtyOrientation(true)
-	, m_bHasSentNoSpeed(true)
 	, m_bOnGround(false)
 	, m_Gravity(-9.81f)
 	, m_LastPos(a_X, a_Y, a_Z)
@@ -316,7 +313,7 @@ bool cEntity::DoTakeDamage(TakeDamageInfo & a_TDI)
 
 		// IsOnGround() only is false if the player is moving downwards
 		// TODO: Better damage increase, and check for enchantments (and use magic critical instead of plain)
-		const cEnchantments & Enchantments = Player->GetEquippedItem().m_Enchantments;
+		const cEnchantments & Enchantments = Player->GetEquippedItem().GetEnchantments();
 		
 		int SharpnessLevel = Enchantments.GetLevel(cEnchantments::enchSharpness);
 		int SmiteLevel = Enchantments.GetLevel(cEnchantments::enchSmite);
@@ -400,7 +397,7 @@ bool cEntity::DoTakeDamage(TakeDamageInfo & a_TDI)
 		for (size_t i = 0; i < ARRAYCOUNT(ArmorItems); i++)
 		{
 			const cItem & Item = ArmorItems[i];
-			ThornsLevel = std::max(ThornsLevel, Item.m_Enchantments.GetLevel(cEnchantments::enchThorns));
+			ThornsLevel = std::max(ThornsLevel, Item.GetEnchantments().GetLevel(cEnchantments::enchThorns));
 		}
 		
 		if (ThornsLevel > 0)
@@ -441,31 +438,31 @@ bool cEntity::DoTakeDamage(TakeDamageInfo & a_TDI)
 		for (size_t i = 0; i < ARRAYCOUNT(ArmorItems); i++)
 		{
 			const cItem & Item = ArmorItems[i];
-			int Level = Item.m_Enchantments.GetLevel(cEnchantments::enchProtection);
+			int Level = Item.GetEnchantments().GetLevel(cEnchantments::enchProtection);
 			if (Level > 0)
 			{
 				EPFProtection += (6 + Level * Level) * 0.75 / 3;
 			}
 
-			Level = Item.m_Enchantments.GetLevel(cEnchantments::enchFireProtection);
+			Level = Item.GetEnchantments().GetLevel(cEnchantments::enchFireProtection);
 			if (Level > 0)
 			{
 				EPFFireProtection += (6 + Level * Level) * 1.25 / 3;
 			}
 
-			Level = Item.m_Enchantments.GetLevel(cEnchantments::enchFeatherFalling);
+			Level = Item.GetEnchantments().GetLevel(cEnchantments::enchFeatherFalling);
 			if (Level > 0)
 			{
 				EPFFeatherFalling += (6 + Level * Level) * 2.5 / 3;
 			}
 
-			Level = Item.m_Enchantments.GetLevel(cEnchantments::enchBlastProtection);
+			Level = Item.GetEnchantments().GetLevel(cEnchantments::enchBlastProtection);
 			if (Level > 0)
 			{
 				EPFBlastProtection += (6 + Level * Level) * 1.5 / 3;
 			}
 
-			Level = Item.m_Enchantments.GetLevel(cEnchantments::enchProjectileProtection);
+			Level = Item.GetEnchantments().GetLevel(cEnchantments::enchProjectileProtection);
 			if (Level > 0)
 			{
 				EPFProjectileProtection += (6 + Level * Level) * 1.5 / 3;
@@ -546,11 +543,11 @@ bool cEntity::DoTakeDamage(TakeDamageInfo & a_TDI)
 	// Add knockback:
 	if ((IsMob() || IsPlayer()) && (a_TDI.Attacker != nullptr))
 	{
-		int KnockbackLevel = a_TDI.Attacker->GetEquippedWeapon().m_Enchantments.GetLevel(cEnchantments::enchKnockback);  // More common enchantment
+		int KnockbackLevel = a_TDI.Attacker->GetEquippedWeapon().GetEnchantments().GetLevel(cEnchantments::enchKnockback);  // More common enchantment
 		if (KnockbackLevel < 1)
 		{
 			// We support punch on swords and vice versa! :)
-			KnockbackLevel = a_TDI.Attacker->GetEquippedWeapon().m_Enchantments.GetLevel(cEnchantments::enchPunch);
+			KnockbackLevel = a_TDI.Attacker->GetEquippedWeapon().GetEnchantments().GetLevel(cEnchantments::enchPunch);
 		}
 
 		Vector3d AdditionalSpeed(0, 0, 0);
@@ -1485,7 +1482,7 @@ void cEntity::HandleAir(void)
 	// See if the entity is /submerged/ water (block above is water)
 	// Get the type of block the entity is standing in:
 
-	int RespirationLevel = GetEquippedHelmet().m_Enchantments.GetLevel(cEnchantments::enchRespiration);
+	int RespirationLevel = GetEquippedHelmet().GetEnchantments().GetLevel(cEnchantments::enchRespiration);
 
 	if (IsSubmerged())
 	{
@@ -1643,69 +1640,20 @@ void cEntity::TeleportToCoords(double a_PosX, double a_PosY, double a_PosZ)
 void cEntity::BroadcastMovementUpdate(const cClientHandle * a_Exclude)
 {
 	// Process packet sending every two ticks
-	if (GetWorld()->GetWorldAge() % 2 == 0)
+	if (GetWorld()->GetWorldAge() % 2 != 0)
 	{
-		double SpeedSqr = GetSpeed().SqrLength();
-		if (SpeedSqr == 0.0)
-		{
-			// Speed is zero, send this to clients once only as well as an absolute position
-			if (!m_bHasSentNoSpeed)
-			{
-				m_World->BroadcastEntityVelocity(*this, a_Exclude);
-				m_World->BroadcastTeleportEntity(*this, a_Exclude);
-				m_bHasSentNoSpeed = true;
-			}
-		}
-		else
-		{
-			// Movin'
-			m_World->BroadcastEntityVelocity(*this, a_Exclude);
-			m_bHasSentNoSpeed = false;
-		}
-		
-		// TODO: Pickups move disgracefully if relative move packets are sent as opposed to just velocity. Have a system to send relmove only when SetPosXXX() is called with a large difference in position
-		int DiffX = (int)(floor(GetPosX() * 32.0) - floor(m_LastPos.x * 32.0));
-		int DiffY = (int)(floor(GetPosY() * 32.0) - floor(m_LastPos.y * 32.0));
-		int DiffZ = (int)(floor(GetPosZ() * 32.0) - floor(m_LastPos.z * 32.0));
+		return;
+	}
 
-		if ((DiffX != 0) || (DiffY != 0) || (DiffZ != 0))  // Have we moved?
-		{
-			if ((abs(DiffX) <= 127) && (abs(DiffY) <= 127) && (abs(DiffZ) <= 127))  // Limitations of a Byte
-			{
-				// Difference within Byte limitations, use a relative move packet
-				if (m_bDirtyOrientation)
-				{
-					m_World->BroadcastEntityRelMoveLook(*this, (char)DiffX, (char)DiffY, (char)DiffZ, a_Exclude);
-					m_bDirtyOrientation = false;
-				}
-				else
-				{
-					m_World->BroadcastEntityRelMove(*this, (char)DiffX, (char)DiffY, (char)DiffZ, a_Exclude);
-				}
-				// Clients seem to store two positions, one for the velocity packet and one for the teleport/relmove packet
-				// The latter is only changed with a relmove/teleport, and m_LastPos stores this position
-				m_LastPos = GetPosition();
-			}
-			else
-			{
-				// Too big a movement, do a teleport
-				m_World->BroadcastTeleportEntity(*this, a_Exclude);
-				m_LastPos = GetPosition();  // See above
-				m_bDirtyOrientation = false;
-			}
-		}
+	// Each client is sent only the changes it hasn't seen yet, at a rate given by its distance (see cEntityTracker):
+	m_World->BroadcastEntityMovement(*this, a_Exclude);
 
-		if (m_bDirtyHead)
-		{
-			m_World->BroadcastEntityHeadLook(*this, a_Exclude);
-			m_bDirtyHead = false;
-		}
-		if (m_bDirtyOrientation)
-		{
-			// Send individual update in case above (sending with rel-move packet) wasn't done
-			GetWorld()->BroadcastEntityLook(*this, a_Exclude);
-			m_bDirtyOrientation = false;
-		}
+	int DiffX = (int)(floor(GetPosX() * 32.0) - floor(m_LastPos.x * 32.0));
+	int DiffY = (int)(floor(GetPosY() * 32.0) - floor(m_LastPos.y * 32.0));
+	int DiffZ = (int)(floor(GetPosZ() * 32.0) - floor(m_LastPos.z * 32.0));
+	if ((DiffX != 0) || (DiffY != 0) || (DiffZ != 0))  // Have we moved?
+	{
+		m_LastPos = GetPosition();
 	}
 }
 
@@ -1764,7 +1712,6 @@ bool cEntity::IsA(const char * a_ClassName) const
 void cEntity::SetRot(const Vector3f & a_Rot)
 {
 	m_Rot = a_Rot;
-	m_bDirtyOrientation = true;
 }
 
 
@@ -1774,7 +1721,6 @@ void cEntity::SetRot(const Vector3f & a_Rot)
 void cEntity::SetHeadYaw(double a_HeadYaw)
 {
 	m_HeadYaw = a_HeadYaw;
-	m_bDirtyHead = true;
 	WrapHeadYaw();
 }
 
@@ -1806,7 +1752,6 @@ void cEntity::SetMass(double a_Mass)
 void cEntity::SetYaw(double a_Yaw)
 {
 	m_Rot.x = a_Yaw;
-	m_bDirtyOrientation = true;
 	WrapRotation();
 }
 
@@ -1817,7 +1762,6 @@ void cEntity::SetYaw(double a_Yaw)
 void cEntity::SetPitch(double a_Pitch)
 {
 	m_Rot.y = a_Pitch;
-	m_bDirtyOrientation = true;
 	WrapRotation();
 }
 
@@ -1828,7 +1772,6 @@ void cEntity::SetPitch(double a_Pitch)
 void cEntity::SetRoll(double a_Roll)
 {
 	m_Rot.z = a_Roll;
-	m_bDirtyOrientation = true;
 }
 
 
@@ -477,16 +477,6 @@ protected:
 	/// The entity which is attached to this entity (rider), nullptr if none
 	cEntity * m_Attachee;
 
-	/** Stores whether head yaw has been set manually */
-	bool m_bDirtyHead;
-	
-	/** Stores whether our yaw/pitch/roll (body orientation) has been set manually */
-	bool m_bDirtyOrientation;
-	
-	/** Stores whether we have sent a Velocity packet with a speed of zero (no speed) to the client
-	Ensures that said packet is sent only once */
-	bool m_bHasSentNoSpeed;
-
 	/** Stores if the entity is on the ground */
 	bool m_bOnGround;
 	
@@ -494,7 +484,7 @@ protected:
 	For realistic effects, this should be negative. For spaaaaaaace, this can be zero or even positive */
 	float m_Gravity;
 	
-	/** Last position sent to client via the Relative Move or Teleport packets (not Velocity)
+	/** The position at the last movement update in which the entity moved by at least 1/32 of a block.
 	Only updated if cEntity::BroadcastMovementUpdate() is called! */
 	Vector3d m_LastPos;
 
@@ -600,6 +590,7 @@ private:
 } ;  // tolua_export
 
 typedef std::list<cEntity *> cEntityList;
+typedef std::vector<cEntity *> cEntityVector;
 
 
 
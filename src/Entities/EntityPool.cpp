@@ -0,0 +1,115 @@
+// EntityPool.cpp
+
+// Implements the cEntityPoolBase class that keeps track of all the entity pools
+
+#include "Globals.h"
+#include "EntityPool.h"
+#include "../CommandOutput.h"
+#include "../Metrics.h"
+
+
+
+
+
+cEntityPoolBase::cEntityPoolBase(const char * a_ClassName) :
+	m_ClassName(a_ClassName)
+{
+	cCSLock Lock(GetRegistryCS());
+	GetRegistry().push_back(this);
+}
+
+
+
+
+
+cEntityPoolBase::~cEntityPoolBase()
+{
+	cCSLock Lock(GetRegistryCS());
+	std::vector<cEntityPoolBase *> & Registry = GetRegistry();
+	Registry.erase(std::remove(Registry.begin(), Registry.end(), this), Registry.end());
+}
+
+
+
+
+
+void cEntityPoolBase::LogStats(cCommandOutputCallback & a_Output)
+{
+	cCSLock Lock(GetRegistryCS());
+	const std::vector<cEntityPoolBase *> & Registry = GetRegistry();
+	a_Output.Out("Entity pools:");
+	for (std::vector<cEntityPoolBase *>::const_iterator itr = Registry.begin(), end = Registry.end(); itr != end; ++itr)
+	{
+		sStats Stats = (*itr)->GetStats();
+		a_Output.Out("  %s (%u bytes each):", (*itr)->m_ClassName, (unsigned)Stats.m_ObjectSize);
+		a_Output.Out("    Live objects: %u (peak %u)", (unsigned)Stats.m_NumLive, (unsigned)Stats.m_PeakLive);
+		a_Output.Out("    Pooled for reuse: %u objects, %u KiB", (unsigned)Stats.m_NumFree, (unsigned)(Stats.m_NumFree * Stats.m_ObjectSize / 1024));
+		a_Output.Out("    Allocations: %llu, frees: %llu", Stats.m_NumAllocations, Stats.m_NumFrees);
+		a_Output.Out("    Blocks of %u objects: %u held (%u of them empty), %llu allocated from the heap, %llu returned to it",
+			(unsigned)Stats.m_ObjectsPerBlock, (unsigned)Stats.m_NumBlocks, (unsigned)Stats.m_NumEmptyBlocks,
+			Stats.m_NumBlockAllocations, Stats.m_NumBlockFrees
+		);
+	}
+}
+
+
+
+
+
+void cEntityPoolBase::CollectMetrics(cMetricsWriter & a_Writer)
+{
+	cCSLock Lock(GetRegistryCS());
+	const std::vector<cEntityPoolBase *> & Registry = GetRegistry();
+
+	// Read all the stats first, each family's samples need to be written together:
+	std::vector<std::pair<AString, sStats>> AllStats;
+	for (std::vector<cEntityPoolBase *>::const_iterator itr = Registry.begin(), end = Registry.end(); itr != end; ++itr)
+	{
+		AllStats.push_back(std::make_pair(cMetricsWriter::Label("class", (*itr)->m_ClassName), (*itr)->GetStats()));
+	}
+
+	a_Writer.BeginFamily("mcserver_entity_pool_live_objects", "Number of entities allocated from the entity pools", "gauge");
+	for (std::vector<std::pair<AString, sStats>>::const_iterator itr = AllStats.begin(), end = AllStats.end(); itr != end; ++itr)
+	{
+		a_Writer.Sample("mcserver_entity_pool_live_objects", itr->first, static_cast<UInt64>(itr->second.m_NumLive));
+	}
+	a_Writer.BeginFamily("mcserver_entity_pool_free_objects", "Number of unused objects held by the entity pools for reuse", "gauge");
+	for (std::vector<std::pair<AString, sStats>>::const_iterator itr = AllStats.begin(), end = AllStats.end(); itr != end; ++itr)
+	{
+		a_Writer.Sample("mcserver_entity_pool_free_objects", itr->first, static_cast<UInt64>(itr->second.m_NumFree));
+	}
+	a_Writer.BeginFamily("mcserver_entity_pool_blocks", "Number of memory blocks held by the entity pools", "gauge");
+	for (std::vector<std::pair<AString, sStats>>::const_iterator itr = AllStats.begin(), end = AllStats.end(); itr != end; ++itr)
+	{
+		a_Writer.Sample("mcserver_entity_pool_blocks", itr->first, static_cast<UInt64>(itr->second.m_NumBlocks));
+	}
+	a_Writer.BeginFamily("mcserver_entity_pool_allocations_total", "Number of allocations from the entity pools", "counter");
+	for (std::vector<std::pair<AString, sStats>>::const_iterator itr = AllStats.begin(), end = AllStats.end(); itr != end; ++itr)
+	{
+		a_Writer.Sample("mcserver_entity_pool_allocations_total", itr->first, itr->second.m_NumAllocations);
+	}
+}
+
+
+
+
+
+std::vector<cEntityPoolBase *> & cEntityPoolBase::GetRegistry(void)
+{
+	static std::vector<cEntityPoolBase *> Registry;
+	return Registry;
+}
+
+
+
+
+
+cCriticalSection & cEntityPoolBase::GetRegistryCS(void)
+{
+	static cCriticalSection CS;
+	return CS;
+}
+
+
+
+
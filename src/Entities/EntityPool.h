@@ -0,0 +1,376 @@
+
+// EntityPool.h
+
+// Declares the cEntityPool class template that pools the memory of short-lived entities
+
+/*
+Pickups, arrows, XP orbs and falling blocks are created and destroyed in large numbers by farms and TNT cannons.
+Allocating each of them from the heap churns and fragments the heap, so these classes provide their own
+operator new / delete that allocate from a per-class cEntityPool instead. The entities are still created
+with new and destroyed with delete, so the pooling is transparent to the rest of the server.
+
+The objects are allocated in blocks of OBJECTS_PER_BLOCK objects, each block a single heap allocation. A freed
+object goes back to its own block, and the pool allocates from the partially used blocks first, so that the blocks
+can drain. A block that becomes completely unused is kept for reuse, unless the pool already keeps MAX_EMPTY_BLOCKS
+empty blocks, in which case it is returned to the heap. This way the memory taken by a burst of entities (a TNT
+cannon, a farm being harvested) is given back once the entities are gone.
+
+Only objects of the exact pooled class are taken from the pool; descendant classes of different size
+fall back to the global heap.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+// fwd:
+class cCommandOutputCallback;
+class cMetricsWriter;
+
+
+
+
+
+/** The non-template part of the entity pools, keeps track of all the pools for the statistics. */
+class cEntityPoolBase
+{
+public:
+	/** The statistics of a single pool */
+	struct sStats
+	{
+		/** Size of the pooled objects, in bytes */
+		size_t m_ObjectSize;
+
+		/** Number of objects currently allocated from the pool */
+		size_t m_NumLive;
+
+		/** The highest number of objects allocated at the same time */
+		size_t m_PeakLive;
+
+		/** Number of unused objects held by the pool for reuse */
+		size_t m_NumFree;
+
+		/** Number of allocations and frees over the pool's lifetime */
+		UInt64 m_NumAllocations;
+		UInt64 m_NumFrees;
+
+		/** Number of objects in a single block */
+		size_t m_ObjectsPerBlock;
+
+		/** Number of blocks currently held by the pool, and how many of them are completely unused */
+		size_t m_NumBlocks;
+		size_t m_NumEmptyBlocks;
+
+		/** Number of blocks allocated from the heap and returned to it over the pool's lifetime */
+		UInt64 m_NumBlockAllocations;
+		UInt64 m_NumBlockFrees;
+	} ;
+
+	cEntityPoolBase(const char * a_ClassName);
+	virtual ~cEntityPoolBase();
+
+	/** Returns the current statistics of the pool. */
+	virtual sStats GetStats(void) = 0;
+
+	/** Outputs the statistics of all the entity pools, used by the "entitypools" console command. */
+	static void LogStats(cCommandOutputCallback & a_Output);
+
+	/** Writes the statistics of all the entity pools as metric families, used by the metrics export. */
+	static void CollectMetrics(cMetricsWriter & a_Writer);
+
+protected:
+	/** Name of the pooled class, for the statistics */
+	const char * m_ClassName;
+
+	/** Returns the list of all the existing pools; the list is protected by GetRegistryCS(). */
+	static std::vector<cEntityPoolBase *> & GetRegistry(void);
+	static cCriticalSection & GetRegistryCS(void);
+} ;
+
+
+
+
+
+/** Pools the memory of a single entity class, see the comment at the top of this file.
+The pool is shared by all the worlds, hence it is thread-safe. */
+template <class T>
+class cEntityPool :
+	public cEntityPoolBase
+{
+	typedef cEntityPoolBase super;
+
+public:
+	/** Number of objects allocated together in a single block */
+	static const size_t OBJECTS_PER_BLOCK = 64;
+
+	/** The number of completely unused blocks that the pool keeps for reuse; any more are returned to the heap */
+	static const size_t MAX_EMPTY_BLOCKS = 2;
+
+
+	cEntityPool(const char * a_ClassName) :
+		super(a_ClassName),
+		m_FirstBlock(nullptr),
+		m_LastBlock(nullptr),
+		m_NumLive(0),
+		m_PeakLive(0),
+		m_NumAllocations(0),
+		m_NumFrees(0),
+		m_NumBlocks(0),
+		m_NumEmptyBlocks(0),
+		m_NumBlockAllocations(0),
+		m_NumBlockFrees(0)
+	{
+	}
+
+	virtual ~cEntityPool()
+	{
+		// Return the unused blocks to the heap; the blocks still holding live objects (leaked entities) are left alone:
+		sBlock * Block = m_FirstBlock;
+		while (Block != nullptr)
+		{
+			sBlock * Next = Block->m_Next;
+			if (Block->m_NumUsed == 0)
+			{
+				delete Block;
+			}
+			Block = Next;
+		}
+	}
+
+	/** Allocates the memory for a new object, to be called from the class' operator new.
+	Throws std::bad_alloc if a new block is needed and the heap is out of memory. */
+	void * Allocate(size_t a_Size)
+	{
+		if (a_Size != sizeof(T))
+		{
+			// A descendant class, not pooled
+			return ::operator new(a_Size);
+		}
+		cCSLock Lock(m_CS);
+		if (m_FirstBlock == nullptr)
+		{
+			LinkBlock(new sBlock, false);
+			m_NumBlocks += 1;
+			m_NumEmptyBlocks += 1;
+			m_NumBlockAllocations += 1;
+		}
+
+		// Take an object from the first block that has a free one; the partially used blocks are at the front:
+		sBlock * Block = m_FirstBlock;
+		sSlot * Slot = Block->m_FirstFree;
+		Block->m_FirstFree = Slot->m_Storage.m_NextFree;
+		if (Block->m_NumUsed == 0)
+		{
+			m_NumEmptyBlocks -= 1;
+		}
+		Block->m_NumUsed += 1;
+		if (Block->m_NumUsed == OBJECTS_PER_BLOCK)
+		{
+			// The block is full, it is only linked back once one of its objects is freed:
+			UnlinkBlock(Block);
+		}
+
+		m_NumAllocations += 1;
+		m_NumLive += 1;
+		m_PeakLive = std::max(m_PeakLive, m_NumLive);
+		return Slot->m_Storage.m_Data;
+	}
+
+	/** Returns the memory of a destroyed object to its block, to be called from the class' operator delete. */
+	void Free(void * a_Ptr, size_t a_Size)
+	{
+		if (a_Ptr == nullptr)
+		{
+			return;
+		}
+		if (a_Size != sizeof(T))
+		{
+			::operator delete(a_Ptr);
+			return;
+		}
+		sSlot * Slot = reinterpret_cast<sSlot *>(static_cast<char *>(a_Ptr) - offsetof(sSlot, m_Storage));
+		sBlock * Block = Slot->m_Block;
+
+		cCSLock Lock(m_CS);
+		m_NumFrees += 1;
+		m_NumLive -= 1;
+		if (Block->m_NumUsed == OBJECTS_PER_BLOCK)
+		{
+			// The block was full, make it available for allocations again:
+			LinkBlock(Block, true);
+		}
+		Slot->m_Storage.m_NextFree = Block->m_FirstFree;
+		Block->m_FirstFree = Slot;
+		Block->m_NumUsed -= 1;
+		if (Block->m_NumUsed > 0)
+		{
+			return;
+		}
+
+		// The block has become empty, keep it for reuse or return it to the heap:
+		UnlinkBlock(Block);
+		if (m_NumEmptyBlocks >= MAX_EMPTY_BLOCKS)
+		{
+			delete Block;
+			m_NumBlocks -= 1;
+			m_NumBlockFrees += 1;
+			return;
+		}
+		LinkBlock(Block, false);
+		m_NumEmptyBlocks += 1;
+	}
+
+	virtual sStats GetStats(void) override
+	{
+		cCSLock Lock(m_CS);
+		sStats Stats;
+		Stats.m_ObjectSize = sizeof(T);
+		Stats.m_NumLive = m_NumLive;
+		Stats.m_PeakLive = m_PeakLive;
+		Stats.m_NumFree = m_NumBlocks * OBJECTS_PER_BLOCK - m_NumLive;
+		Stats.m_NumAllocations = m_NumAllocations;
+		Stats.m_NumFrees = m_NumFrees;
+		Stats.m_ObjectsPerBlock = OBJECTS_PER_BLOCK;
+		Stats.m_NumBlocks = m_NumBlocks;
+		Stats.m_NumEmptyBlocks = m_NumEmptyBlocks;
+		Stats.m_NumBlockAllocations = m_NumBlockAllocations;
+		Stats.m_NumBlockFrees = m_NumBlockFrees;
+		return Stats;
+	}
+
+protected:
+	struct sSlot;
+	struct sBlock;
+
+	/** Raw memory for a single object, aligned for any member type that the entities use.
+	While the object is not allocated, the memory links the block's free objects. */
+	union sStorage
+	{
+		char    m_Data[sizeof(T)];
+		double  m_AlignDouble;
+		Int64   m_AlignInt64;
+		void *  m_AlignPtr;
+		sSlot * m_NextFree;
+	} ;
+
+	/** A single object in a block, together with the pointer to its block, used when the object is freed */
+	struct sSlot
+	{
+		sBlock * m_Block;
+		sStorage m_Storage;
+	} ;
+
+	/** A single heap allocation holding OBJECTS_PER_BLOCK objects */
+	struct sBlock
+	{
+		sSlot m_Slots[OBJECTS_PER_BLOCK];
+
+		/** The first free object in this block; the free objects are linked through sStorage::m_NextFree */
+		sSlot * m_FirstFree;
+
+		/** Number of the objects currently allocated from this block */
+		size_t m_NumUsed;
+
+		/** The neighbors in the list of the blocks that have a free object; unused while the block is full */
+		sBlock * m_Prev;
+		sBlock * m_Next;
+
+		sBlock(void) :
+			m_FirstFree(nullptr),
+			m_NumUsed(0),
+			m_Prev(nullptr),
+			m_Next(nullptr)
+		{
+			for (size_t i = OBJECTS_PER_BLOCK; i > 0; i--)
+			{
+				m_Slots[i - 1].m_Block = this;
+				m_Slots[i - 1].m_Storage.m_NextFree = m_FirstFree;
+				m_FirstFree = &m_Slots[i - 1];
+			}
+		}
+	} ;
+
+
+	/** Protects the blocks and the counters */
+	cCriticalSection m_CS;
+
+	/** The list of the blocks that have a free object: the partially used ones first, then the empty ones */
+	sBlock * m_FirstBlock;
+	sBlock * m_LastBlock;
+
+	size_t m_NumLive;
+	size_t m_PeakLive;
+	UInt64 m_NumAllocations;
+	UInt64 m_NumFrees;
+	size_t m_NumBlocks;
+	size_t m_NumEmptyBlocks;
+	UInt64 m_NumBlockAllocations;
+	UInt64 m_NumBlockFrees;
+
+
+	/** Adds the block to the list of the blocks with a free object, to its front if a_IsPartial, to its back otherwise. */
+	void LinkBlock(sBlock * a_Block, bool a_IsPartial)
+	{
+		if (a_IsPartial)
+		{
+			a_Block->m_Prev = nullptr;
+			a_Block->m_Next = m_FirstBlock;
+			if (m_FirstBlock != nullptr)
+			{
+				m_FirstBlock->m_Prev = a_Block;
+			}
+			else
+			{
+				m_LastBlock = a_Block;
+			}
+			m_FirstBlock = a_Block;
+		}
+		else
+		{
+			a_Block->m_Prev = m_LastBlock;
+			a_Block->m_Next = nullptr;
+			if (m_LastBlock != nullptr)
+			{
+				m_LastBlock->m_Next = a_Block;
+			}
+			else
+			{
+				m_FirstBlock = a_Block;
+			}
+			m_LastBlock = a_Block;
+		}
+	}
+
+	/** Removes the block from the list of the blocks with a free object. */
+	void UnlinkBlock(sBlock * a_Block)
+	{
+		if (a_Block->m_Prev != nullptr)
+		{
+			a_Block->m_Prev->m_Next = a_Block->m_Next;
+		}
+		else
+		{
+			m_FirstBlock = a_Block->m_Next;
+		}
+		if (a_Block->m_Next != nullptr)
+		{
+			a_Block->m_Next->m_Prev = a_Block->m_Prev;
+		}
+		else
+		{
+			m_LastBlock = a_Block->m_Prev;
+		}
+		a_Block->m_Prev = nullptr;
+		a_Block->m_Next = nullptr;
+	}
+} ;
+
+
+
+
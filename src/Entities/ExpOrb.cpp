@@ -1,10 +1,36 @@
 #include "Globals.h"
 
 #include "ExpOrb.h"
+#include "EntityPool.h"
 #include "Player.h"
 #include "../ClientHandle.h"
 
 
+/** The pool for all the cExpOrb objects */
+static cEntityPool<cExpOrb> g_ExpOrbPool("cExpOrb");
+
+
+
+
+
+void * cExpOrb::operator new(size_t a_Size)
+{
+	return g_ExpOrbPool.Allocate(a_Size);
+}
+
+
+
+
+
+void cExpOrb::operator delete(void * a_Ptr, size_t a_Size)
+{
+	g_ExpOrbPool.Free(a_Ptr, a_Size);
+}
+
+
+
+
+
 cExpOrb::cExpOrb(double a_X, double a_Y, double a_Z, int a_Reward)
 	: cEntity(etExpOrb, a_X, a_Y, a_Z, 0.98, 0.98)
 	, m_Reward(a_Reward)
@@ -34,8 +60,6 @@ cExpOrb::cExpOrb(const Vector3d & a_Pos, int a_Reward)
 void cExpOrb::SpawnOn(cClientHandle & a_Client)
 {
 	a_Client.SendExperienceOrb(*this);
-	m_bDirtyOrientation = false;
-	m_bDirtyHead = false;
 }
 
 
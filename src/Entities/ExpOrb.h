@@ -21,6 +21,10 @@ public:
 	cExpOrb(double a_X, double a_Y, double a_Z, int a_Reward);
 	cExpOrb(const Vector3d & a_Pos, int a_Reward);
 
+	/** XP orbs are allocated from a memory pool, see EntityPool.h */
+	static void * operator new(size_t a_Size);
+	static void operator delete(void * a_Ptr, size_t a_Size);
+
 	// Override functions
 	virtual void Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk) override;
 	virtual void SpawnOn(cClientHandle & a_Client) override;
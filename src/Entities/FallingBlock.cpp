@@ -1,6 +1,7 @@
 #include "Globals.h"
 
 #include "FallingBlock.h"
+#include "EntityPool.h"
 #include "../World.h"
 #include "../ClientHandle.h"
 #include "../Simulator/SandSimulator.h"
@@ -10,6 +11,31 @@
 
 
 
+/** The pool for all the cFallingBlock objects */
+static cEntityPool<cFallingBlock> g_FallingBlockPool("cFallingBlock");
+
+
+
+
+
+void * cFallingBlock::operator new(size_t a_Size)
+{
+	return g_FallingBlockPool.Allocate(a_Size);
+}
+
+
+
+
+
+void cFallingBlock::operator delete(void * a_Ptr, size_t a_Size)
+{
+	g_FallingBlockPool.Free(a_Ptr, a_Size);
+}
+
+
+
+
+
 cFallingBlock::cFallingBlock(const Vector3i & a_BlockPosition, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta) :
 	super(etFallingBlock, a_BlockPosition.x + 0.5f, a_BlockPosition.y + 0.5f, a_BlockPosition.z + 0.5f, 0.98, 0.98),
 	m_BlockType(a_BlockType),
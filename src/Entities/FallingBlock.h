@@ -25,6 +25,10 @@ public:
 	/// Creates a new falling block. a_BlockPosition is expected in world coords
 	cFallingBlock(const Vector3i & a_BlockPosition, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta);
 
+	/** Falling blocks are allocated from a memory pool, see EntityPool.h */
+	static void * operator new(size_t a_Size);
+	static void operator delete(void * a_Ptr, size_t a_Size);
+
 	BLOCKTYPE  GetBlockType(void) const { return m_BlockType; }
 	NIBBLETYPE GetBlockMeta(void) const { return m_BlockMeta; }
 	
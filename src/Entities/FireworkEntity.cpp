@@ -10,7 +10,7 @@
 
 cFireworkEntity::cFireworkEntity(cEntity * a_Creator, double a_X, double a_Y, double a_Z, const cItem & a_Item) :
 	super(pkFirework, a_Creator, a_X, a_Y, a_Z, 0.25, 0.25),
-	m_TicksToExplosion(a_Item.m_FireworkItem.m_FlightTimeInTicks),
+	m_TicksToExplosion(a_Item.GetFireworkItem().m_FlightTimeInTicks),
 	m_FireworkItem(a_Item)
 {
 }
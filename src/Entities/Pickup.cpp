@@ -6,6 +6,7 @@
 #endif
 
 #include "Pickup.h"
+#include "EntityPool.h"
 #include "Player.h"
 #include "../ClientHandle.h"
 #include "../World.h"
@@ -13,6 +14,8 @@
 #include "../Bindings/PluginManager.h"
 #include "../Root.h"
 #include "../Chunk.h"
+#include "../BoundingBox.h"
+#include "../BlockEntities/BlockEntity.h"
 
 
 
@@ -84,6 +87,31 @@ protected:
 
 
 
+/** The pool for all the cPickup objects */
+static cEntityPool<cPickup> g_PickupPool("cPickup");
+
+
+
+
+
+void * cPickup::operator new(size_t a_Size)
+{
+	return g_PickupPool.Allocate(a_Size);
+}
+
+
+
+
+
+void cPickup::operator delete(void * a_Ptr, size_t a_Size)
+{
+	g_PickupPool.Free(a_Ptr, a_Size);
+}
+
+
+
+
+
 cPickup::cPickup(double a_PosX, double a_PosY, double a_PosZ, const cItem & a_Item, bool IsPlayerCreated, float a_SpeedX /* = 0.f */, float a_SpeedY /* = 0.f */, float a_SpeedZ /* = 0.f */)
 	: cEntity(etPickup, a_PosX, a_PosY, a_PosZ, 0.2, 0.2)
 	, m_Timer(0)
@@ -150,14 +178,27 @@ void cPickup::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 				}
 			}
 
+			// If there's a hopper right below, wake it up so that it sucks the pickup in:
+			if (!IsDestroyed())
+			{
+				int HopperY = (BlockBelow == E_BLOCK_HOPPER) ? (BlockY - 1) : ((BlockIn == E_BLOCK_HOPPER) ? BlockY : -1);
+				if (HopperY >= 0)
+				{
+					cBlockEntity * Hopper = CurrentChunk->GetBlockEntity(BlockX, HopperY, BlockZ);
+					if (Hopper != nullptr)
+					{
+						Hopper->WakeUp();
+					}
+				}
+			}
+
 			// Try to combine the pickup with adjacent same-item pickups:
 			if (!IsDestroyed() && (m_Item.m_ItemCount < m_Item.GetMaxStackSize()))  // Don't combine if already full
 			{
-				// By using a_Chunk's ForEachEntity() instead of cWorld's, pickups don't combine across chunk boundaries.
-				// That is a small price to pay for not having to traverse the entire world for each entity.
-				// The speedup in the tick thread is quite considerable.
+				// The chunk's pickup index only returns the nearby pickups of the same item type, including those across the chunk borders:
 				cPickupCombiningCallback PickupCombiningCallback(GetPosition(), this);
-				a_Chunk.ForEachEntity(PickupCombiningCallback);
+				cBoundingBox CombineBox(GetPosition() - Vector3d(1.2, 1.2, 1.2), GetPosition() + Vector3d(1.2, 1.2, 1.2));
+				CurrentChunk->ForEachPickupInBox(CombineBox, m_Item.m_ItemType, PickupCombiningCallback);
 				if (PickupCombiningCallback.FoundMatchingPickup())
 				{
 					m_World->BroadcastEntityMetadata(*this);
@@ -27,6 +27,10 @@ public:
 
 	cPickup(double a_PosX, double a_PosY, double a_PosZ, const cItem & a_Item, bool IsPlayerCreated, float a_SpeedX = 0.f, float a_SpeedY = 0.f, float a_SpeedZ = 0.f);
 
+	/** Pickups are allocated from a memory pool, see EntityPool.h */
+	static void * operator new(size_t a_Size);
+	static void operator delete(void * a_Ptr, size_t a_Size);
+
 	cItem &       GetItem(void)       {return m_Item; }  // tolua_export
 	const cItem & GetItem(void) const {return m_Item; }
 
@@ -237,11 +237,16 @@ void cPlayer::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 		// Apply food exhaustion from movement:
 		ApplyFoodExhaustionFromMovement();
 		
-		if (cRoot::Get()->GetPluginManager()->CallHookPlayerMoving(*this, m_LastPos, GetPosition()))
+		cPluginManager * PluginManager = cRoot::Get()->GetPluginManager();
+		if (PluginManager->CallHookPlayerMoving(*this, m_LastPos, GetPosition()))
 		{
 			CanMove = false;
 			TeleportToCoords(m_LastPos.x, m_LastPos.y, m_LastPos.z);
 		}
+		else if (PluginManager->IsHookUsed(cPluginManager::HOOK_PLAYERS_MOVED))
+		{
+			m_World->AddPlayerMove(*this, m_LastPos, GetPosition());
+		}
 	}
 
 	if (CanMove)
@@ -1872,7 +1877,7 @@ void cPlayer::UseEquippedItem(int a_Amount)
 
 	// If the item has an unbreaking enchantment, give it a random chance of not breaking:
 	cItem Item = GetEquippedItem();
-	int UnbreakingLevel = Item.m_Enchantments.GetLevel(cEnchantments::enchUnbreaking);
+	int UnbreakingLevel = Item.GetEnchantments().GetLevel(cEnchantments::enchUnbreaking);
 	if (UnbreakingLevel > 0)
 	{
 		int chance;
@@ -223,7 +223,7 @@ cProjectileEntity::cProjectileEntity(eKind a_Kind, cEntity * a_Creator, double a
 	m_CreatorData(
 		((a_Creator != nullptr) ? a_Creator->GetUniqueID() : -1),
 		((a_Creator != nullptr) ? (a_Creator->IsPlayer() ? ((cPlayer *)a_Creator)->GetName() : "") : ""),
-		((a_Creator != nullptr) ? a_Creator->GetEquippedWeapon().m_Enchantments : cEnchantments())
+		((a_Creator != nullptr) ? a_Creator->GetEquippedWeapon().GetEnchantments() : cEnchantments())
 	),
 	m_IsInGround(false)
 {
@@ -236,7 +236,7 @@ cProjectileEntity::cProjectileEntity(eKind a_Kind, cEntity * a_Creator, double a
 cProjectileEntity::cProjectileEntity(eKind a_Kind, cEntity * a_Creator, const Vector3d & a_Pos, const Vector3d & a_Speed, double a_Width, double a_Height) :
 	super(etProjectile, a_Pos.x, a_Pos.y, a_Pos.z, a_Width, a_Height),
 	m_ProjectileKind(a_Kind),
-	m_CreatorData(a_Creator->GetUniqueID(), a_Creator->IsPlayer() ? ((cPlayer *)a_Creator)->GetName() : "", a_Creator->GetEquippedWeapon().m_Enchantments),
+	m_CreatorData(a_Creator->GetUniqueID(), a_Creator->IsPlayer() ? ((cPlayer *)a_Creator)->GetName() : "", a_Creator->GetEquippedWeapon().GetEnchantments()),
 	m_IsInGround(false)
 {
 	SetSpeed(a_Speed);
@@ -270,7 +270,7 @@ cProjectileEntity * cProjectileEntity::Create(eKind a_Kind, cEntity * a_Creator,
 		case pkFirework:
 		{
 			ASSERT(a_Item != nullptr);
-			if (a_Item->m_FireworkItem.m_Colours.empty())
+			if (a_Item->GetFireworkItem().m_Colours.empty())
 			{
 				return nullptr;
 			}
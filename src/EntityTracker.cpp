@@ -0,0 +1,138 @@
+// EntityTracker.cpp
+
+// Implements the cEntityTracker class that decides how often each client receives the movement updates of each entity
+
+#include "Globals.h"
+#include "EntityTracker.h"
+#include "ClientHandle.h"
+#include "CommandOutput.h"
+#include "IniFile.h"
+#include "Entities/Player.h"
+
+
+
+
+
+cEntityTracker::cEntityTracker(void) :
+	m_FarUpdateInterval(4),
+	m_OutOfRangeUpdateInterval(20),
+	m_NumUpdatesSent(0),
+	m_NumUpdatesSkipped(0),
+	m_NumBytesSent(0)
+{
+	m_Categories[catPlayers].m_FullRateDistance = 48;
+	m_Categories[catPlayers].m_TrackingRange    = 128;
+	m_Categories[catMobs].m_FullRateDistance    = 32;
+	m_Categories[catMobs].m_TrackingRange       = 80;
+	m_Categories[catOthers].m_FullRateDistance  = 24;
+	m_Categories[catOthers].m_TrackingRange     = 64;
+}
+
+
+
+
+
+void cEntityTracker::LoadSettings(cIniFile & a_IniFile)
+{
+	LoadCategorySettings(a_IniFile, "Players", m_Categories[catPlayers]);
+	LoadCategorySettings(a_IniFile, "Mobs",    m_Categories[catMobs]);
+	LoadCategorySettings(a_IniFile, "Others",  m_Categories[catOthers]);
+	m_FarUpdateInterval        = a_IniFile.GetValueSetI("EntityTracking", "FarUpdateInterval",        m_FarUpdateInterval);
+	m_OutOfRangeUpdateInterval = a_IniFile.GetValueSetI("EntityTracking", "OutOfRangeUpdateInterval", m_OutOfRangeUpdateInterval);
+
+	m_FarUpdateInterval = std::max(m_FarUpdateInterval, 1);
+	m_OutOfRangeUpdateInterval = std::max(m_OutOfRangeUpdateInterval, m_FarUpdateInterval);
+}
+
+
+
+
+
+void cEntityTracker::UpdateClient(const cEntity & a_Entity, cClientHandle & a_Client, Int64 a_WorldAge)
+{
+	// The player's own client controls the player's movement, it is never sent any updates for it:
+	const cPlayer * Viewer = a_Client.GetPlayer();
+	if ((Viewer == nullptr) || (Viewer == &a_Entity))
+	{
+		return;
+	}
+
+	// Pick the update interval by the viewer's distance:
+	const sCategorySettings & Settings = m_Categories[GetCategory(a_Entity)];
+	double DistSq = (Viewer->GetPosition() - a_Entity.GetPosition()).SqrLength();
+	int Interval = 1;
+	if (DistSq > Settings.m_TrackingRange * Settings.m_TrackingRange)
+	{
+		Interval = m_OutOfRangeUpdateInterval;
+	}
+	else if (DistSq > Settings.m_FullRateDistance * Settings.m_FullRateDistance)
+	{
+		Interval = m_FarUpdateInterval;
+	}
+
+	// The updates come every two ticks; offset them by the entity ID so that the reduced-rate updates of different entities don't all fall into the same tick:
+	if (((a_WorldAge / 2) + a_Entity.GetUniqueID()) % Interval != 0)
+	{
+		m_NumUpdatesSkipped++;
+		return;
+	}
+
+	m_NumBytesSent += a_Client.SendEntityMovementUpdate(a_Entity);
+	m_NumUpdatesSent++;
+}
+
+
+
+
+
+void cEntityTracker::LogStats(cCommandOutputCallback & a_Output)
+{
+	UInt64 NumBytesSent = m_NumBytesSent;
+	UInt64 NumUpdatesSent = m_NumUpdatesSent;
+	UInt64 NumUpdatesSkipped = m_NumUpdatesSkipped;
+	a_Output.Out("  Movement updates: %llu sent, %llu skipped due to distance",
+		static_cast<unsigned long long>(NumUpdatesSent), static_cast<unsigned long long>(NumUpdatesSkipped)
+	);
+	a_Output.Out("  Movement bytes: %llu KiB sent",
+		static_cast<unsigned long long>(NumBytesSent / 1024)
+	);
+	a_Output.Out("  Full rate / tracking range: players %.0f / %.0f, mobs %.0f / %.0f, others %.0f / %.0f blocks; intervals %d far, %d out of range",
+		m_Categories[catPlayers].m_FullRateDistance, m_Categories[catPlayers].m_TrackingRange,
+		m_Categories[catMobs].m_FullRateDistance,    m_Categories[catMobs].m_TrackingRange,
+		m_Categories[catOthers].m_FullRateDistance,  m_Categories[catOthers].m_TrackingRange,
+		m_FarUpdateInterval, m_OutOfRangeUpdateInterval
+	);
+}
+
+
+
+
+
+cEntityTracker::eCategory cEntityTracker::GetCategory(const cEntity & a_Entity)
+{
+	if (a_Entity.IsPlayer())
+	{
+		return catPlayers;
+	}
+	if (a_Entity.IsMob())
+	{
+		return catMobs;
+	}
+	return catOthers;
+}
+
+
+
+
+
+void cEntityTracker::LoadCategorySettings(cIniFile & a_IniFile, const AString & a_Prefix, sCategorySettings & a_Settings)
+{
+	a_Settings.m_FullRateDistance = a_IniFile.GetValueSetF("EntityTracking", a_Prefix + "FullRateDistance", a_Settings.m_FullRateDistance);
+	a_Settings.m_TrackingRange    = a_IniFile.GetValueSetF("EntityTracking", a_Prefix + "TrackingRange",    a_Settings.m_TrackingRange);
+	a_Settings.m_FullRateDistance = std::max(a_Settings.m_FullRateDistance, 0.0);
+	a_Settings.m_TrackingRange    = std::max(a_Settings.m_TrackingRange, a_Settings.m_FullRateDistance);
+}
+
+
+
+
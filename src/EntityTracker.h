@@ -0,0 +1,107 @@
+// EntityTracker.h
+
+// Declares the cEntityTracker class that decides how often each client receives the movement updates of each entity
+
+/*
+The entities broadcast their movement every two ticks, to all the clients that have the entity's chunk loaded. The
+tracker lowers the rate for the clients that are far from the entity: within the full-rate distance each update is
+sent, within the tracking range only every FarUpdateInterval-th update is sent, and beyond the tracking range only
+every OutOfRangeUpdateInterval-th update. The distances are configured per entity category (players, mobs, other
+entities) in the [EntityTracking] section of world.ini.
+The entities are not despawned for the clients beyond the tracking range, because some entities stop broadcasting
+their movement once they come to rest, and they would never get spawned again.
+Each client remembers what it has last been sent about each entity (cClientHandle::SendEntityMovementUpdate()), so
+the skipped updates are coalesced into a single relative move, and the velocity, look and head look are sent only
+when they change. The state is forgotten when the entity is destroyed on the client, or when the chunk in which it
+was last sent is unloaded from the client.
+*/
+
+
+
+
+
+#pragma once
+
+#include <atomic>
+
+
+
+
+
+// fwd:
+class cEntity;
+class cClientHandle;
+class cCommandOutputCallback;
+class cIniFile;
+
+
+
+
+
+class cEntityTracker
+{
+public:
+	// The approximate wire sizes of the 1.8 entity movement packets, including the length and ID, used for the statistics:
+	static const size_t PACKET_SIZE_RELMOVE     = 9;
+	static const size_t PACKET_SIZE_RELMOVELOOK = 11;
+	static const size_t PACKET_SIZE_LOOK        = 8;
+	static const size_t PACKET_SIZE_HEADLOOK    = 6;
+	static const size_t PACKET_SIZE_VELOCITY    = 11;
+	static const size_t PACKET_SIZE_TELEPORT    = 20;
+
+
+	cEntityTracker(void);
+
+	/** Reads the settings from the [EntityTracking] section of the world's ini file, writing the defaults for missing values. */
+	void LoadSettings(cIniFile & a_IniFile);
+
+	/** Sends the movement update of a_Entity to a_Client, if the update is due at the client's distance from the entity.
+	Called by cChunk for each client that has the entity's chunk loaded, every two ticks. */
+	void UpdateClient(const cEntity & a_Entity, cClientHandle & a_Client, Int64 a_WorldAge);
+
+	/** Outputs the tracker's statistics, used by the "entitytracking" console command. */
+	void LogStats(cCommandOutputCallback & a_Output);
+
+protected:
+	/** The categories of entities that have separate distance settings */
+	enum eCategory
+	{
+		catPlayers = 0,
+		catMobs    = 1,
+		catOthers  = 2,
+		catMax     = 3,
+	} ;
+
+	struct sCategorySettings
+	{
+		/** The updates are sent at the full rate to the clients closer than this (in blocks) */
+		double m_FullRateDistance;
+
+		/** The updates are sent at the reduced rate to the clients closer than this (in blocks) */
+		double m_TrackingRange;
+	} ;
+
+	sCategorySettings m_Categories[catMax];
+
+	/** Only every N-th update is sent to the clients between the full-rate distance and the tracking range */
+	int m_FarUpdateInterval;
+
+	/** Only every N-th update is sent to the clients beyond the tracking range */
+	int m_OutOfRangeUpdateInterval;
+
+	// Statistics, updated from the world's tick thread and read from the console thread:
+	std::atomic<UInt64> m_NumUpdatesSent;
+	std::atomic<UInt64> m_NumUpdatesSkipped;
+	std::atomic<UInt64> m_NumBytesSent;
+
+
+	/** Returns the category of the specified entity */
+	static eCategory GetCategory(const cEntity & a_Entity);
+
+	/** Reads the settings of a single category, a_Prefix is prepended to the ini value names. */
+	static void LoadCategorySettings(cIniFile & a_IniFile, const AString & a_Prefix, sCategorySettings & a_Settings);
+} ;
+
+
+
+
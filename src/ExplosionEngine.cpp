@@ -0,0 +1,434 @@
+// ExplosionEngine.cpp
+
+// Implements the cExplosionEngine class that computes and applies the block destruction caused by explosions
+
+#include "Globals.h"
+#include "ExplosionEngine.h"
+#include "World.h"
+#include "ChunkMap.h"
+#include "Chunk.h"
+#include "ChunkCursor.h"
+#include "BlockInfo.h"
+#include "Blocks/BlockHandler.h"
+
+
+
+
+
+cExplosionEngine::cExplosionEngine(cWorld & a_World, cChunkMap & a_ChunkMap) :
+	m_World(a_World),
+	m_ChunkMap(a_ChunkMap),
+	m_LastSectionCoords(0, 0, 0),
+	m_LastSection(nullptr)
+{
+}
+
+
+
+
+
+void cExplosionEngine::Explode(double a_ExplosionSize, double a_BlockX, double a_BlockY, double a_BlockZ, cVector3iArray & a_BlocksAffected)
+{
+	int bx = (int)floor(a_BlockX);
+	int by = (int)floor(a_BlockY);
+	int bz = (int)floor(a_BlockZ);
+	int ExplosionSizeInt = (int)ceil(a_ExplosionSize);
+
+	// The cursor keeps the chunkmap locked, which also protects the snapshot:
+	cChunkCursor Cursor(m_ChunkMap, nullptr);
+
+	// Don't destroy any blocks if the explosion center is inside a liquid block or an invalid chunk:
+	BLOCKTYPE BlockType;
+	NIBBLETYPE BlockMeta;
+	if (!GetSnapshotBlock(Cursor, bx, by, bz, BlockType, BlockMeta) || IsBlockLiquid(BlockType))
+	{
+		return;
+	}
+
+	const cRayTree & Tree = GetRayTree(ExplosionSizeInt);
+	a_BlocksAffected.reserve(a_BlocksAffected.size() + Tree.size());
+	eShrapnelLevel ShrapnelLevel = m_World.GetTNTShrapnelLevel();
+	size_t NumNodes = Tree.size();
+	for (size_t i = 0; i < NumNodes;)
+	{
+		const sRayNode & Node = Tree[i];
+		int x = bx + Node.m_X;
+		int y = by + Node.m_Y;
+		int z = bz + Node.m_Z;
+		if (!GetSnapshotBlock(Cursor, x, y, z, BlockType, BlockMeta))
+		{
+			// Outside of the world or in an invalid chunk, the rays cannot continue:
+			i += (size_t)Node.m_SubtreeSize;
+			continue;
+		}
+
+		bool ShouldContinueRay = true;
+		switch (BlockType)
+		{
+			case E_BLOCK_TNT:
+			{
+				// Activate the TNT, with a random fuse between 10 to 30 game ticks
+				int FuseTime = 10 + m_World.GetTickRandomNumber(20);
+				m_World.SpawnPrimedTNT(x + 0.5, y + 0.5, z + 0.5, FuseTime);
+				SetSnapshotBlock(x, y, z, BlockType, BlockMeta, E_BLOCK_AIR, 0);
+				a_BlocksAffected.push_back(Vector3i(x, y, z));
+				break;
+			}
+
+			case E_BLOCK_OBSIDIAN:
+			case E_BLOCK_BEACON:
+			case E_BLOCK_BEDROCK:
+			case E_BLOCK_BARRIER:
+			{
+				// These blocks are not affected by explosions and shield the blocks behind them
+				ShouldContinueRay = false;
+				break;
+			}
+
+			case E_BLOCK_WATER:
+			case E_BLOCK_LAVA:
+			{
+				// Not affected by explosions, but the blocks behind them are
+				break;
+			}
+
+			case E_BLOCK_STATIONARY_WATER:
+			{
+				// Turn into simulated water:
+				SetSnapshotBlock(x, y, z, BlockType, BlockMeta, E_BLOCK_WATER, BlockMeta);
+				break;
+			}
+
+			case E_BLOCK_STATIONARY_LAVA:
+			{
+				// Turn into simulated lava:
+				SetSnapshotBlock(x, y, z, BlockType, BlockMeta, E_BLOCK_LAVA, BlockMeta);
+				break;
+			}
+
+			case E_BLOCK_AIR:
+			{
+				// No pickups for air
+				break;
+			}
+
+			default:
+			{
+				if (m_World.GetTickRandomNumber(100) <= 25)  // 25% chance of pickups
+				{
+					cItems Drops;
+					cBlockHandler * Handler = BlockHandler(BlockType);
+
+					Handler->ConvertToPickups(Drops, BlockMeta);  // Stone becomes cobblestone, coal ore becomes coal, etc.
+					m_World.SpawnItemPickups(Drops, x, y, z);
+				}
+				else if ((ShrapnelLevel > slNone) && (m_World.GetTickRandomNumber(100) < 20))  // 20% chance of flinging stuff around
+				{
+					// If the block is shrapnel-able, make a falling block entity out of it:
+					if (
+						((ShrapnelLevel == slAll) && cBlockInfo::FullyOccupiesVoxel(BlockType)) ||
+						((ShrapnelLevel == slGravityAffectedOnly) && ((BlockType == E_BLOCK_SAND) || (BlockType == E_BLOCK_GRAVEL)))
+					)
+					{
+						m_World.SpawnFallingBlock(x, y + 5, z, BlockType, BlockMeta);
+					}
+				}
+
+				SetSnapshotBlock(x, y, z, BlockType, BlockMeta, E_BLOCK_AIR, 0);
+				a_BlocksAffected.push_back(Vector3i(x, y, z));
+				break;
+			}
+		}  // switch (BlockType)
+
+		// Move to the next node, skipping the shielded subtree if the ray stopped here:
+		i += ShouldContinueRay ? 1 : (size_t)Node.m_SubtreeSize;
+	}  // for i - Tree[]
+
+	// Remember the area for waking up the simulators, so that water and lava flows and sand falls into the blasted holes (FS #391):
+	AddDirtyArea(cCuboid(
+		bx - ExplosionSizeInt - 1, std::max(by - ExplosionSizeInt, 0),                      bz - ExplosionSizeInt - 1,
+		bx + ExplosionSizeInt + 1, std::min(by + ExplosionSizeInt, cChunkDef::Height - 1), bz + ExplosionSizeInt + 1
+	));
+}
+
+
+
+
+
+void cExplosionEngine::Flush(void)
+{
+	if (m_Sections.empty() && m_DirtyAreas.empty())
+	{
+		return;
+	}
+
+	{
+		// Write the changed blocks, section by section. The sections are sorted by their chunk, so the cursor stays in one chunk for all its sections.
+		// The chunks queue the changes and broadcast them to the clients all at once in their next tick.
+		// A block that has been changed in the chunk since the explosion (by a player, a simulator or a plugin) is left
+		// alone, the explosion only replaces the block that it has seen:
+		cChunkCursor Cursor(m_ChunkMap, nullptr);
+		for (cSections::const_iterator itr = m_Sections.begin(); itr != m_Sections.end(); ++itr)
+		{
+			int BaseY = itr->first.m_SectionY * SectionHeight;
+			int RelX, RelZ;
+			cChunk * Chunk = Cursor.GetChunkForBlock(itr->first.m_ChunkX * cChunkDef::Width, BaseY, itr->first.m_ChunkZ * cChunkDef::Width, RelX, RelZ);
+			if (Chunk == nullptr)
+			{
+				// The chunk has been unloaded since the explosion
+				continue;
+			}
+			const sSection & Section = *(itr->second);
+			for (std::vector<UInt16>::const_iterator itrC = Section.m_Changes.begin(), endC = Section.m_Changes.end(); itrC != endC; ++itrC)
+			{
+				int Idx = *itrC;
+				int x = Idx % cChunkDef::Width;
+				int z = (Idx / cChunkDef::Width) % cChunkDef::Width;
+				int y = Idx / (cChunkDef::Width * cChunkDef::Width);
+				BLOCKTYPE BlockType;
+				NIBBLETYPE BlockMeta;
+				Chunk->GetBlockTypeMeta(x, BaseY + y, z, BlockType, BlockMeta);
+				if ((BlockType != Section.m_OldBlockTypes[Idx]) || (BlockMeta != Section.m_OldBlockMetas[Idx]))
+				{
+					continue;
+				}
+				Chunk->FastSetBlock(x, BaseY + y, z, Section.m_BlockTypes[Idx], Section.m_BlockMetas[Idx]);
+			}  // for itrC - Section.m_Changes[]
+		}  // for itr - m_Sections[]
+		m_Sections.clear();
+		m_LastSection = nullptr;
+	}
+
+	// Wake up the simulators, once for each group of overlapping explosions:
+	for (std::vector<cCuboid>::const_iterator itr = m_DirtyAreas.begin(); itr != m_DirtyAreas.end(); ++itr)
+	{
+		m_ChunkMap.WakeUpSimulatorsInArea(itr->p1.x, itr->p2.x, itr->p1.y, itr->p2.y, itr->p1.z, itr->p2.z);
+	}
+	m_DirtyAreas.clear();
+}
+
+
+
+
+
+const cExplosionEngine::cRayTree & cExplosionEngine::GetRayTree(int a_Radius)
+{
+	std::map<int, cRayTree>::iterator itr = m_RayTrees.find(a_Radius);
+	if (itr != m_RayTrees.end())
+	{
+		return itr->second;
+	}
+	cRayTree & Tree = m_RayTrees[a_Radius];
+	CreateRayTree(a_Radius, Tree);
+	return Tree;
+}
+
+
+
+
+
+void cExplosionEngine::CreateRayTree(int a_Radius, cRayTree & a_Tree)
+{
+	// Collect all the blocks within the sphere, sorted by their distance from the center:
+	int RadiusSq = a_Radius * a_Radius;
+	std::vector<Vector3i> Targets;
+	for (int y = -a_Radius; y <= a_Radius; y++)
+	{
+		for (int z = -a_Radius; z <= a_Radius; z++)
+		{
+			for (int x = -a_Radius; x <= a_Radius; x++)
+			{
+				if (x * x + y * y + z * z <= RadiusSq)
+				{
+					Targets.push_back(Vector3i(x, y, z));
+				}
+			}
+		}
+	}
+	std::stable_sort(Targets.begin(), Targets.end(), [](const Vector3i & a_First, const Vector3i & a_Second)
+		{
+			return (a_First.SqrLength() < a_Second.SqrLength());
+		}
+	);
+
+	// Build the tree by marching a ray from the center block to each target block.
+	// A block already in the tree is reused, so that each block has a single parent - the block preceding it on the first ray that reached it:
+	int Size = 2 * a_Radius + 1;
+	std::vector<int> NodeAt((size_t)(Size * Size * Size), -1);  // Index of the node for each block in the sphere's bounding cube
+	std::vector<Vector3i> NodePos;
+	std::vector<std::vector<int>> NodeChildren;
+	for (std::vector<Vector3i>::const_iterator itr = Targets.begin(); itr != Targets.end(); ++itr)
+	{
+		int NumSteps = std::max(1, (int)ceil(sqrt((double)itr->SqrLength()) * 4));  // Four steps per block, so that no block on the ray is skipped
+		int Parent = -1;
+		for (int Step = 0; Step <= NumSteps; Step++)
+		{
+			// March from the center of the center block towards the center of the target block:
+			double t = (double)Step / NumSteps;
+			int x = (int)floor(itr->x * t + 0.5);
+			int y = (int)floor(itr->y * t + 0.5);
+			int z = (int)floor(itr->z * t + 0.5);
+			int & Node = NodeAt[(size_t)((x + a_Radius) + (z + a_Radius) * Size + (y + a_Radius) * Size * Size)];
+			if (Node < 0)
+			{
+				Node = (int)NodePos.size();
+				NodePos.push_back(Vector3i(x, y, z));
+				NodeChildren.push_back(std::vector<int>());
+				if (Parent >= 0)
+				{
+					NodeChildren[(size_t)Parent].push_back(Node);
+				}
+			}
+			Parent = Node;
+		}  // for Step
+	}  // for itr - Targets[]
+
+	// Flatten the tree in depth-first order (the center block is the root, node 0):
+	std::vector<int> Order;
+	Order.reserve(NodePos.size());
+	std::vector<int> Stack;
+	Stack.push_back(0);
+	while (!Stack.empty())
+	{
+		int Node = Stack.back();
+		Stack.pop_back();
+		Order.push_back(Node);
+		const std::vector<int> & Children = NodeChildren[(size_t)Node];
+		Stack.insert(Stack.end(), Children.rbegin(), Children.rend());
+	}
+
+	// Calculate the subtree sizes, children always come after their parent in Order:
+	std::vector<int> SubtreeSize(NodePos.size(), 1);
+	for (std::vector<int>::const_reverse_iterator itr = Order.rbegin(); itr != Order.rend(); ++itr)
+	{
+		const std::vector<int> & Children = NodeChildren[(size_t)*itr];
+		for (std::vector<int>::const_iterator itrC = Children.begin(); itrC != Children.end(); ++itrC)
+		{
+			SubtreeSize[(size_t)*itr] += SubtreeSize[(size_t)*itrC];
+		}
+	}
+
+	a_Tree.clear();
+	a_Tree.reserve(Order.size());
+	for (std::vector<int>::const_iterator itr = Order.begin(); itr != Order.end(); ++itr)
+	{
+		sRayNode Node;
+		Node.m_X = (Int16)NodePos[(size_t)*itr].x;
+		Node.m_Y = (Int16)NodePos[(size_t)*itr].y;
+		Node.m_Z = (Int16)NodePos[(size_t)*itr].z;
+		Node.m_SubtreeSize = SubtreeSize[(size_t)*itr];
+		a_Tree.push_back(Node);
+	}
+	ASSERT(a_Tree.size() == Targets.size());  // Each block in the sphere is in the tree exactly once
+}
+
+
+
+
+
+cExplosionEngine::sSection * cExplosionEngine::GetSection(int a_BlockX, int a_BlockY, int a_BlockZ, bool a_Create, int & a_Index)
+{
+	int ChunkX, ChunkZ;
+	cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
+	sSectionCoords Coords(ChunkX, ChunkZ, a_BlockY / SectionHeight);
+	a_Index = (a_BlockX - ChunkX * cChunkDef::Width) + (a_BlockZ - ChunkZ * cChunkDef::Width) * cChunkDef::Width + (a_BlockY % SectionHeight) * cChunkDef::Width * cChunkDef::Width;
+
+	// Consecutive accesses usually go to the same section:
+	if ((m_LastSection != nullptr) && (Coords == m_LastSectionCoords))
+	{
+		return m_LastSection;
+	}
+
+	cSections::iterator itr = m_Sections.find(Coords);
+	if (itr == m_Sections.end())
+	{
+		if (!a_Create)
+		{
+			return nullptr;
+		}
+		itr = m_Sections.insert(std::make_pair(Coords, std::unique_ptr<sSection>(new sSection))).first;
+	}
+	m_LastSectionCoords = Coords;
+	m_LastSection = itr->second.get();
+	return m_LastSection;
+}
+
+
+
+
+
+bool cExplosionEngine::GetSnapshotBlock(cChunkCursor & a_Cursor, int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta)
+{
+	if ((a_BlockY < 0) || (a_BlockY >= cChunkDef::Height))
+	{
+		return false;
+	}
+
+	// Blocks changed by the explosions in this tick are read from the snapshot:
+	int Index;
+	sSection * Section = GetSection(a_BlockX, a_BlockY, a_BlockZ, false, Index);
+	if ((Section != nullptr) && Section->m_IsChanged[Index])
+	{
+		a_BlockType = Section->m_BlockTypes[Index];
+		a_BlockMeta = Section->m_BlockMetas[Index];
+		return a_Cursor.IsBlockValid(a_BlockX, a_BlockY, a_BlockZ);
+	}
+
+	// All the other blocks are read from the chunk:
+	return a_Cursor.GetBlockTypeMeta(a_BlockX, a_BlockY, a_BlockZ, a_BlockType, a_BlockMeta);
+}
+
+
+
+
+
+void cExplosionEngine::SetSnapshotBlock(
+	int a_BlockX, int a_BlockY, int a_BlockZ,
+	BLOCKTYPE a_OldBlockType, NIBBLETYPE a_OldBlockMeta,
+	BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta
+)
+{
+	int Index;
+	sSection * Section = GetSection(a_BlockX, a_BlockY, a_BlockZ, true, Index);
+	if (!Section->m_IsChanged[Index])
+	{
+		// The first change of the block in this tick, the old block is the one in the chunk:
+		Section->m_IsChanged[Index] = true;
+		Section->m_Changes.push_back((UInt16)Index);
+		Section->m_OldBlockTypes[Index] = a_OldBlockType;
+		Section->m_OldBlockMetas[Index] = a_OldBlockMeta;
+	}
+	Section->m_BlockTypes[Index] = a_BlockType;
+	Section->m_BlockMetas[Index] = a_BlockMeta;
+}
+
+
+
+
+
+void cExplosionEngine::AddDirtyArea(const cCuboid & a_Area)
+{
+	// Merge with all the overlapping areas; the merged area may overlap further areas, so repeat until there's nothing left to merge:
+	cCuboid Area(a_Area);
+	bool HasMerged = true;
+	while (HasMerged)
+	{
+		HasMerged = false;
+		for (std::vector<cCuboid>::iterator itr = m_DirtyAreas.begin(); itr != m_DirtyAreas.end(); ++itr)
+		{
+			if (itr->DoesIntersect(Area))
+			{
+				Area.Engulf(itr->p1);
+				Area.Engulf(itr->p2);
+				m_DirtyAreas.erase(itr);
+				HasMerged = true;
+				break;
+			}
+		}
+	}
+	m_DirtyAreas.push_back(Area);
+}
+
+
+
+
@@ -0,0 +1,181 @@
+
+// ExplosionEngine.h
+
+// Declares the cExplosionEngine class that computes and applies the block destruction caused by explosions
+
+/*
+The engine doesn't modify the chunks directly. The affected blocks are recorded into a per-tick snapshot of
+the chunk sections touched by the explosions; all explosions within a single tick read and write the same
+snapshot, so that chained explosions (TNT cannons) see each other's results and are merged into a single
+write pass. The snapshot is applied to the chunks at the end of the chunkmap's tick, section by section,
+and the simulators are woken up once for each group of overlapping explosions. Until then, the chunks still
+contain the blocks destroyed in this tick; the snapshot remembers the original block of each change, and a block
+that has been changed by anything else in the meantime is not overwritten.
+
+The affected blocks are found by marching rays from the explosion center. The rays for each explosion size
+are precomputed and merged into a single tree, flattened in depth-first order; each block within the
+explosion sphere is present in the tree exactly once, its parent being the previous block on the ray.
+Blast-resistant blocks stop the rays, shielding the blocks behind them; the whole subtree is skipped
+in a single step. Liquids don't stop the rays.
+*/
+
+
+
+
+
+#pragma once
+
+#include "ChunkDef.h"
+#include "Cuboid.h"
+
+
+
+
+
+// fwd:
+class cWorld;
+class cChunkMap;
+class cChunkCursor;
+
+
+
+
+
+/** Computes the blocks destroyed by explosions and applies the changes to the chunks, see the comment at the top of this file.
+Owned by cChunkMap; all the methods lock the chunkmap, which also protects the snapshot. */
+class cExplosionEngine
+{
+public:
+	cExplosionEngine(cWorld & a_World, cChunkMap & a_ChunkMap);
+
+	/** Destroys the blocks hit by an explosion of the specified size at the specified coords.
+	The changes are stored in the snapshot and applied to the chunks in the next Flush().
+	Spawns the pickups, falling blocks and primed TNT for the destroyed blocks.
+	Appends the coords of the destroyed blocks to a_BlocksAffected. */
+	void Explode(double a_ExplosionSize, double a_BlockX, double a_BlockY, double a_BlockZ, cVector3iArray & a_BlocksAffected);
+
+	/** Writes all the changes from the snapshot into the chunks, wakes up the simulators around the explosions and clears the snapshot.
+	Called by the chunkmap at the end of each tick. */
+	void Flush(void);
+
+protected:
+
+	/** Height of a single snapshot section; the same as cChunkData's sections */
+	static const int SectionHeight = 16;
+
+	/** Number of blocks in a single snapshot section */
+	static const int SectionBlockCount = SectionHeight * cChunkDef::Width * cChunkDef::Width;
+
+	/** A single node of the ray tree, see the comment at the top of this file. */
+	struct sRayNode
+	{
+		/** Offset of the block, relative to the explosion center */
+		Int16 m_X, m_Y, m_Z;
+
+		/** Number of nodes in the subtree rooted at this node, including the node itself.
+		Skipping this many nodes in the flattened tree skips the entire subtree. */
+		int m_SubtreeSize;
+	} ;
+
+	typedef std::vector<sRayNode> cRayTree;
+
+	/** Coords of a chunk section in the snapshot, ordered so that all sections of a chunk are adjacent. */
+	struct sSectionCoords
+	{
+		int m_ChunkX, m_ChunkZ, m_SectionY;
+
+		sSectionCoords(int a_ChunkX, int a_ChunkZ, int a_SectionY) :
+			m_ChunkX(a_ChunkX),
+			m_ChunkZ(a_ChunkZ),
+			m_SectionY(a_SectionY)
+		{
+		}
+
+		bool operator <(const sSectionCoords & a_Other) const
+		{
+			if (m_ChunkX != a_Other.m_ChunkX)
+			{
+				return (m_ChunkX < a_Other.m_ChunkX);
+			}
+			if (m_ChunkZ != a_Other.m_ChunkZ)
+			{
+				return (m_ChunkZ < a_Other.m_ChunkZ);
+			}
+			return (m_SectionY < a_Other.m_SectionY);
+		}
+
+		bool operator ==(const sSectionCoords & a_Other) const
+		{
+			return ((m_ChunkX == a_Other.m_ChunkX) && (m_ChunkZ == a_Other.m_ChunkZ) && (m_SectionY == a_Other.m_SectionY));
+		}
+	} ;
+
+	/** The snapshot of a single chunk section. Only the blocks changed by the explosions are stored,
+	all other blocks are read from the chunk itself. The blocks are indexed by x + z * 16 + y * 256, y relative to the section. */
+	struct sSection
+	{
+		bool       m_IsChanged [SectionBlockCount];
+		BLOCKTYPE  m_BlockTypes[SectionBlockCount];
+		NIBBLETYPE m_BlockMetas[SectionBlockCount];  // One meta per byte, unlike the chunk itself
+
+		/** The blocks in the chunk before the first change in this tick; the changes are only written if the chunk still has these */
+		BLOCKTYPE  m_OldBlockTypes[SectionBlockCount];
+		NIBBLETYPE m_OldBlockMetas[SectionBlockCount];
+
+		/** Indices of the changed blocks, in the order of the changes */
+		std::vector<UInt16> m_Changes;
+
+		sSection(void)
+		{
+			memset(m_IsChanged, 0, sizeof(m_IsChanged));
+		}
+	} ;
+
+	typedef std::map<sSectionCoords, std::unique_ptr<sSection>> cSections;
+
+	cWorld & m_World;
+	cChunkMap & m_ChunkMap;
+
+	/** The precomputed ray trees, by the explosion radius */
+	std::map<int, cRayTree> m_RayTrees;
+
+	/** The snapshot of the sections changed by the explosions since the last Flush() */
+	cSections m_Sections;
+
+	/** The areas affected by the explosions since the last Flush(), for waking up the simulators.
+	Overlapping areas are merged when added. */
+	std::vector<cCuboid> m_DirtyAreas;
+
+	/** The section that was used last by GetSnapshotBlock() / SetSnapshotBlock(), speeds up the consecutive accesses into a single section. */
+	sSectionCoords m_LastSectionCoords;
+	sSection * m_LastSection;
+
+
+	/** Returns the ray tree for the specified radius, creates it if not yet created. */
+	const cRayTree & GetRayTree(int a_Radius);
+
+	/** Creates the ray tree for the specified radius. */
+	static void CreateRayTree(int a_Radius, cRayTree & a_Tree);
+
+	/** Returns the snapshot section containing the specified block.
+	If the section is not yet in the snapshot, returns nullptr if a_Create is false, or creates it if a_Create is true. */
+	sSection * GetSection(int a_BlockX, int a_BlockY, int a_BlockZ, bool a_Create, int & a_Index);
+
+	/** Reads the block through the snapshot; returns false if the chunk is not valid. */
+	bool GetSnapshotBlock(cChunkCursor & a_Cursor, int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta);
+
+	/** Writes the block into the snapshot. a_OldBlockType and a_OldBlockMeta are the block as read by GetSnapshotBlock(),
+	they are remembered on the first change of the block, so that Flush() doesn't overwrite a block changed meanwhile. */
+	void SetSnapshotBlock(
+		int a_BlockX, int a_BlockY, int a_BlockZ,
+		BLOCKTYPE a_OldBlockType, NIBBLETYPE a_OldBlockMeta,
+		BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta
+	);
+
+	/** Adds the specified area to m_DirtyAreas, merging it with any areas that it overlaps. */
+	void AddDirtyArea(const cCuboid & a_Area);
+} ;
+
+
+
+
@@ -187,6 +187,78 @@ void cBioGenMulticache::InitializeBiomeGen(cIniFile & a_IniFile)
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cBioGenSharedCache:
+
+cBioGenSharedCache::cBioGenSharedCache(cBiomeGenPtr a_BioGenToCache, cBiomeMapSharedCachePtr a_Cache) :
+	m_BioGenToCache(a_BioGenToCache),
+	m_Cache(a_Cache)
+{
+}
+
+
+
+
+
+void cBioGenSharedCache::GenBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::BiomeMap & a_BiomeMap)
+{
+	if (m_Cache->Get(a_ChunkX, a_ChunkZ, a_BiomeMap))
+	{
+		return;
+	}
+	m_BioGenToCache->GenBiomes(a_ChunkX, a_ChunkZ, a_BiomeMap);
+	m_Cache->Put(a_ChunkX, a_ChunkZ, a_BiomeMap);
+}
+
+
+
+
+
+void cBioGenSharedCache::GenBiomesArea(int a_MinChunkX, int a_MinChunkZ, int a_NumChunks, cChunkDef::BiomeMap * a_BiomeMaps)
+{
+	// If all the chunks are cached, use them:
+	bool AllCached = true;
+	for (int z = 0; (z < a_NumChunks) && AllCached; z++)
+	{
+		for (int x = 0; x < a_NumChunks; x++)
+		{
+			if (!m_Cache->Get(a_MinChunkX + x, a_MinChunkZ + z, a_BiomeMaps[x + a_NumChunks * z]))
+			{
+				AllCached = false;
+				break;
+			}
+		}
+	}
+	if (AllCached)
+	{
+		return;
+	}
+
+	// Generate the whole area in one go, it's cheaper than generating the missing chunks one by one:
+	m_BioGenToCache->GenBiomesArea(a_MinChunkX, a_MinChunkZ, a_NumChunks, a_BiomeMaps);
+	for (int z = 0; z < a_NumChunks; z++)
+	{
+		for (int x = 0; x < a_NumChunks; x++)
+		{
+			m_Cache->Put(a_MinChunkX + x, a_MinChunkZ + z, a_BiomeMaps[x + a_NumChunks * z]);
+		}
+	}
+}
+
+
+
+
+
+void cBioGenSharedCache::InitializeBiomeGen(cIniFile & a_IniFile)
+{
+	super::InitializeBiomeGen(a_IniFile);
+	m_BioGenToCache->InitializeBiomeGen(a_IniFile);
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cBiomeGenList:
 
@@ -938,80 +1010,10 @@ class cBioGenGrown:
 	public cBiomeGen
 {
 public:
-	cBioGenGrown(int a_Seed)
+	cBioGenGrown(int a_Seed) :
+		m_Gen(CreateGen<cChunkDef::Width>(a_Seed)),
+		m_BatchGen(CreateGen<BatchSize>(a_Seed))
 	{
-		auto FinalRivers =
-			std::make_shared<cIntGenSmooth<8>>   (a_Seed + 1,
-			std::make_shared<cIntGenZoom  <10>>  (a_Seed + 2,
-			std::make_shared<cIntGenRiver <7>>   (a_Seed + 3,
-			std::make_shared<cIntGenZoom  <9>>   (a_Seed + 4,
-			std::make_shared<cIntGenSmooth<6>>   (a_Seed + 5,
-			std::make_shared<cIntGenZoom  <8>>   (a_Seed + 8,
-			std::make_shared<cIntGenSmooth<6>>   (a_Seed + 5,
-			std::make_shared<cIntGenZoom  <8>>   (a_Seed + 9,
-			std::make_shared<cIntGenSmooth<6>>   (a_Seed + 5,
-			std::make_shared<cIntGenZoom  <8>>   (a_Seed + 10,
-			std::make_shared<cIntGenSmooth<6>>   (a_Seed + 5,
-			std::make_shared<cIntGenSmooth<8>>   (a_Seed + 6,
-			std::make_shared<cIntGenZoom  <10>>  (a_Seed + 11,
-			std::make_shared<cIntGenChoice<2, 7>>(a_Seed + 12
-		))))))))))))));
-
-		auto alteration =
-			std::make_shared<cIntGenZoom     <8>>(a_Seed,
-			std::make_shared<cIntGenLandOcean<6>>(a_Seed, 20
-		));
-
-		auto alteration2 =
-			std::make_shared<cIntGenZoom     <8>>(a_Seed + 1,
-			std::make_shared<cIntGenZoom     <6>>(a_Seed + 2,
-			std::make_shared<cIntGenZoom     <5>>(a_Seed + 1,
-			std::make_shared<cIntGenZoom     <4>>(a_Seed + 2,
-			std::make_shared<cIntGenLandOcean<4>>(a_Seed + 1, 10
-		)))));
-
-		auto FinalBiomes =
-			std::make_shared<cIntGenSmooth         <8>> (a_Seed + 1,
-			std::make_shared<cIntGenZoom           <10>>(a_Seed + 15,
-			std::make_shared<cIntGenSmooth         <7>> (a_Seed + 1,
-			std::make_shared<cIntGenZoom           <9>> (a_Seed + 16,
-			std::make_shared<cIntGenBeaches        <6>> (
-			std::make_shared<cIntGenZoom           <8>> (a_Seed + 1,
-			std::make_shared<cIntGenAddIslands     <6>> (a_Seed + 2004, 10,
-			std::make_shared<cIntGenAddToOcean     <6>> (a_Seed + 10, 500, biDeepOcean,
-			std::make_shared<cIntGenReplaceRandomly<8>> (a_Seed + 1, biPlains, biSunflowerPlains, 20,
-			std::make_shared<cIntGenMBiomes        <8>> (a_Seed + 5, alteration2,
-			std::make_shared<cIntGenAlternateBiomes<8>> (a_Seed + 1, alteration,
-			std::make_shared<cIntGenBiomeEdges     <8>> (a_Seed + 3,
-			std::make_shared<cIntGenZoom           <10>>(a_Seed + 2,
-			std::make_shared<cIntGenZoom           <7>> (a_Seed + 4,
-			std::make_shared<cIntGenReplaceRandomly<5>> (a_Seed + 99, biIcePlains, biIcePlainsSpikes, 50,
-			std::make_shared<cIntGenZoom           <5>> (a_Seed + 8,
-			std::make_shared<cIntGenAddToOcean     <4>> (a_Seed + 10, 300, biDeepOcean,
-			std::make_shared<cIntGenAddToOcean     <6>> (a_Seed + 9, 8, biMushroomIsland,
-			std::make_shared<cIntGenBiomes         <8>> (a_Seed + 3000,
-			std::make_shared<cIntGenAddIslands     <8>> (a_Seed + 2000, 200,
-			std::make_shared<cIntGenZoom           <8>> (a_Seed + 5,
-			std::make_shared<cIntGenRareBiomeGroups<6>> (a_Seed + 5, 50,
-			std::make_shared<cIntGenBiomeGroupEdges<6>> (
-			std::make_shared<cIntGenAddIslands     <8>> (a_Seed + 2000, 200,
-			std::make_shared<cIntGenZoom           <8>> (a_Seed + 7,
-			std::make_shared<cIntGenSetRandomly    <6>> (a_Seed + 8, 50, bgOcean,
-			std::make_shared<cIntGenReplaceRandomly<6>> (a_Seed + 101, bgIce, bgTemperate, 150,
-			std::make_shared<cIntGenAddIslands     <6>> (a_Seed + 2000, 200,
-			std::make_shared<cIntGenSetRandomly    <6>> (a_Seed + 9, 50, bgOcean,
-			std::make_shared<cIntGenZoom           <6>> (a_Seed + 10,
-			std::make_shared<cIntGenLandOcean      <5>> (a_Seed + 100, 30
-		)))))))))))))))))))))))))))))));
-
-		m_Gen =
-			std::make_shared<cIntGenSmooth   <16>>(a_Seed,
-			std::make_shared<cIntGenZoom     <18>>(a_Seed,
-			std::make_shared<cIntGenSmooth   <11>>(a_Seed,
-			std::make_shared<cIntGenZoom     <13>>(a_Seed,
-			std::make_shared<cIntGenMixRivers<8>> (
-			FinalBiomes, FinalRivers
-		)))));
 	}
 
 	virtual void GenBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::BiomeMap & a_Biomes) override
@@ -1027,8 +1029,156 @@ public:
 		}
 	}
 
+	virtual void GenBiomesArea(int a_MinChunkX, int a_MinChunkZ, int a_NumChunks, cChunkDef::BiomeMap * a_BiomeMaps) override
+	{
+		// Generate tiles of BatchChunks * BatchChunks chunks, pick the chunks within the area from each tile:
+		cIntGen<BatchSize>::Values vals;
+		for (int TileZ = 0; TileZ < a_NumChunks; TileZ += BatchChunks)
+		{
+			for (int TileX = 0; TileX < a_NumChunks; TileX += BatchChunks)
+			{
+				m_BatchGen->GetInts((a_MinChunkX + TileX) * cChunkDef::Width, (a_MinChunkZ + TileZ) * cChunkDef::Width, vals);
+				int NumZ = std::min(BatchChunks, a_NumChunks - TileZ);
+				int NumX = std::min(BatchChunks, a_NumChunks - TileX);
+				for (int cz = 0; cz < NumZ; cz++)
+				{
+					for (int cx = 0; cx < NumX; cx++)
+					{
+						cChunkDef::BiomeMap & Biomes = a_BiomeMaps[TileX + cx + a_NumChunks * (TileZ + cz)];
+						const int * Src = vals + cx * cChunkDef::Width + cz * cChunkDef::Width * BatchSize;
+						for (int z = 0; z < cChunkDef::Width; z++)
+						{
+							for (int x = 0; x < cChunkDef::Width; x++)
+							{
+								cChunkDef::SetBiome(Biomes, x, z, (EMCSBiome)Src[x + BatchSize * z]);
+							}
+						}
+					}  // for cx
+				}  // for cz
+			}  // for TileX
+		}  // for TileZ
+	}
+
 protected:
-	std::shared_ptr<cIntGen<16, 16>> m_Gen;
+	/** Number of chunks, in each direction, generated in one go by m_BatchGen */
+	static const int BatchChunks = 4;
+
+	/** Size of the area, in blocks, generated in one go by m_BatchGen */
+	static const int BatchSize = BatchChunks * cChunkDef::Width;
+
+	/** The generator for a single chunk */
+	std::shared_ptr<cIntGen<cChunkDef::Width>> m_Gen;
+
+	/** The same generator for BatchChunks * BatchChunks chunks; the generators depend only on the absolute coords,
+	so the output is the same, only the overhead of the borders needed by the underlying generators is lower. */
+	std::shared_ptr<cIntGen<BatchSize>> m_BatchGen;
+
+
+	/** Creates the generator chain that outputs Size * Size values.
+	The sizes of the individual generators are derived from the output size, each zoom halves the size and adds 2,
+	each generator that looks at the neighbors adds 2. */
+	template <int Size>
+	static std::shared_ptr<cIntGen<Size>> CreateGen(int a_Seed)
+	{
+		// Sizes of the generators that are shared by the chains below:
+		const int MixSize = (((Size + 2) / 2 + 2) + 2) / 2 + 2;
+
+		// The rivers:
+		const int R1 = (MixSize + 2) / 2 + 2;
+		const int R2 = (R1 + 2) / 2 + 2;
+		const int R3 = (R2 + 2) / 2 + 2;
+		const int R4 = (R3 + 2) / 2 + 2;
+		const int R5 = (R4 + 2) / 2 + 2;
+		const int R6 = (R5 + 4) / 2 + 2;
+		auto FinalRivers =
+			std::make_shared<cIntGenSmooth<MixSize>>(a_Seed + 1,
+			std::make_shared<cIntGenZoom  <MixSize + 2>>(a_Seed + 2,
+			std::make_shared<cIntGenRiver <R1>>     (a_Seed + 3,
+			std::make_shared<cIntGenZoom  <R1 + 2>> (a_Seed + 4,
+			std::make_shared<cIntGenSmooth<R2>>     (a_Seed + 5,
+			std::make_shared<cIntGenZoom  <R2 + 2>> (a_Seed + 8,
+			std::make_shared<cIntGenSmooth<R3>>     (a_Seed + 5,
+			std::make_shared<cIntGenZoom  <R3 + 2>> (a_Seed + 9,
+			std::make_shared<cIntGenSmooth<R4>>     (a_Seed + 5,
+			std::make_shared<cIntGenZoom  <R4 + 2>> (a_Seed + 10,
+			std::make_shared<cIntGenSmooth<R5>>     (a_Seed + 5,
+			std::make_shared<cIntGenSmooth<R5 + 2>> (a_Seed + 6,
+			std::make_shared<cIntGenZoom  <R5 + 4>> (a_Seed + 11,
+			std::make_shared<cIntGenChoice<2, R6>>  (a_Seed + 12
+		))))))))))))));
+
+		// The biomes:
+		const int B1 = (MixSize + 2) / 2 + 2;
+		const int B2 = (B1 + 2) / 2 + 2;
+		const int B3 = (B2 + 2) / 2 + 2;
+		const int B4 = (B3 + 4) / 2 + 2;
+		const int B5 = B4 / 2 + 2;
+		const int B6 = B5 / 2 + 2;
+		const int B7 = (B6 + 4) / 2 + 2;
+		const int B8 = (B7 + 2) / 2 + 2;
+		const int B9 = B8 / 2 + 2;
+
+		const int AltSize = B3 + 2;
+		auto alteration =
+			std::make_shared<cIntGenZoom     <AltSize>>        (a_Seed,
+			std::make_shared<cIntGenLandOcean<AltSize / 2 + 2>>(a_Seed, 20
+		));
+
+		const int Alt2Size1 = AltSize / 2 + 2;
+		const int Alt2Size2 = Alt2Size1 / 2 + 2;
+		const int Alt2Size3 = Alt2Size2 / 2 + 2;
+		auto alteration2 =
+			std::make_shared<cIntGenZoom     <AltSize>>          (a_Seed + 1,
+			std::make_shared<cIntGenZoom     <Alt2Size1>>        (a_Seed + 2,
+			std::make_shared<cIntGenZoom     <Alt2Size2>>        (a_Seed + 1,
+			std::make_shared<cIntGenZoom     <Alt2Size3>>        (a_Seed + 2,
+			std::make_shared<cIntGenLandOcean<Alt2Size3 / 2 + 2>>(a_Seed + 1, 10
+		)))));
+
+		auto FinalBiomes =
+			std::make_shared<cIntGenSmooth         <MixSize>>    (a_Seed + 1,
+			std::make_shared<cIntGenZoom           <MixSize + 2>>(a_Seed + 15,
+			std::make_shared<cIntGenSmooth         <B1>>         (a_Seed + 1,
+			std::make_shared<cIntGenZoom           <B1 + 2>>     (a_Seed + 16,
+			std::make_shared<cIntGenBeaches        <B2>>         (
+			std::make_shared<cIntGenZoom           <B2 + 2>>     (a_Seed + 1,
+			std::make_shared<cIntGenAddIslands     <B3>>         (a_Seed + 2004, 10,
+			std::make_shared<cIntGenAddToOcean     <B3>>         (a_Seed + 10, 500, biDeepOcean,
+			std::make_shared<cIntGenReplaceRandomly<B3 + 2>>     (a_Seed + 1, biPlains, biSunflowerPlains, 20,
+			std::make_shared<cIntGenMBiomes        <B3 + 2>>     (a_Seed + 5, alteration2,
+			std::make_shared<cIntGenAlternateBiomes<B3 + 2>>     (a_Seed + 1, alteration,
+			std::make_shared<cIntGenBiomeEdges     <B3 + 2>>     (a_Seed + 3,
+			std::make_shared<cIntGenZoom           <B3 + 4>>     (a_Seed + 2,
+			std::make_shared<cIntGenZoom           <B4>>         (a_Seed + 4,
+			std::make_shared<cIntGenReplaceRandomly<B5>>         (a_Seed + 99, biIcePlains, biIcePlainsSpikes, 50,
+			std::make_shared<cIntGenZoom           <B5>>         (a_Seed + 8,
+			std::make_shared<cIntGenAddToOcean     <B6>>         (a_Seed + 10, 300, biDeepOcean,
+			std::make_shared<cIntGenAddToOcean     <B6 + 2>>     (a_Seed + 9, 8, biMushroomIsland,
+			std::make_shared<cIntGenBiomes         <B6 + 4>>     (a_Seed + 3000,
+			std::make_shared<cIntGenAddIslands     <B6 + 4>>     (a_Seed + 2000, 200,
+			std::make_shared<cIntGenZoom           <B6 + 4>>     (a_Seed + 5,
+			std::make_shared<cIntGenRareBiomeGroups<B7>>         (a_Seed + 5, 50,
+			std::make_shared<cIntGenBiomeGroupEdges<B7>>         (
+			std::make_shared<cIntGenAddIslands     <B7 + 2>>     (a_Seed + 2000, 200,
+			std::make_shared<cIntGenZoom           <B7 + 2>>     (a_Seed + 7,
+			std::make_shared<cIntGenSetRandomly    <B8>>         (a_Seed + 8, 50, bgOcean,
+			std::make_shared<cIntGenReplaceRandomly<B8>>         (a_Seed + 101, bgIce, bgTemperate, 150,
+			std::make_shared<cIntGenAddIslands     <B8>>         (a_Seed + 2000, 200,
+			std::make_shared<cIntGenSetRandomly    <B8>>         (a_Seed + 9, 50, bgOcean,
+			std::make_shared<cIntGenZoom           <B8>>         (a_Seed + 10,
+			std::make_shared<cIntGenLandOcean      <B9>>         (a_Seed + 100, 30
+		)))))))))))))))))))))))))))))));
+
+		const int S1 = (Size + 2) / 2 + 2;
+		return
+			std::make_shared<cIntGenSmooth   <Size>>    (a_Seed,
+			std::make_shared<cIntGenZoom     <Size + 2>>(a_Seed,
+			std::make_shared<cIntGenSmooth   <S1>>      (a_Seed,
+			std::make_shared<cIntGenZoom     <S1 + 2>>  (a_Seed,
+			std::make_shared<cIntGenMixRivers<MixSize>> (
+			FinalBiomes, FinalRivers
+		)))));
+	}
 };
 
 
@@ -1142,6 +1292,21 @@ protected:
 ////////////////////////////////////////////////////////////////////////////////
 // cBiomeGen:
 
+void cBiomeGen::GenBiomesArea(int a_MinChunkX, int a_MinChunkZ, int a_NumChunks, cChunkDef::BiomeMap * a_BiomeMaps)
+{
+	for (int z = 0; z < a_NumChunks; z++)
+	{
+		for (int x = 0; x < a_NumChunks; x++)
+		{
+			GenBiomes(a_MinChunkX + x, a_MinChunkZ + z, a_BiomeMaps[x + a_NumChunks * z]);
+		}
+	}
+}
+
+
+
+
+
 cBiomeGenPtr cBiomeGen::CreateBiomeGen(cIniFile & a_IniFile, int a_Seed, bool & a_CacheOffByDefault)
 {
 	AString BiomeGenName = a_IniFile.GetValueSet("Generator", "BiomeGen", "");
@@ -112,6 +112,34 @@ protected:
 
 
 
+/** A front-end to a cache shared among multiple generator instances, possibly running in different threads.
+On a miss the biomes are generated by this instance's own biome generator and stored into the shared cache.
+Only the cache is thread-safe, the front-end is not: the biome generators keep mutable state (such as the Voronoi
+maps' cached cells), so each generator instance must be used by a single thread at a time. */
+class cBioGenSharedCache :
+	public cBiomeGen
+{
+	typedef cBiomeGen super;
+
+public:
+	cBioGenSharedCache(cBiomeGenPtr a_BioGenToCache, cBiomeMapSharedCachePtr a_Cache);
+
+protected:
+	/** The biome generator used on cache misses. */
+	cBiomeGenPtr m_BioGenToCache;
+
+	/** The cache storage, shared with other generator instances. */
+	cBiomeMapSharedCachePtr m_Cache;
+
+	virtual void GenBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::BiomeMap & a_BiomeMap) override;
+	virtual void GenBiomesArea(int a_MinChunkX, int a_MinChunkZ, int a_NumChunks, cChunkDef::BiomeMap * a_BiomeMaps) override;
+	virtual void InitializeBiomeGen(cIniFile & a_IniFile) override;
+} ;
+
+
+
+
+
 /// Base class for generators that use a list of available biomes. This class takes care of the list.
 class cBiomeGenList :
 	public cBiomeGen
@@ -47,11 +47,29 @@ cChunkGenerator::~cChunkGenerator()
 
 
 
-bool cChunkGenerator::Start(cPluginInterface & a_PluginInterface, cChunkSink & a_ChunkSink, cIniFile & a_IniFile)
+bool cChunkGenerator::Start(cPluginInterface & a_PluginInterface, cChunkSink & a_ChunkSink, cIniFile & a_IniFile, const AString & a_DataFolder)
 {
 	m_PluginInterface = &a_PluginInterface;
 	m_ChunkSink = &a_ChunkSink;
 
+	if (!InitGenerator(a_IniFile, a_DataFolder))
+	{
+		LOGERROR("Generator could not start, aborting the server");
+		return false;
+	}
+
+	return super::Start();
+}
+
+
+
+
+
+bool cChunkGenerator::InitGenerator(cIniFile & a_IniFile, const AString & a_DataFolder)
+{
+	ASSERT(m_Generator == nullptr);  // Already initialized?
+	m_DataFolder = a_DataFolder;
+
 	// Get the seed; create a new one and log it if not found in the INI file:
 	if (a_IniFile.HasValue("Seed", "Seed"))
 	{
@@ -82,13 +100,14 @@ bool cChunkGenerator::Start(cPluginInterface & a_PluginInterface, cChunkSink & a
 
 	if (m_Generator == nullptr)
 	{
-		LOGERROR("Generator could not start, aborting the server");
 		return false;
 	}
 
 	m_Generator->Initialize(a_IniFile);
 
-	return super::Start();
+	// The biome queries come from other threads, give them their own instance, if the generator supports it:
+	m_BiomeGenerator = m_Generator->CreateInstance(a_IniFile);
+	return true;
 }
 
 
@@ -102,6 +121,8 @@ void cChunkGenerator::Stop(void)
 	m_evtRemoved.Set();  // Wake up anybody waiting for empty queue
 	Wait();
 
+	cCSLock Lock(m_CSBiomes);
+	m_BiomeGenerator.reset();
 	delete m_Generator;
 	m_Generator = nullptr;
 }
@@ -134,9 +155,11 @@ void cChunkGenerator::QueueGenerateChunk(int a_ChunkX, int a_ChunkZ, bool a_Forc
 
 void cChunkGenerator::GenerateBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::BiomeMap & a_BiomeMap)
 {
-	if (m_Generator != nullptr)
+	cCSLock Lock(m_CSBiomes);
+	cGenerator * Generator = GetBiomeGenerator();
+	if (Generator != nullptr)
 	{
-		m_Generator->GenerateBiomes(a_ChunkX, a_ChunkZ, a_BiomeMap);
+		Generator->GenerateBiomes(a_ChunkX, a_ChunkZ, a_BiomeMap);
 	}
 }
 
@@ -171,7 +194,8 @@ int cChunkGenerator::GetQueueLength(void)
 EMCSBiome cChunkGenerator::GetBiomeAt(int a_BlockX, int a_BlockZ)
 {
 	ASSERT(m_Generator != nullptr);
-	return m_Generator->GetBiomeAt(a_BlockX, a_BlockZ);
+	cCSLock Lock(m_CSBiomes);
+	return GetBiomeGenerator()->GetBiomeAt(a_BlockX, a_BlockZ);
 }
 
 
@@ -292,7 +316,16 @@ void cChunkGenerator::DoGenerate(int a_ChunkX, int a_ChunkZ)
 
 	cChunkDesc ChunkDesc(a_ChunkX, a_ChunkZ);
 	m_PluginInterface->CallHookChunkGenerating(ChunkDesc);
-	m_Generator->DoGenerate(a_ChunkX, a_ChunkZ, ChunkDesc);
+	if (m_BiomeGenerator != nullptr)
+	{
+		m_Generator->DoGenerate(a_ChunkX, a_ChunkZ, ChunkDesc);
+	}
+	else
+	{
+		// The biome queries share m_Generator with this thread:
+		cCSLock Lock(m_CSBiomes);
+		m_Generator->DoGenerate(a_ChunkX, a_ChunkZ, ChunkDesc);
+	}
 	m_PluginInterface->CallHookChunkGenerated(ChunkDesc);
 
 	#ifdef _DEBUG
@@ -307,6 +340,44 @@ void cChunkGenerator::DoGenerate(int a_ChunkX, int a_ChunkZ)
 
 
 
+std::unique_ptr<cChunkGenerator::cGenerator> cChunkGenerator::CreateGeneratorInstance(cIniFile & a_IniFile)
+{
+	if (m_Generator == nullptr)
+	{
+		return nullptr;
+	}
+	return m_Generator->CreateInstance(a_IniFile);
+}
+
+
+
+
+
+cChunkGenerator::cGenerator * cChunkGenerator::GetBiomeGenerator(void)
+{
+	if (m_BiomeGenerator != nullptr)
+	{
+		return m_BiomeGenerator.get();
+	}
+	return m_Generator;
+}
+
+
+
+
+
+void cChunkGenerator::LogCacheStats(cCommandOutputCallback & a_Output)
+{
+	if (m_Generator != nullptr)
+	{
+		m_Generator->LogCacheStats(a_Output);
+	}
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cChunkGenerator::cGenerator:
 
@@ -28,6 +28,7 @@ If the generator queue is overloaded, the generator skips chunks with no clients
 // fwd:
 class cIniFile;
 class cChunkDesc;
+class cCommandOutputCallback;
 
 
 
@@ -57,6 +58,14 @@ public:
 
 		/// Called in a separate thread to do the actual chunk generation. Generator should generate into a_ChunkDesc.
 		virtual void DoGenerate(int a_ChunkX, int a_ChunkZ, cChunkDesc & a_ChunkDesc) = 0;
+
+		/** Creates a new instance of the same generator, initialized from a_IniFile, that shares this instance's caches.
+		The new instance may generate chunks in a different thread than this instance.
+		Returns nullptr if the generator doesn't support multiple instances (the default). */
+		virtual std::unique_ptr<cGenerator> CreateInstance(cIniFile & a_IniFile) { UNUSED(a_IniFile); return nullptr; }
+
+		/** Outputs the statistics of the generator's caches, if it has any. */
+		virtual void LogCacheStats(cCommandOutputCallback & a_Output) { UNUSED(a_Output); }
 		
 	protected:
 		cChunkGenerator & m_ChunkGenerator;
@@ -116,9 +125,16 @@ public:
 	cChunkGenerator (void);
 	~cChunkGenerator();
 
-	bool Start(cPluginInterface & a_PluginInterface, cChunkSink & a_ChunkSink, cIniFile & a_IniFile);
+	/** Starts the generator thread. a_DataFolder is the folder where the generator may store its own data, such as
+	the structure layouts; usually the world folder. */
+	bool Start(cPluginInterface & a_PluginInterface, cChunkSink & a_ChunkSink, cIniFile & a_IniFile, const AString & a_DataFolder);
 	void Stop(void);
 
+	/** Reads the seed and creates and initializes the generator engine, without starting the generator thread.
+	Called by Start(); tools that generate chunks through CreateGeneratorInstance() call this directly instead.
+	Returns false if the generator couldn't be created. */
+	bool InitGenerator(cIniFile & a_IniFile, const AString & a_DataFolder);
+
 	/** Queues the chunk for generation
 	If a-ForceGenerate is set, the chunk is regenerated even if the data is already present in the chunksink.
 	a_Callback is called after the chunk is generated. If the chunk was already present, the callback is still called, even if not regenerating.
@@ -126,7 +142,8 @@ public:
 	If the generator becomes overloaded and skips this chunk, the callback is still called. */
 	void QueueGenerateChunk(int a_ChunkX, int a_ChunkZ, bool a_ForceGenerate, cChunkCoordCallback * a_Callback = nullptr);
 	
-	/// Generates the biomes for the specified chunk (directly, not in a separate thread). Used by the world loader if biomes failed loading.
+	/** Generates the biomes for the specified chunk (directly, not in a separate thread). Used by the world loader if biomes failed loading.
+	Thread-safe, the calls are serialized and use a generator instance separate from the generator thread's, if the generator supports it. */
 	void GenerateBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::BiomeMap & a_BiomeMap);
 	
 	void WaitForQueueEmpty(void);
@@ -134,10 +151,22 @@ public:
 	int GetQueueLength(void);
 	
 	int GetSeed(void) const { return m_Seed; }
+
+	/** Returns the folder where the generator may store its own data, as given to Start() or InitGenerator(). */
+	const AString & GetDataFolder(void) const { return m_DataFolder; }
 	
-	/** Returns the biome at the specified coords. Used by ChunkMap if an invalid chunk is queried for biome */
+	/** Returns the biome at the specified coords. Used by ChunkMap if an invalid chunk is queried for biome.
+	Thread-safe, see GenerateBiomes(). */
 	EMCSBiome GetBiomeAt(int a_BlockX, int a_BlockZ);
 
+	/** Creates a new instance of the generator used by the generator thread, sharing its caches, see cGenerator::CreateInstance().
+	The instance generates chunks directly, bypassing the queue, the plugins and the chunk sink.
+	Returns nullptr if the generator isn't running or doesn't support multiple instances. */
+	std::unique_ptr<cGenerator> CreateGeneratorInstance(cIniFile & a_IniFile);
+
+	/** Outputs the statistics of the generator's caches. */
+	void LogCacheStats(cCommandOutputCallback & a_Output);
+
 	/** Reads a block type from the ini file; returns the blocktype on success, emits a warning and returns a_Default's representation on failure. */
 	static BLOCKTYPE GetIniBlock(cIniFile & a_IniFile, const AString & a_SectionName, const AString & a_ValueName, const AString & a_Default);
 	
@@ -161,6 +190,9 @@ private:
 	/** Seed used for the generator. */
 	int m_Seed;
 
+	/** The folder where the generator may store its own data. */
+	AString m_DataFolder;
+
 	/** CS protecting access to the queue. */
 	cCriticalSection m_CS;
 
@@ -175,6 +207,13 @@ private:
 	
 	/** The actual generator engine used to generate chunks. */
 	cGenerator * m_Generator;
+
+	/** The generator instance used for the biome queries from the other threads, sharing m_Generator's caches.
+	nullptr if the generator doesn't support multiple instances, m_Generator is then used under m_CSBiomes. */
+	std::unique_ptr<cGenerator> m_BiomeGenerator;
+
+	/** Serializes the biome queries. Also held while generating a chunk if m_BiomeGenerator is nullptr. */
+	cCriticalSection m_CSBiomes;
 	
 	/** The plugin interface that may modify the generated chunks */
 	cPluginInterface * m_PluginInterface;
@@ -188,6 +227,9 @@ private:
 
 	/** Generates the specified chunk and sets it into the chunksink. */
 	void DoGenerate(int a_ChunkX, int a_ChunkZ);
+
+	/** Returns the generator instance to be used for the biome queries. The caller must hold m_CSBiomes. */
+	cGenerator * GetBiomeGenerator(void);
 };
 
 
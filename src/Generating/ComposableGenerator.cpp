@@ -9,6 +9,7 @@
 #include "../World.h"
 #include "../IniFile.h"
 #include "../Root.h"
+#include "../CommandOutput.h"
 
 // Individual composed algorithms:
 #include "BioGen.h"
@@ -25,6 +26,7 @@
 #include "DistortedHeightmap.h"
 #include "DungeonRoomsFinisher.h"
 #include "EndGen.h"
+#include "GridStructGen.h"
 #include "MineShafts.h"
 #include "NetherFortGen.h"
 #include "Noise3DGenerator.h"
@@ -114,6 +116,23 @@ cTerrainCompositionGenPtr cTerrainCompositionGen::CreateCompositionGen(cIniFile
 ////////////////////////////////////////////////////////////////////////////////
 // cComposableGenerator:
 
+/** Outputs the hit / miss statistics of a single shared generator cache. */
+template <typename DataType>
+static void LogSharedCacheStats(const char * a_Name, cSharedGenCache<DataType> & a_Cache, cCommandOutputCallback & a_Output)
+{
+	typename cSharedGenCache<DataType>::sStats Stats = a_Cache.GetStats();
+	UInt64 NumLookups = Stats.m_NumHits + Stats.m_NumMisses;
+	a_Output.Out("    %s: %llu hits, %llu misses (%.1f %% hit rate), %u of %u entries used",
+		a_Name, Stats.m_NumHits, Stats.m_NumMisses,
+		(NumLookups > 0) ? 100.0 * static_cast<double>(Stats.m_NumHits) / static_cast<double>(NumLookups) : 0.0,
+		static_cast<unsigned>(Stats.m_NumUsed), static_cast<unsigned>(Stats.m_Capacity)
+	);
+}
+
+
+
+
+
 cComposableGenerator::cComposableGenerator(cChunkGenerator & a_ChunkGenerator) :
 	super(a_ChunkGenerator),
 	m_BiomeGen(),
@@ -126,6 +145,21 @@ cComposableGenerator::cComposableGenerator(cChunkGenerator & a_ChunkGenerator) :
 
 
 
+cComposableGenerator::cComposableGenerator(cChunkGenerator & a_ChunkGenerator, const cComposableGenerator & a_ShareCachesWith) :
+	super(a_ChunkGenerator),
+	m_BiomeGen(),
+	m_ShapeGen(),
+	m_CompositionGen(),
+	m_SharedBiomes(a_ShareCachesWith.m_SharedBiomes),
+	m_SharedHeights(a_ShareCachesWith.m_SharedHeights),
+	m_LayoutStores(a_ShareCachesWith.m_LayoutStores)
+{
+}
+
+
+
+
+
 void cComposableGenerator::Initialize(cIniFile & a_IniFile)
 {
 	super::Initialize(a_IniFile);
@@ -196,6 +230,35 @@ void cComposableGenerator::DoGenerate(int a_ChunkX, int a_ChunkZ, cChunkDesc & a
 
 
 
+std::unique_ptr<cChunkGenerator::cGenerator> cComposableGenerator::CreateInstance(cIniFile & a_IniFile)
+{
+	cComposableGenerator * Generator = new cComposableGenerator(m_ChunkGenerator, *this);
+	std::unique_ptr<cChunkGenerator::cGenerator> res(Generator);
+	Generator->Initialize(a_IniFile);
+	return res;
+}
+
+
+
+
+
+void cComposableGenerator::LogCacheStats(cCommandOutputCallback & a_Output)
+{
+	a_Output.Out("  Generator caches:");
+	if (m_SharedBiomes != nullptr)
+	{
+		LogSharedCacheStats("biomes", *m_SharedBiomes, a_Output);
+	}
+	if (m_SharedHeights != nullptr)
+	{
+		LogSharedCacheStats("composited heights", *m_SharedHeights, a_Output);
+	}
+}
+
+
+
+
+
 void cComposableGenerator::InitBiomeGen(cIniFile & a_IniFile)
 {
 	bool CacheOffByDefault = false;
@@ -217,16 +280,14 @@ void cComposableGenerator::InitBiomeGen(cIniFile & a_IniFile)
 		);
 		CacheSize = 4;
 	}
-	LOGD("Using a cache for biomegen of size %d.", CacheSize);
-	if (MultiCacheLength > 0)
-	{
-		LOGD("Enabling multicache for biomegen of length %d.", MultiCacheLength);
-		m_BiomeGen = cBiomeGenPtr(new cBioGenMulticache(m_BiomeGen, CacheSize, MultiCacheLength));
-	}
-	else
+	if (m_SharedBiomes == nullptr)
 	{
-		m_BiomeGen = cBiomeGenPtr(new cBioGenCache(m_BiomeGen, CacheSize));
+		// The cache is split into MultiCacheLength stripes of CacheSize entries each, same as the former multicache:
+		MultiCacheLength = std::max(MultiCacheLength, 1);
+		LOGD("Using a shared cache for biomegen of %d stripes of size %d.", MultiCacheLength, CacheSize);
+		m_SharedBiomes = std::make_shared<cBiomeMapSharedCache>(static_cast<size_t>(MultiCacheLength), static_cast<size_t>(CacheSize));
 	}
+	m_BiomeGen = std::make_shared<cBioGenSharedCache>(m_BiomeGen, m_SharedBiomes);
 }
 
 
@@ -274,8 +335,14 @@ void cComposableGenerator::InitCompositionGen(cIniFile & a_IniFile)
 	}
 
 	// Create a cache of the composited heightmaps, so that finishers may use it:
-	m_CompositedHeightCache = std::make_shared<cHeiGenMultiCache>(std::make_shared<cCompositedHeiGen>(m_ShapeGen, m_CompositionGen), 16, 24);
-	// 24 subcaches of depth 16 each = 96 KiB of RAM. Acceptable, for the amount of work this saves.
+	if (m_SharedHeights == nullptr)
+	{
+		// 24 stripes of depth 16 each = 96 KiB of RAM by default. Acceptable, for the amount of work this saves.
+		int StripeSize = std::max(a_IniFile.GetValueSetI("Generator", "CompositedHeightCacheSize", 16), 1);
+		int NumStripes = std::max(a_IniFile.GetValueSetI("Generator", "CompositedHeightCacheStripes", 24), 1);
+		m_SharedHeights = std::make_shared<cHeightMapSharedCache>(static_cast<size_t>(NumStripes), static_cast<size_t>(StripeSize));
+	}
+	m_CompositedHeightCache = std::make_shared<cHeiGenSharedCache>(std::make_shared<cCompositedHeiGen>(m_ShapeGen, m_CompositionGen), m_SharedHeights);
 }
 
 
@@ -293,6 +360,8 @@ void cComposableGenerator::InitFinishGens(cIniFile & a_IniFile)
 	AStringVector Str = StringSplitAndTrim(Finishers, ",");
 	for (AStringVector::const_iterator itr = Str.begin(); itr != Str.end(); ++itr)
 	{
+		size_t NumFinishGens = m_FinishGens.size();
+
 		// Finishers, alpha-sorted:
 		if (NoCaseCompare(*itr, "Animals") == 0)
 		{
@@ -636,9 +705,105 @@ void cComposableGenerator::InitFinishGens(cIniFile & a_IniFile)
 		{
 			LOGWARNING("Unknown Finisher in the [Generator] section: \"%s\". Ignoring.", itr->c_str());
 		}
+
+		// If the finisher is a grid-based structure generator, let it share the structure layouts:
+		if (m_FinishGens.size() > NumFinishGens)
+		{
+			cGridStructGen * GridStructGen = dynamic_cast<cGridStructGen *>(m_FinishGens.back().get());
+			if (GridStructGen != nullptr)
+			{
+				AttachLayoutStore(*GridStructGen, *itr, a_IniFile);
+			}
+		}
 	}  // for itr - Str[]
 }
 
 
 
 
+
+void cComposableGenerator::AttachLayoutStore(cGridStructGen & a_Gen, const AString & a_FinisherName, cIniFile & a_IniFile)
+{
+	if (m_LayoutStores == nullptr)
+	{
+		// This is the first instance, create the stores' map:
+		m_LayoutStores = std::make_shared<std::map<AString, cStructureLayoutStorePtr>>();
+	}
+	else
+	{
+		// Another instance has already created the stores, reuse the one for this finisher:
+		std::map<AString, cStructureLayoutStorePtr>::const_iterator itr = m_LayoutStores->find(a_FinisherName);
+		if (itr != m_LayoutStores->end())
+		{
+			a_Gen.SetLayoutStore(itr->second);
+		}
+		return;
+	}
+
+	cStructureLayoutStorePtr Store;
+	if (a_IniFile.GetValueSetB("Generator", "PersistStructureLayouts", false))
+	{
+		AString Folder = m_ChunkGenerator.GetDataFolder() + cFile::PathSeparator + "structures";
+		cFile::CreateFolder(Folder);
+		AString FileName = Printf("%s%c%s.txt", Folder.c_str(), cFile::PathSeparator, a_FinisherName.c_str());
+		Store = std::make_shared<cStructureLayoutStore>(FileName, a_Gen.GetLayoutSignature() + " terrain" + GetTerrainSignature(a_IniFile));
+	}
+	else
+	{
+		Store = std::make_shared<cStructureLayoutStore>();
+	}
+	(*m_LayoutStores)[a_FinisherName] = Store;
+	a_Gen.SetLayoutStore(Store);
+}
+
+
+
+
+AString cComposableGenerator::GetTerrainSignature(const cIniFile & a_IniFile)
+{
+	static const char * GenValueNames[] =
+	{
+		"BiomeGen",
+		"ShapeGen",
+		"HeightGen",
+		"CompositionGen",
+	};
+	AStringVector GenNames;
+	AString res;
+	for (size_t i = 0; i < ARRAYCOUNT(GenValueNames); i++)
+	{
+		AString GenName = a_IniFile.GetValue("Generator", GenValueNames[i]);
+		AppendPrintf(res, " %s=%s", GenValueNames[i], GenName.c_str());
+		if (!GenName.empty())
+		{
+			GenNames.push_back(StrToLower(GenName));
+		}
+	}
+
+	// Add the generators' settings, sorted by name so that the order in the ini file doesn't matter:
+	std::map<AString, AString> Settings;
+	int KeyID = a_IniFile.FindKey("Generator");
+	int NumValues = (KeyID < 0) ? 0 : a_IniFile.GetNumValues(KeyID);
+	for (int v = 0; v < NumValues; v++)
+	{
+		AString ValueName = StrToLower(a_IniFile.GetValueName(KeyID, v));
+		for (AStringVector::const_iterator itr = GenNames.begin(), end = GenNames.end(); itr != end; ++itr)
+		{
+			if ((ValueName.size() > itr->size()) && (ValueName.compare(0, itr->size(), *itr) == 0))
+			{
+				Settings[ValueName] = a_IniFile.GetValue(KeyID, v);
+				break;
+			}
+		}
+	}
+	for (std::map<AString, AString>::const_iterator itr = Settings.begin(), end = Settings.end(); itr != end; ++itr)
+	{
+		AppendPrintf(res, " %s=%s", itr->first.c_str(), itr->second.c_str());
+	}
+	return res;
+}
+
+
+
+
+
@@ -19,6 +19,8 @@ See http://forum.mc-server.org/showthread.php?tid=409 for details.
 
 #include "ChunkGenerator.h"
 #include "ChunkDesc.h"
+#include "SharedGenCache.h"
+#include "StructureLayoutStore.h"
 
 
 
@@ -30,12 +32,19 @@ class cTerrainShapeGen;
 class cTerrainHeightGen;
 class cTerrainCompositionGen;
 class cFinishGen;
+class cGridStructGen;
 typedef SharedPtr<cBiomeGen>              cBiomeGenPtr;
 typedef SharedPtr<cTerrainShapeGen>       cTerrainShapeGenPtr;
 typedef SharedPtr<cTerrainHeightGen>      cTerrainHeightGenPtr;
 typedef SharedPtr<cTerrainCompositionGen> cTerrainCompositionGenPtr;
 typedef SharedPtr<cFinishGen>             cFinishGenPtr;
 
+/** The caches that the generator instances of a single world share among themselves */
+typedef cSharedGenCache<cChunkDef::BiomeMap>  cBiomeMapSharedCache;
+typedef cSharedGenCache<cChunkDef::HeightMap> cHeightMapSharedCache;
+typedef SharedPtr<cBiomeMapSharedCache>       cBiomeMapSharedCachePtr;
+typedef SharedPtr<cHeightMapSharedCache>      cHeightMapSharedCachePtr;
+
 
 
 
@@ -51,6 +60,12 @@ public:
 	
 	/** Generates biomes for the given chunk */
 	virtual void GenBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::BiomeMap & a_BiomeMap) = 0;
+
+	/** Generates biomes for a square of a_NumChunks * a_NumChunks chunks starting at the given chunk, in one call.
+	a_BiomeMaps must hold a_NumChunks * a_NumChunks maps, the map for chunk [MinX + x, MinZ + z] is at index [x + a_NumChunks * z].
+	Meant for bulk generation, such as pregeneration or map rendering. The default calls GenBiomes() for each chunk;
+	generators with a high per-call overhead override this. Implemented in BioGen.cpp. */
+	virtual void GenBiomesArea(int a_MinChunkX, int a_MinChunkZ, int a_NumChunks, cChunkDef::BiomeMap * a_BiomeMaps);
 	
 	/** Reads parameters from the ini file, prepares generator for use. */
 	virtual void InitializeBiomeGen(cIniFile & a_IniFile) {}
@@ -177,11 +192,16 @@ class cComposableGenerator :
 	
 public:
 	cComposableGenerator(cChunkGenerator & a_ChunkGenerator);
+
+	/** Creates a generator that will share the biome and composited height caches with a_ShareCachesWith. */
+	cComposableGenerator(cChunkGenerator & a_ChunkGenerator, const cComposableGenerator & a_ShareCachesWith);
 	
 	// cChunkGenerator::cGenerator overrides:
 	virtual void Initialize(cIniFile & a_IniFile) override;
 	virtual void GenerateBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::BiomeMap & a_BiomeMap) override;
 	virtual void DoGenerate(int a_ChunkX, int a_ChunkZ, cChunkDesc & a_ChunkDesc) override;
+	virtual std::unique_ptr<cChunkGenerator::cGenerator> CreateInstance(cIniFile & a_IniFile) override;
+	virtual void LogCacheStats(cCommandOutputCallback & a_Output) override;
 
 protected:
 	// The generator's composition:
@@ -197,6 +217,17 @@ protected:
 	/** The cache for the heights of the composited terrain. */
 	cTerrainHeightGenPtr m_CompositedHeightCache;
 
+	/** The storage behind the biome cache, shared by all the generator instances created through CreateInstance(). */
+	cBiomeMapSharedCachePtr m_SharedBiomes;
+
+	/** The storage behind m_CompositedHeightCache, shared by all the generator instances created through CreateInstance(). */
+	cHeightMapSharedCachePtr m_SharedHeights;
+
+	/** The layout stores of the grid-based structure generators, indexed by the finisher name. Shared by all the
+	generator instances created through CreateInstance(); filled in by the first instance's InitFinishGens() and
+	only read afterwards, so it needs no locking. */
+	SharedPtr<std::map<AString, cStructureLayoutStorePtr>> m_LayoutStores;
+
 	/** The finisher generators, in the order in which they are applied. */
 	cFinishGenList m_FinishGens;
 	
@@ -212,6 +243,15 @@ protected:
 	
 	/** Reads the finishers from the ini and initializes m_FinishGens accordingly */
 	void InitFinishGens(cIniFile & a_IniFile);
+
+	/** Attaches the layout store for the specified finisher to a_Gen; the first instance creates the store,
+	persisted in the world folder if the ini says so. */
+	void AttachLayoutStore(cGridStructGen & a_Gen, const AString & a_FinisherName, cIniFile & a_IniFile);
+
+	/** Returns the names and settings of the biome, shape, height and composition generators, as found in the ini.
+	The settings are the [Generator] values named with the generator's name as a prefix. Used in the persisted
+	layouts' signature, because the structures are placed into the terrain that these generators produce. */
+	static AString GetTerrainSignature(const cIniFile & a_IniFile);
 } ;
 
 
@@ -52,7 +52,8 @@ cGridStructGen::cGridStructGen(
 	m_MaxOffsetZ(a_MaxOffsetZ),
 	m_MaxStructureSizeX(a_MaxStructureSizeX),
 	m_MaxStructureSizeZ(a_MaxStructureSizeZ),
-	m_MaxCacheSize(a_MaxCacheSize)
+	m_MaxCacheSize(a_MaxCacheSize),
+	m_CacheCost(0)
 {
 	if (m_GridSizeX == 0)
 	{
@@ -79,6 +80,17 @@ cGridStructGen::cGridStructGen(
 
 
 
+AString cGridStructGen::GetLayoutSignature(void) const
+{
+	return Printf("%d %d %d %d %d %d %d",
+		m_Seed, m_GridSizeX, m_GridSizeZ, m_MaxOffsetX, m_MaxOffsetZ, m_MaxStructureSizeX, m_MaxStructureSizeZ
+	);
+}
+
+
+
+
+
 void cGridStructGen::GetStructuresForChunk(int a_ChunkX, int a_ChunkZ, cStructurePtrs & a_Structures)
 {
 	// Calculate the min and max grid coords of the structures to be returned:
@@ -90,76 +102,83 @@ void cGridStructGen::GetStructuresForChunk(int a_ChunkX, int a_ChunkZ, cStructur
 	int MinGridZ = MinBlockZ / m_GridSizeZ;
 	int MaxGridX = (MaxBlockX + m_GridSizeX - 1) / m_GridSizeX;
 	int MaxGridZ = (MaxBlockZ + m_GridSizeZ - 1) / m_GridSizeZ;
-	int MinX = MinGridX * m_GridSizeX;
-	int MaxX = MaxGridX * m_GridSizeX;
-	int MinZ = MinGridZ * m_GridSizeZ;
-	int MaxZ = MaxGridZ * m_GridSizeZ;
-
-	// Walk the cache, move each structure that we want into a_Structures:
-	for (cStructurePtrs::iterator itr = m_Cache.begin(), end = m_Cache.end(); itr != end;)
-	{
-		if (
-			((*itr)->m_GridX >= MinX) && ((*itr)->m_GridX < MaxX) &&
-			((*itr)->m_GridZ >= MinZ) && ((*itr)->m_GridZ < MaxZ)
-		)
-		{
-			// want
-			a_Structures.push_back(*itr);
-			itr = m_Cache.erase(itr);
-		}
-		else
-		{
-			// don't want
-			++itr;
-		}
-	}  // for itr - m_Cache[]
 
-	// Create those structures that haven't been in the cache:
+	// Look up each grid cell in the cache, obtain those that aren't cached:
 	for (int x = MinGridX; x < MaxGridX; x++)
 	{
 		int GridX = x * m_GridSizeX;
 		for (int z = MinGridZ; z < MaxGridZ; z++)
 		{
 			int GridZ = z * m_GridSizeZ;
-			bool Found = false;
-			for (cStructurePtrs::const_iterator itr = a_Structures.begin(), end = a_Structures.end(); itr != end; ++itr)
+			Int64 Key = CellKey(GridX, GridZ);
+			cStructureIndex::iterator itr = m_CacheIndex.find(Key);
+			if (itr != m_CacheIndex.end())
 			{
-				if (((*itr)->m_GridX == GridX) && ((*itr)->m_GridZ == GridZ))
-				{
-					Found = true;
-					break;
-				}
-			}  // for itr - a_Structures[]
-			if (!Found)
+				// Cached, move to the front of the LRU order (the iterator stays valid):
+				m_Cache.splice(m_Cache.begin(), m_Cache, itr->second);
+			}
+			else
 			{
-				int OriginX = GridX + ((m_Noise.IntNoise2DInt(GridX + 3, GridZ + 5) / 7) % (m_MaxOffsetX * 2)) - m_MaxOffsetX;
-				int OriginZ = GridZ + ((m_Noise.IntNoise2DInt(GridX + 5, GridZ + 3) / 7) % (m_MaxOffsetZ * 2)) - m_MaxOffsetZ;
-				cStructurePtr Structure = CreateStructure(GridX, GridZ, OriginX, OriginZ);
-				if (Structure.get() == nullptr)
-				{
-					Structure.reset(new cEmptyStructure(GridX, GridZ, OriginX, OriginZ));
-				}
-				a_Structures.push_back(Structure);
+				cStructurePtr Structure = ObtainStructure(GridX, GridZ);
+				m_Cache.push_front(Structure);
+				m_CacheIndex[Key] = m_Cache.begin();
+				m_CacheCost += Structure->GetCacheCost();
 			}
+			a_Structures.push_back(m_Cache.front());
 		}  // for z
 	}  // for x
 
-	// Copy a_Forts into m_Cache to the beginning:
-	cStructurePtrs StructuresCopy (a_Structures);
-	m_Cache.splice(m_Cache.begin(), StructuresCopy, StructuresCopy.begin(), StructuresCopy.end());
+	// Trim the cache if it's too expensive; the structures for this chunk are at the front, so they stay:
+	while ((m_CacheCost > m_MaxCacheSize) && !m_Cache.empty())
+	{
+		const cStructurePtr & Oldest = m_Cache.back();
+		m_CacheCost -= Oldest->GetCacheCost();
+		m_CacheIndex.erase(CellKey(Oldest->m_GridX, Oldest->m_GridZ));
+		m_Cache.pop_back();
+	}
+}
+
+
+
+
+
+cGridStructGen::cStructurePtr cGridStructGen::ObtainStructure(int a_GridX, int a_GridZ)
+{
+	int OriginX = a_GridX + ((m_Noise.IntNoise2DInt(a_GridX + 3, a_GridZ + 5) / 7) % (m_MaxOffsetX * 2)) - m_MaxOffsetX;
+	int OriginZ = a_GridZ + ((m_Noise.IntNoise2DInt(a_GridX + 5, a_GridZ + 3) / 7) % (m_MaxOffsetZ * 2)) - m_MaxOffsetZ;
+
+	// Try recreating the structure from its stored layout:
+	AString Layout;
+	if ((m_LayoutStore != nullptr) && m_LayoutStore->Get(a_GridX, a_GridZ, Layout))
+	{
+		if (Layout.empty())
+		{
+			return cStructurePtr(new cEmptyStructure(a_GridX, a_GridZ, OriginX, OriginZ));
+		}
+		cStructurePtr Structure = CreateStructureFromLayout(a_GridX, a_GridZ, OriginX, OriginZ, Layout);
+		if (Structure != nullptr)
+		{
+			return Structure;
+		}
+	}
 
-	// Trim the cache if it's too long:
-	size_t CacheSize = 0;
-	for (cStructurePtrs::iterator itr = m_Cache.begin(), end = m_Cache.end(); itr != end; ++itr)
+	// Create a new structure, store its layout for the other generator instances:
+	cStructurePtr Structure = CreateStructure(a_GridX, a_GridZ, OriginX, OriginZ);
+	if (Structure == nullptr)
 	{
-		CacheSize += (*itr)->GetCacheCost();
-		if (CacheSize > m_MaxCacheSize)
+		if (m_LayoutStore != nullptr)
 		{
-			// Erase all items from this one till the cache end
-			m_Cache.erase(itr, m_Cache.end());
-			break;
+			m_LayoutStore->Put(a_GridX, a_GridZ, AString());
 		}
+		return cStructurePtr(new cEmptyStructure(a_GridX, a_GridZ, OriginX, OriginZ));
+	}
+	Layout.clear();
+	if ((m_LayoutStore != nullptr) && Structure->SerializeLayout(Layout))
+	{
+		ASSERT(!Layout.empty());
+		m_LayoutStore->Put(a_GridX, a_GridZ, Layout);
 	}
+	return Structure;
 }
 
 
@@ -11,6 +11,7 @@
 
 #include "ComposableGenerator.h"
 #include "../Noise/Noise.h"
+#include "StructureLayoutStore.h"
 
 
 
@@ -28,11 +29,16 @@ which it's built (m_OriginX, m_OriginZ).
 
 This class provides a cache for the structures generated for successive chunks and manages that cache. It
 also provides the cFinishGen override that uses the cache to actually generate the structure into chunk data.
+The cache is indexed by the grid cell, so that each chunk only looks up the cells that it may intersect.
 
 After generating each chunk the cache is checked for size, each item in the cache has a cost associated with
 it and the cache is trimmed (from its least-recently-used end) so that the sum of the cost in the cache is
 less than m_MaxCacheSize
 
+Optionally the generator may be given a cStructureLayoutStore shared with the other generator instances of the
+world. Structures that are not in the cache are then first looked up in the store, and recreated from their
+stored layout by CreateStructureFromLayout(); newly created structures put their layout into the store.
+
 To use this class, declare a descendant class that implements the overridable methods, then create an
 instance of that class. The descendant must provide the CreateStructure() function that is called to generate
 a structure at the specific grid cell.
@@ -73,6 +79,11 @@ public:
 		
 		/** Returns the cost of keeping this structure in the cache */
 		virtual size_t GetCacheCost(void) const { return 1; }
+
+		/** Stores the layout of the structure, from which the generator's CreateStructureFromLayout() can recreate it,
+		into a_Layout. The layout must be a single line of text, and mustn't be empty.
+		Returns false if the structure doesn't support layouts (the default). */
+		virtual bool SerializeLayout(AString & a_Layout) const { UNUSED(a_Layout); return false; }
 	} ;
 	typedef SharedPtr<cStructure> cStructurePtr;
 	typedef std::list<cStructurePtr> cStructurePtrs;
@@ -85,8 +96,20 @@ public:
 		int a_MaxStructureSizeX, int a_MaxStructureSizeZ,
 		size_t a_MaxCacheSize
 	);
+
+	/** Sets the store for the structure layouts, shared with the other generator instances. */
+	void SetLayoutStore(cStructureLayoutStorePtr a_LayoutStore) { m_LayoutStore = a_LayoutStore; }
+
+	/** Returns a string identifying the settings that affect the generated structures.
+	The persisted layouts are only reused if the signature matches. Descendants with additional settings should
+	append them to the base signature. The terrain generators' settings are added by the composable generator,
+	see cComposableGenerator::GetTerrainSignature(). */
+	virtual AString GetLayoutSignature(void) const;
 	
 protected:
+	typedef std::map<Int64, cStructurePtrs::iterator> cStructureIndex;
+
+
 	/** Seed for generating grid offsets and also available for descendants. */
 	int m_Seed;
 	
@@ -121,10 +144,26 @@ protected:
 	
 	/** Cache for the most recently generated structures, ordered by the recentness. */
 	cStructurePtrs m_Cache;
+
+	/** Index of the structures in m_Cache by their grid cell, see CellKey(). */
+	cStructureIndex m_CacheIndex;
+
+	/** Sum of the costs of all the structures in m_Cache */
+	size_t m_CacheCost;
+
+	/** The store of the structure layouts, shared with the other generator instances. May be nullptr. */
+	cStructureLayoutStorePtr m_LayoutStore;
 	
 	
-	/** Clears everything from the cache */
-	void ClearCache(void);
+	/** Returns the key into m_CacheIndex for the specified grid cell. */
+	static Int64 CellKey(int a_GridX, int a_GridZ)
+	{
+		return (static_cast<Int64>(a_GridX) << 32) | static_cast<Int64>(static_cast<UInt32>(a_GridZ));
+	}
+
+	/** Returns the structure for the specified grid cell, recreated from the layout store if possible, or newly created.
+	Never returns nullptr, grid cells with no structure get an empty structure. Doesn't touch the cache. */
+	cStructurePtr ObtainStructure(int a_GridX, int a_GridZ);
 	
 	/** Returns all structures that may intersect the given chunk.
 	The structures are considered as intersecting iff their bounding box (defined by m_MaxStructureSize)
@@ -137,6 +176,18 @@ protected:
 	// Functions for the descendants to override:
 	/** Create a new structure at the specified gridpoint */
 	virtual cStructurePtr CreateStructure(int a_GridX, int a_GridZ, int a_OriginX, int a_OriginZ) = 0;
+
+	/** Recreates the structure at the specified gridpoint from the layout that it produced in SerializeLayout().
+	Returns nullptr if the layout is not valid; the structure is then created anew by CreateStructure(). */
+	virtual cStructurePtr CreateStructureFromLayout(int a_GridX, int a_GridZ, int a_OriginX, int a_OriginZ, const AString & a_Layout)
+	{
+		UNUSED(a_GridX);
+		UNUSED(a_GridZ);
+		UNUSED(a_OriginX);
+		UNUSED(a_OriginZ);
+		UNUSED(a_Layout);
+		return cStructurePtr();
+	}
 } ;
 
 
@@ -194,6 +194,33 @@ bool cHeiGenMultiCache::GetHeightAt(int a_ChunkX, int a_ChunkZ, int a_RelX, int
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cHeiGenSharedCache:
+
+cHeiGenSharedCache::cHeiGenSharedCache(cTerrainHeightGenPtr a_HeiGenToCache, cHeightMapSharedCachePtr a_Cache) :
+	m_HeiGenToCache(a_HeiGenToCache),
+	m_Cache(a_Cache)
+{
+}
+
+
+
+
+
+void cHeiGenSharedCache::GenHeightMap(int a_ChunkX, int a_ChunkZ, cChunkDef::HeightMap & a_HeightMap)
+{
+	if (m_Cache->Get(a_ChunkX, a_ChunkZ, a_HeightMap))
+	{
+		return;
+	}
+	m_HeiGenToCache->GenHeightMap(a_ChunkX, a_ChunkZ, a_HeightMap);
+	m_Cache->Put(a_ChunkX, a_ChunkZ, a_HeightMap);
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cHeiGenClassic:
 
@@ -95,6 +95,29 @@ protected:
 
 
 
+/** A front-end to a cache shared among multiple generator instances, possibly running in different threads.
+On a miss the heightmap is generated by this instance's own height generator and stored into the shared cache. */
+class cHeiGenSharedCache :
+	public cTerrainHeightGen
+{
+public:
+	cHeiGenSharedCache(cTerrainHeightGenPtr a_HeiGenToCache, cHeightMapSharedCachePtr a_Cache);
+
+	// cTerrainHeightGen overrides:
+	virtual void GenHeightMap(int a_ChunkX, int a_ChunkZ, cChunkDef::HeightMap & a_HeightMap) override;
+
+protected:
+	/** The height generator used on cache misses. */
+	cTerrainHeightGenPtr m_HeiGenToCache;
+
+	/** The cache storage, shared with other generator instances. */
+	cHeightMapSharedCachePtr m_Cache;
+} ;
+
+
+
+
+
 class cHeiGenFlat :
 	public cTerrainHeightGen
 {
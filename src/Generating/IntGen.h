@@ -128,10 +128,11 @@ public:
 	{
 		for (int z = 0; z < SizeZ; z++)
 		{
-			int BaseZ = a_MinZ + z;
+			int * Row = a_Values + SizeX * z;
+			super::m_Noise.IntNoise2DIntRow(a_MinX, 1, a_MinZ + z, SizeX, Row);
 			for (int x = 0; x < SizeX; x++)
 			{
-				a_Values[x + SizeX * z] = (super::m_Noise.IntNoise2DInt(a_MinX + x, BaseZ) / 7) % Range;
+				Row[x] = (Row[x] / 7) % Range;
 			}
 		}  // for z
 	}
@@ -163,11 +164,12 @@ public:
 	{
 		for (int z = 0; z < SizeZ; z++)
 		{
-			int BaseZ = a_MinZ + z;
+			int * Row = a_Values + SizeX * z;
+			super::m_Noise.IntNoise2DIntRow(a_MinX, 1, a_MinZ + z, SizeX, Row);
 			for (int x = 0; x < SizeX; x++)
 			{
-				int rnd = (super::m_Noise.IntNoise2DInt(a_MinX + x, BaseZ) / 7);
-				a_Values[x + SizeX * z] = ((rnd % 100) < m_Threshold) ? ((rnd / 101) % bgLandOceanMax + 1) : 0;
+				int rnd = Row[x] / 7;
+				Row[x] = ((rnd % 100) < m_Threshold) ? ((rnd / 101) % bgLandOceanMax + 1) : 0;
 			}
 		}
 
@@ -221,23 +223,34 @@ public:
 		const int lowStepZ = (m_LowerSizeZ - 1) * 2;
 		int cache[lowStepX * lowStepZ];
 
-		// Discreet-interpolate the values into twice the size:
+		// Discreet-interpolate the values into twice the size; the noise for each row is hashed in a single pass first:
+		int NoiseAbove[m_LowerSizeX - 1];
+		int NoiseBelow[m_LowerSizeX - 1];
+		int NoiseCenter[m_LowerSizeX - 1];
 		for (int z = 0; z < m_LowerSizeZ - 1; ++z)
 		{
 			int idx = (z * 2) * lowStepX;
 			int PrevZ0 = lowerData[z * m_LowerSizeX];
 			int PrevZ1 = lowerData[(z + 1) * m_LowerSizeX];
+			int RndZ = (z + lowerMinZ) * 2;
+			super::m_Noise.IntNoise2DIntRow(lowerMinX * 2, 2, RndZ - 1, m_LowerSizeX - 1, NoiseAbove);
+			super::m_Noise.IntNoise2DIntRow(lowerMinX * 2, 2, RndZ + 1, m_LowerSizeX - 1, NoiseBelow);
+			super::m_Noise.IntNoise2DIntRow(lowerMinX * 2, 2, RndZ,     m_LowerSizeX - 1, NoiseCenter);
 
 			for (int x = 0; x < m_LowerSizeX - 1; ++x)
 			{
 				int ValX1Z0 = lowerData[x + 1 + z * m_LowerSizeX];
 				int ValX1Z1 = lowerData[x + 1 + (z + 1) * m_LowerSizeX];
-				int RndX = (x + lowerMinX) * 2;
-				int RndZ = (z + lowerMinZ) * 2;
 				cache[idx] = PrevZ0;
-				cache[idx + lowStepX] = super::ChooseRandomOne(RndX, RndZ + 1, PrevZ0, PrevZ1);
-				cache[idx + 1]        = super::ChooseRandomOne(RndX, RndZ - 1, PrevZ0, ValX1Z0);
-				cache[idx + 1 + lowStepX] = super::ChooseRandomOne(RndX, RndZ, PrevZ0, ValX1Z0, PrevZ1, ValX1Z1);
+				cache[idx + lowStepX] = (((NoiseBelow[x] / 7) & 1) == 0) ? PrevZ0 : PrevZ1;
+				cache[idx + 1]        = (((NoiseAbove[x] / 7) & 1) == 0) ? PrevZ0 : ValX1Z0;
+				switch ((NoiseCenter[x] / 7) % 4)
+				{
+					case 0:  cache[idx + 1 + lowStepX] = PrevZ0;  break;
+					case 1:  cache[idx + 1 + lowStepX] = ValX1Z0; break;
+					case 2:  cache[idx + 1 + lowStepX] = PrevZ1;  break;
+					default: cache[idx + 1 + lowStepX] = ValX1Z1; break;
+				}
 				idx += 2;
 				PrevZ0 = ValX1Z0;
 				PrevZ1 = ValX1Z1;
@@ -43,6 +43,17 @@ public:
 		}
 	}
 
+
+	/** Creates a fort out of the pieces recreated from a stored layout; takes over the pieces from a_Pieces. */
+	cNetherFort(cNetherFortGen & a_ParentGen, int a_GridX, int a_GridZ, int a_OriginX, int a_OriginZ, int a_GridSize, int a_Seed, cPlacedPieces & a_Pieces) :
+		super(a_GridX, a_GridZ, a_OriginX, a_OriginZ),
+		m_ParentGen(a_ParentGen),
+		m_GridSize(a_GridSize),
+		m_Seed(a_Seed)
+	{
+		std::swap(m_Pieces, a_Pieces);
+	}
+
 	
 	~cNetherFort()
 	{
@@ -59,6 +70,12 @@ public:
 			Prefab.Draw(a_Chunk, *itr);
 		}  // for itr - m_PlacedPieces[]
 	}
+
+
+	virtual bool SerializeLayout(AString & a_Layout) const override
+	{
+		return cPieceGenerator::SerializePieces(m_Pieces, cNetherFortGen::m_PiecePool.GetAllPieces(), a_Layout);
+	}
 };
 
 
@@ -132,3 +149,28 @@ cGridStructGen::cStructurePtr cNetherFortGen::CreateStructure(int a_GridX, int a
 
 
 
+
+AString cNetherFortGen::GetLayoutSignature(void) const
+{
+	AString res = super::GetLayoutSignature();
+	AppendPrintf(res, " netherfort %d %u", m_MaxDepth, static_cast<unsigned>(m_PiecePool.GetAllPieces().size()));
+	return res;
+}
+
+
+
+
+
+cGridStructGen::cStructurePtr cNetherFortGen::CreateStructureFromLayout(int a_GridX, int a_GridZ, int a_OriginX, int a_OriginZ, const AString & a_Layout)
+{
+	cPlacedPieces Pieces;
+	if (!cPieceGenerator::DeserializePieces(StringSplit(a_Layout, " "), 0, m_PiecePool.GetAllPieces(), Pieces))
+	{
+		return cStructurePtr();
+	}
+	return cStructurePtr(new cNetherFort(*this, a_GridX, a_GridZ, a_OriginX, a_OriginZ, m_GridSizeX, m_Seed, Pieces));
+}
+
+
+
+
@@ -355,6 +355,90 @@ void cPieceGenerator::FreePieces(cPlacedPieces & a_PlacedPieces)
 
 
 
+bool cPieceGenerator::SerializePieces(const cPlacedPieces & a_PlacedPieces, const cPieces & a_AllPieces, AString & a_Layout)
+{
+	for (size_t i = 0; i < a_PlacedPieces.size(); i++)
+	{
+		const cPlacedPiece & Placed = *a_PlacedPieces[i];
+		cPieces::const_iterator PieceItr = std::find(a_AllPieces.begin(), a_AllPieces.end(), &Placed.GetPiece());
+		if (PieceItr == a_AllPieces.end())
+		{
+			return false;
+		}
+		int ParentIdx = -1;
+		if (Placed.GetParent() != nullptr)
+		{
+			cPlacedPieces::const_iterator ParentItr = std::find(a_PlacedPieces.begin(), a_PlacedPieces.begin() + static_cast<ptrdiff_t>(i), Placed.GetParent());
+			if (ParentItr == a_PlacedPieces.begin() + static_cast<ptrdiff_t>(i))
+			{
+				return false;
+			}
+			ParentIdx = static_cast<int>(ParentItr - a_PlacedPieces.begin());
+		}
+
+		// The hitbox is calculated from the coords before any move to ground, use it to get the original Y coord:
+		cCuboid ZeroHitBox = Placed.GetPiece().RotateMoveHitBox(Placed.GetNumCCWRotations(), 0, 0, 0);
+		ZeroHitBox.Sort();
+		int OrigY = Placed.GetHitBox().p1.y - ZeroHitBox.p1.y;
+
+		const Vector3i & Coords = Placed.GetCoords();
+		AppendPrintf(a_Layout, "%s%d %d %d %d %d %d %d %d",
+			a_Layout.empty() ? "" : " ",
+			static_cast<int>(PieceItr - a_AllPieces.begin()), ParentIdx,
+			Coords.x, OrigY, Coords.z, Placed.GetNumCCWRotations(),
+			Placed.HasBeenMovedToGround() ? 1 : 0, Coords.y
+		);
+	}  // for i - a_PlacedPieces[]
+	return true;
+}
+
+
+
+
+
+bool cPieceGenerator::DeserializePieces(const AStringVector & a_Numbers, size_t a_Start, const cPieces & a_AllPieces, cPlacedPieces & a_PlacedPieces)
+{
+	static const size_t NUMBERS_PER_PIECE = 8;
+	if ((a_Start > a_Numbers.size()) || (((a_Numbers.size() - a_Start) % NUMBERS_PER_PIECE) != 0))
+	{
+		return false;
+	}
+	for (size_t i = a_Start; i < a_Numbers.size(); i += NUMBERS_PER_PIECE)
+	{
+		int Values[NUMBERS_PER_PIECE];
+		for (size_t j = 0; j < NUMBERS_PER_PIECE; j++)
+		{
+			if (!StringToInteger(a_Numbers[i + j], Values[j]))
+			{
+				FreePieces(a_PlacedPieces);
+				return false;
+			}
+		}
+		int PieceIdx = Values[0], ParentIdx = Values[1], NumCCWRotations = Values[5];
+		if (
+			(PieceIdx < 0) || (static_cast<size_t>(PieceIdx) >= a_AllPieces.size()) ||
+			(ParentIdx < -1) || (ParentIdx >= static_cast<int>(a_PlacedPieces.size())) ||
+			(NumCCWRotations < 0) || (NumCCWRotations > 3)
+		)
+		{
+			FreePieces(a_PlacedPieces);
+			return false;
+		}
+		const cPlacedPiece * Parent = (ParentIdx < 0) ? nullptr : a_PlacedPieces[static_cast<size_t>(ParentIdx)];
+		cPlacedPiece * Placed = new cPlacedPiece(Parent, *a_AllPieces[static_cast<size_t>(PieceIdx)], Vector3i(Values[2], Values[3], Values[4]), NumCCWRotations);
+		if (Values[6] != 0)
+		{
+			Placed->MoveToGroundBy(Values[7] - Values[3]);
+		}
+		a_PlacedPieces.push_back(Placed);
+	}
+	return true;
+}
+
+
+
+
+
 cPlacedPiece * cPieceGenerator::PlaceStartingPiece(int a_BlockX, int a_BlockY, int a_BlockZ, cFreeConnectors & a_OutConnectors)
 {
 	m_PiecePool.Reset();
@@ -199,6 +199,16 @@ public:
 	/** Cleans up all the memory used by the placed pieces.
 	Call this utility function instead of freeing the items on your own. */
 	static void FreePieces(cPlacedPieces & a_PlacedPieces);
+
+	/** Appends the layout of the placed pieces to a_Layout, as a list of space-separated numbers.
+	The pieces are identified by their index in a_AllPieces, each piece's parent must precede it in a_PlacedPieces.
+	Returns false if the layout cannot be serialized (a piece is not in a_AllPieces). */
+	static bool SerializePieces(const cPlacedPieces & a_PlacedPieces, const cPieces & a_AllPieces, AString & a_Layout);
+
+	/** Recreates the placed pieces from the numbers produced by SerializePieces(), starting at a_Numbers[a_Start].
+	a_AllPieces must be the same list as the one used for serializing.
+	Returns false if the data is not valid, a_PlacedPieces is left empty then. */
+	static bool DeserializePieces(const AStringVector & a_Numbers, size_t a_Start, const cPieces & a_AllPieces, cPlacedPieces & a_PlacedPieces);
 	
 protected:
 	/** The type used for storing a connection from one piece to another, while building the piece tree. */
@@ -35,6 +35,17 @@ cPrefabPiecePool::~cPrefabPiecePool()
 
 
 
+cPieces cPrefabPiecePool::GetAllPieces(void) const
+{
+	cPieces res(m_AllPieces);
+	res.insert(res.end(), m_StartingPieces.begin(), m_StartingPieces.end());
+	return res;
+}
+
+
+
+
+
 void cPrefabPiecePool::Clear(void)
 {
 	m_PiecesByConnector.clear();
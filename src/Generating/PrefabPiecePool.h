@@ -37,6 +37,10 @@ public:
 	/** Destroys the pool, freeing all pieces. */
 	~cPrefabPiecePool();
 	
+	/** Returns all the pieces in the pool, the starting pieces after the regular ones.
+	The order is stable for the same piece definitions, so the index can be used to identify a piece. */
+	cPieces GetAllPieces(void) const;
+	
 	/** Removes and frees all pieces from this pool. */
 	void Clear(void);
 	
@@ -0,0 +1,187 @@
+
+// SharedGenCache.h
+
+// Declares the cSharedGenCache class template, a thread-safe cache of per-chunk generator data
+
+/*
+The cache is split into stripes by the chunk coords, each stripe has its own lock and a fixed number of entries,
+so the memory used by the cache is bounded and the threads generating different chunks rarely contend for a lock.
+Within a stripe the entries are kept in MRU order, the least recently used entry is replaced on insertion.
+The cache only stores the data, it doesn't generate anything; on a miss the caller generates the data using
+its own generator instance and then puts the result in, see cHeiGenSharedCache and cBioGenSharedCache.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+template <typename DataType>
+class cSharedGenCache
+{
+public:
+	/** The statistics of the cache, summed over all the stripes */
+	struct sStats
+	{
+		UInt64 m_NumHits;
+		UInt64 m_NumMisses;
+
+		/** Number of entries currently holding data */
+		size_t m_NumUsed;
+
+		/** The maximum number of entries in the cache */
+		size_t m_Capacity;
+	} ;
+
+
+	/** Creates a cache of a_NumStripes stripes with a_StripeSize entries each. */
+	cSharedGenCache(size_t a_NumStripes, size_t a_StripeSize)
+	{
+		ASSERT(a_NumStripes > 0);
+		ASSERT(a_StripeSize > 0);
+		m_Stripes.reserve(a_NumStripes);
+		for (size_t i = 0; i < a_NumStripes; i++)
+		{
+			m_Stripes.push_back(make_unique<sStripe>(a_StripeSize));
+		}
+	}
+
+
+	/** Copies the cached data for the specified chunk into a_Data and returns true.
+	Returns false if the chunk is not in the cache; a_Data is left untouched. Updates the hit / miss counters. */
+	bool Get(int a_ChunkX, int a_ChunkZ, DataType & a_Data)
+	{
+		sStripe & Stripe = GetStripe(a_ChunkX, a_ChunkZ);
+		cCSLock Lock(Stripe.m_CS);
+		size_t Size = Stripe.m_Order.size();
+		for (size_t i = 0; i < Size; i++)
+		{
+			size_t Idx = Stripe.m_Order[i];
+			if ((Stripe.m_Entries[Idx].m_ChunkX != a_ChunkX) || (Stripe.m_Entries[Idx].m_ChunkZ != a_ChunkZ))
+			{
+				continue;
+			}
+			// Found it, move to front and use the data:
+			std::rotate(Stripe.m_Order.begin(), Stripe.m_Order.begin() + static_cast<ptrdiff_t>(i), Stripe.m_Order.begin() + static_cast<ptrdiff_t>(i) + 1);
+			memcpy(&a_Data, &Stripe.m_Entries[Idx].m_Data, sizeof(DataType));
+			Stripe.m_NumHits += 1;
+			return true;
+		}
+		Stripe.m_NumMisses += 1;
+		return false;
+	}
+
+
+	/** Stores the data for the specified chunk as the most recently used entry of its stripe.
+	If the chunk is already cached (another thread generated it in the meantime), only the MRU order is updated. */
+	void Put(int a_ChunkX, int a_ChunkZ, const DataType & a_Data)
+	{
+		sStripe & Stripe = GetStripe(a_ChunkX, a_ChunkZ);
+		cCSLock Lock(Stripe.m_CS);
+		size_t Size = Stripe.m_Order.size();
+		size_t Pos = Size - 1;  // Replace the least recently used entry, unless the chunk is found
+		for (size_t i = 0; i < Size; i++)
+		{
+			const sEntry & Entry = Stripe.m_Entries[Stripe.m_Order[i]];
+			if ((Entry.m_ChunkX == a_ChunkX) && (Entry.m_ChunkZ == a_ChunkZ))
+			{
+				Pos = i;
+				break;
+			}
+		}
+		std::rotate(Stripe.m_Order.begin(), Stripe.m_Order.begin() + static_cast<ptrdiff_t>(Pos), Stripe.m_Order.begin() + static_cast<ptrdiff_t>(Pos) + 1);
+		sEntry & Entry = Stripe.m_Entries[Stripe.m_Order[0]];
+		Entry.m_ChunkX = a_ChunkX;
+		Entry.m_ChunkZ = a_ChunkZ;
+		memcpy(&Entry.m_Data, &a_Data, sizeof(DataType));
+	}
+
+
+	/** Returns the statistics summed over all the stripes. */
+	sStats GetStats(void)
+	{
+		sStats Stats;
+		Stats.m_NumHits = 0;
+		Stats.m_NumMisses = 0;
+		Stats.m_NumUsed = 0;
+		Stats.m_Capacity = 0;
+		for (typename cStripes::iterator itr = m_Stripes.begin(), end = m_Stripes.end(); itr != end; ++itr)
+		{
+			cCSLock Lock((*itr)->m_CS);
+			Stats.m_NumHits += (*itr)->m_NumHits;
+			Stats.m_NumMisses += (*itr)->m_NumMisses;
+			Stats.m_Capacity += (*itr)->m_Entries.size();
+			for (typename std::vector<sEntry>::const_iterator itrE = (*itr)->m_Entries.begin(), endE = (*itr)->m_Entries.end(); itrE != endE; ++itrE)
+			{
+				if (itrE->m_ChunkX != InvalidCoord)
+				{
+					Stats.m_NumUsed += 1;
+				}
+			}
+		}
+		return Stats;
+	}
+
+protected:
+	/** The chunk coord marking an unused entry */
+	static const int InvalidCoord = 0x7fffffff;
+
+	/** The coefficient used to turn the chunk coords into the stripe index (x + Coeff * z), the same as the older multicaches. */
+	static const size_t CoeffZ = 5;
+
+	struct sEntry
+	{
+		int m_ChunkX;
+		int m_ChunkZ;
+		DataType m_Data;
+	} ;
+
+	struct sStripe
+	{
+		cCriticalSection m_CS;
+
+		/** The cached data. Not reordered, to avoid moving the data around; m_Order provides the MRU order. */
+		std::vector<sEntry> m_Entries;
+
+		/** Indices into m_Entries, m_Entries[m_Order[0]] is the most recently used */
+		std::vector<size_t> m_Order;
+
+		UInt64 m_NumHits;
+		UInt64 m_NumMisses;
+
+		sStripe(size_t a_Size) :
+			m_Entries(a_Size),
+			m_Order(a_Size),
+			m_NumHits(0),
+			m_NumMisses(0)
+		{
+			for (size_t i = 0; i < a_Size; i++)
+			{
+				m_Entries[i].m_ChunkX = InvalidCoord;
+				m_Entries[i].m_ChunkZ = InvalidCoord;
+				m_Order[i] = i;
+			}
+		}
+	} ;
+
+	typedef std::vector<std::unique_ptr<sStripe>> cStripes;
+
+	/** The stripes. The vector itself is never modified after construction, so it needs no locking. */
+	cStripes m_Stripes;
+
+
+	/** Returns the stripe responsible for the specified chunk. */
+	sStripe & GetStripe(int a_ChunkX, int a_ChunkZ)
+	{
+		return *m_Stripes[(static_cast<size_t>(a_ChunkX) + CoeffZ * static_cast<size_t>(a_ChunkZ)) % m_Stripes.size()];
+	}
+} ;
+
+
+
+
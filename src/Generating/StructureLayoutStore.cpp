@@ -0,0 +1,127 @@
+// StructureLayoutStore.cpp
+
+// Implements the cStructureLayoutStore class that stores the layouts of the structures generated by a cGridStructGen
+
+#include "Globals.h"
+#include "StructureLayoutStore.h"
+
+
+
+
+
+cStructureLayoutStore::cStructureLayoutStore(void)
+{
+}
+
+
+
+
+
+cStructureLayoutStore::cStructureLayoutStore(const AString & a_FileName, const AString & a_Signature)
+{
+	if (cFile::IsFile(a_FileName))
+	{
+		if (LoadLayouts(cFile::ReadWholeFile(a_FileName), a_Signature))
+		{
+			if (!m_File.Open(a_FileName, cFile::fmAppend))
+			{
+				LOGWARNING("Cannot append to the structure layouts file \"%s\", new layouts will not be persisted.", a_FileName.c_str());
+			}
+			return;
+		}
+		LOGINFO("The generator settings have changed, discarding the structure layouts in \"%s\".", a_FileName.c_str());
+	}
+
+	// Start a new file:
+	if (!m_File.Open(a_FileName, cFile::fmWrite))
+	{
+		LOGWARNING("Cannot create the structure layouts file \"%s\", the layouts will not be persisted.", a_FileName.c_str());
+		return;
+	}
+	m_File.Printf("%s\n", a_Signature.c_str());
+}
+
+
+
+
+
+bool cStructureLayoutStore::Get(int a_GridX, int a_GridZ, AString & a_Layout)
+{
+	cCSLock Lock(m_CS);
+	cLayoutMap::const_iterator itr = m_Layouts.find(CellKey(a_GridX, a_GridZ));
+	if (itr == m_Layouts.end())
+	{
+		return false;
+	}
+	a_Layout = itr->second;
+	return true;
+}
+
+
+
+
+
+void cStructureLayoutStore::Put(int a_GridX, int a_GridZ, const AString & a_Layout)
+{
+	cCSLock Lock(m_CS);
+	if (!m_Layouts.insert(std::make_pair(CellKey(a_GridX, a_GridZ), a_Layout)).second)
+	{
+		// Already stored by another thread
+		return;
+	}
+	if (m_File.IsOpen())
+	{
+		m_File.Printf("%d %d %s\n", a_GridX, a_GridZ, a_Layout.c_str());
+		m_File.Flush();
+	}
+}
+
+
+
+
+
+size_t cStructureLayoutStore::GetNumLayouts(void)
+{
+	cCSLock Lock(m_CS);
+	return m_Layouts.size();
+}
+
+
+
+
+
+bool cStructureLayoutStore::LoadLayouts(const AString & a_Contents, const AString & a_Signature)
+{
+	AStringVector Lines = StringSplit(a_Contents, "\n");
+	if (Lines.empty() || (TrimString(Lines[0]) != a_Signature))
+	{
+		return false;
+	}
+
+	// Each line is "GridX GridZ Layout"; skip the lines that don't parse, such as an incomplete last line:
+	for (AStringVector::const_iterator itr = Lines.begin() + 1, end = Lines.end(); itr != end; ++itr)
+	{
+		AString Line = TrimString(*itr);
+		size_t FirstSpace = Line.find(' ');
+		if (FirstSpace == AString::npos)
+		{
+			continue;
+		}
+		size_t SecondSpace = Line.find(' ', FirstSpace + 1);
+		int GridX, GridZ;
+		if (
+			!StringToInteger(Line.substr(0, FirstSpace), GridX) ||
+			!StringToInteger(Line.substr(FirstSpace + 1, SecondSpace - FirstSpace - 1), GridZ)
+		)
+		{
+			continue;
+		}
+		AString Layout = (SecondSpace == AString::npos) ? AString() : Line.substr(SecondSpace + 1);
+		m_Layouts[CellKey(GridX, GridZ)] = Layout;
+	}  // for itr - Lines[]
+	return true;
+}
+
+
+
+
@@ -0,0 +1,74 @@
+
+// StructureLayoutStore.h
+
+// Declares the cStructureLayoutStore class that stores the layouts of the structures generated by a cGridStructGen
+
+/*
+The layouts are short strings produced by the structures themselves (cGridStructGen::cStructure::SerializeLayout()),
+from which the generator can recreate the structure without repeating the expensive placement (biome checks,
+piece generation). An empty layout stands for a grid cell with no structure.
+A single store is shared by all the generator instances of a world, so that a structure placed by one generator
+thread is not recomputed by another one. If persisted, the store appends each new layout as a line of text into its
+file, so that the layouts survive a server restart. The first line of the file is the signature of the generator
+settings; if it doesn't match the current settings, the file is discarded and started anew.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../OSSupport/File.h"
+
+
+
+
+
+class cStructureLayoutStore
+{
+public:
+	/** Creates a store that is kept only in memory. */
+	cStructureLayoutStore(void);
+
+	/** Creates a store persisted in the specified file. Loads the layouts from the file, if it exists and has been
+	written with the same signature; otherwise the file is started anew. */
+	cStructureLayoutStore(const AString & a_FileName, const AString & a_Signature);
+
+	/** Retrieves the layout stored for the specified grid cell. Returns false if there's none. */
+	bool Get(int a_GridX, int a_GridZ, AString & a_Layout);
+
+	/** Stores the layout for the specified grid cell, and appends it to the file, if persisted.
+	If a layout is already stored for the cell (another thread has placed the same structure), it is kept. */
+	void Put(int a_GridX, int a_GridZ, const AString & a_Layout);
+
+	/** Returns the number of layouts in the store. */
+	size_t GetNumLayouts(void);
+
+protected:
+	typedef std::map<Int64, AString> cLayoutMap;
+
+	cCriticalSection m_CS;
+
+	/** The layouts, indexed by the grid cell (see CellKey()). Protected by m_CS. */
+	cLayoutMap m_Layouts;
+
+	/** The file to which the new layouts are appended. Not open if the store is not persisted. Protected by m_CS. */
+	cFile m_File;
+
+
+	/** Returns the key into m_Layouts for the specified grid cell. */
+	static Int64 CellKey(int a_GridX, int a_GridZ)
+	{
+		return (static_cast<Int64>(a_GridX) << 32) | static_cast<Int64>(static_cast<UInt32>(a_GridZ));
+	}
+
+	/** Loads the layouts from the specified file contents. Returns false if the signature doesn't match. */
+	bool LoadLayouts(const AString & a_Contents, const AString & a_Signature);
+} ;
+
+typedef SharedPtr<cStructureLayoutStore> cStructureLayoutStorePtr;
+
+
+
+
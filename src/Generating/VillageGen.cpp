@@ -149,6 +149,33 @@ public:
 			MoveAllDescendants(m_Pieces, 0, NewPosY - OrigPosY);
 		}
 	}
+
+	/** Creates a village out of the pieces recreated from a stored layout; takes over the pieces from a_Pieces. */
+	cVillage(
+		int a_Seed,
+		int a_GridX, int a_GridZ,
+		int a_OriginX, int a_OriginZ,
+		int a_MaxSize,
+		int a_Density,
+		cVillagePiecePool & a_Prefabs,
+		cTerrainHeightGenPtr a_HeightGen,
+		BLOCKTYPE a_RoadBlock,
+		BLOCKTYPE a_WaterRoadBlock,
+		cPlacedPieces & a_Pieces
+	) :
+		super(a_GridX, a_GridZ, a_OriginX, a_OriginZ),
+		m_Seed(a_Seed),
+		m_Noise(a_Seed),
+		m_MaxSize(a_MaxSize),
+		m_Density(a_Density),
+		m_Borders(a_OriginX - a_MaxSize, 0, a_OriginZ - a_MaxSize, a_OriginX + a_MaxSize, cChunkDef::Height - 1, a_OriginZ + a_MaxSize),
+		m_Prefabs(a_Prefabs),
+		m_HeightGen(a_HeightGen),
+		m_RoadBlock(a_RoadBlock),
+		m_WaterRoadBlock(a_WaterRoadBlock)
+	{
+		std::swap(m_Pieces, a_Pieces);
+	}
 	
 	~cVillage()
 	{
@@ -188,6 +215,8 @@ protected:
 	
 	
 	// cGridStructGen::cStructure overrides:
+	virtual bool SerializeLayout(AString & a_Layout) const override;
+
 	virtual void DrawIntoChunk(cChunkDesc & a_Chunk) override
 	{
 		// Iterate over all items
@@ -355,6 +384,37 @@ static cVillagePiecePool * g_PlainsVillagePools[] =
 	&g_JapaneseVillage,
 } ;
 
+/** All the village pools; the index into this array identifies the pool in the stored village layouts. */
+static cVillagePiecePool * g_AllVillagePools[] =
+{
+	&g_SandVillage,
+	&g_SandFlatRoofVillage,
+	&g_AlchemistVillage,
+	&g_PlainsVillage,
+	&g_JapaneseVillage,
+} ;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cVillageGen::cVillage:
+
+bool cVillageGen::cVillage::SerializeLayout(AString & a_Layout) const
+{
+	// The layout is "PoolIndex Density", followed by the pieces:
+	for (size_t i = 0; i < ARRAYCOUNT(g_AllVillagePools); i++)
+	{
+		if (static_cast<cPiecePool *>(g_AllVillagePools[i]) == &m_Prefabs)
+		{
+			a_Layout = Printf("%u %d", static_cast<unsigned>(i), m_Density);
+			return cPieceGenerator::SerializePieces(m_Pieces, g_AllVillagePools[i]->GetAllPieces(), a_Layout);
+		}
+	}
+	return false;
+}
+
 
 
 
@@ -375,6 +435,43 @@ cVillageGen::cVillageGen(int a_Seed, int a_GridSize, int a_MaxOffset, int a_MaxD
 
 
 
+AString cVillageGen::GetLayoutSignature(void) const
+{
+	AString res = super::GetLayoutSignature();
+	AppendPrintf(res, " village %d %d %d %d", m_MaxDepth, m_MaxSize, m_MinDensity, m_MaxDensity);
+	for (size_t i = 0; i < ARRAYCOUNT(g_AllVillagePools); i++)
+	{
+		AppendPrintf(res, " %u", static_cast<unsigned>(g_AllVillagePools[i]->GetAllPieces().size()));
+	}
+	return res;
+}
+
+
+
+
+
+cGridStructGen::cStructurePtr cVillageGen::CreateStructureFromLayout(int a_GridX, int a_GridZ, int a_OriginX, int a_OriginZ, const AString & a_Layout)
+{
+	AStringVector Numbers = StringSplit(a_Layout, " ");
+	unsigned PoolIdx;
+	int Density;
+	if ((Numbers.size() < 2) || !StringToInteger(Numbers[0], PoolIdx) || !StringToInteger(Numbers[1], Density) || (PoolIdx >= ARRAYCOUNT(g_AllVillagePools)))
+	{
+		return cStructurePtr();
+	}
+	cVillagePiecePool & Prefabs = *g_AllVillagePools[PoolIdx];
+	cPlacedPieces Pieces;
+	if (!cPieceGenerator::DeserializePieces(Numbers, 2, Prefabs.GetAllPieces(), Pieces))
+	{
+		return cStructurePtr();
+	}
+	return cStructurePtr(new cVillage(m_Seed, a_GridX, a_GridZ, a_OriginX, a_OriginZ, m_MaxSize, Density, Prefabs, m_HeightGen, E_BLOCK_GRAVEL, E_BLOCK_PLANKS, Pieces));
+}
+
+
+
+
+
 cGridStructGen::cStructurePtr cVillageGen::CreateStructure(int a_GridX, int a_GridZ, int a_OriginX, int a_OriginZ)
 {
 	// Generate the biomes for the chunk surrounding the origin:
@@ -49,7 +49,9 @@ protected:
 
 
 	// cGridStructGen overrides:
+	virtual AString GetLayoutSignature(void) const override;
 	virtual cStructurePtr CreateStructure(int a_GridX, int a_GridZ, int a_OriginX, int a_OriginZ) override;
+	virtual cStructurePtr CreateStructureFromLayout(int a_GridX, int a_GridZ, int a_OriginX, int a_OriginZ, const AString & a_Layout) override;
 } ;
 
 
@@ -53,6 +53,9 @@
 	
 	#define NORETURN      __declspec(noreturn)
 
+	// MSVC 2013 has no thread_local; the extension only works for types with trivial construction and destruction
+	#define THREAD_LOCAL __declspec(thread)
+
 	// Use non-standard defines in <cmath>
 	#define _USE_MATH_DEFINES
 
@@ -97,6 +100,9 @@
 	
 	#define NORETURN      __attribute((__noreturn__))
 
+	// The extension only works for types with trivial construction and destruction, unlike C++11 thread_local
+	#define THREAD_LOCAL __thread
+
 #else
 
 	#error "You are using an unsupported compiler, you might need to #define some stuff here for your compiler"
@@ -116,6 +122,9 @@
 	// Mark types / variables for alignment. Do the platforms need it?
 	#define ALIGN_8
 	#define ALIGN_16
+
+	// Mark variables as thread-local; the types need trivial construction and destruction
+	#define THREAD_LOCAL
 	*/
 
 #endif
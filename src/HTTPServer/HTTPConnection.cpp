@@ -38,7 +38,7 @@ cHTTPConnection::~cHTTPConnection()
 
 void cHTTPConnection::SendStatusAndReason(int a_StatusCode, const AString & a_Response)
 {
-	SendData(Printf("%d %s\r\nContent-Length: 0\r\n\r\n", a_StatusCode, a_Response.c_str()));
+	SendData(Printf("HTTP/1.1 %d %s\r\nContent-Length: 0\r\n\r\n", a_StatusCode, a_Response.c_str()));
 	m_State = wcsRecvHeaders;
 }
 
@@ -56,6 +56,16 @@ void cHTTPConnection::SendNeedAuth(const AString & a_Realm)
 
 
 
+void cHTTPConnection::SendNotModified(const AString & a_ETag)
+{
+	SendData(Printf("HTTP/1.1 304 Not Modified\r\nETag: %s\r\n\r\n", a_ETag.c_str()));
+	m_State = wcsRecvHeaders;
+}
+
+
+
+
+
 void cHTTPConnection::Send(const cHTTPResponse & a_Response)
 {
 	ASSERT(m_State == wcsRecvIdle);
@@ -106,7 +116,7 @@ void cHTTPConnection::AwaitNextRequest(void)
 		case wcsRecvIdle:
 		{
 			// The client is waiting for a response, send an "Internal server error":
-			SendData("HTTP/1.1 500 Internal Server Error\r\n\r\n");
+			SendData("HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n");
 			m_State = wcsRecvHeaders;
 			break;
 		}
@@ -209,9 +219,10 @@ void cHTTPConnection::OnReceivedData(const char * a_Data, size_t a_Size)
 		case wcsRecvBody:
 		{
 			ASSERT(m_CurrentRequest != nullptr);
+			size_t BytesToConsume = 0;
 			if (m_CurrentRequestBodyRemaining > 0)
 			{
-				size_t BytesToConsume = std::min(m_CurrentRequestBodyRemaining, (size_t)a_Size);
+				BytesToConsume = std::min(m_CurrentRequestBodyRemaining, (size_t)a_Size);
 				m_HTTPServer.RequestBody(*this, *m_CurrentRequest, a_Data, BytesToConsume);
 				m_CurrentRequestBodyRemaining -= BytesToConsume;
 			}
@@ -228,6 +239,13 @@ void cHTTPConnection::OnReceivedData(const char * a_Data, size_t a_Size)
 				}
 				delete m_CurrentRequest;
 				m_CurrentRequest = nullptr;
+
+				// Pipelining: the client may have sent the next requests without waiting for the response, process them.
+				// The responses are sent synchronously from RequestFinished(), so they go out in the order of the requests.
+				if (a_Size > BytesToConsume)
+				{
+					cHTTPConnection::OnReceivedData(a_Data + BytesToConsume, a_Size - BytesToConsume);
+				}
 			}
 			break;
 		}
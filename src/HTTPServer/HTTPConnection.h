@@ -47,6 +47,9 @@ public:
 	/** Sends the "401 unauthorized" reply together with instructions on authorizing, using the specified realm */
 	void SendNeedAuth(const AString & a_Realm);
 	
+	/** Sends the "304 Not Modified" reply, used when the client's cached copy (a_ETag) is still valid */
+	void SendNotModified(const AString & a_ETag);
+	
 	/** Sends the headers contained in a_Response */
 	void Send(const cHTTPResponse & a_Response);
 	
@@ -66,6 +66,20 @@ void cHTTPMessage::AddHeader(const AString & a_Key, const AString & a_Value)
 
 
 
+AString cHTTPMessage::GetHeader(const AString & a_Key) const
+{
+	cNameValueMap::const_iterator itr = m_Headers.find(StrToLower(a_Key));
+	if (itr == m_Headers.end())
+	{
+		return AString();
+	}
+	return itr->second;
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cHTTPRequest:
 
@@ -123,6 +137,16 @@ size_t cHTTPRequest::ParseHeaders(const char * a_Data, size_t a_Size)
 
 
 
+bool cHTTPRequest::DoesAcceptGzip(void) const
+{
+	// Only look for the "gzip" coding, the quality values are ignored (no client sends "gzip;q=0")
+	return (StrToLower(GetHeader("Accept-Encoding")).find("gzip") != AString::npos);
+}
+
+
+
+
+
 AString cHTTPRequest::GetBareURL(void) const
 {
 	size_t idxQM = m_URL.find('?');
@@ -142,6 +166,7 @@ AString cHTTPRequest::GetBareURL(void) const
 
 size_t cHTTPRequest::ParseRequestLine(const char * a_Data, size_t a_Size)
 {
+	size_t PrevSize = m_IncomingHeaderData.size();
 	m_IncomingHeaderData.append(a_Data, a_Size);
 	size_t IdxEnd = m_IncomingHeaderData.size();
 
@@ -210,7 +235,12 @@ size_t cHTTPRequest::ParseRequestLine(const char * a_Data, size_t a_Size)
 				}
 				m_Method = m_IncomingHeaderData.substr(LineStart, MethodEnd - LineStart);
 				m_URL = m_IncomingHeaderData.substr(MethodEnd + 1, URLEnd - MethodEnd - 1);
-				return i + 1;
+
+				// HTTP/1.1 connections are persistent by default, unless the headers say otherwise:
+				m_AllowKeepAlive = ((i >= URLEnd + 10) && (m_IncomingHeaderData[URLEnd + 8] == '1'));
+
+				// Return the number of bytes consumed from a_Data; the line may have started in the previously received data
+				return i + 1 - PrevSize;
 			}
 		}  // switch (m_IncomingHeaderData[i])
 	}  // for i - m_IncomingHeaderData[]
@@ -239,9 +269,16 @@ void cHTTPRequest::OnHeaderLine(const AString & a_Key, const AString & a_Value)
 			m_HasAuth = true;
 		}
 	}
-	if ((a_Key == "Connection") && (NoCaseCompare(a_Value, "keep-alive") == 0))
+	if (NoCaseCompare(a_Key, "Connection") == 0)
 	{
-		m_AllowKeepAlive = true;
+		if (NoCaseCompare(a_Value, "keep-alive") == 0)
+		{
+			m_AllowKeepAlive = true;
+		}
+		else if (NoCaseCompare(a_Value, "close") == 0)
+		{
+			m_AllowKeepAlive = false;
+		}
 	}
 	AddHeader(a_Key, a_Value);
 }
@@ -269,7 +306,8 @@ void cHTTPResponse::AppendToData(AString & a_DataStream) const
 	a_DataStream.append("\r\n");
 	for (cNameValueMap::const_iterator itr = m_Headers.begin(), end = m_Headers.end(); itr != end; ++itr)
 	{
-		if ((itr->first == "Content-Type") || (itr->first == "Content-Length"))
+		// The keys are stored lowercase by AddHeader()
+		if ((itr->first == "content-type") || (itr->first == "content-length"))
 		{
 			continue;
 		}
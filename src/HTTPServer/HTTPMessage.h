@@ -44,6 +44,9 @@ public:
 	const AString & GetContentType  (void) const { return m_ContentType; }
 	size_t          GetContentLength(void) const { return m_ContentLength; }
 
+	/** Returns the value of the specified header (case-insensitive), or an empty string if the header is not present */
+	AString GetHeader(const AString & a_Key) const;
+
 protected:
 	typedef std::map<AString, AString> cNameValueMap;
 	
@@ -111,6 +114,9 @@ public:
 	
 	bool DoesAllowKeepAlive(void) const { return m_AllowKeepAlive; }
 	
+	/** Returns true if the client has indicated that it accepts gzip-compressed responses */
+	bool DoesAcceptGzip(void) const;
+	
 protected:
 	/** Parser for the envelope data */
 	cEnvelopeParser m_EnvelopeParser;
@@ -139,7 +145,8 @@ protected:
 	/** The password used for auth */
 	AString m_AuthPassword;
 	
-	/** Set to true if the request indicated that it supports keepalives.
+	/** Set to true if the connection is to be kept alive after the request: HTTP/1.1 requests unless they specify
+	"Connection: close", and HTTP/1.0 requests that specify "Connection: keep-alive".
 	If false, the server will close the connection once the request is finished */
 	bool m_AllowKeepAlive;
 	
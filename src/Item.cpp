@@ -11,6 +11,12 @@
 
 
 
+const cItem::sExtendedData cItem::s_EmptyExtendedData;
+
+
+
+
+
 cItem cItem::CopyOne(void) const
 {
 	cItem res(*this);
@@ -128,31 +134,32 @@ void cItem::GetJson(Json::Value & a_OutValue) const
 	{
 		a_OutValue["Count"] = m_ItemCount;
 		a_OutValue["Health"] = m_ItemDamage;
-		AString Enchantments(m_Enchantments.ToString());
+		AString Enchantments(GetEnchantments().ToString());
 		if (!Enchantments.empty())
 		{
 			a_OutValue["ench"] = Enchantments;
 		}
 		if (!IsCustomNameEmpty())
 		{
-			a_OutValue["Name"] = m_CustomName;
+			a_OutValue["Name"] = GetCustomName();
 		}
 		if (!IsLoreEmpty())
 		{
-			a_OutValue["Lore"] = m_Lore;
+			a_OutValue["Lore"] = GetLore();
 		}
 
 		if ((m_ItemType == E_ITEM_FIREWORK_ROCKET) || (m_ItemType == E_ITEM_FIREWORK_STAR))
 		{
-			a_OutValue["Flicker"] = m_FireworkItem.m_HasFlicker;
-			a_OutValue["Trail"] = m_FireworkItem.m_HasTrail;
-			a_OutValue["Type"] = m_FireworkItem.m_Type;
-			a_OutValue["FlightTimeInTicks"] = m_FireworkItem.m_FlightTimeInTicks;
-			a_OutValue["Colours"] = m_FireworkItem.ColoursToString(m_FireworkItem);
-			a_OutValue["FadeColours"] = m_FireworkItem.FadeColoursToString(m_FireworkItem);
+			const cFireworkItem & FireworkItem = GetFireworkItem();
+			a_OutValue["Flicker"] = FireworkItem.m_HasFlicker;
+			a_OutValue["Trail"] = FireworkItem.m_HasTrail;
+			a_OutValue["Type"] = FireworkItem.m_Type;
+			a_OutValue["FlightTimeInTicks"] = FireworkItem.m_FlightTimeInTicks;
+			a_OutValue["Colours"] = cFireworkItem::ColoursToString(FireworkItem);
+			a_OutValue["FadeColours"] = cFireworkItem::FadeColoursToString(FireworkItem);
 		}
 
-		a_OutValue["RepairCost"] = m_RepairCost;
+		a_OutValue["RepairCost"] = GetRepairCost();
 	}
 }
 
@@ -167,22 +174,23 @@ void cItem::FromJson(const Json::Value & a_Value)
 	{
 		m_ItemCount = (char)a_Value.get("Count", -1).asInt();
 		m_ItemDamage = (short)a_Value.get("Health", -1).asInt();
-		m_Enchantments.Clear();
-		m_Enchantments.AddFromString(a_Value.get("ench", "").asString());
-		m_CustomName = a_Value.get("Name", "").asString();
-		m_Lore = a_Value.get("Lore", "").asString();
+		m_Extended.reset();
+		SetEnchantments(cEnchantments(a_Value.get("ench", "").asString()));
+		SetCustomName(a_Value.get("Name", "").asString());
+		SetLore(a_Value.get("Lore", "").asString());
 
 		if ((m_ItemType == E_ITEM_FIREWORK_ROCKET) || (m_ItemType == E_ITEM_FIREWORK_STAR))
 		{
-			m_FireworkItem.m_HasFlicker = a_Value.get("Flicker", false).asBool();
-			m_FireworkItem.m_HasTrail = a_Value.get("Trail", false).asBool();
-			m_FireworkItem.m_Type = (NIBBLETYPE)a_Value.get("Type", 0).asInt();
-			m_FireworkItem.m_FlightTimeInTicks = (short)a_Value.get("FlightTimeInTicks", 0).asInt();
-			m_FireworkItem.ColoursFromString(a_Value.get("Colours", "").asString(), m_FireworkItem);
-			m_FireworkItem.FadeColoursFromString(a_Value.get("FadeColours", "").asString(), m_FireworkItem);
+			cFireworkItem & FireworkItem = ModifyFireworkItem();
+			FireworkItem.m_HasFlicker = a_Value.get("Flicker", false).asBool();
+			FireworkItem.m_HasTrail = a_Value.get("Trail", false).asBool();
+			FireworkItem.m_Type = (NIBBLETYPE)a_Value.get("Type", 0).asInt();
+			FireworkItem.m_FlightTimeInTicks = (short)a_Value.get("FlightTimeInTicks", 0).asInt();
+			cFireworkItem::ColoursFromString(a_Value.get("Colours", "").asString(), FireworkItem);
+			cFireworkItem::FadeColoursFromString(a_Value.get("FadeColours", "").asString(), FireworkItem);
 		}
 
-		m_RepairCost = a_Value.get("RepairCost", 0).asInt();
+		SetRepairCost(a_Value.get("RepairCost", 0).asInt());
 	}
 }
 
@@ -328,7 +336,7 @@ bool cItem::EnchantByXPLevels(int a_NumXPLevels)
 	}
 
 	cEnchantments Enchantment1 = cEnchantments::GetRandomEnchantmentFromVector(Enchantments);
-	m_Enchantments.AddFromString(Enchantment1.ToString());
+	ModifyEnchantments().Add(Enchantment1);
 	cEnchantments::RemoveEnchantmentWeightFromVector(Enchantments, Enchantment1);
 
 	// Checking for conflicting enchantments
@@ -345,7 +353,7 @@ bool cItem::EnchantByXPLevels(int a_NumXPLevels)
 	}
 
 	cEnchantments Enchantment2 = cEnchantments::GetRandomEnchantmentFromVector(Enchantments);
-	m_Enchantments.AddFromString(Enchantment2.ToString());
+	ModifyEnchantments().Add(Enchantment2);
 	cEnchantments::RemoveEnchantmentWeightFromVector(Enchantments, Enchantment2);
 
 	// Checking for conflicting enchantments
@@ -360,7 +368,7 @@ bool cItem::EnchantByXPLevels(int a_NumXPLevels)
 	}
 
 	cEnchantments Enchantment3 = cEnchantments::GetRandomEnchantmentFromVector(Enchantments);
-	m_Enchantments.AddFromString(Enchantment3.ToString());
+	ModifyEnchantments().Add(Enchantment3);
 	cEnchantments::RemoveEnchantmentWeightFromVector(Enchantments, Enchantment3);
 
 	// Checking for conflicting enchantments
@@ -374,7 +382,7 @@ bool cItem::EnchantByXPLevels(int a_NumXPLevels)
 		return true;
 	}
 	cEnchantments Enchantment4 = cEnchantments::GetRandomEnchantmentFromVector(Enchantments);
-	m_Enchantments.AddFromString(Enchantment4.ToString());
+	ModifyEnchantments().Add(Enchantment4);
 
 	return true;
 }
@@ -383,6 +391,110 @@ bool cItem::EnchantByXPLevels(int a_NumXPLevels)
 
 
 
+void cItem::SetEnchantments(const cEnchantments & a_Enchantments)
+{
+	if (a_Enchantments.IsEmpty() && GetEnchantments().IsEmpty())
+	{
+		return;
+	}
+	ModifyExtendedData().m_Enchantments = a_Enchantments;
+}
+
+
+
+
+
+void cItem::SetCustomName(const AString & a_CustomName)
+{
+	if (a_CustomName == GetCustomName())
+	{
+		return;
+	}
+	ModifyExtendedData().m_CustomName = a_CustomName;
+}
+
+
+
+
+
+void cItem::SetLore(const AString & a_Lore)
+{
+	if (a_Lore == GetLore())
+	{
+		return;
+	}
+	ModifyExtendedData().m_Lore = a_Lore;
+}
+
+
+
+
+
+void cItem::SetRepairCost(int a_RepairCost)
+{
+	if (a_RepairCost == GetRepairCost())
+	{
+		return;
+	}
+	ModifyExtendedData().m_RepairCost = a_RepairCost;
+}
+
+
+
+
+
+void cItem::SetFireworkItem(const cFireworkItem & a_FireworkItem)
+{
+	if (a_FireworkItem.IsEqualTo(GetFireworkItem()))
+	{
+		return;
+	}
+	ModifyExtendedData().m_FireworkItem.CopyFrom(a_FireworkItem);
+}
+
+
+
+
+
+cItem::sExtendedData & cItem::ModifyExtendedData(void)
+{
+	if (m_Extended == nullptr)
+	{
+		m_Extended = std::make_shared<sExtendedData>();
+	}
+	else if (m_Extended.use_count() > 1)
+	{
+		// Shared with other items, make a private copy before it gets modified:
+		m_Extended = std::make_shared<sExtendedData>(*m_Extended);
+	}
+	return *m_Extended;
+}
+
+
+
+
+
+bool cItem::IsExtendedDataEqual(const cItem & a_Item) const
+{
+	if (m_Extended == a_Item.m_Extended)
+	{
+		// Both have no extended data, or they share the same block
+		return true;
+	}
+	const sExtendedData & Mine = GetExtendedData();
+	const sExtendedData & Theirs = a_Item.GetExtendedData();
+	return (
+		(Mine.m_Enchantments == Theirs.m_Enchantments) &&
+		(Mine.m_CustomName == Theirs.m_CustomName) &&
+		(Mine.m_Lore == Theirs.m_Lore) &&
+		Mine.m_FireworkItem.IsEqualTo(Theirs.m_FireworkItem)
+	);
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cItems:
 
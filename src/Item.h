@@ -29,6 +29,15 @@ namespace Json
 
 
 
+/*
+The item is stored in two parts. The hot part (type, count and damage) fits into 64 bits and is kept inline. The rest
+(enchantments, custom name, lore, repair cost and firework data) is stored out-of-line in an extended data block,
+which most items don't have at all. Copying, comparing and destroying such ordinary items never touches the heap.
+The extended data block is immutable once shared: copying an item only shares the block, and the block is copied
+first when one of the items sharing it is modified (copy-on-write). Use the Get*() accessors for reading and the
+Modify*() / Set*() accessors for writing the extended data.
+*/
+
 // tolua_begin
 class cItem
 {
@@ -37,11 +46,7 @@ public:
 	cItem(void) :
 		m_ItemType(E_ITEM_EMPTY),
 		m_ItemCount(0),
-		m_ItemDamage(0),
-		m_CustomName(""),
-		m_Lore(""),
-		m_RepairCost(0),
-		m_FireworkItem()
+		m_ItemDamage(0)
 	{
 	}
 	
@@ -57,12 +62,7 @@ public:
 	) :
 		m_ItemType    (a_ItemType),
 		m_ItemCount   (a_ItemCount),
-		m_ItemDamage  (a_ItemDamage),
-		m_Enchantments(a_Enchantments),
-		m_CustomName  (a_CustomName),
-		m_Lore        (a_Lore),
-		m_RepairCost  (0),
-		m_FireworkItem()
+		m_ItemDamage  (a_ItemDamage)
 	{
 		if (!IsValidItem(m_ItemType))
 		{
@@ -71,6 +71,14 @@ public:
 				LOGWARNING("%s: creating an invalid item type (%d), resetting to empty.", __FUNCTION__, a_ItemType);
 			}
 			Empty();
+			return;
+		}
+		if (!a_Enchantments.empty() || !a_CustomName.empty() || !a_Lore.empty())
+		{
+			sExtendedData & Extended = ModifyExtendedData();
+			Extended.m_Enchantments.AddFromString(a_Enchantments);
+			Extended.m_CustomName = a_CustomName;
+			Extended.m_Lore = a_Lore;
 		}
 	}
 	
@@ -84,11 +92,7 @@ public:
 		m_ItemType    (a_CopyFrom.m_ItemType),
 		m_ItemCount   (a_CopyFrom.m_ItemCount),
 		m_ItemDamage  (a_CopyFrom.m_ItemDamage),
-		m_Enchantments(a_CopyFrom.m_Enchantments),
-		m_CustomName  (a_CopyFrom.m_CustomName),
-		m_Lore        (a_CopyFrom.m_Lore),
-		m_RepairCost  (a_CopyFrom.m_RepairCost),
-		m_FireworkItem(a_CopyFrom.m_FireworkItem)
+		m_Extended    (a_CopyFrom.m_Extended)
 	{
 	}
 	
@@ -100,11 +104,7 @@ public:
 		m_ItemType = E_ITEM_EMPTY;
 		m_ItemCount = 0;
 		m_ItemDamage = 0;
-		m_Enchantments.Clear();
-		m_CustomName = "";
-		m_Lore = "";
-		m_RepairCost = 0;
-		m_FireworkItem.EmptyData();
+		m_Extended.reset();
 	}
 	
 	
@@ -113,7 +113,7 @@ public:
 		m_ItemType = E_ITEM_EMPTY;
 		m_ItemCount = 0;
 		m_ItemDamage = 0;
-		m_RepairCost = 0;
+		SetRepairCost(0);
 	}
 	
 	
@@ -129,10 +129,7 @@ public:
 		return (
 			IsSameType(a_Item) &&
 			(m_ItemDamage == a_Item.m_ItemDamage) &&
-			(m_Enchantments == a_Item.m_Enchantments) &&
-			(m_CustomName == a_Item.m_CustomName) &&
-			(m_Lore == a_Item.m_Lore) &&
-			m_FireworkItem.IsEqualTo(a_Item.m_FireworkItem)
+			IsExtendedDataEqual(a_Item)
 		);
 	}
 	
@@ -145,12 +142,12 @@ public:
 
 	bool IsBothNameAndLoreEmpty(void) const
 	{
-		return (m_CustomName.empty() && m_Lore.empty());
+		return (IsCustomNameEmpty() && IsLoreEmpty());
 	}
 
 
-	bool IsCustomNameEmpty(void) const { return (m_CustomName.empty()); }
-	bool IsLoreEmpty(void) const { return (m_Lore.empty()); }
+	bool IsCustomNameEmpty(void) const { return ((m_Extended == nullptr) || m_Extended->m_CustomName.empty()); }
+	bool IsLoreEmpty(void) const { return ((m_Extended == nullptr) || m_Extended->m_Lore.empty()); }
 
 	/** Returns a copy of this item with m_ItemCount set to 1. Useful to preserve enchantments etc. on stacked items */
 	cItem CopyOne(void) const;
@@ -194,20 +191,87 @@ public:
 	/** Enchants the item using the specified number of XP levels.
 	Returns true if item enchanted, false if not. */
 	bool EnchantByXPLevels(int a_NumXPLevels);  // tolua_export
+	
+	/** Returns true if the item has the out-of-line extended data (it may still be all empty). */
+	bool HasExtendedData(void) const { return (m_Extended != nullptr); }
+	
+	const cEnchantments & GetEnchantments(void) const { return GetExtendedData().m_Enchantments; }
+	const AString &       GetCustomName  (void) const { return GetExtendedData().m_CustomName; }
+	const AString &       GetLore        (void) const { return GetExtendedData().m_Lore; }
+	int                   GetRepairCost  (void) const { return (m_Extended == nullptr) ? 0 : m_Extended->m_RepairCost; }
+	const cFireworkItem & GetFireworkItem(void) const { return GetExtendedData().m_FireworkItem; }
+	
+	/** Returns the enchantments for modification. The extended data is created, or unshared from the other items, first. */
+	cEnchantments & ModifyEnchantments(void) { return ModifyExtendedData().m_Enchantments; }
+	
+	/** Returns the firework data for modification. The extended data is created, or unshared from the other items, first. */
+	cFireworkItem & ModifyFireworkItem(void) { return ModifyExtendedData().m_FireworkItem; }
+	
+	void SetEnchantments(const cEnchantments & a_Enchantments);
+	void SetCustomName(const AString & a_CustomName);
+	void SetLore(const AString & a_Lore);
+	void SetRepairCost(int a_RepairCost);
+	void SetFireworkItem(const cFireworkItem & a_FireworkItem);
+	
+	// The accessors used by the Lua bindings for the extended data properties, named the way ToLua expects them.
+	// m_Enchantments and m_FireworkItem are exported in ManualBindings.cpp instead, so that the getters unshare the
+	// extended data before giving Lua a modifiable reference into it:
+	const AString & get_m_CustomName(void) const { return GetCustomName(); }
+	const AString & get_m_Lore      (void) const { return GetLore(); }
+	int             get_m_RepairCost(void) const { return GetRepairCost(); }
+	void set_m_CustomName(const AString & a_CustomName) { SetCustomName(a_CustomName); }
+	void set_m_Lore      (const AString & a_Lore)       { SetLore(a_Lore); }
+	void set_m_RepairCost(int a_RepairCost)             { SetRepairCost(a_RepairCost); }
 
 	// tolua_begin
 	
 	short          m_ItemType;
 	char           m_ItemCount;
 	short          m_ItemDamage;
-	cEnchantments  m_Enchantments;
-	AString        m_CustomName;
-	AString        m_Lore;
-
-	int            m_RepairCost;
-	cFireworkItem  m_FireworkItem;
-};
-// tolua_end
+	
+	// The extended data is exported to Lua as properties under the original member names; the C++ code uses the accessors above.
+	// This is only ever seen by ToLua:
+	#if 0
+	tolua_property__default AString        m_CustomName;
+	tolua_property__default AString        m_Lore;
+	tolua_property__default int            m_RepairCost;
+	#endif
+	
+	// tolua_end
+	
+protected:
+	
+	/** The rarely used item data, stored out-of-line */
+	struct sExtendedData
+	{
+		cEnchantments  m_Enchantments;
+		AString        m_CustomName;
+		AString        m_Lore;
+		int            m_RepairCost;
+		cFireworkItem  m_FireworkItem;
+		
+		sExtendedData(void) : m_RepairCost(0) {}
+	} ;
+	
+	/** The extended data, shared by the copies of this item until one of them is modified. nullptr if the item has none. */
+	std::shared_ptr<sExtendedData> m_Extended;
+	
+	
+	/** Returns the extended data, or an all-empty instance if the item has none. */
+	const sExtendedData & GetExtendedData(void) const
+	{
+		return (m_Extended == nullptr) ? s_EmptyExtendedData : *m_Extended;
+	}
+	
+	/** Returns the extended data for modification; creates it if the item has none, or copies it if it is shared. */
+	sExtendedData & ModifyExtendedData(void);
+	
+	/** Returns true if the extended data of the two items is the same (the repair cost is not compared). */
+	bool IsExtendedDataEqual(const cItem & a_Item) const;
+	
+	/** The extended data returned for items that have none */
+	static const sExtendedData s_EmptyExtendedData;
+};  // tolua_export
 
 
 
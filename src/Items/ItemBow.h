@@ -78,7 +78,7 @@ public:
 		a_Player->GetWorld()->BroadcastSoundEffect("random.bow", a_Player->GetPosX(), a_Player->GetPosY(), a_Player->GetPosZ(), 0.5, (float)Force);
 		if (!a_Player->IsGameModeCreative())
 		{
-			if (a_Player->GetEquippedItem().m_Enchantments.GetLevel(cEnchantments::enchInfinity) == 0)
+			if (a_Player->GetEquippedItem().GetEnchantments().GetLevel(cEnchantments::enchInfinity) == 0)
 			{
 				a_Player->GetInventory().RemoveItem(cItem(E_ITEM_ARROW));
 			}
@@ -91,7 +91,7 @@ public:
 			a_Player->UseEquippedItem();
 		}
 
-		if (a_Player->GetEquippedItem().m_Enchantments.GetLevel(cEnchantments::enchFlame) > 0)
+		if (a_Player->GetEquippedItem().GetEnchantments().GetLevel(cEnchantments::enchFlame) > 0)
 		{
 			Arrow->StartBurning(100);
 		}
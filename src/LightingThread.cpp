@@ -355,6 +355,70 @@ void cLightingThread::ReadChunks(int a_ChunkX, int a_ChunkZ)
 
 
 
+void cLightingThread::LightChunkData(
+	const BLOCKTYPE * const a_BlockTypes[9], const HEIGHTTYPE * const a_HeightMaps[9],
+	cChunkDef::BlockNibbles & a_BlockLight, cChunkDef::BlockNibbles & a_SkyLight
+)
+{
+	ReadChunkData(a_BlockTypes, a_HeightMaps);
+
+	PrepareBlockLight();
+	CalcLight(m_BlockLight);
+
+	PrepareSkyLight();
+	CalcLight(m_SkyLight);
+
+	CompressLight(m_BlockLight, a_BlockLight);
+	CompressLight(m_SkyLight, a_SkyLight);
+}
+
+
+
+
+
+void cLightingThread::ReadChunkData(const BLOCKTYPE * const a_BlockTypes[9], const HEIGHTTYPE * const a_HeightMaps[9])
+{
+	// Distribute the heightmaps into the 3x3 chunk blob, find the highest block in the entire area:
+	HEIGHTTYPE MaxHeight = 0;
+	for (int i = 0; i < 9; i++)
+	{
+		const HEIGHTTYPE * HeightMap = a_HeightMaps[i];
+		int OutputIdx = (i % 3) * cChunkDef::Width + (i / 3) * cChunkDef::Width * cChunkDef::Width * 3;
+		for (int z = 0; z < cChunkDef::Width; z++)
+		{
+			memcpy(m_HeightMap + OutputIdx, HeightMap + z * cChunkDef::Width, cChunkDef::Width * sizeof(HEIGHTTYPE));
+			OutputIdx += cChunkDef::Width * 3;
+		}
+		for (int j = 0; j < cChunkDef::Width * cChunkDef::Width; j++)
+		{
+			MaxHeight = std::max(MaxHeight, HeightMap[j]);
+		}
+	}
+	m_MaxHeight = MaxHeight;
+
+	// Distribute the blocktypes, only as high as needed (16 blocks above the highest):
+	int NumLayers = std::min(+cChunkDef::Height, m_MaxHeight + 16);
+	for (int i = 0; i < 9; i++)
+	{
+		const BLOCKTYPE * BlockTypes = a_BlockTypes[i];
+		int OutputIdx = (i % 3) * cChunkDef::Width + (i / 3) * cChunkDef::Width * cChunkDef::Width * 3;
+		for (int y = 0; y < NumLayers; y++)
+		{
+			for (int z = 0; z < cChunkDef::Width; z++)
+			{
+				memcpy(m_BlockTypes + OutputIdx + y * BlocksPerYLayer + z * cChunkDef::Width * 3, BlockTypes + cChunkDef::MakeIndexNoCheck(0, y, z), cChunkDef::Width);
+			}
+		}
+	}
+
+	memset(m_BlockLight, 0, sizeof(m_BlockLight));
+	memset(m_SkyLight,   0, sizeof(m_SkyLight));
+}
+
+
+
+
+
 void cLightingThread::PrepareSkyLight(void)
 {
 	// Clear seeds:
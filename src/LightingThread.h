@@ -67,6 +67,15 @@ public:
 	void WaitForQueueEmpty(void);
 	
 	size_t GetQueueLength(void);
+
+	/** Calculates the light of a chunk directly from the supplied data, without a world and without the thread.
+	a_BlockTypes and a_HeightMaps are the data of the 3x3 chunks around the lit chunk, indexed as [x + 3 * z],
+	the lit chunk being the one at index 4. The output is written into a_BlockLight and a_SkyLight.
+	Used by the offline pregenerator, which lights the chunks in several threads, each with its own object. */
+	void LightChunkData(
+		const BLOCKTYPE * const a_BlockTypes[9], const HEIGHTTYPE * const a_HeightMaps[9],
+		cChunkDef::BlockNibbles & a_BlockLight, cChunkDef::BlockNibbles & a_SkyLight
+	);
 	
 protected:
 
@@ -141,6 +150,9 @@ protected:
 	
 	/** Prepares m_BlockTypes and m_HeightMap data; zeroes out the light arrays */
 	void ReadChunks(int a_ChunkX, int a_ChunkZ);
+
+	/** Same as ReadChunks(), but reads the data from the supplied arrays instead of the world, see LightChunkData() */
+	void ReadChunkData(const BLOCKTYPE * const a_BlockTypes[9], const HEIGHTTYPE * const a_HeightMaps[9]);
 	
 	/** Uses m_HeightMap to initialize the m_SkyLight[] data; fills in seeds for the skylight */
 	void PrepareSkyLight(void);
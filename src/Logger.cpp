@@ -10,6 +10,42 @@
 
 
 
+/** Maximum number of messages waiting for the writer thread; more messages are dropped (and the drop is reported) */
+static const size_t MAX_QUEUE_LENGTH = 100000;
+
+/** The same message logged again within this many seconds of its last output is only counted, not output */
+static const time_t REPEAT_WINDOW_SEC = 10;
+
+/** How often the writer thread wakes up even without new messages, to report the collapsed repeated messages */
+static const unsigned WRITER_WAKEUP_MSEC = 1000;
+
+
+
+
+
+cLogger::cLogger(void) :
+	m_NumDropped(0),
+	m_IsWriterRunning(false),
+	m_ShouldTerminate(false),
+	m_LastLogLevel(llRegular),
+	m_LastMessageTime(0),
+	m_NumRepeats(0)
+{
+}
+
+
+
+
+
+cLogger::~cLogger()
+{
+	StopWriterThread();
+}
+
+
+
+
+
 cLogger & cLogger::GetInstance(void)
 {
 	static cLogger Instance;
@@ -29,33 +65,36 @@ void cLogger::InitiateMultithreading()
 
 
 
-void cLogger::LogSimple(AString a_Message, eLogLevel a_LogLevel)
+void cLogger::LogSimple(AString a_Message, eLogLevel a_LogLevel, bool a_ShouldCollapseRepeats)
 {
-	time_t rawtime;
-	time(&rawtime);
-
-	struct tm * timeinfo;
-	#ifdef _MSC_VER
-		struct tm timeinforeal;
-		timeinfo = &timeinforeal;
-		localtime_s(timeinfo, &rawtime);
-	#else
-		timeinfo = localtime(&rawtime);
-	#endif
+	sEntry Entry;
+	Entry.m_Time = time(nullptr);
+	Entry.m_ThreadID = std::this_thread::get_id();
+	Entry.m_LogLevel = a_LogLevel;
+	std::swap(Entry.m_Message, a_Message);
+	Entry.m_ShouldCollapseRepeats = a_ShouldCollapseRepeats;
 
-	AString Line;
-	#ifdef _DEBUG
-		Printf(Line, "[%04llx|%02d:%02d:%02d] %s\n", static_cast<UInt64>(std::hash<std::thread::id>()(std::this_thread::get_id())), timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, a_Message.c_str());
-	#else
-		Printf(Line, "[%02d:%02d:%02d] %s\n", timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, a_Message.c_str());
-	#endif
-
-
-	cCSLock Lock(m_CriticalSection);
-	for (size_t i = 0; i < m_LogListeners.size(); i++)
 	{
-		m_LogListeners[i]->Log(Line, a_LogLevel);
+		cCSLock Lock(m_CSQueue);
+		if (m_IsWriterRunning)
+		{
+			if (m_Queue.size() >= MAX_QUEUE_LENGTH)
+			{
+				m_NumDropped += 1;
+				return;
+			}
+			m_Queue.push_back(std::move(Entry));
+			if (m_Queue.size() == 1)
+			{
+				// The writer may be waiting for the first message:
+				m_evtQueue.Set();
+			}
+			return;
+		}
 	}
+
+	// There's no writer thread, write the message directly:
+	WriteEntries(cEntries(1, Entry));
 }
 
 
@@ -93,6 +132,209 @@ void cLogger::DetachListener(cListener * a_Listener)
 
 
 
+void cLogger::StartWriterThread(void)
+{
+	cCSLock Lock(m_CSQueue);
+	if (m_IsWriterRunning)
+	{
+		return;
+	}
+	m_ShouldTerminate = false;
+	try
+	{
+		m_WriterThread = std::thread(&cLogger::WriterThread, this);
+	}
+	catch (const std::system_error &)
+	{
+		// Keep writing the messages directly
+		return;
+	}
+	m_IsWriterRunning = true;
+}
+
+
+
+
+
+void cLogger::StopWriterThread(void)
+{
+	{
+		cCSLock Lock(m_CSQueue);
+		if (!m_IsWriterRunning)
+		{
+			return;
+		}
+		m_ShouldTerminate = true;
+	}
+	m_evtQueue.Set();
+	m_WriterThread.join();
+	{
+		cCSLock Lock(m_CSQueue);
+		m_IsWriterRunning = false;
+	}
+
+	// Write out the messages queued while the writer was finishing:
+	Flush();
+}
+
+
+
+
+
+void cLogger::Flush(void)
+{
+	WriteQueue();
+
+	cCSLock Lock(m_CriticalSection);
+	WriteRepeatsNote();
+	for (std::vector<cListener *>::iterator itr = m_LogListeners.begin(), end = m_LogListeners.end(); itr != end; ++itr)
+	{
+		(*itr)->Flush();
+	}
+}
+
+
+
+
+
+void cLogger::WriterThread(void)
+{
+	for (;;)
+	{
+		m_evtQueue.Wait(WRITER_WAKEUP_MSEC);
+		WriteQueue();
+		cCSLock Lock(m_CSQueue);
+		if (m_ShouldTerminate)
+		{
+			return;
+		}
+	}
+}
+
+
+
+
+
+void cLogger::WriteQueue(void)
+{
+	cEntries Entries;
+	size_t NumDropped;
+	{
+		cCSLock Lock(m_CSQueue);
+		std::swap(Entries, m_Queue);
+		NumDropped = m_NumDropped;
+		m_NumDropped = 0;
+	}
+	if (NumDropped > 0)
+	{
+		sEntry Entry;
+		Entry.m_Time = time(nullptr);
+		Entry.m_ThreadID = std::this_thread::get_id();
+		Entry.m_LogLevel = llWarning;
+		Printf(Entry.m_Message, "The log queue has overflown, " SIZE_T_FMT " messages have been dropped", NumDropped);
+		Entry.m_ShouldCollapseRepeats = true;
+		Entries.push_back(std::move(Entry));
+	}
+	WriteEntries(Entries);
+}
+
+
+
+
+
+void cLogger::WriteEntries(const cEntries & a_Entries)
+{
+	cCSLock Lock(m_CriticalSection);
+	for (cEntries::const_iterator itr = a_Entries.begin(), end = a_Entries.end(); itr != end; ++itr)
+	{
+		if (!itr->m_ShouldCollapseRepeats)
+		{
+			// Output the message as-is, and don't count the next message as a repeat of the one before this one:
+			WriteRepeatsNote();
+			WriteLine(itr->m_Time, itr->m_ThreadID, itr->m_LogLevel, itr->m_Message);
+			m_LastMessage.clear();
+			m_LastMessageTime = 0;
+			continue;
+		}
+
+		// Collapse a message repeated in a quick succession, such as the same failure reported for many chunks:
+		if (
+			(itr->m_LogLevel == m_LastLogLevel) &&
+			(itr->m_Message == m_LastMessage) &&
+			(itr->m_Time - m_LastMessageTime < REPEAT_WINDOW_SEC)
+		)
+		{
+			m_NumRepeats += 1;
+			continue;
+		}
+		WriteRepeatsNote();
+		WriteLine(itr->m_Time, itr->m_ThreadID, itr->m_LogLevel, itr->m_Message);
+		m_LastMessage = itr->m_Message;
+		m_LastLogLevel = itr->m_LogLevel;
+		m_LastMessageTime = itr->m_Time;
+	}
+
+	// Report the repeats once the message stops being repeated, even if there's no other message after it:
+	if ((m_NumRepeats > 0) && (time(nullptr) - m_LastMessageTime >= REPEAT_WINDOW_SEC))
+	{
+		WriteRepeatsNote();
+	}
+
+	for (std::vector<cListener *>::iterator itr = m_LogListeners.begin(), end = m_LogListeners.end(); itr != end; ++itr)
+	{
+		(*itr)->Flush();
+	}
+}
+
+
+
+
+
+void cLogger::WriteRepeatsNote(void)
+{
+	if (m_NumRepeats == 0)
+	{
+		return;
+	}
+	AString Message;
+	Printf(Message, "(the previous message has been repeated %d more times)", m_NumRepeats);
+	WriteLine(time(nullptr), std::this_thread::get_id(), m_LastLogLevel, Message);
+	m_NumRepeats = 0;
+}
+
+
+
+
+
+void cLogger::WriteLine(time_t a_Time, std::thread::id a_ThreadID, eLogLevel a_LogLevel, const AString & a_Message)
+{
+	struct tm * timeinfo;
+	#ifdef _MSC_VER
+		struct tm timeinforeal;
+		timeinfo = &timeinforeal;
+		localtime_s(timeinfo, &a_Time);
+	#else
+		timeinfo = localtime(&a_Time);
+	#endif
+
+	AString Line;
+	#ifdef _DEBUG
+		Printf(Line, "[%04llx|%02d:%02d:%02d] %s\n", static_cast<UInt64>(std::hash<std::thread::id>()(a_ThreadID)), timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, a_Message.c_str());
+	#else
+		UNUSED(a_ThreadID);
+		Printf(Line, "[%02d:%02d:%02d] %s\n", timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, a_Message.c_str());
+	#endif
+
+	for (size_t i = 0; i < m_LogListeners.size(); i++)
+	{
+		m_LogListeners[i]->Log(Line, a_LogLevel);
+	}
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Global functions
 
@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <thread>
+
 
 class cLogger
 {
@@ -20,25 +22,102 @@ public:
 		public:
 		virtual void Log(AString a_Message, eLogLevel a_LogLevel) = 0;
 
+		/** Called after each batch of messages has been passed to Log(), the listener may write out any buffered data. */
+		virtual void Flush(void) {}
+
 		virtual ~cListener(){}
 	};
 
 	void Log  (const char * a_Format, eLogLevel a_LogLevel, va_list a_ArgList) FORMATSTRING(2, 0);
 
-	/** Logs the simple text message at the specified log level. */
-	void LogSimple(AString a_Message, eLogLevel a_LogLevel = llRegular);
+	/** Logs the simple text message at the specified log level.
+	If a_ShouldCollapseRepeats is false, the message is always output, even if it repeats the previous one;
+	used for the console command output, where the repeated lines are a part of the output. */
+	void LogSimple(AString a_Message, eLogLevel a_LogLevel = llRegular, bool a_ShouldCollapseRepeats = true);
 
 	void AttachListener(cListener * a_Listener);
 	void DetachListener(cListener * a_Listener);
-	
+
+	/** Starts the writer thread; from now on the messages are only queued by the logging threads and the writer thread
+	formats them and passes them to the listeners in batches. Before this (and after StopWriterThread()) the messages
+	are written by the logging thread directly. */
+	void StartWriterThread(void);
+
+	/** Stops the writer thread, after it writes out all the queued messages. */
+	void StopWriterThread(void);
+
+	/** Writes out all the queued messages from the calling thread.
+	Used when the server is crashing, so that the messages leading to the crash are not lost. */
+	void Flush(void);
+
 	static cLogger & GetInstance(void);
 	// Must be called before calling GetInstance in a multithreaded context
 	static void InitiateMultithreading();
 private:
 
+	/** A single message waiting in the queue, the formatting of the line is deferred to the writer */
+	struct sEntry
+	{
+		time_t m_Time;
+		std::thread::id m_ThreadID;
+		eLogLevel m_LogLevel;
+		AString m_Message;
+
+		/** If false, the message is output even if it repeats the previous one */
+		bool m_ShouldCollapseRepeats;
+	};
+
+	typedef std::vector<sEntry> cEntries;
+
+
+	/** Protects m_LogListeners and the repeated message tracking; held while the messages are being written out */
 	cCriticalSection m_CriticalSection;
 	std::vector<cListener *> m_LogListeners;
 
+	/** Protects m_Queue, m_NumDropped and m_ShouldTerminate */
+	cCriticalSection m_CSQueue;
+
+	/** The messages waiting for the writer thread */
+	cEntries m_Queue;
+
+	/** Number of messages dropped because the queue was full, since the last report */
+	size_t m_NumDropped;
+
+	/** Set when the first message is added to an empty queue, and when the writer thread should terminate */
+	cEvent m_evtQueue;
+
+	std::thread m_WriterThread;
+
+	/** True while the writer thread is running, the messages are queued instead of written directly */
+	bool m_IsWriterRunning;
+
+	bool m_ShouldTerminate;
+
+	// The last message written, for collapsing the repeated messages; protected by m_CriticalSection:
+	AString m_LastMessage;
+	eLogLevel m_LastLogLevel;
+	time_t m_LastMessageTime;
+	int m_NumRepeats;
+
+
+	cLogger(void);
+	~cLogger();
+
+	/** The writer thread's entrypoint */
+	void WriterThread(void);
+
+	/** Writes out the queued messages; the listeners are flushed once all of them are written. */
+	void WriteQueue(void);
+
+	/** Formats the messages and passes them to the listeners, collapsing the repeated messages. */
+	void WriteEntries(const cEntries & a_Entries);
+
+	/** Outputs the number of times the last message was repeated, if it was. m_CriticalSection must be held. */
+	void WriteRepeatsNote(void);
+
+	/** Formats a single line and passes it to all the listeners. m_CriticalSection must be held. */
+	void WriteLine(time_t a_Time, std::thread::id a_ThreadID, eLogLevel a_LogLevel, const AString & a_Message);
+
 };
 
 
@@ -276,12 +276,18 @@ cLogger::cListener * MakeConsoleListener(void)
 ////////////////////////////////////////////////////////////////////////////////
 // cFileListener:
 
-cFileListener::cFileListener(void)
+/** A new log file is started once the current one grows over this size */
+static const size_t MAX_LOG_FILE_SIZE = 64 * 1024 * 1024;
+
+
+
+
+
+cFileListener::cFileListener(void) :
+	m_FileSize(0)
 {
 	cFile::CreateFolder(FILE_IO_PREFIX + AString("logs"));
-	AString FileName;
-	FileName = Printf("%s%sLOG_%d.txt", FILE_IO_PREFIX, "logs/", (int)time(nullptr));
-	m_File.Open(FileName, cFile::fmAppend);
+	OpenNewFile();
 }
 
 
@@ -314,7 +320,47 @@ void cFileListener::Log(AString a_Message, cLogger::eLogLevel a_LogLevel)
 			break;
 		}
 	}
-	m_File.Printf("%s%s", LogLevelPrefix, a_Message.c_str());
+	m_Buffer.append(LogLevelPrefix);
+	m_Buffer.append(a_Message);
+}
+
+
+
+
+
+void cFileListener::Flush(void)
+{
+	if (!m_File.IsOpen())
+	{
+		m_Buffer.clear();
+		return;
+	}
+	if (m_Buffer.empty())
+	{
+		return;
+	}
+	m_File.Write(m_Buffer.data(), m_Buffer.size());
+	m_File.Flush();
+	m_FileSize += m_Buffer.size();
+	m_Buffer.clear();
+
+	if (m_FileSize > MAX_LOG_FILE_SIZE)
+	{
+		OpenNewFile();
+	}
+}
+
+
+
+
+
+void cFileListener::OpenNewFile(void)
+{
+	AString FileName;
+	FileName = Printf("%s%sLOG_%d.txt", FILE_IO_PREFIX, "logs/", (int)time(nullptr));
+	m_File.Close();
+	m_File.Open(FileName, cFile::fmAppend);
+	m_FileSize = m_File.IsOpen() ? static_cast<size_t>(std::max(m_File.GetSize(), 0)) : 0;
 }
 
 
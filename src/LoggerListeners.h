@@ -14,10 +14,20 @@ public:
 	cFileListener(AString a_Filename);
 
 	virtual void Log(AString a_Message, cLogger::eLogLevel a_LogLevel) override;
+	virtual void Flush(void) override;
 	
 private:
 
 	cFile m_File;
+
+	/** The lines logged since the last Flush(), written into the file in a single batch */
+	AString m_Buffer;
+
+	/** Number of bytes written into m_File; a new file is started once this exceeds the limit */
+	size_t m_FileSize;
+
+	/** Opens a new log file, named by the current time. */
+	void OpenNewFile(void);
 };
 
 
@@ -10,6 +10,7 @@
 #include "Chunk.h"
 #include "Entities/Player.h"
 #include "FastRandom.h"
+#include "MapManager.h"
 
 
 
@@ -114,6 +115,204 @@ void cMapDecorator::Update(void)
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cMapRenderRegion:
+
+const cMapRenderRegion::ColorID cMapRenderRegion::PIXEL_NOT_RENDERED;
+
+
+
+
+
+cMapRenderRegion::cMapRenderRegion(const cMap & a_Map, int a_PixelX, int a_PixelZ, int a_PixelRadius) :
+	m_MapID(a_Map.GetID()),
+	m_MapCenterX(a_Map.GetCenterX()),
+	m_MapCenterZ(a_Map.GetCenterZ()),
+	m_MapScale(a_Map.GetScale()),
+	m_MapWidth(a_Map.GetWidth()),
+	m_MapHeight(a_Map.GetHeight()),
+	m_IsNether(a_Map.GetDimension() == dimNether),
+	m_StartX(0),
+	m_StartZ(0),
+	m_SizeX(0),
+	m_SizeZ(0),
+	m_PixelWidth((int)a_Map.GetPixelWidth()),
+	m_BlockX(0),
+	m_BlockZ(0)
+{
+	int Width  = (int)m_MapWidth;
+	int Height = (int)m_MapHeight;
+	int StartX = Clamp(a_PixelX - a_PixelRadius, 0, Width);
+	int StartZ = Clamp(a_PixelZ - a_PixelRadius, 0, Height);
+	int EndX   = Clamp(a_PixelX + a_PixelRadius, 0, Width);
+	int EndZ   = Clamp(a_PixelZ + a_PixelRadius, 0, Height);
+	if ((StartX >= EndX) || (StartZ >= EndZ))
+	{
+		return;
+	}
+
+	m_StartX = (unsigned int)StartX;
+	m_StartZ = (unsigned int)StartZ;
+	m_SizeX  = (unsigned int)(EndX - StartX);
+	m_SizeZ  = (unsigned int)(EndZ - StartZ);
+	m_BlockX = m_MapCenterX + (StartX - Width  / 2) * m_PixelWidth;
+	m_BlockZ = m_MapCenterZ + (StartZ - Height / 2) * m_PixelWidth;
+
+	// Only the pixels within the circle are rendered:
+	m_Pixels.assign(m_SizeX * m_SizeZ, cMap::E_BASE_COLOR_TRANSPARENT);
+	for (int X = StartX; X < EndX; ++X)
+	{
+		for (int Z = StartZ; Z < EndZ; ++Z)
+		{
+			int dX = X - a_PixelX;
+			int dZ = Z - a_PixelZ;
+			if ((dX * dX) + (dZ * dZ) >= (a_PixelRadius * a_PixelRadius))
+			{
+				m_Pixels[(size_t)(X - StartX) * m_SizeZ + (size_t)(Z - StartZ)] = PIXEL_NOT_RENDERED;
+			}
+		}
+	}
+}
+
+
+
+
+
+void cMapRenderRegion::Render(cWorld & a_World)
+{
+	if (m_IsNether)
+	{
+		// TODO 2014-02-22 xdot: Nether maps
+		return;
+	}
+
+	// Read the colors of all the block columns within the region, locking each chunk only once:
+	int SizeX = (int)m_SizeX * m_PixelWidth;
+	int SizeZ = (int)m_SizeZ * m_PixelWidth;
+	std::vector<ColorID> Columns((size_t)(SizeX * SizeZ), PIXEL_NOT_RENDERED);
+
+	class cReadColumnsCallback :
+		public cChunkCallback
+	{
+	public:
+		cReadColumnsCallback(cMapRenderRegion & a_Region, std::vector<ColorID> & a_Columns, int a_SizeX, int a_SizeZ) :
+			m_Region(a_Region),
+			m_Columns(a_Columns),
+			m_SizeX(a_SizeX),
+			m_SizeZ(a_SizeZ)
+		{
+		}
+
+		virtual bool Item(cChunk * a_Chunk) override
+		{
+			if (!a_Chunk->IsValid())
+			{
+				// Not loaded, the pixels keep their current colors
+				return false;
+			}
+
+			// The intersection of the chunk and the region, in region-relative block coords:
+			int ChunkBlockX = a_Chunk->GetPosX() * cChunkDef::Width - m_Region.m_BlockX;
+			int ChunkBlockZ = a_Chunk->GetPosZ() * cChunkDef::Width - m_Region.m_BlockZ;
+			int MinX = std::max(ChunkBlockX, 0);
+			int MinZ = std::max(ChunkBlockZ, 0);
+			int MaxX = std::min(ChunkBlockX + cChunkDef::Width, m_SizeX);
+			int MaxZ = std::min(ChunkBlockZ + cChunkDef::Width, m_SizeZ);
+			int PixelWidth = m_Region.m_PixelWidth;
+			for (int X = MinX; X < MaxX; X++)
+			{
+				for (int Z = MinZ; Z < MaxZ; Z++)
+				{
+					if (m_Region.m_Pixels[(size_t)(X / PixelWidth) * m_Region.m_SizeZ + (size_t)(Z / PixelWidth)] == PIXEL_NOT_RENDERED)
+					{
+						// Outside the circle
+						continue;
+					}
+					m_Columns[(size_t)(X * m_SizeZ + Z)] = a_Chunk->GetMapColumnColor(X - ChunkBlockX, Z - ChunkBlockZ);
+				}
+			}
+			return false;
+		}
+
+	protected:
+		cMapRenderRegion & m_Region;
+		std::vector<ColorID> & m_Columns;
+		int m_SizeX, m_SizeZ;
+	} ReadColumns(*this, Columns, SizeX, SizeZ);
+
+	int MinChunkX, MinChunkZ, MaxChunkX, MaxChunkZ;
+	cChunkDef::BlockToChunk(m_BlockX, m_BlockZ, MinChunkX, MinChunkZ);
+	cChunkDef::BlockToChunk(m_BlockX + SizeX - 1, m_BlockZ + SizeZ - 1, MaxChunkX, MaxChunkZ);
+	for (int ChunkX = MinChunkX; ChunkX <= MaxChunkX; ChunkX++)
+	{
+		for (int ChunkZ = MinChunkZ; ChunkZ <= MaxChunkZ; ChunkZ++)
+		{
+			a_World.DoWithChunk(ChunkX, ChunkZ, ReadColumns);
+		}
+	}
+
+	// Each pixel gets the most common color of its columns, the lowest color wins a tie:
+	unsigned int ColorCounts[256] = {};
+	for (unsigned int PixelX = 0; PixelX < m_SizeX; PixelX++)
+	{
+		for (unsigned int PixelZ = 0; PixelZ < m_SizeZ; PixelZ++)
+		{
+			ColorID & Pixel = m_Pixels[PixelX * m_SizeZ + PixelZ];
+			if (Pixel == PIXEL_NOT_RENDERED)
+			{
+				continue;
+			}
+			ColorID PixelColor = PIXEL_NOT_RENDERED;
+			unsigned int MaxCount = 0;
+			int FirstX = (int)PixelX * m_PixelWidth;
+			int FirstZ = (int)PixelZ * m_PixelWidth;
+			for (int X = FirstX; X < FirstX + m_PixelWidth; X++)
+			{
+				for (int Z = FirstZ; Z < FirstZ + m_PixelWidth; Z++)
+				{
+					ColorID Color = Columns[(size_t)(X * SizeZ + Z)];
+					if (Color == PIXEL_NOT_RENDERED)
+					{
+						continue;
+					}
+					unsigned int Count = ++ColorCounts[Color];
+					if ((Count > MaxCount) || ((Count == MaxCount) && (Color < PixelColor)))
+					{
+						PixelColor = Color;
+						MaxCount = Count;
+					}
+				}
+			}
+
+			// Reset the counts for the next pixel:
+			for (int X = FirstX; X < FirstX + m_PixelWidth; X++)
+			{
+				for (int Z = FirstZ; Z < FirstZ + m_PixelWidth; Z++)
+				{
+					ColorCounts[Columns[(size_t)(X * SizeZ + Z)]] = 0;
+				}
+			}
+
+			if (PixelColor == PIXEL_NOT_RENDERED)
+			{
+				// None of the pixel's chunks are loaded
+				Pixel = PIXEL_NOT_RENDERED;
+				continue;
+			}
+
+			// TODO 2014-02-22 xdot: Adjust brightness
+			Pixel = PixelColor + 1;
+		}
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMap:
+
 cMap::cMap(unsigned int a_ID, cWorld * a_World)
 	: m_ID(a_ID)
 	, m_Width(cChunkDef::Width * 8)
@@ -122,6 +321,7 @@ cMap::cMap(unsigned int a_ID, cWorld * a_World)
 	, m_CenterX(0)
 	, m_CenterZ(0)
 	, m_World(a_World)
+	, m_IsRenderPending(false)
 {
 	m_Data.assign(m_Width * m_Height, E_BASE_COLOR_TRANSPARENT);
 
@@ -140,6 +340,7 @@ cMap::cMap(unsigned int a_ID, int a_CenterX, int a_CenterZ, cWorld * a_World, un
 	, m_CenterX(a_CenterX)
 	, m_CenterZ(a_CenterZ)
 	, m_World(a_World)
+	, m_IsRenderPending(false)
 {
 	m_Data.assign(m_Width * m_Height, E_BASE_COLOR_TRANSPARENT);
 
@@ -152,27 +353,28 @@ cMap::cMap(unsigned int a_ID, int a_CenterX, int a_CenterZ, cWorld * a_World, un
 
 void cMap::UpdateRadius(int a_PixelX, int a_PixelZ, unsigned int a_Radius)
 {
-	int PixelRadius = a_Radius / GetPixelWidth();
-
-	unsigned int StartX = Clamp(a_PixelX - PixelRadius, 0, (int)m_Width);
-	unsigned int StartZ = Clamp(a_PixelZ - PixelRadius, 0, (int)m_Height);
-
-	unsigned int EndX   = Clamp(a_PixelX + PixelRadius, 0, (int)m_Width);
-	unsigned int EndZ   = Clamp(a_PixelZ + PixelRadius, 0, (int)m_Height);
+	ASSERT(m_World != nullptr);
+	if (m_IsRenderPending)
+	{
+		// The previous update is still being rendered in the background, skip this one
+		return;
+	}
 
-	for (unsigned int X = StartX; X < EndX; ++X)
+	std::unique_ptr<cMapRenderRegion> Region = make_unique<cMapRenderRegion>(*this, a_PixelX, a_PixelZ, (int)(a_Radius / GetPixelWidth()));
+	if (Region->IsEmpty())
 	{
-		for (unsigned int Z = StartZ; Z < EndZ; ++Z)
-		{
-			int dX = X - a_PixelX;
-			int dZ = Z - a_PixelZ;
+		return;
+	}
 
-			if ((dX * dX) + (dZ * dZ) < (PixelRadius * PixelRadius))
-			{
-				UpdatePixel(X, Z);
-			}
-		}
+	cMapManager & MapManager = m_World->GetMapManager();
+	if (MapManager.IsBackgroundRenderingEnabled())
+	{
+		m_IsRenderPending = true;
+		MapManager.QueueRenderRegion(std::move(Region));
+		return;
 	}
+	Region->Render(*m_World);
+	ApplyRenderRegion(*Region);
 }
 
 
@@ -193,141 +395,53 @@ void cMap::UpdateRadius(cPlayer & a_Player, unsigned int a_Radius)
 
 
 
-bool cMap::UpdatePixel(unsigned int a_X, unsigned int a_Z)
+cMap::ColorID cMap::GetBlockColor(BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta)
 {
-	unsigned int PixelWidth = GetPixelWidth();
-
-	int BlockX = m_CenterX + ((a_X - (m_Width  / 2)) * PixelWidth);
-	int BlockZ = m_CenterZ + ((a_Z - (m_Height / 2)) * PixelWidth);
-
-	int ChunkX, ChunkZ;
-	cChunkDef::BlockToChunk(BlockX, BlockZ, ChunkX, ChunkZ);
-
-	int RelX = BlockX - (ChunkX * cChunkDef::Width);
-	int RelZ = BlockZ - (ChunkZ * cChunkDef::Width);
+	UNUSED(a_BlockMeta);
 
-	class cCalculatePixelCb :
-		public cChunkCallback
+	// TODO 2014-02-22 xdot: Query block color
+	switch (a_BlockType)
 	{
-		cMap * m_Map;
-
-		int m_RelX, m_RelZ;
-
-		ColorID m_PixelData;
-
-	public:
-		cCalculatePixelCb(cMap * a_Map, int a_RelX, int a_RelZ)
-			: m_Map(a_Map), m_RelX(a_RelX), m_RelZ(a_RelZ), m_PixelData(E_BASE_COLOR_TRANSPARENT) {}
-
-		virtual bool Item(cChunk * a_Chunk) override
+		case E_BLOCK_GRASS:
 		{
-			if (a_Chunk == nullptr)
-			{
-				return false;
-			}
-
-			unsigned int PixelWidth = m_Map->GetPixelWidth();
-
-			if (m_Map->GetDimension() == dimNether)
-			{
-				// TODO 2014-02-22 xdot: Nether maps
-
-				return false;
-			}
-
-			typedef std::map<ColorID, unsigned int> ColorCountMap;
-			ColorCountMap ColorCounts;
-
-			// Count surface blocks
-			for (unsigned int X = m_RelX; X < m_RelX + PixelWidth; ++X)
-			{
-				for (unsigned int Z = m_RelZ; Z < m_RelZ + PixelWidth; ++Z)
-				{
-					// unsigned int WaterDepth = 0;
-
-					BLOCKTYPE TargetBlock = E_BLOCK_AIR;
-					NIBBLETYPE TargetMeta = 0;
-
-					int Height = a_Chunk->GetHeight(X, Z);
-
-					while (Height > 0)
-					{
-						a_Chunk->GetBlockTypeMeta(X, Height, Z, TargetBlock, TargetMeta);
-
-						// TODO 2014-02-22 xdot: Check if block color is transparent
-						if (TargetBlock == E_BLOCK_AIR)
-						{
-							--Height;
-							continue;
-						}
-						// TODO 2014-02-22 xdot: Check if block is liquid
-						/*
-						else if (false)
-						{
-							--Height;
-							++WaterDepth;
-							continue;
-						}
-						*/
-
-						break;
-					}
+			return E_BASE_COLOR_LIGHT_GREEN;
+		}
+		case E_BLOCK_STATIONARY_WATER:
+		case E_BLOCK_WATER:
+		{
+			return E_BASE_COLOR_BLUE;
+		}
+	}
+	return E_BASE_COLOR_BROWN;
+}
 
-					// TODO 2014-02-22 xdot: Query block color
-					ColorID Color = E_BASE_COLOR_BROWN;
 
-					// Debug - Temporary
-					switch (TargetBlock)
-					{
-						case E_BLOCK_GRASS:
-						{
-							Color = E_BASE_COLOR_LIGHT_GREEN; break;
-						}
-						case E_BLOCK_STATIONARY_WATER:
-						case E_BLOCK_WATER:
-						{
-							Color = E_BASE_COLOR_BLUE; break;
-						}
-					}
 
-					++ColorCounts[Color];
-				}
-			}
 
-			// Find dominant color
-			ColorID PixelColor = E_BASE_COLOR_TRANSPARENT;
 
-			unsigned int MaxCount = 0;
+void cMap::ApplyRenderRegion(const cMapRenderRegion & a_Region)
+{
+	m_IsRenderPending = false;
+	if (
+		(a_Region.m_MapCenterX != m_CenterX) || (a_Region.m_MapCenterZ != m_CenterZ) ||
+		(a_Region.m_MapScale != m_Scale) || (a_Region.m_MapWidth != m_Width) || (a_Region.m_MapHeight != m_Height)
+	)
+	{
+		// The map has changed since the region was created, the pixels are no longer valid
+		return;
+	}
 
-			for (ColorCountMap::iterator it = ColorCounts.begin(); it != ColorCounts.end(); ++it)
+	const cMapRenderRegion::ColorID * Pixel = a_Region.m_Pixels.data();
+	for (unsigned int X = 0; X < a_Region.m_SizeX; ++X)
+	{
+		for (unsigned int Z = 0; Z < a_Region.m_SizeZ; ++Z, ++Pixel)
+		{
+			if (*Pixel != cMapRenderRegion::PIXEL_NOT_RENDERED)
 			{
-				if (it->second > MaxCount)
-				{
-					PixelColor = it->first;
-					MaxCount = it->second;
-				}
+				SetPixel(a_Region.m_StartX + X, a_Region.m_StartZ + Z, *Pixel);
 			}
-
-			// TODO 2014-02-22 xdot: Adjust brightness
-			unsigned int dColor = 1;
-
-			m_PixelData = PixelColor + dColor;
-
-			return false;
-		}
-
-		ColorID GetPixelData(void) const
-		{
-			return m_PixelData;
 		}
-	} CalculatePixelCb(this, RelX, RelZ);
-
-	ASSERT(m_World != nullptr);
-	m_World->DoWithChunk(ChunkX, ChunkZ, CalculatePixelCb);
-
-	SetPixel(a_X, a_Z, CalculatePixelCb.GetPixelData());
-
-	return true;
+	}
 }
 
 
@@ -23,6 +23,7 @@ class cClientHandle;
 class cWorld;
 class cPlayer;
 class cMap;
+class cMapRenderRegion;
 
 
 
@@ -91,6 +92,60 @@ typedef std::list<cMapDecorator> cMapDecoratorList;
 
 
 
+/** A rectangle of map pixels, rendered from the world's chunks.
+The region is rendered chunk by chunk, each chunk is locked only once and the colors of its block columns are taken
+from the chunk's cache. The rendering doesn't touch the map itself, so it can run in a background thread; the rendered
+pixels are then written into the map by cMap::ApplyRenderRegion(), in the world's tick thread. */
+class cMapRenderRegion
+{
+public:
+	typedef Byte ColorID;
+
+	/** Pixels in m_Pixels that are not to be written into the map (outside the circle, or in unloaded chunks) */
+	static const ColorID PIXEL_NOT_RENDERED = 0xff;
+
+
+	/** Creates a region of the pixels of a_Map within a_PixelRadius of the specified center pixel.
+	The pixels are not rendered yet. */
+	cMapRenderRegion(const cMap & a_Map, int a_PixelX, int a_PixelZ, int a_PixelRadius);
+
+	/** Returns true if the region has no pixels in the map. */
+	bool IsEmpty(void) const { return m_Pixels.empty(); }
+
+	/** Renders the pixels from the chunks of a_World. May be called from any thread. */
+	void Render(cWorld & a_World);
+
+	unsigned int GetMapID(void) const { return m_MapID; }
+
+protected:
+	friend class cMap;
+
+	unsigned int m_MapID;
+
+	// The map's parameters at the time the region was created:
+	int m_MapCenterX, m_MapCenterZ;
+	unsigned int m_MapScale;
+	unsigned int m_MapWidth, m_MapHeight;
+	bool m_IsNether;
+
+	/** The first pixel of the region, and the region's size, in pixels */
+	unsigned int m_StartX, m_StartZ;
+	unsigned int m_SizeX, m_SizeZ;
+
+	/** Number of blocks in each direction per pixel */
+	int m_PixelWidth;
+
+	/** Block coords of the northwest corner of the region */
+	int m_BlockX, m_BlockZ;
+
+	/** The pixel colors, m_SizeX * m_SizeZ, X-major; PIXEL_NOT_RENDERED for pixels that are to be left untouched */
+	std::vector<ColorID> m_Pixels;
+} ;
+
+
+
+
+
 // tolua_begin
 
 /** Encapsulates an in-game world map. */
@@ -134,7 +189,9 @@ public:
 	/** Send this map to the specified client. WARNING: Slow */
 	void SendTo(cClientHandle & a_Client);
 
-	/** Update a circular region with the specified radius and center (in pixels). */
+	/** Update a circular region with the specified radius (in blocks) and center (in pixels).
+	The region is rendered chunk by chunk; if the world's map manager renders in the background, the region is only
+	queued and the pixels get updated in a later tick. */
 	void UpdateRadius(int a_PixelX, int a_PixelZ, unsigned int a_Radius);
 
 	/** Update a circular region around the specified player. */
@@ -189,6 +246,9 @@ public:
 		return "cMap";
 	}
 
+	/** Returns the color of the specified block, as drawn on the map. */
+	static ColorID GetBlockColor(BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta);
+
 
 protected:
 
@@ -220,8 +280,8 @@ private:
 	/** Update the associated decorators. */
 	void UpdateDecorators(void);
 
-	/** Update the specified pixel. */
-	bool UpdatePixel(unsigned int a_X, unsigned int a_Z);
+	/** Writes the rendered pixels of the region into the map, unless the map was moved, resized or rescaled since the region was created. */
+	void ApplyRenderRegion(const cMapRenderRegion & a_Region);
 
 	/** Add a new map client. */
 	void AddPlayer(cPlayer * a_Player, Int64 a_WorldAge);
@@ -254,7 +314,11 @@ private:
 
 	AString m_Name;
 
+	/** True while a region of this map is being rendered in the background; no other region is queued meanwhile. */
+	bool m_IsRenderPending;
+
 	friend class cMapSerializer;
+	friend class cMapManager;
 
 };  // tolua_export
 
@@ -6,12 +6,105 @@
 #include "MapManager.h"
 
 #include "World.h"
+#include "IniFile.h"
 #include "WorldStorage/MapSerializer.h"
 
 
 
 
 
+/** The task that writes a region rendered by the background renderer into its map, in the world's tick thread */
+class cMapRenderResultTask :
+	public cWorld::cTask
+{
+public:
+	cMapRenderResultTask(std::unique_ptr<cMapRenderRegion> a_Region) :
+		m_Region(std::move(a_Region))
+	{
+	}
+
+protected:
+	std::unique_ptr<cMapRenderRegion> m_Region;
+
+	// cWorld::cTask overrides:
+	virtual void Run(cWorld & a_World) override
+	{
+		a_World.GetMapManager().ApplyRenderRegion(*m_Region);
+	}
+} ;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMapManager::cRenderThread:
+
+cMapManager::cRenderThread::cRenderThread(cWorld & a_World) :
+	super("cMapManager::cRenderThread"),
+	m_World(a_World)
+{
+}
+
+
+
+
+
+void cMapManager::cRenderThread::QueueRegion(std::unique_ptr<cMapRenderRegion> a_Region)
+{
+	{
+		cCSLock Lock(m_CS);
+		m_Queue.push_back(std::move(a_Region));
+	}
+	m_evtQueued.Set();
+}
+
+
+
+
+
+void cMapManager::cRenderThread::StopThread(void)
+{
+	m_ShouldTerminate = true;
+	m_evtQueued.Set();
+	Stop();
+}
+
+
+
+
+
+void cMapManager::cRenderThread::Execute(void)
+{
+	while (!m_ShouldTerminate)
+	{
+		std::unique_ptr<cMapRenderRegion> Region;
+		{
+			cCSLock Lock(m_CS);
+			if (!m_Queue.empty())
+			{
+				Region = std::move(m_Queue.front());
+				m_Queue.pop_front();
+			}
+		}
+		if (Region == nullptr)
+		{
+			m_evtQueued.Wait();
+			continue;
+		}
+
+		Region->Render(m_World);
+		m_World.QueueTask(std::unique_ptr<cWorld::cTask>(new cMapRenderResultTask(std::move(Region))));
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMapManager:
+
 cMapManager::cMapManager(cWorld * a_World)
 	: m_World(a_World)
 {
@@ -22,6 +115,15 @@ cMapManager::cMapManager(cWorld * a_World)
 
 
 
+cMapManager::~cMapManager()
+{
+	StopRendering();
+}
+
+
+
+
+
 bool cMapManager::DoWithMap(int a_ID, cMapCallback & a_Callback)
 {
 	cCSLock Lock(m_CS);
@@ -176,3 +278,53 @@ void cMapManager::SaveMapData(void)
 
 
 
+void cMapManager::LoadSettings(cIniFile & a_IniFile)
+{
+	if (!a_IniFile.GetValueSetB("Maps", "BackgroundRendering", false) || (m_Renderer != nullptr))
+	{
+		return;
+	}
+	m_Renderer = make_unique<cRenderThread>(*m_World);
+	m_Renderer->Start();
+}
+
+
+
+
+
+void cMapManager::StopRendering(void)
+{
+	if (m_Renderer == nullptr)
+	{
+		return;
+	}
+	m_Renderer->StopThread();
+	m_Renderer.reset();
+}
+
+
+
+
+
+void cMapManager::QueueRenderRegion(std::unique_ptr<cMapRenderRegion> a_Region)
+{
+	ASSERT(m_Renderer != nullptr);
+	m_Renderer->QueueRegion(std::move(a_Region));
+}
+
+
+
+
+
+void cMapManager::ApplyRenderRegion(const cMapRenderRegion & a_Region)
+{
+	cMap * Map = GetMapData(a_Region.GetMapID());
+	if (Map != nullptr)
+	{
+		Map->ApplyRenderRegion(a_Region);
+	}
+}
+
+
+
+
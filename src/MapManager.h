@@ -12,12 +12,16 @@
 
 
 #include "Map.h"
+#include "OSSupport/IsThread.h"
 
 
 
 
 typedef cItemCallback<cMap> cMapCallback;
 
+// fwd:
+class cIniFile;
+
 
 
 
@@ -31,6 +35,8 @@ public:
 
 	cMapManager(cWorld * a_World);
 
+	~cMapManager();
+
 	/** Returns the map with the specified ID, nullptr if out of range.
 	WARNING: The returned map object is not thread safe.
 	*/
@@ -58,17 +64,70 @@ public:
 	/** Saves the map data to the disk */
 	void SaveMapData(void);
 
+	/** Reads the settings from the [Maps] section of the world's ini file and starts the background renderer, if enabled. */
+	void LoadSettings(cIniFile & a_IniFile);
+
+	/** Stops the background renderer; the regions still in its queue are dropped. */
+	void StopRendering(void);
+
+	/** Returns true if the map updates are rendered in the background thread instead of the world's tick thread. */
+	bool IsBackgroundRenderingEnabled(void) const { return (m_Renderer != nullptr); }
+
+	/** Queues the region for rendering in the background thread.
+	Once rendered, the region is written into its map by ApplyRenderRegion(), in the world's tick thread. */
+	void QueueRenderRegion(std::unique_ptr<cMapRenderRegion> a_Region);
+
+	/** Writes the rendered region into its map. Must be called from the world's tick thread. */
+	void ApplyRenderRegion(const cMapRenderRegion & a_Region);
+
 
 private:
 
 	typedef std::vector<cMap> cMapList;
 
+	/** The thread that renders the queued map regions from the world's chunks */
+	class cRenderThread :
+		public cIsThread
+	{
+		typedef cIsThread super;
+
+	public:
+		cRenderThread(cWorld & a_World);
+
+		/** Adds the region to the queue and wakes up the thread. */
+		void QueueRegion(std::unique_ptr<cMapRenderRegion> a_Region);
+
+		/** Signals the thread to terminate and waits for it. */
+		void StopThread(void);
+
+	protected:
+		typedef std::list<std::unique_ptr<cMapRenderRegion>> cRegions;
+
+		cWorld & m_World;
+
+		/** Protects m_Queue */
+		cCriticalSection m_CS;
+
+		/** The regions waiting to be rendered */
+		cRegions m_Queue;
+
+		/** Set when a region is queued, or when the thread should terminate */
+		cEvent m_evtQueued;
+
+
+		// cIsThread overrides:
+		virtual void Execute(void) override;
+	} ;
+
 	cCriticalSection m_CS;
 
 	cMapList m_MapData;
 
 	cWorld * m_World;
 
+	/** The background renderer; nullptr if the map updates are rendered in the tick thread */
+	std::unique_ptr<cRenderThread> m_Renderer;
+
 };  // tolua_export
 
 
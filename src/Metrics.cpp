@@ -0,0 +1,336 @@
+
+// Metrics.cpp
+
+// Implements the cMetricsRegistry class and the metrics classes, exporting the server's internals for monitoring
+
+#include "Globals.h"
+#include "Metrics.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetricCounter:
+
+cMetricCounter::cMetricCounter(const AString & a_Labels) :
+	super(a_Labels),
+	m_Value(0)
+{
+}
+
+
+
+
+
+void cMetricCounter::Write(cMetricsWriter & a_Writer, const AString & a_Name) const
+{
+	a_Writer.Sample(a_Name, m_Labels, GetValue());
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetricGauge:
+
+cMetricGauge::cMetricGauge(const AString & a_Labels) :
+	super(a_Labels),
+	m_Value(0)
+{
+}
+
+
+
+
+
+void cMetricGauge::Write(cMetricsWriter & a_Writer, const AString & a_Name) const
+{
+	a_Writer.Sample(a_Name, m_Labels, GetValue());
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetricHistogram:
+
+cMetricHistogram::cMetricHistogram(const AString & a_Labels, const cBounds & a_Bounds) :
+	super(a_Labels),
+	m_Bounds(a_Bounds),
+	m_Buckets(new std::atomic<UInt64>[a_Bounds.size() + 1]),
+	m_Count(0),
+	m_Sum(0)
+{
+	for (size_t i = 0; i <= m_Bounds.size(); i++)
+	{
+		m_Buckets[i].store(0);
+	}
+}
+
+
+
+
+
+void cMetricHistogram::Observe(UInt64 a_Value)
+{
+	// There are only a few bounds, a linear search is the fastest:
+	size_t Bucket = 0;
+	while ((Bucket < m_Bounds.size()) && (a_Value > m_Bounds[Bucket]))
+	{
+		Bucket++;
+	}
+	m_Buckets[Bucket].fetch_add(1, std::memory_order_relaxed);
+	m_Count.fetch_add(1, std::memory_order_relaxed);
+	m_Sum.fetch_add(a_Value, std::memory_order_relaxed);
+}
+
+
+
+
+
+void cMetricHistogram::Write(cMetricsWriter & a_Writer, const AString & a_Name) const
+{
+	// The exported buckets are cumulative:
+	UInt64 Cumulative = 0;
+	for (size_t i = 0; i < m_Bounds.size(); i++)
+	{
+		Cumulative += m_Buckets[i].load(std::memory_order_relaxed);
+		AString Bound = Printf("%llu", static_cast<unsigned long long>(m_Bounds[i]));
+		a_Writer.Sample(a_Name + "_bucket", cMetricsWriter::JoinLabels(m_Labels, cMetricsWriter::Label("le", Bound)), Cumulative);
+	}
+	Cumulative += m_Buckets[m_Bounds.size()].load(std::memory_order_relaxed);
+	a_Writer.Sample(a_Name + "_bucket", cMetricsWriter::JoinLabels(m_Labels, cMetricsWriter::Label("le", "+Inf")), Cumulative);
+	a_Writer.Sample(a_Name + "_sum",   m_Labels, m_Sum.load(std::memory_order_relaxed));
+	a_Writer.Sample(a_Name + "_count", m_Labels, m_Count.load(std::memory_order_relaxed));
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetricsWriter:
+
+void cMetricsWriter::BeginFamily(const AString & a_Name, const AString & a_Help, const char * a_Type)
+{
+	AppendPrintf(m_Output, "# HELP %s %s\n# TYPE %s %s\n", a_Name.c_str(), a_Help.c_str(), a_Name.c_str(), a_Type);
+}
+
+
+
+
+
+void cMetricsWriter::Sample(const AString & a_Name, const AString & a_Labels, Int64 a_Value)
+{
+	if (a_Labels.empty())
+	{
+		AppendPrintf(m_Output, "%s %lld\n", a_Name.c_str(), static_cast<long long>(a_Value));
+	}
+	else
+	{
+		AppendPrintf(m_Output, "%s{%s} %lld\n", a_Name.c_str(), a_Labels.c_str(), static_cast<long long>(a_Value));
+	}
+}
+
+
+
+
+
+void cMetricsWriter::Sample(const AString & a_Name, const AString & a_Labels, UInt64 a_Value)
+{
+	if (a_Labels.empty())
+	{
+		AppendPrintf(m_Output, "%s %llu\n", a_Name.c_str(), static_cast<unsigned long long>(a_Value));
+	}
+	else
+	{
+		AppendPrintf(m_Output, "%s{%s} %llu\n", a_Name.c_str(), a_Labels.c_str(), static_cast<unsigned long long>(a_Value));
+	}
+}
+
+
+
+
+
+AString cMetricsWriter::Label(const AString & a_Name, const AString & a_Value)
+{
+	AString res(a_Name);
+	res.append("=\"");
+	for (AString::const_iterator itr = a_Value.begin(), end = a_Value.end(); itr != end; ++itr)
+	{
+		switch (*itr)
+		{
+			case '\\': res.append("\\\\"); break;
+			case '"':  res.append("\\\""); break;
+			case '\n': res.append("\\n");  break;
+			default:   res.push_back(*itr); break;
+		}
+	}
+	res.push_back('"');
+	return res;
+}
+
+
+
+
+
+AString cMetricsWriter::JoinLabels(const AString & a_Labels1, const AString & a_Labels2)
+{
+	if (a_Labels1.empty())
+	{
+		return a_Labels2;
+	}
+	if (a_Labels2.empty())
+	{
+		return a_Labels1;
+	}
+	return a_Labels1 + "," + a_Labels2;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetricsRegistry:
+
+cMetricsRegistry & cMetricsRegistry::Get(void)
+{
+	static cMetricsRegistry Instance;
+	return Instance;
+}
+
+
+
+
+
+cMetricCounter & cMetricsRegistry::AddCounter(const AString & a_Name, const AString & a_Help, const AString & a_Labels)
+{
+	cCSLock Lock(m_CS);
+	cMetric * Metric = FindMetric(a_Name, a_Help, "counter", a_Labels);
+	if (Metric == nullptr)
+	{
+		Metric = new cMetricCounter(a_Labels);
+		AddMetric(a_Name, Metric);
+	}
+	return *static_cast<cMetricCounter *>(Metric);
+}
+
+
+
+
+
+cMetricGauge & cMetricsRegistry::AddGauge(const AString & a_Name, const AString & a_Help, const AString & a_Labels)
+{
+	cCSLock Lock(m_CS);
+	cMetric * Metric = FindMetric(a_Name, a_Help, "gauge", a_Labels);
+	if (Metric == nullptr)
+	{
+		Metric = new cMetricGauge(a_Labels);
+		AddMetric(a_Name, Metric);
+	}
+	return *static_cast<cMetricGauge *>(Metric);
+}
+
+
+
+
+
+cMetricHistogram & cMetricsRegistry::AddHistogram(const AString & a_Name, const AString & a_Help, const cMetricHistogram::cBounds & a_Bounds, const AString & a_Labels)
+{
+	cCSLock Lock(m_CS);
+	cMetric * Metric = FindMetric(a_Name, a_Help, "histogram", a_Labels);
+	if (Metric == nullptr)
+	{
+		Metric = new cMetricHistogram(a_Labels, a_Bounds);
+		AddMetric(a_Name, Metric);
+	}
+	return *static_cast<cMetricHistogram *>(Metric);
+}
+
+
+
+
+
+void cMetricsRegistry::AddCollector(cCollector * a_Collector)
+{
+	cCSLock Lock(m_CS);
+	m_Collectors.push_back(a_Collector);
+}
+
+
+
+
+
+void cMetricsRegistry::RemoveCollector(cCollector * a_Collector)
+{
+	cCSLock Lock(m_CS);
+	m_Collectors.erase(std::remove(m_Collectors.begin(), m_Collectors.end(), a_Collector), m_Collectors.end());
+}
+
+
+
+
+
+AString cMetricsRegistry::Export(void)
+{
+	cMetricsWriter Writer;
+	cCSLock Lock(m_CS);
+	for (cFamilies::const_iterator itr = m_Families.begin(), end = m_Families.end(); itr != end; ++itr)
+	{
+		Writer.BeginFamily(itr->first, itr->second.m_Help, itr->second.m_Type);
+		for (std::vector<std::unique_ptr<cMetric>>::const_iterator itrM = itr->second.m_Metrics.begin(), endM = itr->second.m_Metrics.end(); itrM != endM; ++itrM)
+		{
+			(*itrM)->Write(Writer, itr->first);
+		}
+	}
+	for (cCollectors::iterator itr = m_Collectors.begin(), end = m_Collectors.end(); itr != end; ++itr)
+	{
+		(*itr)->Collect(Writer);
+	}
+	return Writer.GetOutput();
+}
+
+
+
+
+
+cMetric * cMetricsRegistry::FindMetric(const AString & a_Name, const AString & a_Help, const char * a_Type, const AString & a_Labels)
+{
+	ASSERT(m_CS.IsLockedByCurrentThread());
+
+	cFamilies::iterator itrF = m_Families.find(a_Name);
+	if (itrF == m_Families.end())
+	{
+		sFamily & Family = m_Families[a_Name];
+		Family.m_Help = a_Help;
+		Family.m_Type = a_Type;
+		return nullptr;
+	}
+	ASSERT(strcmp(itrF->second.m_Type, a_Type) == 0);  // The same name must not be used for metrics of different types
+	for (std::vector<std::unique_ptr<cMetric>>::const_iterator itr = itrF->second.m_Metrics.begin(), end = itrF->second.m_Metrics.end(); itr != end; ++itr)
+	{
+		if ((*itr)->GetLabels() == a_Labels)
+		{
+			return itr->get();
+		}
+	}
+	return nullptr;
+}
+
+
+
+
+
+void cMetricsRegistry::AddMetric(const AString & a_Name, cMetric * a_Metric)
+{
+	ASSERT(m_CS.IsLockedByCurrentThread());
+	m_Families[a_Name].m_Metrics.push_back(std::unique_ptr<cMetric>(a_Metric));
+}
+
+
+
+
@@ -0,0 +1,231 @@
+
+// Metrics.h
+
+// Declares the cMetricsRegistry class and the metrics classes, exporting the server's internals for monitoring
+
+/*
+There are two kinds of metrics:
+- The metrics updated on the hot paths (bytes sent, tick durations) are objects registered in the cMetricsRegistry
+once and then updated directly; an update is a single relaxed atomic operation, no locking.
+- The values that the server already keeps elsewhere (queue lengths, chunk and entity counts, ...) are not
+duplicated; a cMetricsRegistry::cCollector reads them only when the metrics are exported.
+The metrics are exported in the Prometheus text format by cWebAdmin, in the "/~webadmin/metrics" URL.
+*/
+
+
+
+
+
+#pragma once
+
+#include <atomic>
+
+
+
+
+
+class cMetricsWriter;
+
+
+
+
+
+/** The common ancestor of the registered metrics. */
+class cMetric
+{
+public:
+	cMetric(const AString & a_Labels) :
+		m_Labels(a_Labels)
+	{
+	}
+
+	virtual ~cMetric() {}
+
+	/** Returns the labels of the metric, formatted as the contents of the braces: name="value", ... */
+	const AString & GetLabels(void) const { return m_Labels; }
+
+	/** Writes the metric's samples, the family header has been written already. */
+	virtual void Write(cMetricsWriter & a_Writer, const AString & a_Name) const = 0;
+
+protected:
+	AString m_Labels;
+} ;
+
+
+
+
+
+/** A value that only ever increases, such as the number of bytes sent. */
+class cMetricCounter :
+	public cMetric
+{
+	typedef cMetric super;
+
+public:
+	cMetricCounter(const AString & a_Labels);
+
+	void Inc(UInt64 a_Delta = 1) { m_Value.fetch_add(a_Delta, std::memory_order_relaxed); }
+
+	UInt64 GetValue(void) const { return m_Value.load(std::memory_order_relaxed); }
+
+	// cMetric overrides:
+	virtual void Write(cMetricsWriter & a_Writer, const AString & a_Name) const override;
+
+protected:
+	std::atomic<UInt64> m_Value;
+} ;
+
+
+
+
+
+/** A value that can go up and down, such as a queue length. */
+class cMetricGauge :
+	public cMetric
+{
+	typedef cMetric super;
+
+public:
+	cMetricGauge(const AString & a_Labels);
+
+	void Set(Int64 a_Value) { m_Value.store(a_Value, std::memory_order_relaxed); }
+
+	void Add(Int64 a_Delta) { m_Value.fetch_add(a_Delta, std::memory_order_relaxed); }
+
+	Int64 GetValue(void) const { return m_Value.load(std::memory_order_relaxed); }
+
+	// cMetric overrides:
+	virtual void Write(cMetricsWriter & a_Writer, const AString & a_Name) const override;
+
+protected:
+	std::atomic<Int64> m_Value;
+} ;
+
+
+
+
+
+/** The distribution of the observed values, counted into buckets by their fixed upper bounds. */
+class cMetricHistogram :
+	public cMetric
+{
+	typedef cMetric super;
+
+public:
+	typedef std::vector<UInt64> cBounds;
+
+
+	/** Creates the histogram with the specified bucket upper bounds, in ascending order. */
+	cMetricHistogram(const AString & a_Labels, const cBounds & a_Bounds);
+
+	void Observe(UInt64 a_Value);
+
+	// cMetric overrides:
+	virtual void Write(cMetricsWriter & a_Writer, const AString & a_Name) const override;
+
+protected:
+	cBounds m_Bounds;
+
+	/** The number of observations in each bucket (not cumulative); the last one is for the values above all the bounds */
+	std::unique_ptr<std::atomic<UInt64>[]> m_Buckets;
+
+	std::atomic<UInt64> m_Count;
+	std::atomic<UInt64> m_Sum;
+} ;
+
+
+
+
+
+/** Formats the metrics in the Prometheus text format. */
+class cMetricsWriter
+{
+public:
+	/** Writes the header of a metric family; all the family's samples must follow before the next family. */
+	void BeginFamily(const AString & a_Name, const AString & a_Help, const char * a_Type);
+
+	/** Writes a single sample. a_Labels is formatted as the contents of the braces, may be empty. */
+	void Sample(const AString & a_Name, const AString & a_Labels, Int64 a_Value);
+	void Sample(const AString & a_Name, const AString & a_Labels, UInt64 a_Value);
+
+	/** Returns the formatted metrics. */
+	const AString & GetOutput(void) const { return m_Output; }
+
+	/** Returns a single label formatted for the a_Labels params: name="value" with the value escaped. */
+	static AString Label(const AString & a_Name, const AString & a_Value);
+
+	/** Joins two formatted label lists. */
+	static AString JoinLabels(const AString & a_Labels1, const AString & a_Labels2);
+
+protected:
+	AString m_Output;
+} ;
+
+
+
+
+
+class cMetricsRegistry
+{
+public:
+	/** The interface for reading the values kept elsewhere in the server, called each time the metrics are exported. */
+	class cCollector
+	{
+	public:
+		virtual ~cCollector() {}
+
+		/** Writes the collected metric families into the writer. */
+		virtual void Collect(cMetricsWriter & a_Writer) = 0;
+	} ;
+
+
+	static cMetricsRegistry & Get(void);
+
+	/** Returns the counter with the specified name and labels, registering it if needed.
+	The metrics are never unregistered, the returned reference is valid for the lifetime of the server. */
+	cMetricCounter & AddCounter(const AString & a_Name, const AString & a_Help, const AString & a_Labels = AString());
+
+	/** Returns the gauge with the specified name and labels, registering it if needed. */
+	cMetricGauge & AddGauge(const AString & a_Name, const AString & a_Help, const AString & a_Labels = AString());
+
+	/** Returns the histogram with the specified name and labels, registering it with the bounds if needed. */
+	cMetricHistogram & AddHistogram(const AString & a_Name, const AString & a_Help, const cMetricHistogram::cBounds & a_Bounds, const AString & a_Labels = AString());
+
+	void AddCollector(cCollector * a_Collector);
+	void RemoveCollector(cCollector * a_Collector);
+
+	/** Returns all the metrics, the registered ones and the collected ones, in the Prometheus text format. */
+	AString Export(void);
+
+protected:
+	/** All the metrics registered with the same name, differing in their labels */
+	struct sFamily
+	{
+		AString m_Help;
+		const char * m_Type;
+		std::vector<std::unique_ptr<cMetric>> m_Metrics;
+	} ;
+
+	typedef std::map<AString, sFamily> cFamilies;
+	typedef std::vector<cCollector *> cCollectors;
+
+
+	/** Protects m_Families and m_Collectors; the metric values themselves are atomic and updated without locking */
+	cCriticalSection m_CS;
+
+	cFamilies m_Families;
+
+	cCollectors m_Collectors;
+
+
+	/** Returns the metric with the specified labels in the family, or nullptr if not registered yet.
+	Creates the (empty) family if it doesn't exist. Assumes m_CS is held. */
+	cMetric * FindMetric(const AString & a_Name, const AString & a_Help, const char * a_Type, const AString & a_Labels);
+
+	/** Adds the new metric into its family. Assumes m_CS is held. */
+	void AddMetric(const AString & a_Name, cMetric * a_Metric);
+} ;
+
+
+
+
@@ -47,7 +47,7 @@ void cCaveSpider::GetDrops(cItems & a_Drops, cEntity * a_Killer)
 	int LootingLevel = 0;
 	if (a_Killer != nullptr)
 	{
-		LootingLevel = a_Killer->GetEquippedWeapon().m_Enchantments.GetLevel(cEnchantments::enchLooting);
+		LootingLevel = a_Killer->GetEquippedWeapon().GetEnchantments().GetLevel(cEnchantments::enchLooting);
 	}
 	AddRandomDropItem(a_Drops, 0, 2 + LootingLevel, E_ITEM_STRING);
 	if ((a_Killer != nullptr) && (a_Killer->IsPlayer() || a_Killer->IsA("cWolf")))
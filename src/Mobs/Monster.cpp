@@ -11,6 +11,7 @@
 #include "../MonsterConfig.h"
 
 #include "../Chunk.h"
+#include "../ChunkCursor.h"
 #include "../FastRandom.h"
 
 
@@ -142,6 +143,8 @@ void cMonster::TickPathFinding()
 		return;
 	}
 
+	// All the lookups are around a single position, read them through a single cursor to avoid re-locking the chunkmap for each block:
+	cChunkCursor Cursor(*m_World);
 	for (size_t i = 0; i < ARRAYCOUNT(gCrossCoords); i++)
 	{
 		if (IsCoordinateInTraversedList(Vector3i(gCrossCoords[i].x + PosX, PosY, gCrossCoords[i].z + PosZ)))
@@ -149,11 +152,11 @@ void cMonster::TickPathFinding()
 			continue;
 		}
 
-		BLOCKTYPE BlockAtY = m_World->GetBlock(gCrossCoords[i].x + PosX, PosY, gCrossCoords[i].z + PosZ);
-		BLOCKTYPE BlockAtYP = m_World->GetBlock(gCrossCoords[i].x + PosX, PosY + 1, gCrossCoords[i].z + PosZ);
-		BLOCKTYPE BlockAtYPP = m_World->GetBlock(gCrossCoords[i].x + PosX, PosY + 2, gCrossCoords[i].z + PosZ);
-		int LowestY = FindFirstNonAirBlockPosition(gCrossCoords[i].x + PosX, gCrossCoords[i].z + PosZ);
-		BLOCKTYPE BlockAtLowestY = (LowestY >= cChunkDef::Height) ? E_BLOCK_AIR : m_World->GetBlock(gCrossCoords[i].x + PosX, LowestY, gCrossCoords[i].z + PosZ);
+		BLOCKTYPE BlockAtY = Cursor.GetBlock(gCrossCoords[i].x + PosX, PosY, gCrossCoords[i].z + PosZ);
+		BLOCKTYPE BlockAtYP = Cursor.GetBlock(gCrossCoords[i].x + PosX, PosY + 1, gCrossCoords[i].z + PosZ);
+		BLOCKTYPE BlockAtYPP = Cursor.GetBlock(gCrossCoords[i].x + PosX, PosY + 2, gCrossCoords[i].z + PosZ);
+		int LowestY = FindFirstNonAirBlockPosition(Cursor, gCrossCoords[i].x + PosX, gCrossCoords[i].z + PosZ);
+		BLOCKTYPE BlockAtLowestY = (LowestY >= cChunkDef::Height) ? E_BLOCK_AIR : Cursor.GetBlock(gCrossCoords[i].x + PosX, LowestY, gCrossCoords[i].z + PosZ);
 
 		if (
 			(!cBlockInfo::IsSolid(BlockAtY)) &&
@@ -431,13 +434,25 @@ void cMonster::HandleFalling()
 
 
 int cMonster::FindFirstNonAirBlockPosition(double a_PosX, double a_PosZ)
+{
+	cChunkCursor Cursor(*m_World);
+	return FindFirstNonAirBlockPosition(Cursor, a_PosX, a_PosZ);
+}
+
+
+
+
+
+int cMonster::FindFirstNonAirBlockPosition(cChunkCursor & a_Cursor, double a_PosX, double a_PosZ)
 {
 	int PosY = POSY_TOINT;
 	PosY = Clamp(PosY, 0, cChunkDef::Height);
+	int BlockX = (int)floor(a_PosX);
+	int BlockZ = (int)floor(a_PosZ);
 
-	if (!cBlockInfo::IsSolid(m_World->GetBlock((int)floor(a_PosX), PosY, (int)floor(a_PosZ))))
+	if (!cBlockInfo::IsSolid(a_Cursor.GetBlock(BlockX, PosY, BlockZ)))
 	{
-		while (!cBlockInfo::IsSolid(m_World->GetBlock((int)floor(a_PosX), PosY, (int)floor(a_PosZ))) && (PosY > 0))
+		while (!cBlockInfo::IsSolid(a_Cursor.GetBlock(BlockX, PosY, BlockZ)) && (PosY > 0))
 		{
 			PosY--;
 		}
@@ -446,7 +461,7 @@ int cMonster::FindFirstNonAirBlockPosition(double a_PosX, double a_PosZ)
 	}
 	else
 	{
-		while ((PosY < cChunkDef::Height) && cBlockInfo::IsSolid(m_World->GetBlock((int)floor(a_PosX), PosY, (int)floor(a_PosZ))))
+		while ((PosY < cChunkDef::Height) && cBlockInfo::IsSolid(a_Cursor.GetBlock(BlockX, PosY, BlockZ)))
 		{
 			PosY++;
 		}
@@ -567,9 +582,9 @@ void cMonster::OnRightClicked(cPlayer & a_Player)
 	super::OnRightClicked(a_Player);
 
 	const cItem & EquippedItem = a_Player.GetEquippedItem();
-	if ((EquippedItem.m_ItemType == E_ITEM_NAME_TAG) && !EquippedItem.m_CustomName.empty())
+	if ((EquippedItem.m_ItemType == E_ITEM_NAME_TAG) && !EquippedItem.GetCustomName().empty())
 	{
-		SetCustomName(EquippedItem.m_CustomName);
+		SetCustomName(EquippedItem.GetCustomName());
 		if (!a_Player.IsGameModeCreative())
 		{
 			a_Player.GetInventory().RemoveOneEquippedItem();
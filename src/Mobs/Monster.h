@@ -14,6 +14,7 @@
 
 class cClientHandle;
 class cWorld;
+class cChunkCursor;
 
 
 
@@ -178,6 +179,9 @@ protected:
 	If no suitable position is found, returns cChunkDef::Height. */
 	int FindFirstNonAirBlockPosition(double a_PosX, double a_PosZ);
 
+	/** Same as FindFirstNonAirBlockPosition(), but reads the blocks through the specified cursor. */
+	int FindFirstNonAirBlockPosition(cChunkCursor & a_Cursor, double a_PosX, double a_PosZ);
+
 	/** Returns if a monster can actually reach a given height by jumping or walking */
 	inline bool IsNextYPosReachable(int a_PosY)
 	{
@@ -39,6 +39,10 @@ public:
 	inline int IntNoise2DInt(int a_X, int a_Y) const;
 	inline int IntNoise3DInt(int a_X, int a_Y, int a_Z) const;
 
+	/** Fills a_Out[i] with IntNoise2DInt(a_StartX + i * a_StepX, a_Y) for i in [0, a_Count).
+	The loop has no branches and uses wrapping unsigned arithmetic, so that the compiler can vectorize it. */
+	inline void IntNoise2DIntRow(int a_StartX, int a_StepX, int a_Y, int a_Count, int * a_Out) const;
+
 	NOISE_DATATYPE LinearNoise1D(NOISE_DATATYPE a_X) const;
 	NOISE_DATATYPE CosineNoise1D(NOISE_DATATYPE a_X) const;
 	NOISE_DATATYPE CubicNoise1D (NOISE_DATATYPE a_X) const;
@@ -238,6 +242,23 @@ int cNoise::IntNoise2DInt(int a_X, int a_Y) const
 
 
 
+void cNoise::IntNoise2DIntRow(int a_StartX, int a_StepX, int a_Y, int a_Count, int * a_Out) const
+{
+	// Same as IntNoise2DInt(), the unsigned arithmetic wraps around the same way as the signed one does in practice:
+	UInt32 Base = static_cast<UInt32>(a_StartX) + static_cast<UInt32>(a_Y) * 57 + static_cast<UInt32>(m_Seed) * 57 * 57;
+	UInt32 Step = static_cast<UInt32>(a_StepX);
+	for (int i = 0; i < a_Count; i++)
+	{
+		UInt32 n = Base + static_cast<UInt32>(i) * Step;
+		n = (n << 13) ^ n;
+		a_Out[i] = static_cast<int>((n * (n * n * 15731 + 789221) + 1376312589) & 0x7fffffff);
+	}
+}
+
+
+
+
+
 int cNoise::IntNoise3DInt(int a_X, int a_Y, int a_Z) const
 {
 	int n = a_X + a_Y * 57 + a_Z * 57 * 57 + m_Seed * 57 * 57 * 57;
@@ -363,6 +363,20 @@ int cFile::GetSize(const AString & a_FileName)
 
 
 
+time_t cFile::GetLastModificationTime(const AString & a_FileName)
+{
+	struct stat st;
+	if (stat(a_FileName.c_str(), &st) == 0)
+	{
+		return st.st_mtime;
+	}
+	return -1;
+}
+
+
+
+
+
 bool cFile::CreateFolder(const AString & a_FolderPath)
 {
 	#ifdef _WIN32
@@ -132,6 +132,9 @@ public:
 	/** Returns the list of all items in the specified folder (files, folders, nix pipes, whatever's there). */
 	static AStringVector GetFolderContents(const AString & a_Folder);  // Exported in ManualBindings.cpp
 
+	/** Returns the last modification time of the specified file, or -1 on error */
+	static time_t GetLastModificationTime(const AString & a_FileName);
+
 	int Printf(const char * a_Fmt, ...) FORMATSTRING(2, 3);
 	
 	/** Flushes all the bufferef output into the file (only when writing) */
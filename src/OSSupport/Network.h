@@ -69,6 +69,15 @@ public:
 		return Send(a_Data.data(), a_Data.size());
 	}
 
+	/** Queues the data in a_Data for sending to the remote peer, taking over the contents instead of copying them.
+	a_Data is left empty, but with a preallocated capacity, so that the caller can keep filling it with the next data.
+	Returns true on success, false on failure (see Send()). */
+	virtual bool SendOwned(AString & a_Data) = 0;
+
+	/** Returns the number of bytes that have been queued for sending, but not yet handed over to the OS.
+	Used for backpressure, a growing number means the remote peer doesn't keep up with reading the data. */
+	virtual size_t GetOutgoingQueueSize(void) = 0;
+
 	/** Returns the IP address of the local endpoint of the connection. */
 	virtual AString GetLocalIP(void) const = 0;
 
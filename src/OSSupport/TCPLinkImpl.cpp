@@ -7,6 +7,74 @@
 #include "TCPLinkImpl.h"
 #include "NetworkSingleton.h"
 #include "ServerHandleImpl.h"
+#include <event2/buffer.h>
+
+
+
+
+
+/** Data smaller than this is copied by SendOwned(), because a separate LibEvent chain for it would cost more than the copy. */
+static const size_t MIN_SEND_OWNED_SIZE = 1024;
+
+
+
+
+
+/** The buffers that have been sent by SendOwned(), kept for reuse so that their memory doesn't need to be reallocated.
+Shared by all the links; the buffers are returned from the LibEvent thread and taken from any thread sending data. */
+class cSendBufferPool
+{
+public:
+	~cSendBufferPool()
+	{
+		for (std::vector<AString *>::iterator itr = m_Buffers.begin(), end = m_Buffers.end(); itr != end; ++itr)
+		{
+			delete *itr;
+		}
+	}
+
+
+	/** Returns an empty buffer, either a recycled one or a new one. The caller is responsible for returning it via Release(). */
+	AString * Get(void)
+	{
+		{
+			cCSLock Lock(m_CS);
+			if (!m_Buffers.empty())
+			{
+				AString * res = m_Buffers.back();
+				m_Buffers.pop_back();
+				return res;
+			}
+		}
+		return new AString;
+	}
+
+
+	/** Returns the buffer to the pool. Huge buffers, and the ones that don't fit into the pool, are deleted. */
+	void Release(AString * a_Buffer)
+	{
+		if (a_Buffer->capacity() <= MAX_BUFFER_CAPACITY)
+		{
+			a_Buffer->clear();
+			cCSLock Lock(m_CS);
+			if (m_Buffers.size() < MAX_NUM_BUFFERS)
+			{
+				m_Buffers.push_back(a_Buffer);
+				return;
+			}
+		}
+		delete a_Buffer;
+	}
+
+protected:
+	static const size_t MAX_NUM_BUFFERS = 256;
+	static const size_t MAX_BUFFER_CAPACITY = 256 * 1024;
+
+	cCriticalSection m_CS;
+	std::vector<AString *> m_Buffers;
+};
+
+static cSendBufferPool g_SendBufferPool;
 
 
 
@@ -128,6 +196,39 @@ bool cTCPLinkImpl::Send(const void * a_Data, size_t a_Length)
 
 
 
+bool cTCPLinkImpl::SendOwned(AString & a_Data)
+{
+	if (a_Data.size() < MIN_SEND_OWNED_SIZE)
+	{
+		bool res = Send(a_Data.data(), a_Data.size());
+		a_Data.clear();
+		return res;
+	}
+
+	// Swap the data into a buffer that LibEvent references until it's sent, the caller gets a recycled empty buffer in exchange:
+	AString * Buffer = g_SendBufferPool.Get();
+	std::swap(*Buffer, a_Data);
+	if (evbuffer_add_reference(bufferevent_get_output(m_BufferEvent), Buffer->data(), Buffer->size(), SendOwnedCleanup, Buffer) != 0)
+	{
+		g_SendBufferPool.Release(Buffer);
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+size_t cTCPLinkImpl::GetOutgoingQueueSize(void)
+{
+	return evbuffer_get_length(bufferevent_get_output(m_BufferEvent));
+}
+
+
+
+
+
 void cTCPLinkImpl::Shutdown(void)
 {
 	#ifdef _WIN32
@@ -257,6 +358,17 @@ void cTCPLinkImpl::EventCallback(bufferevent * a_BufferEvent, short a_What, void
 
 
 
+void cTCPLinkImpl::SendOwnedCleanup(const void * a_Data, size_t a_Length, void * a_Buffer)
+{
+	UNUSED(a_Data);
+	UNUSED(a_Length);
+	g_SendBufferPool.Release(static_cast<AString *>(a_Buffer));
+}
+
+
+
+
+
 void cTCPLinkImpl::UpdateAddress(const sockaddr * a_Address, socklen_t a_AddrLen, AString & a_IP, UInt16 & a_Port)
 {
 	// Based on the family specified in the address, use the correct datastructure to convert to IP string:
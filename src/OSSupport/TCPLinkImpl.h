@@ -58,6 +58,8 @@ public:
 
 	// cTCPLink overrides:
 	virtual bool Send(const void * a_Data, size_t a_Length) override;
+	virtual bool SendOwned(AString & a_Data) override;
+	virtual size_t GetOutgoingQueueSize(void) override;
 	virtual AString GetLocalIP(void) const override { return m_LocalIP; }
 	virtual UInt16 GetLocalPort(void) const override { return m_LocalPort; }
 	virtual AString GetRemoteIP(void) const override { return m_RemoteIP; }
@@ -107,6 +109,10 @@ protected:
 	/** Callback that LibEvent calls when there's a non-data-related event on the socket. */
 	static void EventCallback(bufferevent * a_BufferEvent, short a_What, void * a_Self);
 
+	/** Callback that LibEvent calls when it has finished sending a buffer queued by SendOwned().
+	a_Buffer is the AString holding the data, it is returned to the buffer pool. */
+	static void SendOwnedCleanup(const void * a_Data, size_t a_Length, void * a_Buffer);
+
 	/** Sets a_IP and a_Port to values read from a_Address, based on the correct address family. */
 	static void UpdateAddress(const sockaddr * a_Address, socklen_t a_AddrLen, AString & a_IP, UInt16 & a_Port);
 
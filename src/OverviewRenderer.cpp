@@ -0,0 +1,764 @@
+
+// OverviewRenderer.cpp
+
+// Implements the cOverviewRenderer class that renders the top-down overview of the worlds for the webadmin, from the region files
+
+#include "Globals.h"
+#include "OverviewRenderer.h"
+#include "BlockID.h"
+#include "IniFile.h"
+#include "StringCompression.h"
+#include "WorldStorage/FastNBT.h"
+
+
+
+
+
+/** Number of bytes of a single pixel in the tiles (RGBA) */
+static const size_t BYTES_PER_PIXEL = 4;
+
+/** Number of bytes of the raw pixels of a single tile */
+static const size_t TILE_PIXELS_SIZE = cOverviewRenderer::TILE_SIZE * cOverviewRenderer::TILE_SIZE * BYTES_PER_PIXEL;
+
+/** Number of chunks in a region file */
+static const size_t CHUNKS_PER_REGION = cOverviewRenderer::REGION_CHUNKS * cOverviewRenderer::REGION_CHUNKS;
+
+/** Size of the chunk timestamps stored in the header of the zoom-0 tiles, the same layout as in the region file */
+static const size_t TIMESTAMPS_SIZE = CHUNKS_PER_REGION * 4;
+
+/** The zlib compression factor used for the raw tile data */
+static const int TILE_COMPRESSION_FACTOR = 3;
+
+
+
+
+
+/** Appends the number to the string as 4 bytes in the big-endian order, as used by PNG */
+static void AppendUInt32BE(AString & a_Dest, UInt32 a_Value)
+{
+	a_Dest.push_back(static_cast<char>((a_Value >> 24) & 0xff));
+	a_Dest.push_back(static_cast<char>((a_Value >> 16) & 0xff));
+	a_Dest.push_back(static_cast<char>((a_Value >> 8)  & 0xff));
+	a_Dest.push_back(static_cast<char>(a_Value         & 0xff));
+}
+
+
+
+
+
+/** Appends a single PNG chunk (length, type, data and CRC) to the PNG data */
+static void AppendPNGChunk(AString & a_PNG, const char * a_Type, const AString & a_Data)
+{
+	AppendUInt32BE(a_PNG, static_cast<UInt32>(a_Data.size()));
+	size_t TypeStart = a_PNG.size();
+	a_PNG.append(a_Type, 4);
+	a_PNG.append(a_Data);
+	uLong CRC = crc32(0, reinterpret_cast<const Bytef *>(a_PNG.data() + TypeStart), static_cast<uInt>(a_PNG.size() - TypeStart));
+	AppendUInt32BE(a_PNG, static_cast<UInt32>(CRC));
+}
+
+
+
+
+
+/** Encodes the RGBA pixels of a tile as a PNG image. */
+static void EncodePNG(const std::vector<Byte> & a_Pixels, AString & a_PNG)
+{
+	const int Size = cOverviewRenderer::TILE_SIZE;
+	const size_t RowSize = Size * BYTES_PER_PIXEL;
+
+	// Header: size, 8 bits per channel, RGBA, deflate, adaptive filtering, no interlacing
+	AString Header;
+	AppendUInt32BE(Header, Size);
+	AppendUInt32BE(Header, Size);
+	Header.push_back(8);
+	Header.push_back(6);
+	Header.push_back(0);
+	Header.push_back(0);
+	Header.push_back(0);
+
+	// The image data: each row is prefixed with its filter type, the "Sub" filter is used for all rows (compresses well, cheap to compute):
+	AString Filtered;
+	Filtered.reserve(Size * (RowSize + 1));
+	for (int z = 0; z < Size; z++)
+	{
+		const Byte * Row = a_Pixels.data() + z * RowSize;
+		Filtered.push_back(1);
+		for (size_t i = 0; i < RowSize; i++)
+		{
+			Byte Left = (i < BYTES_PER_PIXEL) ? 0 : Row[i - BYTES_PER_PIXEL];
+			Filtered.push_back(static_cast<char>(Row[i] - Left));
+		}
+	}
+	AString Compressed;
+	CompressString(Filtered.data(), Filtered.size(), Compressed, Z_DEFAULT_COMPRESSION);
+
+	static const char Signature[] = "\x89PNG\r\n\x1a\n";
+	a_PNG.assign(Signature, sizeof(Signature) - 1);
+	AppendPNGChunk(a_PNG, "IHDR", Header);
+	AppendPNGChunk(a_PNG, "IDAT", Compressed);
+	AppendPNGChunk(a_PNG, "IEND", AString());
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cOverviewRenderer:
+
+cOverviewRenderer::cOverviewRenderer(void) :
+	super("cOverviewRenderer"),
+	m_IsEnabled(false),
+	m_UpdateInterval(300),
+	m_NumThreads(2),
+	m_MaxZoom(4),
+	m_CacheFolder(FILE_IO_PREFIX "overview"),
+	m_NextRegion(0)
+{
+}
+
+
+
+
+
+cOverviewRenderer::~cOverviewRenderer()
+{
+	StopRendering();
+}
+
+
+
+
+
+void cOverviewRenderer::LoadSettings(cIniFile & a_IniFile)
+{
+	m_IsEnabled      = a_IniFile.GetValueSetB("Overview", "Enabled",        m_IsEnabled);
+	m_UpdateInterval = a_IniFile.GetValueSetI("Overview", "UpdateInterval", m_UpdateInterval);
+	m_NumThreads     = a_IniFile.GetValueSetI("Overview", "NumThreads",     m_NumThreads);
+	m_MaxZoom        = a_IniFile.GetValueSetI("Overview", "MaxZoom",        m_MaxZoom);
+	m_CacheFolder    = a_IniFile.GetValueSet ("Overview", "CacheFolder",    m_CacheFolder);
+
+	m_UpdateInterval = std::max(m_UpdateInterval, 10);
+	m_NumThreads = Clamp(m_NumThreads, 1, 32);
+	m_MaxZoom = Clamp(m_MaxZoom, 0, 16);
+	if (m_CacheFolder.empty() || (m_CacheFolder[m_CacheFolder.size() - 1] != '/'))
+	{
+		m_CacheFolder.push_back('/');
+	}
+}
+
+
+
+
+
+void cOverviewRenderer::StartRendering(const AStringVector & a_WorldNames)
+{
+	if (!m_IsEnabled)
+	{
+		return;
+	}
+	m_WorldNames = a_WorldNames;
+	cFile::CreateFolder(m_CacheFolder);
+	for (AStringVector::const_iterator itr = m_WorldNames.begin(), end = m_WorldNames.end(); itr != end; ++itr)
+	{
+		CreateCacheFolders(*itr);
+	}
+	LOG("Rendering the world overview into \"%s\" every %d seconds, using %d threads", m_CacheFolder.c_str(), m_UpdateInterval, m_NumThreads);
+	Start();
+}
+
+
+
+
+
+void cOverviewRenderer::StopRendering(void)
+{
+	m_ShouldTerminate = true;
+	m_evtTerminate.Set();
+	Stop();
+}
+
+
+
+
+
+bool cOverviewRenderer::GetTile(const AString & a_WorldName, int a_Zoom, int a_TileX, int a_TileZ, AString & a_PNGData, time_t & a_LastModified) const
+{
+	// Only the rendered worlds are allowed, so that the world name cannot be used to reach outside the cache folder:
+	if (
+		(a_Zoom < 0) || (a_Zoom > m_MaxZoom) ||
+		(std::find(m_WorldNames.begin(), m_WorldNames.end(), a_WorldName) == m_WorldNames.end())
+	)
+	{
+		return false;
+	}
+	AString FileName = GetTileFileName(a_WorldName, a_Zoom, a_TileX, a_TileZ) + ".png";
+	a_LastModified = cFile::GetLastModificationTime(FileName);
+	a_PNGData = cFile::ReadWholeFile(FileName);
+	return ((a_LastModified >= 0) && !a_PNGData.empty());
+}
+
+
+
+
+
+void cOverviewRenderer::Execute(void)
+{
+	while (!m_ShouldTerminate)
+	{
+		for (AStringVector::const_iterator itr = m_WorldNames.begin(), end = m_WorldNames.end(); itr != end; ++itr)
+		{
+			if (m_ShouldTerminate)
+			{
+				return;
+			}
+			RenderWorld(*itr);
+		}
+		m_evtTerminate.Wait(static_cast<unsigned>(m_UpdateInterval) * 1000);
+	}
+}
+
+
+
+
+
+void cOverviewRenderer::RenderWorld(const AString & a_WorldName)
+{
+	// List the region files:
+	cRegions Regions;
+	AStringVector Files = cFile::GetFolderContents(FILE_IO_PREFIX + a_WorldName + "/region");
+	for (AStringVector::const_iterator itr = Files.begin(), end = Files.end(); itr != end; ++itr)
+	{
+		sRegion Region;
+		char Dummy;
+		if (sscanf(itr->c_str(), "r.%d.%d.mc%c", &Region.m_RegionX, &Region.m_RegionZ, &Dummy) != 3)
+		{
+			continue;
+		}
+		if (itr->compare(itr->size() - 4, 4, ".mca") != 0)
+		{
+			continue;
+		}
+		Region.m_HasChanged = false;
+		Regions.push_back(Region);
+	}
+	if (Regions.empty())
+	{
+		return;
+	}
+
+	// Render the regions in parallel:
+	m_NextRegion = 0;
+	size_t NumThreads = std::min(static_cast<size_t>(m_NumThreads), Regions.size());
+	std::vector<std::thread> Threads;
+	Threads.reserve(NumThreads - 1);
+	for (size_t i = 1; i < NumThreads; i++)
+	{
+		Threads.push_back(std::thread(&cOverviewRenderer::RenderRegionsThread, this, std::cref(a_WorldName), std::ref(Regions)));
+	}
+	RenderRegionsThread(a_WorldName, Regions);
+	for (std::vector<std::thread>::iterator itr = Threads.begin(), end = Threads.end(); itr != end; ++itr)
+	{
+		itr->join();
+	}
+
+	// Re-compose the higher zoom levels containing the changed regions:
+	cTileCoordsSet Changed;
+	for (cRegions::const_iterator itr = Regions.begin(), end = Regions.end(); itr != end; ++itr)
+	{
+		if (itr->m_HasChanged)
+		{
+			Changed.insert(cTileCoords(itr->m_RegionX, itr->m_RegionZ));
+		}
+	}
+	size_t NumChangedRegions = Changed.size();
+	for (int Zoom = 1; (Zoom <= m_MaxZoom) && !Changed.empty(); Zoom++)
+	{
+		cTileCoordsSet Parents;
+		for (cTileCoordsSet::const_iterator itr = Changed.begin(), end = Changed.end(); itr != end; ++itr)
+		{
+			Parents.insert(cTileCoords(FAST_FLOOR_DIV(itr->first, 2), FAST_FLOOR_DIV(itr->second, 2)));
+		}
+		for (cTileCoordsSet::const_iterator itr = Parents.begin(), end = Parents.end(); itr != end; ++itr)
+		{
+			if (m_ShouldTerminate)
+			{
+				return;
+			}
+			ComposeTile(a_WorldName, Zoom, itr->first, itr->second);
+		}
+		std::swap(Changed, Parents);
+	}
+	if (NumChangedRegions > 0)
+	{
+		LOGD("Overview of world \"%s\": %u of %u regions updated",
+			a_WorldName.c_str(), static_cast<unsigned>(NumChangedRegions), static_cast<unsigned>(Regions.size())
+		);
+	}
+}
+
+
+
+
+
+void cOverviewRenderer::RenderRegionsThread(const AString & a_WorldName, cRegions & a_Regions)
+{
+	while (!m_ShouldTerminate)
+	{
+		size_t Index;
+		{
+			cCSLock Lock(m_CS);
+			if (m_NextRegion >= a_Regions.size())
+			{
+				return;
+			}
+			Index = m_NextRegion++;
+		}
+		sRegion & Region = a_Regions[Index];
+		Region.m_HasChanged = RenderRegion(a_WorldName, Region.m_RegionX, Region.m_RegionZ);
+	}
+}
+
+
+
+
+
+bool cOverviewRenderer::RenderRegion(const AString & a_WorldName, int a_RegionX, int a_RegionZ)
+{
+	// The file is opened read-only and read by this thread alone, the chunks are read directly, without cWSSAnvil::cMCAFile:
+	// The cMCAFile opens the file for writing and treats the reading errors as fatal, while the renderer may see
+	// a chunk that is just being written by the server; such a chunk is simply skipped and re-tried in the next pass.
+	AString RegionFileName = Printf("%s%s/region/r.%d.%d.mca", FILE_IO_PREFIX, a_WorldName.c_str(), a_RegionX, a_RegionZ);
+	cFile File(RegionFileName, cFile::fmRead);
+	if (!File.IsOpen())
+	{
+		return false;
+	}
+	UInt32 Header[2 * CHUNKS_PER_REGION];
+	if (File.Read(Header, sizeof(Header)) != sizeof(Header))
+	{
+		return false;
+	}
+	const UInt32 * Locations = Header;
+	const UInt32 * TimeStamps = Header + CHUNKS_PER_REGION;
+
+	// Load the previously rendered tile, with the timestamps of the rendered chunks:
+	AString TileFileName = GetTileFileName(a_WorldName, 0, a_RegionX, a_RegionZ);
+	AString CachedTimeStamps;
+	cPixels Pixels;
+	LoadTile(TileFileName, CachedTimeStamps, TIMESTAMPS_SIZE, Pixels);
+	UInt32 * CachedTS = reinterpret_cast<UInt32 *>(&CachedTimeStamps[0]);
+
+	bool HasChanged = false;
+	AString ChunkData, Uncompressed;
+	for (int RelZ = 0; RelZ < REGION_CHUNKS; RelZ++)
+	{
+		for (int RelX = 0; RelX < REGION_CHUNKS; RelX++)
+		{
+			size_t Idx = static_cast<size_t>(RelX + RelZ * REGION_CHUNKS);
+			if (CachedTS[Idx] == TimeStamps[Idx])
+			{
+				// Not changed since the last pass (or not present in either)
+				continue;
+			}
+			UInt32 Location = ntohl(Locations[Idx]);
+			UInt32 Offset = Location >> 8;
+			UInt32 NumSectors = Location & 0xff;
+			if ((Location == 0) || (Offset < 2))
+			{
+				// The chunk has been erased from the region file, clear its pixels:
+				for (int z = 0; z < cChunkDef::Width; z++)
+				{
+					size_t PixelIdx = ((RelZ * cChunkDef::Width + z) * TILE_SIZE + RelX * cChunkDef::Width) * BYTES_PER_PIXEL;
+					memset(&Pixels[PixelIdx], 0, cChunkDef::Width * BYTES_PER_PIXEL);
+				}
+				CachedTS[Idx] = TimeStamps[Idx];
+				HasChanged = true;
+				continue;
+			}
+
+			// Read the chunk data:
+			Byte ChunkHeader[5];
+			if (
+				(File.Seek(static_cast<int>(Offset * 4096)) != static_cast<int>(Offset * 4096)) ||
+				(File.Read(ChunkHeader, sizeof(ChunkHeader)) != sizeof(ChunkHeader))
+			)
+			{
+				continue;
+			}
+			UInt32 ChunkSize = (ChunkHeader[0] << 24) | (ChunkHeader[1] << 16) | (ChunkHeader[2] << 8) | ChunkHeader[3];
+			if ((ChunkSize < 2) || (ChunkSize > NumSectors * 4096))
+			{
+				continue;
+			}
+			ChunkData.resize(ChunkSize - 1);
+			if (File.Read(&ChunkData[0], ChunkSize - 1) != static_cast<int>(ChunkSize - 1))
+			{
+				continue;
+			}
+			int res = Z_DATA_ERROR;
+			switch (ChunkHeader[4])
+			{
+				case 1: res = UncompressStringGZIP(ChunkData.data(), ChunkData.size(), Uncompressed); break;
+				case 2: res = InflateString(ChunkData.data(), ChunkData.size(), Uncompressed); break;
+			}
+			if (res != Z_OK)
+			{
+				continue;
+			}
+			cParsedNBT NBT(Uncompressed.data(), Uncompressed.size());
+			if (!NBT.IsValid() || !RenderChunk(NBT, RelX, RelZ, Pixels))
+			{
+				continue;
+			}
+			CachedTS[Idx] = TimeStamps[Idx];
+			HasChanged = true;
+		}  // for RelX
+	}  // for RelZ
+
+	if (HasChanged)
+	{
+		SaveTile(TileFileName, CachedTimeStamps, Pixels);
+	}
+	return HasChanged;
+}
+
+
+
+
+
+void cOverviewRenderer::ComposeTile(const AString & a_WorldName, int a_Zoom, int a_TileX, int a_TileZ)
+{
+	ASSERT(a_Zoom > 0);
+	const int Half = TILE_SIZE / 2;
+	size_t ChildHeaderSize = (a_Zoom == 1) ? TIMESTAMPS_SIZE : 0;
+	cPixels Pixels(TILE_PIXELS_SIZE, 0);
+	cPixels ChildPixels;
+	AString ChildHeader;
+	for (int dz = 0; dz < 2; dz++)
+	{
+		for (int dx = 0; dx < 2; dx++)
+		{
+			if (!LoadTile(GetTileFileName(a_WorldName, a_Zoom - 1, 2 * a_TileX + dx, 2 * a_TileZ + dz), ChildHeader, ChildHeaderSize, ChildPixels))
+			{
+				// The child doesn't exist, leave the quarter transparent
+				continue;
+			}
+
+			// Downscale the child into the quarter, each pixel is the average of the opaque pixels of the 2 * 2 child pixels:
+			for (int z = 0; z < Half; z++)
+			{
+				Byte * Dst = &Pixels[((dz * Half + z) * TILE_SIZE + dx * Half) * BYTES_PER_PIXEL];
+				const Byte * Src = &ChildPixels[(2 * z * TILE_SIZE) * BYTES_PER_PIXEL];
+				for (int x = 0; x < Half; x++, Dst += BYTES_PER_PIXEL, Src += 2 * BYTES_PER_PIXEL)
+				{
+					static const size_t Offsets[] = {0, BYTES_PER_PIXEL, TILE_SIZE * BYTES_PER_PIXEL, (TILE_SIZE + 1) * BYTES_PER_PIXEL};
+					int R = 0, G = 0, B = 0, NumOpaque = 0;
+					for (size_t i = 0; i < ARRAYCOUNT(Offsets); i++)
+					{
+						const Byte * Px = Src + Offsets[i];
+						if (Px[3] != 0)
+						{
+							R += Px[0];
+							G += Px[1];
+							B += Px[2];
+							NumOpaque++;
+						}
+					}
+					if (NumOpaque > 0)
+					{
+						Dst[0] = static_cast<Byte>(R / NumOpaque);
+						Dst[1] = static_cast<Byte>(G / NumOpaque);
+						Dst[2] = static_cast<Byte>(B / NumOpaque);
+						Dst[3] = 0xff;
+					}
+				}  // for x
+			}  // for z
+		}  // for dx
+	}  // for dz
+	SaveTile(GetTileFileName(a_WorldName, a_Zoom, a_TileX, a_TileZ), AString(), Pixels);
+}
+
+
+
+
+
+AString cOverviewRenderer::GetTileFileName(const AString & a_WorldName, int a_Zoom, int a_TileX, int a_TileZ) const
+{
+	return Printf("%s%s/%d/%d.%d", m_CacheFolder.c_str(), a_WorldName.c_str(), a_Zoom, a_TileX, a_TileZ);
+}
+
+
+
+
+
+void cOverviewRenderer::CreateCacheFolders(const AString & a_WorldName)
+{
+	AString WorldFolder = m_CacheFolder + a_WorldName;
+	cFile::CreateFolder(WorldFolder);
+	for (int Zoom = 0; Zoom <= m_MaxZoom; Zoom++)
+	{
+		cFile::CreateFolder(Printf("%s/%d", WorldFolder.c_str(), Zoom));
+	}
+}
+
+
+
+
+
+void cOverviewRenderer::SaveTile(const AString & a_FileName, const AString & a_Header, const cPixels & a_Pixels)
+{
+	ASSERT(a_Pixels.size() == TILE_PIXELS_SIZE);
+
+	AString Raw(a_Header);
+	Raw.append(reinterpret_cast<const char *>(a_Pixels.data()), a_Pixels.size());
+	AString Compressed;
+	if (CompressString(Raw.data(), Raw.size(), Compressed, TILE_COMPRESSION_FACTOR) != Z_OK)
+	{
+		return;
+	}
+	AString PNG;
+	EncodePNG(a_Pixels, PNG);
+	if (!WriteFileAtomic(a_FileName + ".dat", Compressed) || !WriteFileAtomic(a_FileName + ".png", PNG))
+	{
+		LOGWARNING("Cannot write the overview tile \"%s\"", a_FileName.c_str());
+	}
+}
+
+
+
+
+
+bool cOverviewRenderer::LoadTile(const AString & a_FileName, AString & a_Header, size_t a_HeaderSize, cPixels & a_Pixels)
+{
+	AString Compressed = cFile::ReadWholeFile(a_FileName + ".dat");
+	AString Raw;
+	if (
+		!Compressed.empty() &&
+		(UncompressString(Compressed.data(), Compressed.size(), Raw, a_HeaderSize + TILE_PIXELS_SIZE) == Z_OK) &&
+		(Raw.size() == a_HeaderSize + TILE_PIXELS_SIZE)
+	)
+	{
+		a_Header.assign(Raw, 0, a_HeaderSize);
+		a_Pixels.assign(Raw.begin() + static_cast<AString::difference_type>(a_HeaderSize), Raw.end());
+		return true;
+	}
+
+	// The tile doesn't exist or is damaged, start from scratch:
+	a_Header.assign(a_HeaderSize, '\0');
+	a_Pixels.assign(TILE_PIXELS_SIZE, 0);
+	return false;
+}
+
+
+
+
+
+bool cOverviewRenderer::RenderChunk(const cParsedNBT & a_NBT, int a_RelChunkX, int a_RelChunkZ, cPixels & a_Pixels)
+{
+	int Level = a_NBT.FindChildByName(0, "Level");
+	if (Level < 0)
+	{
+		return false;
+	}
+	int Sections = a_NBT.FindChildByName(Level, "Sections");
+	if ((Sections < 0) || (a_NBT.GetType(Sections) != TAG_List))
+	{
+		return false;
+	}
+
+	// Find the block data of the sections present in the chunk, in the MCA-native y / z / x ordering:
+	const int NumSections = cChunkDef::Height / 16;
+	const Byte * SectionBlocks[NumSections];
+	const Byte * SectionMetas[NumSections];
+	memset(SectionBlocks, 0, sizeof(SectionBlocks));
+	memset(SectionMetas,  0, sizeof(SectionMetas));
+	for (int Child = a_NBT.GetFirstChild(Sections); Child >= 0; Child = a_NBT.GetNextSibling(Child))
+	{
+		int SectionY = a_NBT.FindChildByName(Child, "Y");
+		if ((SectionY < 0) || (a_NBT.GetType(SectionY) != TAG_Byte))
+		{
+			continue;
+		}
+		int y = a_NBT.GetByte(SectionY);
+		int Blocks = a_NBT.FindChildByName(Child, "Blocks");
+		int Metas = a_NBT.FindChildByName(Child, "Data");
+		if (
+			(y < 0) || (y >= NumSections) ||
+			(Blocks < 0) || (a_NBT.GetType(Blocks) != TAG_ByteArray) || (a_NBT.GetDataLength(Blocks) != 4096) ||
+			(Metas < 0)  || (a_NBT.GetType(Metas) != TAG_ByteArray)  || (a_NBT.GetDataLength(Metas) != 2048)
+		)
+		{
+			continue;
+		}
+		SectionBlocks[y] = reinterpret_cast<const Byte *>(a_NBT.GetData(Blocks));
+		SectionMetas[y]  = reinterpret_cast<const Byte *>(a_NBT.GetData(Metas));
+	}
+
+	// Find the top block of each column and its color:
+	int Heights[cChunkDef::Width][cChunkDef::Width];
+	UInt32 Colors[cChunkDef::Width][cChunkDef::Width];
+	for (int z = 0; z < cChunkDef::Width; z++)
+	{
+		for (int x = 0; x < cChunkDef::Width; x++)
+		{
+			Heights[z][x] = -1;
+			Colors[z][x] = 0;
+			int WaterDepth = 0;
+			for (int y = cChunkDef::Height - 1; y >= 0; y--)
+			{
+				const Byte * Blocks = SectionBlocks[y / 16];
+				if (Blocks == nullptr)
+				{
+					// Skip the whole missing section, it is all air:
+					y -= y % 16;
+					continue;
+				}
+				int Idx = (y % 16) * 256 + z * 16 + x;
+				BLOCKTYPE BlockType = Blocks[Idx];
+				if (BlockType == E_BLOCK_AIR)
+				{
+					continue;
+				}
+				if ((BlockType == E_BLOCK_WATER) || (BlockType == E_BLOCK_STATIONARY_WATER))
+				{
+					// Look through the water up to 16 blocks deep, the deeper the water, the darker:
+					if (WaterDepth == 0)
+					{
+						Heights[z][x] = y;
+					}
+					if (++WaterDepth < 16)
+					{
+						continue;
+					}
+				}
+				if (WaterDepth > 0)
+				{
+					UInt32 Color = GetBlockColor(E_BLOCK_WATER, 0);
+					int Factor = 256 - WaterDepth * 6;
+					Colors[z][x] = (((((Color >> 16) & 0xff) * Factor) >> 8) << 16) | (((((Color >> 8) & 0xff) * Factor) >> 8) << 8) | (((Color & 0xff) * Factor) >> 8);
+					break;
+				}
+				NIBBLETYPE Meta = (SectionMetas[y / 16][Idx / 2] >> ((Idx & 1) * 4)) & 0x0f;
+				Heights[z][x] = y;
+				Colors[z][x] = GetBlockColor(BlockType, Meta);
+				break;
+			}  // for y
+		}  // for x
+	}  // for z
+
+	// Write the pixels, shaded by the height difference to the column to the north:
+	for (int z = 0; z < cChunkDef::Width; z++)
+	{
+		Byte * Pixel = &a_Pixels[((a_RelChunkZ * cChunkDef::Width + z) * TILE_SIZE + a_RelChunkX * cChunkDef::Width) * BYTES_PER_PIXEL];
+		for (int x = 0; x < cChunkDef::Width; x++, Pixel += BYTES_PER_PIXEL)
+		{
+			if (Heights[z][x] < 0)
+			{
+				// Nothing but air in the column
+				memset(Pixel, 0, BYTES_PER_PIXEL);
+				continue;
+			}
+			int Shade = 256;
+			if (z > 0)
+			{
+				int NorthHeight = Heights[z - 1][x];
+				Shade = (Heights[z][x] > NorthHeight) ? 288 : ((Heights[z][x] < NorthHeight) ? 220 : 256);
+			}
+			UInt32 Color = Colors[z][x];
+			Pixel[0] = static_cast<Byte>(std::min<UInt32>(255, (((Color >> 16) & 0xff) * Shade) >> 8));
+			Pixel[1] = static_cast<Byte>(std::min<UInt32>(255, (((Color >> 8) & 0xff) * Shade) >> 8));
+			Pixel[2] = static_cast<Byte>(std::min<UInt32>(255, ((Color & 0xff) * Shade) >> 8));
+			Pixel[3] = 0xff;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+UInt32 cOverviewRenderer::GetBlockColor(BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta)
+{
+	switch (a_BlockType)
+	{
+		case E_BLOCK_GRASS:             return 0x6b9a3f;
+		case E_BLOCK_TALL_GRASS:        return 0x5f8f34;
+		case E_BLOCK_DIRT:              return 0x866043;
+		case E_BLOCK_FARMLAND:          return 0x734c2d;
+		case E_BLOCK_MYCELIUM:          return 0x6f6369;
+		case E_BLOCK_STONE:             return 0x7d7d7d;
+		case E_BLOCK_COBBLESTONE:       return 0x747474;
+		case E_BLOCK_BEDROCK:           return 0x545454;
+		case E_BLOCK_GRAVEL:            return 0x857f7e;
+		case E_BLOCK_SAND:              return (a_BlockMeta == E_META_SAND_RED) ? 0xa95821 : 0xdbd3a0;
+		case E_BLOCK_SANDSTONE:         return 0xd8cf9b;
+		case E_BLOCK_RED_SANDSTONE:     return 0xa6561e;
+		case E_BLOCK_CLAY:              return 0x9fa4b0;
+		case E_BLOCK_HARDENED_CLAY:     return 0x965c42;
+		case E_BLOCK_STAINED_CLAY:      return 0x9a6b58;
+		case E_BLOCK_SNOW:
+		case E_BLOCK_SNOW_BLOCK:        return 0xf0fbfb;
+		case E_BLOCK_ICE:               return 0x7dadff;
+		case E_BLOCK_PACKED_ICE:        return 0xa0bcf0;
+		case E_BLOCK_WATER:
+		case E_BLOCK_STATIONARY_WATER:  return 0x3050e0;
+		case E_BLOCK_LAVA:
+		case E_BLOCK_STATIONARY_LAVA:   return 0xd45a12;
+		case E_BLOCK_LEAVES:
+		case E_BLOCK_NEW_LEAVES:        return 0x3e6e1e;
+		case E_BLOCK_VINES:             return 0x3a6a1a;
+		case E_BLOCK_LILY_PAD:          return 0x208030;
+		case E_BLOCK_CACTUS:            return 0x107e1d;
+		case E_BLOCK_SUGARCANE:         return 0x94c065;
+		case E_BLOCK_CROPS:             return 0x8c9a32;
+		case E_BLOCK_PUMPKIN:           return 0xc07615;
+		case E_BLOCK_DEAD_BUSH:         return 0x7b5a2c;
+		case E_BLOCK_DANDELION:         return 0xd0d020;
+		case E_BLOCK_FLOWER:            return 0xc02020;
+		case E_BLOCK_LOG:
+		case E_BLOCK_NEW_LOG:           return 0x665132;
+		case E_BLOCK_PLANKS:            return 0x9c7f4e;
+		case E_BLOCK_WOOL:              return 0xdddddd;
+		case E_BLOCK_BRICK:             return 0x976253;
+		case E_BLOCK_STONE_BRICKS:      return 0x7a7a7a;
+		case E_BLOCK_OBSIDIAN:          return 0x14121e;
+		case E_BLOCK_NETHERRACK:        return 0x6f3634;
+		case E_BLOCK_SOULSAND:          return 0x553f33;
+		case E_BLOCK_GLOWSTONE:         return 0xf9d49c;
+		case E_BLOCK_NETHER_BRICK:      return 0x2c161a;
+		case E_BLOCK_QUARTZ_BLOCK:      return 0xece9e2;
+		case E_BLOCK_END_STONE:         return 0xdddfa5;
+	}
+	return 0x8f8f8f;
+}
+
+
+
+
+
+bool cOverviewRenderer::WriteFileAtomic(const AString & a_FileName, const AString & a_Data)
+{
+	AString TempFileName = a_FileName + ".tmp";
+	{
+		cFile File(TempFileName, cFile::fmWrite);
+		if (!File.IsOpen() || (File.Write(a_Data.data(), a_Data.size()) != static_cast<int>(a_Data.size())))
+		{
+			return false;
+		}
+	}
+
+	// Rename fails on some platforms if the destination exists:
+	if (!cFile::Rename(TempFileName, a_FileName))
+	{
+		cFile::Delete(a_FileName);
+		return cFile::Rename(TempFileName, a_FileName);
+	}
+	return true;
+}
+
+
+
+
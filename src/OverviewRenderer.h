@@ -0,0 +1,169 @@
+
+// OverviewRenderer.h
+
+// Declares the cOverviewRenderer class that renders the top-down overview of the worlds for the webadmin, from the region files
+
+/*
+The renderer runs in its own thread and never touches the loaded chunks (cChunkMap); instead it periodically reads
+the region files (<world>/region/r.X.Z.mca) directly, the same files that cWSSAnvil saves the chunks into. The files
+are opened read-only and parsed here, rather than through cWSSAnvil::cMCAFile, because that class opens the files for
+writing and treats any read error as fatal, while the renderer may race the server writing a chunk. Each region
+is rendered into a single 512 * 512 pixel tile at zoom level 0, one pixel per block column; the regions are rendered
+in parallel by several threads. Each higher zoom level halves the resolution, a tile at level N is composed of 2 * 2
+tiles of level N - 1.
+The tiles are cached on disk, in <CacheFolder>/<world>/<zoom>/<X>.<Z>.png, next to a .dat file containing the raw
+pixels (and for zoom level 0 also the timestamps of the chunks, as stored in the region file header). Each pass only
+re-renders the chunks whose timestamp has changed since the last pass, and only re-composes the higher-level tiles
+that contain a changed region. A chunk that cannot be read (for example because the server is just writing it) keeps
+its old timestamp in the cache and is re-tried in the next pass.
+The settings are read from the [Overview] section of webadmin.ini. The tiles are served by cWebAdmin in the
+"/~webadmin/overview/<world>/<zoom>/<X>.<Z>.png" URLs.
+*/
+
+
+
+
+
+#pragma once
+
+#include "OSSupport/IsThread.h"
+
+
+
+
+
+// fwd:
+class cIniFile;
+class cParsedNBT;
+
+
+
+
+
+class cOverviewRenderer :
+	public cIsThread
+{
+	typedef cIsThread super;
+
+public:
+	/** Size of a tile, in pixels; a zoom-0 tile is one region, one pixel per block column */
+	static const int TILE_SIZE = 512;
+
+	/** Number of chunks in a region, along each axis */
+	static const int REGION_CHUNKS = 32;
+
+
+	cOverviewRenderer(void);
+
+	virtual ~cOverviewRenderer();
+
+	/** Reads the settings from the [Overview] section of the (webadmin) ini file, writing the defaults for missing values. */
+	void LoadSettings(cIniFile & a_IniFile);
+
+	/** Starts rendering the specified worlds, if enabled in the settings. */
+	void StartRendering(const AStringVector & a_WorldNames);
+
+	/** Stops the rendering thread; the pass in progress is abandoned after the regions currently being rendered. */
+	void StopRendering(void);
+
+	/** Returns true if the renderer is enabled in the settings. */
+	bool IsEnabled(void) const { return m_IsEnabled; }
+
+	/** Returns the number of seconds between the rendering passes. */
+	int GetUpdateInterval(void) const { return m_UpdateInterval; }
+
+	/** Reads the specified tile from the cache. Returns true and fills in the PNG data and the time when the tile was
+	last written, if the tile exists. Returns false if the tile hasn't been rendered (yet), or the params are invalid. */
+	bool GetTile(const AString & a_WorldName, int a_Zoom, int a_TileX, int a_TileZ, AString & a_PNGData, time_t & a_LastModified) const;
+
+protected:
+	/** The raw pixels of a tile, RGBA, row by row */
+	typedef std::vector<Byte> cPixels;
+
+	/** Coords of a single tile within a zoom level */
+	typedef std::pair<int, int> cTileCoords;
+	typedef std::set<cTileCoords> cTileCoordsSet;
+
+	/** A region being rendered in the current pass */
+	struct sRegion
+	{
+		int m_RegionX;
+		int m_RegionZ;
+
+		/** Set by the worker thread if any of the region's chunks has been re-rendered */
+		bool m_HasChanged;
+	} ;
+
+	typedef std::vector<sRegion> cRegions;
+
+
+	/** If false, the renderer is not started at all */
+	bool m_IsEnabled;
+
+	/** Number of seconds between the starts of two rendering passes */
+	int m_UpdateInterval;
+
+	/** Number of threads rendering the regions in parallel */
+	int m_NumThreads;
+
+	/** The highest zoom level that is rendered */
+	int m_MaxZoom;
+
+	/** The folder where the tiles are cached, with the trailing path separator */
+	AString m_CacheFolder;
+
+	/** The worlds to render */
+	AStringVector m_WorldNames;
+
+	/** Set when the thread should terminate, wakes up the thread waiting between passes */
+	cEvent m_evtTerminate;
+
+	/** Index of the next region in the current pass to be picked by a worker thread; protected by m_CS */
+	size_t m_NextRegion;
+
+	/** Protects m_NextRegion */
+	cCriticalSection m_CS;
+
+
+	// cIsThread overrides:
+	virtual void Execute(void) override;
+
+	/** Renders the changes in the specified world's region files, then re-composes the affected higher zoom levels. */
+	void RenderWorld(const AString & a_WorldName);
+
+	/** The entrypoint of the threads rendering the regions in parallel; renders the regions until none are left. */
+	void RenderRegionsThread(const AString & a_WorldName, cRegions & a_Regions);
+
+	/** Renders the changed chunks of a single region into its zoom-0 tile. Returns true if the tile has changed. */
+	bool RenderRegion(const AString & a_WorldName, int a_RegionX, int a_RegionZ);
+
+	/** Composes the specified tile of zoom level a_Zoom (at least 1) from the four tiles of the level below. */
+	void ComposeTile(const AString & a_WorldName, int a_Zoom, int a_TileX, int a_TileZ);
+
+	/** Returns the path to the specified tile's file in the cache, without the extension. */
+	AString GetTileFileName(const AString & a_WorldName, int a_Zoom, int a_TileX, int a_TileZ) const;
+
+	/** Creates the cache folders for the specified world and all the zoom levels. */
+	void CreateCacheFolders(const AString & a_WorldName);
+
+	/** Writes the tile: the raw data (a_Header followed by the pixels) into the .dat file and the pixels as a .png file. */
+	static void SaveTile(const AString & a_FileName, const AString & a_Header, const cPixels & a_Pixels);
+
+	/** Loads the raw tile data (a_Header followed by the pixels) from the .dat file.
+	If the file doesn't exist or is damaged, a_Header is zero-filled, the pixels are transparent and false is returned. */
+	static bool LoadTile(const AString & a_FileName, AString & a_Header, size_t a_HeaderSize, cPixels & a_Pixels);
+
+	/** Renders a single chunk, parsed from the region file, into the tile pixels at the specified chunk coords
+	relative to the region. Returns false if the NBT data doesn't contain a valid chunk. */
+	static bool RenderChunk(const cParsedNBT & a_NBT, int a_RelChunkX, int a_RelChunkZ, cPixels & a_Pixels);
+
+	/** Returns the color (0xRRGGBB) for the specified top block of a column */
+	static UInt32 GetBlockColor(BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta);
+
+	/** Writes a file atomically, by writing a temporary file first and then renaming it. Returns true on success. */
+	static bool WriteFileAtomic(const AString & a_FileName, const AString & a_Data);
+} ;
+
+
+
+
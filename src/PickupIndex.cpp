@@ -0,0 +1,100 @@
+// PickupIndex.cpp
+
+// Implements the cPickupIndex class that indexes the pickups within a single chunk by their position and item type
+
+#include "Globals.h"
+#include "PickupIndex.h"
+#include "BoundingBox.h"
+#include "Entities/Pickup.h"
+
+
+
+
+
+cPickupIndex::cPickupIndex(void) :
+	m_IsValid(false)
+{
+}
+
+
+
+
+
+void cPickupIndex::Rebuild(const cEntityVector & a_Entities)
+{
+	m_Entries.clear();
+	for (cEntityVector::const_iterator itr = a_Entities.begin(), end = a_Entities.end(); itr != end; ++itr)
+	{
+		if ((*itr == nullptr) || !(*itr)->IsPickup() || (*itr)->IsDestroyed())
+		{
+			continue;
+		}
+		cPickup * Pickup = static_cast<cPickup *>(*itr);
+		sEntry Entry;
+		Entry.m_BucketX = FloorC(Pickup->GetPosX() / BucketSize);
+		Entry.m_BucketY = FloorC(Pickup->GetPosY() / BucketSize);
+		Entry.m_BucketZ = FloorC(Pickup->GetPosZ() / BucketSize);
+		Entry.m_ItemType = Pickup->GetItem().m_ItemType;
+		Entry.m_Pickup = Pickup;
+		m_Entries.push_back(Entry);
+	}
+	std::sort(m_Entries.begin(), m_Entries.end());
+	m_IsValid = true;
+}
+
+
+
+
+
+bool cPickupIndex::ForEachPickupInBox(const cBoundingBox & a_Box, short a_ItemType, cEntityCallback & a_Callback) const
+{
+	ASSERT(m_IsValid);
+	if (m_Entries.empty())
+	{
+		return true;
+	}
+
+	int MinBucketX = FloorC(a_Box.GetMinX() / BucketSize);
+	int MinBucketY = FloorC(a_Box.GetMinY() / BucketSize);
+	int MinBucketZ = FloorC(a_Box.GetMinZ() / BucketSize);
+	int MaxBucketX = FloorC(a_Box.GetMaxX() / BucketSize);
+	int MaxBucketY = FloorC(a_Box.GetMaxY() / BucketSize);
+	int MaxBucketZ = FloorC(a_Box.GetMaxZ() / BucketSize);
+	bool IsAnyType = (a_ItemType == E_ITEM_EMPTY);
+	for (int x = MinBucketX; x <= MaxBucketX; x++)
+	{
+		for (int z = MinBucketZ; z <= MaxBucketZ; z++)
+		{
+			for (int y = MinBucketY; y <= MaxBucketY; y++)
+			{
+				// Find the first entry in the bucket, of the item type if specified:
+				sEntry Key;
+				Key.m_BucketX = x;
+				Key.m_BucketY = y;
+				Key.m_BucketZ = z;
+				Key.m_ItemType = IsAnyType ? std::numeric_limits<short>::min() : a_ItemType;
+				Key.m_Pickup = nullptr;
+				for (cEntries::const_iterator itr = std::lower_bound(m_Entries.begin(), m_Entries.end(), Key), end = m_Entries.end(); itr != end; ++itr)
+				{
+					if (
+						(itr->m_BucketX != x) || (itr->m_BucketZ != z) || (itr->m_BucketY != y) ||
+						(!IsAnyType && (itr->m_ItemType != a_ItemType))
+					)
+					{
+						// Past the bucket / item type
+						break;
+					}
+					if (a_Callback.Item(itr->m_Pickup))
+					{
+						return false;
+					}
+				}  // for itr - m_Entries[]
+			}  // for y
+		}  // for z
+	}  // for x
+	return true;
+}
+
+
+
+
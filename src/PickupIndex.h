@@ -0,0 +1,89 @@
+
+// PickupIndex.h
+
+// Declares the cPickupIndex class that indexes the pickups within a single chunk by their position and item type
+
+
+
+
+
+#pragma once
+
+#include "Entities/Entity.h"
+
+
+
+
+
+// fwd:
+class cPickup;
+class cBoundingBox;
+template <typename T> class cItemCallback;
+typedef cItemCallback<cEntity> cEntityCallback;
+
+
+
+
+
+/** Index of the pickups in a single chunk, bucketed by their position and item type.
+Used by the pickup merging and the hopper collection, so that these don't need to walk all the entities in the chunk.
+The index is a sorted array that the owning chunk rebuilds lazily after it has been invalidated - at the start of each
+chunk tick and whenever a pickup is added to or removed from the chunk. Hence the positions may be slightly out of date
+(the pickups move during the tick), the users need to check the exact position themselves. */
+class cPickupIndex
+{
+public:
+	/** Size of a single bucket, in blocks, in each direction. Divides the chunk width, so that the buckets don't straddle chunks. */
+	static const int BucketSize = 2;
+
+	cPickupIndex(void);
+
+	/** Marks the index as out of date; it will be rebuilt before the next query. */
+	void Invalidate(void) { m_IsValid = false; }
+
+	bool IsValid(void) const { return m_IsValid; }
+
+	/** Rebuilds the index from the pickups in the specified entity list. nullptr slots are skipped. */
+	void Rebuild(const cEntityVector & a_Entities);
+
+	/** Calls the callback for each indexed pickup in the buckets that intersect the specified box.
+	Only the pickups of a_ItemType are processed, unless a_ItemType is E_ITEM_EMPTY, in which case all pickups are processed.
+	Returns true if all pickups processed, false if the callback aborted by returning true. */
+	bool ForEachPickupInBox(const cBoundingBox & a_Box, short a_ItemType, cEntityCallback & a_Callback) const;
+
+protected:
+	/** A single pickup in the index, sorted by the bucket coords and then the item type */
+	struct sEntry
+	{
+		int m_BucketX, m_BucketZ, m_BucketY;
+		short m_ItemType;
+		cPickup * m_Pickup;
+
+		bool operator <(const sEntry & a_Other) const
+		{
+			if (m_BucketX != a_Other.m_BucketX)
+			{
+				return (m_BucketX < a_Other.m_BucketX);
+			}
+			if (m_BucketZ != a_Other.m_BucketZ)
+			{
+				return (m_BucketZ < a_Other.m_BucketZ);
+			}
+			if (m_BucketY != a_Other.m_BucketY)
+			{
+				return (m_BucketY < a_Other.m_BucketY);
+			}
+			return (m_ItemType < a_Other.m_ItemType);
+		}
+	} ;
+
+	typedef std::vector<sEntry> cEntries;
+
+	cEntries m_Entries;
+
+	bool m_IsValid;
+} ;
+
+
+
+
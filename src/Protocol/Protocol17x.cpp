@@ -2438,7 +2438,7 @@ void cProtocol172::ParseItemMetadata(cItem & a_Item, const AString & a_Metadata)
 			{
 				if ((TagName == "ench") || (TagName == "StoredEnchantments"))  // Enchantments tags
 				{
-					EnchantmentSerializer::ParseFromNBT(a_Item.m_Enchantments, NBT, tag);
+					EnchantmentSerializer::ParseFromNBT(a_Item.ModifyEnchantments(), NBT, tag);
 				}
 				break;
 			}
@@ -2450,7 +2450,7 @@ void cProtocol172::ParseItemMetadata(cItem & a_Item, const AString & a_Metadata)
 					{
 						if ((NBT.GetType(displaytag) == TAG_String) && (NBT.GetName(displaytag) == "Name"))  // Custon name tag
 						{
-							a_Item.m_CustomName = NBT.GetString(displaytag);
+							a_Item.SetCustomName(NBT.GetString(displaytag));
 						}
 						else if ((NBT.GetType(displaytag) == TAG_List) && (NBT.GetName(displaytag) == "Lore"))  // Lore tag
 						{
@@ -2461,13 +2461,13 @@ void cProtocol172::ParseItemMetadata(cItem & a_Item, const AString & a_Metadata)
 								AppendPrintf(Lore, "%s`", NBT.GetString(loretag).c_str());  // Append the lore with a grave accent/backtick, used internally by MCS to display a new line in the client; don't forget to c_str ;)
 							}
 
-							a_Item.m_Lore = Lore;
+							a_Item.SetLore(Lore);
 						}
 					}
 				}
 				else if ((TagName == "Fireworks") || (TagName == "Explosion"))
 				{
-					cFireworkItem::ParseFromNBT(a_Item.m_FireworkItem, NBT, tag, (ENUM_ITEM_ID)a_Item.m_ItemType);
+					cFireworkItem::ParseFromNBT(a_Item.ModifyFireworkItem(), NBT, tag, (ENUM_ITEM_ID)a_Item.m_ItemType);
 				}
 				break;
 			}
@@ -2475,7 +2475,7 @@ void cProtocol172::ParseItemMetadata(cItem & a_Item, const AString & a_Metadata)
 			{
 				if (TagName == "RepairCost")
 				{
-					a_Item.m_RepairCost = NBT.GetInt(tag);
+					a_Item.SetRepairCost(NBT.GetInt(tag));
 				}
 			}
 			default: LOGD("Unimplemented NBT data when parsing!"); break;
@@ -2565,7 +2565,7 @@ void cProtocol172::cPacketizer::WriteItem(const cItem & a_Item)
 	WriteChar (a_Item.m_ItemCount);
 	WriteShort(a_Item.m_ItemDamage);
 	
-	if (a_Item.m_Enchantments.IsEmpty() && a_Item.IsBothNameAndLoreEmpty() && (a_Item.m_ItemType != E_ITEM_FIREWORK_ROCKET) && (a_Item.m_ItemType != E_ITEM_FIREWORK_STAR))
+	if (a_Item.GetEnchantments().IsEmpty() && a_Item.IsBothNameAndLoreEmpty() && (a_Item.m_ItemType != E_ITEM_FIREWORK_ROCKET) && (a_Item.m_ItemType != E_ITEM_FIREWORK_STAR))
 	{
 		WriteShort(-1);
 		return;
@@ -2573,27 +2573,27 @@ void cProtocol172::cPacketizer::WriteItem(const cItem & a_Item)
 
 	// Send the enchantments and custom names:
 	cFastNBTWriter Writer;
-	if (a_Item.m_RepairCost != 0)
+	if (a_Item.GetRepairCost() != 0)
 	{
-		Writer.AddInt("RepairCost", a_Item.m_RepairCost);
+		Writer.AddInt("RepairCost", a_Item.GetRepairCost());
 	}
-	if (!a_Item.m_Enchantments.IsEmpty())
+	if (!a_Item.GetEnchantments().IsEmpty())
 	{
 		const char * TagName = (a_Item.m_ItemType == E_ITEM_BOOK) ? "StoredEnchantments" : "ench";
-		EnchantmentSerializer::WriteToNBTCompound(a_Item.m_Enchantments, Writer, TagName);
+		EnchantmentSerializer::WriteToNBTCompound(a_Item.GetEnchantments(), Writer, TagName);
 	}
 	if (!a_Item.IsBothNameAndLoreEmpty())
 	{
 		Writer.BeginCompound("display");
 		if (!a_Item.IsCustomNameEmpty())
 		{
-			Writer.AddString("Name", a_Item.m_CustomName.c_str());
+			Writer.AddString("Name", a_Item.GetCustomName().c_str());
 		}
 		if (!a_Item.IsLoreEmpty())
 		{
 			Writer.BeginList("Lore", TAG_String);
 
-			AStringVector Decls = StringSplit(a_Item.m_Lore, "`");
+			AStringVector Decls = StringSplit(a_Item.GetLore(), "`");
 			for (AStringVector::const_iterator itr = Decls.begin(), end = Decls.end(); itr != end; ++itr)
 			{
 				if (itr->empty())
@@ -2610,7 +2610,7 @@ void cProtocol172::cPacketizer::WriteItem(const cItem & a_Item)
 	}
 	if ((a_Item.m_ItemType == E_ITEM_FIREWORK_ROCKET) || (a_Item.m_ItemType == E_ITEM_FIREWORK_STAR))
 	{
-		cFireworkItem::WriteToNBTCompound(a_Item.m_FireworkItem, Writer, (ENUM_ITEM_ID)a_Item.m_ItemType);
+		cFireworkItem::WriteToNBTCompound(a_Item.GetFireworkItem(), Writer, (ENUM_ITEM_ID)a_Item.m_ItemType);
 	}
 	Writer.Finish();
 
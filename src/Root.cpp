@@ -19,6 +19,10 @@
 #include "LoggerListeners.h"
 #include "BuildInfo.h"
 #include "IniFile.h"
+#include "Metrics.h"
+#include "ClientHandle.h"
+#include "Entities/EntityPool.h"
+#include "ChunkSectionPool.h"
 
 #ifdef _WIN32
 	#include <conio.h>
@@ -33,6 +37,30 @@
 
 
 
+/** Exports cRoot's statistics when the metrics are exported, registered for the duration of cRoot::Start(). */
+class cRootMetricsCollector :
+	public cMetricsRegistry::cCollector
+{
+public:
+	cRootMetricsCollector(cRoot & a_Root) :
+		m_Root(a_Root)
+	{
+	}
+
+	// cMetricsRegistry::cCollector overrides:
+	virtual void Collect(cMetricsWriter & a_Writer) override
+	{
+		m_Root.CollectMetrics(a_Writer);
+	}
+
+protected:
+	cRoot & m_Root;
+} ;
+
+
+
+
+
 cRoot* cRoot::s_Root = nullptr;
 
 
@@ -104,6 +132,7 @@ void cRoot::Start(void)
 	cLogger::cListener * fileLogListener = new cFileListener();
 	cLogger::GetInstance().AttachListener(consoleLogListener);
 	cLogger::GetInstance().AttachListener(fileLogListener);
+	cLogger::GetInstance().StartWriterThread();
 	
 	LOG("--- Started Log ---\n");
 
@@ -135,6 +164,10 @@ void cRoot::Start(void)
 			IniFile.AddHeaderComment(" See: http://wiki.mc-server.org/doku.php?id=configure:settings.ini for further configuration help");
 		}
 
+		// The chunk section pool is shared by all the worlds, it needs to be set up before any chunk is loaded:
+		cChunkSectionPool::Get().SetUseHugePages(IniFile.GetValueSetB("Memory", "ChunkSectionHugePages", false));
+		cUnloadGovernor::SetMemoryBudget(static_cast<Int64>(IniFile.GetValueSetI("Memory", "ChunkMemoryBudgetMiB", 0)) * 1024 * 1024);
+
 		LOG("Starting server...");
 		m_MojangAPI = new cMojangAPI;
 		bool ShouldAuthenticate = IniFile.GetValueSetB("Authentication", "Authenticate", true);
@@ -181,8 +214,10 @@ void cRoot::Start(void)
 		IniFile.WriteFile("settings.ini");
 
 		LOGD("Finalising startup...");
+		cRootMetricsCollector MetricsCollector(*this);
 		if (m_Server->Start())
 		{
+			cMetricsRegistry::Get().AddCollector(&MetricsCollector);
 			m_WebAdmin->Start();
 
 			#if !defined(ANDROID_NDK)
@@ -215,6 +250,7 @@ void cRoot::Start(void)
 
 			// Stop the server:
 			m_WebAdmin->Stop();
+			cMetricsRegistry::Get().RemoveCollector(&MetricsCollector);
 
 			LOG("Shutting down server...");
 			m_Server->Shutdown();
@@ -259,6 +295,7 @@ void cRoot::Start(void)
 	
 	LOG("--- Stopped Log ---");
 	
+	cLogger::GetInstance().StopWriterThread();
 	cLogger::GetInstance().DetachListener(consoleLogListener);
 	delete consoleLogListener;
 	cLogger::GetInstance().DetachListener(fileLogListener);
@@ -812,6 +849,9 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 		a_Output.Out("  Num chunks in generator queue: %d", NumInGenerator);
 		a_Output.Out("  Num chunks in storage load queue: %d", NumInLoadQueue);
 		a_Output.Out("  Num chunks in storage save queue: %d", NumInSaveQueue);
+		World->GetAutosaveScheduler().LogStats(a_Output);
+		World->GetUnloadGovernor().LogStats(a_Output);
+		World->GetGenerator().LogCacheStats(a_Output);
 		int Mem = NumValid * sizeof(cChunk);
 		a_Output.Out("  Memory used by chunks: %d KiB (%d MiB)", (Mem + 1023) / 1024, (Mem + 1024 * 1024 - 1) / (1024 * 1024));
 		a_Output.Out("  Per-chunk memory size breakdown:");
@@ -832,6 +872,159 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 	a_Output.Out("  Num chunks in lighting queue: %d", SumNumInLighting);
 	a_Output.Out("  Num chunks in generator queue: %d", SumNumInGenerator);
 	a_Output.Out("  Memory used by chunks: %d KiB (%d MiB)", (SumMem + 1023) / 1024, (SumMem + 1024 * 1024 - 1) / (1024 * 1024));
+	cChunkSectionPool::Get().LogStats(a_Output);
+	Int64 ChunkMemory = cUnloadGovernor::GetChunkMemory();
+	a_Output.Out("  Estimated chunk memory: %d MiB", static_cast<int>((ChunkMemory + 1024 * 1024 - 1) / (1024 * 1024)));
+}
+
+
+
+
+
+void cRoot::CollectMetrics(cMetricsWriter & a_Writer)
+{
+	/** The statistics of a single world, all of them are read first because each family's samples must be written together */
+	struct sWorldStats
+	{
+		AString m_Label;
+		int m_NumValid;
+		int m_NumDirty;
+		int m_NumInLighting;
+		int m_NumInGenerator;
+		size_t m_NumInLoadQueue;
+		size_t m_NumInSaveQueue;
+		int m_NumCached;
+		int m_NumLimitedPlayers;
+		int m_NumEntities[cEntity::etPainting + 1];
+	} ;
+
+	/** Counts the world's entities by their type */
+	class cEntityCounter :
+		public cEntityCallback
+	{
+	public:
+		cEntityCounter(int * a_NumEntities) :
+			m_NumEntities(a_NumEntities)
+		{
+		}
+
+		virtual bool Item(cEntity * a_Entity) override
+		{
+			m_NumEntities[a_Entity->GetEntityType()] += 1;
+			return false;
+		}
+
+	protected:
+		int * m_NumEntities;
+	} ;
+
+	std::vector<sWorldStats> AllStats;
+	for (WorldMap::iterator itr = m_WorldsByName.begin(), end = m_WorldsByName.end(); itr != end; ++itr)
+	{
+		cWorld * World = itr->second;
+		sWorldStats Stats;
+		Stats.m_Label = cMetricsWriter::Label("world", World->GetName());
+		World->GetChunkStats(Stats.m_NumValid, Stats.m_NumDirty, Stats.m_NumInLighting);
+		Stats.m_NumInGenerator = World->GetGeneratorQueueLength();
+		Stats.m_NumInLoadQueue = World->GetStorageLoadQueueLength();
+		Stats.m_NumInSaveQueue = World->GetStorageSaveQueueLength();
+		Stats.m_NumCached = World->GetUnloadGovernor().GetNumCachedChunks();
+		Stats.m_NumLimitedPlayers = World->GetUnloadGovernor().GetNumLimitedPlayers();
+		std::fill(Stats.m_NumEntities, Stats.m_NumEntities + ARRAYCOUNT(Stats.m_NumEntities), 0);
+		cEntityCounter Counter(Stats.m_NumEntities);
+		World->ForEachEntity(Counter);
+		AllStats.push_back(Stats);
+	}
+
+	// Writes one family of per-world gauges:
+	#define WRITE_WORLD_GAUGE(Name, Help, Member) \
+		a_Writer.BeginFamily(Name, Help, "gauge"); \
+		for (std::vector<sWorldStats>::const_iterator itr = AllStats.begin(), end = AllStats.end(); itr != end; ++itr) \
+		{ \
+			a_Writer.Sample(Name, itr->m_Label, static_cast<Int64>(itr->Member)); \
+		}
+
+	WRITE_WORLD_GAUGE("mcserver_chunks_loaded",             "Number of chunks loaded",                     m_NumValid);
+	WRITE_WORLD_GAUGE("mcserver_chunks_dirty",              "Number of loaded chunks waiting to be saved", m_NumDirty);
+	WRITE_WORLD_GAUGE("mcserver_lighting_queue_length",     "Number of chunks in the lighting queue",      m_NumInLighting);
+	WRITE_WORLD_GAUGE("mcserver_generator_queue_length",    "Number of chunks in the generator queue",     m_NumInGenerator);
+	WRITE_WORLD_GAUGE("mcserver_storage_load_queue_length", "Number of chunks in the storage load queue",  m_NumInLoadQueue);
+	WRITE_WORLD_GAUGE("mcserver_storage_save_queue_length", "Number of chunks in the storage save queue",  m_NumInSaveQueue);
+	WRITE_WORLD_GAUGE("mcserver_chunks_cached",             "Number of unused chunks kept loaded",         m_NumCached);
+	WRITE_WORLD_GAUGE("mcserver_players_view_limited",      "Number of idle players with limited view",    m_NumLimitedPlayers);
+
+	#undef WRITE_WORLD_GAUGE
+
+	// The entity counts, by world and type:
+	static const char * EntityTypeNames[] =
+	{
+		"other", "ender_crystal", "player", "pickup", "monster", "falling_block", "minecart",
+		"boat", "tnt", "projectile", "exp_orb", "floater", "item_frame", "painting",
+	};
+	static_assert(ARRAYCOUNT(EntityTypeNames) == cEntity::etPainting + 1, "The entity type names don't match eEntityType");
+	a_Writer.BeginFamily("mcserver_entities", "Number of entities, by type", "gauge");
+	for (std::vector<sWorldStats>::const_iterator itr = AllStats.begin(), end = AllStats.end(); itr != end; ++itr)
+	{
+		for (size_t i = 0; i < ARRAYCOUNT(EntityTypeNames); i++)
+		{
+			if (itr->m_NumEntities[i] > 0)
+			{
+				a_Writer.Sample("mcserver_entities", cMetricsWriter::JoinLabels(itr->m_Label, cMetricsWriter::Label("type", EntityTypeNames[i])), static_cast<Int64>(itr->m_NumEntities[i]));
+			}
+		}
+	}
+
+	// The per-client network traffic:
+	class cClientTraffic :
+		public cPlayerListCallback
+	{
+	public:
+		std::vector<std::pair<AString, cClientHandlePtr>> m_Clients;
+
+		virtual bool Item(cPlayer * a_Player) override
+		{
+			cClientHandlePtr Client = a_Player->GetClientHandlePtr();
+			if (Client != nullptr)
+			{
+				m_Clients.push_back(std::make_pair(cMetricsWriter::Label("player", a_Player->GetName()), Client));
+			}
+			return false;
+		}
+	} Traffic;
+	ForEachPlayer(Traffic);
+	a_Writer.BeginFamily("mcserver_players_online", "Number of players online", "gauge");
+	a_Writer.Sample("mcserver_players_online", "", static_cast<UInt64>(Traffic.m_Clients.size()));
+	a_Writer.BeginFamily("mcserver_client_bytes_sent_total", "Number of bytes sent to each player's client", "counter");
+	for (std::vector<std::pair<AString, cClientHandlePtr>>::const_iterator itr = Traffic.m_Clients.begin(), end = Traffic.m_Clients.end(); itr != end; ++itr)
+	{
+		a_Writer.Sample("mcserver_client_bytes_sent_total", itr->first, itr->second->GetNumBytesSent());
+	}
+	a_Writer.BeginFamily("mcserver_client_bytes_received_total", "Number of bytes received from each player's client", "counter");
+	for (std::vector<std::pair<AString, cClientHandlePtr>>::const_iterator itr = Traffic.m_Clients.begin(), end = Traffic.m_Clients.end(); itr != end; ++itr)
+	{
+		a_Writer.Sample("mcserver_client_bytes_received_total", itr->first, itr->second->GetNumBytesReceived());
+	}
+
+	// The process-wide statistics:
+	a_Writer.BeginFamily("mcserver_physical_memory_kibibytes", "Physical memory used by the server process, in KiB", "gauge");
+	a_Writer.Sample("mcserver_physical_memory_kibibytes", "", static_cast<Int64>(GetPhysicalRAMUsage()));
+	cEntityPoolBase::CollectMetrics(a_Writer);
+	cChunkSectionPool::Get().CollectMetrics(a_Writer);
+	a_Writer.BeginFamily("mcserver_chunk_memory_bytes", "Estimated memory used by the chunks of all the worlds, in bytes", "gauge");
+	a_Writer.Sample("mcserver_chunk_memory_bytes", "", cUnloadGovernor::GetChunkMemory());
+}
+
+
+
+
+
+void cRoot::LogEntityTrackingStats(cCommandOutputCallback & a_Output)
+{
+	for (WorldMap::iterator itr = m_WorldsByName.begin(), end = m_WorldsByName.end(); itr != end; ++itr)
+	{
+		a_Output.Out("World %s:", itr->second->GetName().c_str());
+		itr->second->GetEntityTracker().LogStats(a_Output);
+	}
 }
 
 
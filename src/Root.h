@@ -24,6 +24,7 @@ class cWorld;
 class cPlayer;
 class cCommandOutputCallback;
 class cCompositeChat;
+class cMetricsWriter;
 
 typedef cItemCallback<cPlayer> cPlayerListCallback;
 typedef cItemCallback<cWorld>  cWorldListCallback;
@@ -74,6 +75,12 @@ public:
 	
 	/// Writes chunkstats, for each world and totals, to the output callback
 	void LogChunkStats(cCommandOutputCallback & a_Output);
+
+	/** Writes the entity tracking statistics, for each world, to the output callback */
+	void LogEntityTrackingStats(cCommandOutputCallback & a_Output);
+
+	/** Writes the server's state (chunk, queue, entity and player statistics) as metric families, for the metrics export. */
+	void CollectMetrics(cMetricsWriter & a_Writer);
 	
 	cMonsterConfig * GetMonsterConfig(void) { return m_MonsterConfig; }
 
@@ -17,6 +17,8 @@
 #include "WebAdmin.h"
 #include "Protocol/ProtocolRecognizer.h"
 #include "CommandOutput.h"
+#include "Benchmarks.h"
+#include "Entities/EntityPool.h"
 
 #include "IniFile.h"
 #include "Vector3.h"
@@ -330,6 +332,10 @@ bool cServer::Tick(float a_Dt)
 	// Tick all clients not yet assigned to a world:
 	TickClients(a_Dt);
 
+	// Collect the plugins' garbage now, rather than letting the collector kick in during the callbacks.
+	// This is the thread that loads and unloads the plugins, so the plugin list cannot change meanwhile:
+	cPluginManager::Get()->StepPluginsGC();
+
 	if (!m_bRestarting)
 	{
 		return true;
@@ -532,6 +538,36 @@ void cServer::ExecuteConsoleCommand(const AString & a_Cmd, cCommandOutputCallbac
 		a_Output.Finished();
 		return;
 	}
+	else if (split[0].compare("entitytracking") == 0)
+	{
+		cRoot::Get()->LogEntityTrackingStats(a_Output);
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0].compare("entitypools") == 0)
+	{
+		cEntityPoolBase::LogStats(a_Output);
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0].compare("hookstats") == 0)
+	{
+		cPluginManager::Get()->LogHookStats(a_Output);
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0].compare("pluginmem") == 0)
+	{
+		cPluginManager::Get()->LogMemoryStats(a_Output);
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0].compare("benchmark") == 0)
+	{
+		cBenchmarks::Run(split, a_Output);
+		a_Output.Finished();
+		return;
+	}
 	#if defined(_MSC_VER) && defined(_DEBUG) && defined(ENABLE_LEAK_FINDER)
 	else if (split[0].compare("dumpmem") == 0)
 	{
@@ -614,6 +650,11 @@ void cServer::BindBuiltInConsoleCommands(void)
 	PlgMgr->BindConsoleCommand("restart", nullptr, " - Restarts the server cleanly");
 	PlgMgr->BindConsoleCommand("stop", nullptr, " - Stops the server cleanly");
 	PlgMgr->BindConsoleCommand("chunkstats", nullptr, " - Displays detailed chunk memory statistics");
+	PlgMgr->BindConsoleCommand("entitypools", nullptr, " - Displays the allocation statistics of the pooled entities");
+	PlgMgr->BindConsoleCommand("entitytracking", nullptr, " - Displays the entity movement updates sent and the bandwidth saved by the distance-based rates");
+	PlgMgr->BindConsoleCommand("hookstats", nullptr, " - Displays the number of calls and the time spent in each plugin hook");
+	PlgMgr->BindConsoleCommand("pluginmem", nullptr, " - Displays the Lua memory usage and garbage collection statistics of each plugin");
+	PlgMgr->BindConsoleCommand("benchmark <name> [world]", nullptr, " - Runs the specified in-server benchmark; lists the benchmarks if no name given");
 	PlgMgr->BindConsoleCommand("load <pluginname>", nullptr, " - Adds and enables the specified plugin");
 	PlgMgr->BindConsoleCommand("unload <pluginname>", nullptr, " - Disables the specified plugin");
 	PlgMgr->BindConsoleCommand("destroyentities", nullptr, " - Destroys all entities in all worlds");
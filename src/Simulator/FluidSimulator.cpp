@@ -2,6 +2,7 @@
 
 #include "FluidSimulator.h"
 #include "../World.h"
+#include "../ChunkCursor.h"
 
 
 
@@ -124,7 +125,8 @@ Direction cFluidSimulator::GetFlowingDirection(int a_X, int a_Y, int a_Z, bool a
 	{
 		return NONE;
 	}
-	BLOCKTYPE BlockID = m_World.GetBlock(a_X, a_Y, a_Z);
+	cChunkCursor Cursor(m_World);
+	BLOCKTYPE BlockID = Cursor.GetBlock(a_X, a_Y, a_Z);
 	if (!IsAllowedBlock(BlockID))  // No Fluid -> No Flowing direction :D
 	{
 		return NONE;
@@ -139,10 +141,10 @@ Direction cFluidSimulator::GetFlowingDirection(int a_X, int a_Y, int a_Z, bool a
 	}
 	*/
 
-	NIBBLETYPE LowestPoint = m_World.GetBlockMeta(a_X, a_Y, a_Z);  // Current Block Meta so only lower points will be counted
+	NIBBLETYPE LowestPoint = Cursor.GetBlockMeta(a_X, a_Y, a_Z);  // Current Block Meta so only lower points will be counted
 	int X = 0, Z = 0;  // Lowest Pos will be stored here
 
-	if (IsAllowedBlock(m_World.GetBlock(a_X, a_Y + 1, a_Z)) && a_Over)  // check for upper block to flow because this also affects the flowing direction
+	if (IsAllowedBlock(Cursor.GetBlock(a_X, a_Y + 1, a_Z)) && a_Over)  // check for upper block to flow because this also affects the flowing direction
 	{
 		return GetFlowingDirection(a_X, a_Y + 1, a_Z, false);
 	}
@@ -160,10 +162,10 @@ Direction cFluidSimulator::GetFlowingDirection(int a_X, int a_Y, int a_Z, bool a
 	for (std::vector<Vector3i *>::iterator it = Points.begin(); it < Points.end(); ++it)
 	{
 		Vector3i *Pos = (*it);
-		char BlockID = m_World.GetBlock(Pos->x, Pos->y, Pos->z);
+		char BlockID = Cursor.GetBlock(Pos->x, Pos->y, Pos->z);
 		if (IsAllowedBlock(BlockID))
 		{
-			char Meta = m_World.GetBlockMeta(Pos->x, Pos->y, Pos->z);
+			char Meta = Cursor.GetBlockMeta(Pos->x, Pos->y, Pos->z);
 
 			if (Meta > LowestPoint)
 			{
@@ -183,7 +185,7 @@ Direction cFluidSimulator::GetFlowingDirection(int a_X, int a_Y, int a_Z, bool a
 		Pos = nullptr;
 	}
 
-	if (LowestPoint == m_World.GetBlockMeta(a_X, a_Y, a_Z))
+	if (LowestPoint == Cursor.GetBlockMeta(a_X, a_Y, a_Z))
 	{
 		return NONE;
 	}
@@ -3,6 +3,7 @@
 
 #include "Tracer.h"
 #include "World.h"
+#include "ChunkCursor.h"
 
 #include "Entities/Entity.h"
 
@@ -167,6 +168,8 @@ bool cTracer::Trace(const Vector3f & a_Start, const Vector3f & a_Direction, int
 
 	bool reachedX = false, reachedY = false, reachedZ = false;
 
+	// The trace visits neighboring blocks, read them through a single cursor instead of querying the world for each:
+	cChunkCursor Cursor(*m_World);
 	int Iterations = 0;
 	while (Iterations < a_Distance)
 	{
@@ -232,13 +235,13 @@ bool cTracer::Trace(const Vector3f & a_Start, const Vector3f & a_Direction, int
 		{
 			return false;
 		}
-		BLOCKTYPE BlockID = m_World->GetBlock(pos.x, pos.y, pos.z);
+		BLOCKTYPE BlockID = Cursor.GetBlock(pos.x, pos.y, pos.z);
 		// Block is counted as a collision if we are not doing a line of sight and it is solid,
 		// or if the block is not air and not water. That way mobs can still see underwater.
 		if ((!a_LineOfSight && cBlockInfo::IsSolid(BlockID)) || (a_LineOfSight && (BlockID != E_BLOCK_AIR) && !IsBlockWater(BlockID)))
 		{
 			BlockHitPosition = pos;
-			int Normal = GetHitNormal(a_Start, End, pos);
+			int Normal = GetHitNormal(a_Start, End, pos, BlockID);
 			if (Normal > 0)
 			{
 				HitNormal = m_NormalTable[Normal-1];
@@ -324,12 +327,11 @@ int cTracer::intersect3D_SegmentPlane(const Vector3f & a_Origin, const Vector3f
 
 
 
-int cTracer::GetHitNormal(const Vector3f & start, const Vector3f & end, const Vector3i & a_BlockPos)
+int cTracer::GetHitNormal(const Vector3f & start, const Vector3f & end, const Vector3i & a_BlockPos, BLOCKTYPE a_BlockType)
 {
 	Vector3i SmallBlockPos = a_BlockPos;
-	char BlockID = m_World->GetBlock(a_BlockPos.x, a_BlockPos.y, a_BlockPos.z);
 
-	if ((BlockID == E_BLOCK_AIR) || IsBlockWater(BlockID))
+	if ((a_BlockType == E_BLOCK_AIR) || IsBlockWater(a_BlockType))
 	{
 		return 0;
 	}
@@ -59,7 +59,8 @@ private:
 	/// Determines which face on the block a collision occured, if it does occur
 	/// Returns 0 if the block is air, water or no collision occured
 	/// Return 1 through 6 for the following block faces, repectively: -x, -z, x, z, y, -y
-	int GetHitNormal( const Vector3f & start, const Vector3f & end, const Vector3i &  a_BlockPos);
+	/// a_BlockType is the type of the block at a_BlockPos, as already read by the caller
+	int GetHitNormal( const Vector3f & start, const Vector3f & end, const Vector3i &  a_BlockPos, BLOCKTYPE a_BlockType);
 
 	float SigNum( float a_Num);
 	cWorld* m_World;
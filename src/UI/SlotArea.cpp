@@ -1061,14 +1061,14 @@ void cSlotAreaAnvil::UpdateResult(cPlayer & a_Player)
 
 	m_MaximumCost = 0;
 	m_StackSizeToBeUsedInRepair = 0;
-	int RepairCost = Input.m_RepairCost;
+	int RepairCost = Input.GetRepairCost();
 	int NeedExp = 0;
 	bool IsEnchantBook = false;
 	if (!SecondInput.IsEmpty())
 	{
 		IsEnchantBook = (SecondInput.m_ItemType == E_ITEM_ENCHANTED_BOOK);
 		
-		RepairCost += SecondInput.m_RepairCost;
+		RepairCost += SecondInput.GetRepairCost();
 		if (Input.IsDamageable() && cItemHandler::GetItemHandler(Input)->CanRepairWithRawMaterial(SecondInput.m_ItemType))
 		{
 			// Tool and armor repair with special item (iron / gold / diamond / ...)
@@ -1086,7 +1086,7 @@ void cSlotAreaAnvil::UpdateResult(cPlayer & a_Player)
 			while ((DamageDiff > 0) && (x < SecondInput.m_ItemCount))
 			{
 				Input.m_ItemDamage -= DamageDiff;
-				NeedExp += std::max(1, DamageDiff / 100) + (int)Input.m_Enchantments.Count();
+				NeedExp += std::max(1, DamageDiff / 100) + (int)Input.GetEnchantments().Count();
 				DamageDiff = std::min((int)Input.m_ItemDamage, (int)Input.GetMaxDamage() / 4);
 
 				++x;
@@ -1133,25 +1133,25 @@ void cSlotAreaAnvil::UpdateResult(cPlayer & a_Player)
 	if (RepairedItemName.empty())
 	{
 		// Remove custom name
-		if (!Input.m_CustomName.empty())
+		if (!Input.GetCustomName().empty())
 		{
 			NameChangeExp = (Input.IsDamageable()) ? 7 : (Input.m_ItemCount * 5);
 			NeedExp += NameChangeExp;
-			Input.m_CustomName = "";
+			Input.SetCustomName("");
 		}
 	}
-	else if (RepairedItemName != Input.m_CustomName)
+	else if (RepairedItemName != Input.GetCustomName())
 	{
 		// Change custom name
 		NameChangeExp = (Input.IsDamageable()) ? 7 : (Input.m_ItemCount * 5);
 		NeedExp += NameChangeExp;
 
-		if (!Input.m_CustomName.empty())
+		if (!Input.GetCustomName().empty())
 		{
 			RepairCost += NameChangeExp / 2;
 		}
 
-		Input.m_CustomName = RepairedItemName;
+		Input.SetCustomName(RepairedItemName);
 	}
 
 	// TODO: Add enchantment exp cost.
@@ -1174,14 +1174,14 @@ void cSlotAreaAnvil::UpdateResult(cPlayer & a_Player)
 
 	if (!Input.IsEmpty())
 	{
-		RepairCost = std::max(Input.m_RepairCost, SecondInput.m_RepairCost);
-		if (!Input.m_CustomName.empty())
+		RepairCost = std::max(Input.GetRepairCost(), SecondInput.GetRepairCost());
+		if (!Input.GetCustomName().empty())
 		{
 			RepairCost -= 9;
 		}
 		RepairCost = std::max(RepairCost, 0);
 		RepairCost += 2;
-		Input.m_RepairCost = RepairCost;
+		Input.SetRepairCost(RepairCost);
 	}
 
 	SetSlot(2, a_Player, Input);
@@ -1562,7 +1562,7 @@ void cSlotAreaEnchanting::UpdateResult(cPlayer & a_Player)
 {
 	cItem Item = *GetSlot(0, a_Player);
 
-	if (cItem::IsEnchantable(Item.m_ItemType) && Item.m_Enchantments.IsEmpty())
+	if (cItem::IsEnchantable(Item.m_ItemType) && Item.GetEnchantments().IsEmpty())
 	{
 		int Bookshelves = std::min(GetBookshelvesCount(a_Player.GetWorld()), 15);
 
@@ -0,0 +1,331 @@
+
+// UnloadGovernor.cpp
+
+// Implements the cUnloadGovernor class that unloads the unused chunks of a world, keeping the chunk memory within a budget
+
+#include "Globals.h"
+#include "UnloadGovernor.h"
+#include "World.h"
+#include "ChunkMap.h"
+#include "Chunk.h"
+#include "ChunkSectionPool.h"
+#include "ClientHandle.h"
+#include "CommandOutput.h"
+#include "IniFile.h"
+#include "Root.h"
+#include "AutosaveScheduler.h"
+#include "Entities/Player.h"
+
+
+
+
+
+/** Number of world ticks between two passes */
+static const Int64 TICKS_PER_PASS = 20;
+
+/** The memory budget for the chunks of all the worlds, in bytes; 0 means no budget */
+static std::atomic<Int64> s_MemoryBudget(0);
+
+/** True while the chunk memory is above the budget and hasn't yet dropped below the low watermark */
+static std::atomic<bool> s_IsUnderPressure(false);
+
+
+
+
+
+/** Returns true if the chunk can be unloaded now, or queued for saving; false if it is already being saved. */
+static bool IsNotSaving(const sUnloadCandidate & a_Candidate)
+{
+	return !a_Candidate.m_IsSaving;
+}
+
+
+
+
+
+/** Returns true if a_First was last used before a_Second, i.e. a_First should be unloaded first. */
+static bool IsLessRecentlyUsed(const sUnloadCandidate & a_First, const sUnloadCandidate & a_Second)
+{
+	return (a_First.m_UnusedSince < a_Second.m_UnusedSince);
+}
+
+
+
+
+
+cUnloadGovernor::cUnloadGovernor(cWorld & a_World, cChunkMap & a_ChunkMap) :
+	m_World(a_World),
+	m_ChunkMap(a_ChunkMap),
+	m_CacheTicks(300 * 20),
+	m_IdleTicks(300 * 20),
+	m_IdleViewDistance(4),
+	m_LastPassTick(0),
+	m_NumCachedChunks(0),
+	m_NumUnloadedLastPass(0),
+	m_NumQueuedForSaveLastPass(0),
+	m_NumUnloadedUnderPressure(0),
+	m_NumUnloadedTotal(0)
+{
+}
+
+
+
+
+
+void cUnloadGovernor::LoadSettings(cIniFile & a_IniFile)
+{
+	int CacheSeconds   = a_IniFile.GetValueSetI("Memory", "UnusedChunkCacheSeconds", 300);
+	int IdleSeconds    = a_IniFile.GetValueSetI("Memory", "IdlePlayerSeconds",       300);
+	m_IdleViewDistance = a_IniFile.GetValueSetI("Memory", "IdlePlayerViewDistance",  m_IdleViewDistance);
+
+	m_CacheTicks = static_cast<Int64>(std::max(CacheSeconds, 0)) * 20;
+	m_IdleTicks = static_cast<Int64>(std::max(IdleSeconds, 1)) * 20;
+	m_IdleViewDistance = Clamp(m_IdleViewDistance, static_cast<int>(cClientHandle::MIN_VIEW_DISTANCE), static_cast<int>(cClientHandle::MAX_VIEW_DISTANCE));
+}
+
+
+
+
+
+void cUnloadGovernor::Tick(Int64 a_WorldAge)
+{
+	if (a_WorldAge - m_LastPassTick < TICKS_PER_PASS)
+	{
+		return;
+	}
+	m_LastPassTick = a_WorldAge;
+	RunPass(a_WorldAge);
+}
+
+
+
+
+
+void cUnloadGovernor::LogStats(cCommandOutputCallback & a_Output)
+{
+	a_Output.Out("  Unloading: %d unused chunks cached, %d unloaded and %d queued for saving in the last pass; %llu unloaded in total, %llu of them under memory pressure",
+		m_NumCachedChunks, m_NumUnloadedLastPass, m_NumQueuedForSaveLastPass, m_NumUnloadedTotal, m_NumUnloadedUnderPressure
+	);
+	a_Output.Out("  Unloading: cache time %d seconds, %d idle players limited to view distance %d",
+		static_cast<int>(m_CacheTicks / 20), GetNumLimitedPlayers(), m_IdleViewDistance
+	);
+}
+
+
+
+
+
+void cUnloadGovernor::SetMemoryBudget(Int64 a_Budget)
+{
+	s_MemoryBudget.store(std::max<Int64>(a_Budget, 0));
+}
+
+
+
+
+
+Int64 cUnloadGovernor::GetChunkMemory(void)
+{
+	Int64 SectionMemory = static_cast<Int64>(cChunkSectionPool::Get().GetUsedMemory());
+	Int64 NumChunks = static_cast<Int64>(cRoot::Get()->GetTotalChunkCount());
+	return SectionMemory + NumChunks * static_cast<Int64>(sizeof(cChunk));
+}
+
+
+
+
+
+void cUnloadGovernor::RunPass(Int64 a_WorldAge)
+{
+	cUnloadCandidates Candidates;
+	m_ChunkMap.CollectUnloadCandidates(Candidates);
+	size_t NumUnused = Candidates.size();
+
+	// The chunks queued for saving by the previous passes cannot be unloaded nor queued again until they are saved:
+	cUnloadCandidates::iterator SavingStart = std::partition(Candidates.begin(), Candidates.end(), IsNotSaving);
+	size_t NumSaving = static_cast<size_t>(Candidates.end() - SavingStart);
+	Candidates.erase(SavingStart, Candidates.end());
+
+	// The chunks unused for longer than the cache time are unloaded regardless of the pressure:
+	size_t NumToUnload = 0;
+	for (cUnloadCandidates::const_iterator itr = Candidates.begin(), end = Candidates.end(); itr != end; ++itr)
+	{
+		if (a_WorldAge - itr->m_UnusedSince >= m_CacheTicks)
+		{
+			NumToUnload += 1;
+		}
+	}
+
+	// Under pressure, unload this world's share of the excess memory, assuming the memory is spread evenly over the chunks.
+	// The chunks being saved will be unloaded once saved, their memory is already on its way out:
+	Int64 Memory, Excess;
+	bool IsUnderPressure = CheckPressure(Memory, Excess);
+	size_t NumOld = NumToUnload;
+	if (IsUnderPressure && (Excess > 0) && (Memory > 0))
+	{
+		Int64 NumWorldChunks = m_ChunkMap.GetNumChunks();
+		size_t NumExcess = static_cast<size_t>((Excess * NumWorldChunks + Memory - 1) / Memory);
+		NumExcess = (NumExcess > NumSaving) ? (NumExcess - NumSaving) : 0;
+		NumToUnload = std::max(NumToUnload, NumExcess);
+	}
+	NumToUnload = std::min(NumToUnload, Candidates.size());
+
+	// Pick the least recently used chunks:
+	std::partial_sort(Candidates.begin(), Candidates.begin() + static_cast<ptrdiff_t>(NumToUnload), Candidates.end(), IsLessRecentlyUsed);
+
+	// Unload the clean chunks right away, queue the dirty ones for saving, a later pass unloads them once saved:
+	cUnloadCandidates ToUnload;
+	cAutosaveCandidates ToSave;
+	for (size_t i = 0; i < NumToUnload; i++)
+	{
+		const sUnloadCandidate & Candidate = Candidates[i];
+		if (!Candidate.m_IsDirty)
+		{
+			ToUnload.push_back(Candidate);
+			continue;
+		}
+		sAutosaveCandidate Save;
+		Save.m_ChunkX = Candidate.m_ChunkX;
+		Save.m_ChunkZ = Candidate.m_ChunkZ;
+		Save.m_DirtySince = Candidate.m_DirtySince;
+		Save.m_IsUnused = true;
+		ToSave.push_back(Save);
+	}
+	m_NumUnloadedLastPass = ToUnload.empty() ? 0 : m_ChunkMap.UnloadChunks(ToUnload);
+	m_NumQueuedForSaveLastPass = ToSave.empty() ? 0 : m_ChunkMap.QueueChunksForSave(ToSave);
+
+	// Update the statistics:
+	m_NumCachedChunks = static_cast<int>(NumUnused) - m_NumUnloadedLastPass;
+	m_NumUnloadedTotal += static_cast<UInt64>(m_NumUnloadedLastPass);
+	if (NumToUnload > NumOld)
+	{
+		// Only count the chunks that wouldn't have been unloaded without the pressure:
+		size_t NumUnloaded = static_cast<size_t>(m_NumUnloadedLastPass);
+		m_NumUnloadedUnderPressure += static_cast<UInt64>(std::min(NumUnloaded, NumToUnload - NumOld));
+	}
+
+	UpdatePlayers(a_WorldAge, IsUnderPressure);
+}
+
+
+
+
+
+void cUnloadGovernor::UpdatePlayers(Int64 a_WorldAge, bool a_IsUnderPressure)
+{
+	class cCallback :
+		public cPlayerListCallback
+	{
+	public:
+		cCallback(cUnloadGovernor & a_Governor, Int64 a_WorldAge, bool a_IsUnderPressure) :
+			m_Governor(a_Governor),
+			m_WorldAge(a_WorldAge),
+			m_IsUnderPressure(a_IsUnderPressure)
+		{
+		}
+
+		virtual bool Item(cPlayer * a_Player) override
+		{
+			int ID = a_Player->GetUniqueID();
+			m_Seen.insert(ID);
+
+			// Update the player's activity; any movement or looking around counts:
+			cPlayerActivities::iterator itr = m_Governor.m_PlayerActivities.find(ID);
+			bool IsNew = (itr == m_Governor.m_PlayerActivities.end());
+			sPlayerActivity & Activity = m_Governor.m_PlayerActivities[ID];
+			if (
+				IsNew ||
+				(Activity.m_PosX != a_Player->GetPosX()) ||
+				(Activity.m_PosY != a_Player->GetPosY()) ||
+				(Activity.m_PosZ != a_Player->GetPosZ()) ||
+				(Activity.m_Yaw != a_Player->GetYaw()) ||
+				(Activity.m_Pitch != a_Player->GetPitch())
+			)
+			{
+				Activity.m_PosX = a_Player->GetPosX();
+				Activity.m_PosY = a_Player->GetPosY();
+				Activity.m_PosZ = a_Player->GetPosZ();
+				Activity.m_Yaw = a_Player->GetYaw();
+				Activity.m_Pitch = a_Player->GetPitch();
+				Activity.m_LastActive = m_WorldAge;
+			}
+
+			cClientHandle * Client = a_Player->GetClientHandle();
+			if (Client == nullptr)
+			{
+				return false;
+			}
+			bool IsIdle = (m_WorldAge - Activity.m_LastActive >= m_Governor.m_IdleTicks);
+			bool IsLimited = (m_Governor.m_LimitedPlayers.find(ID) != m_Governor.m_LimitedPlayers.end());
+			if (m_IsUnderPressure && IsIdle)
+			{
+				if (!IsLimited)
+				{
+					Client->SetViewDistanceLimit(m_Governor.m_IdleViewDistance);
+					m_Governor.m_LimitedPlayers.insert(ID);
+				}
+			}
+			else if (IsLimited)
+			{
+				Client->SetViewDistanceLimit(cClientHandle::MAX_VIEW_DISTANCE);
+				m_Governor.m_LimitedPlayers.erase(ID);
+			}
+			return false;
+		}
+
+		cUnloadGovernor & m_Governor;
+		Int64 m_WorldAge;
+		bool m_IsUnderPressure;
+
+		/** IDs of the players found in the world in this pass */
+		std::set<int> m_Seen;
+	} Callback(*this, a_WorldAge, a_IsUnderPressure);
+	m_World.ForEachPlayer(Callback);
+
+	// Forget the players who have left the world; their limit has been lifted by cClientHandle::RemoveFromWorld():
+	for (cPlayerActivities::iterator itr = m_PlayerActivities.begin(); itr != m_PlayerActivities.end();)
+	{
+		if (Callback.m_Seen.find(itr->first) == Callback.m_Seen.end())
+		{
+			m_LimitedPlayers.erase(itr->first);
+			itr = m_PlayerActivities.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+
+
+
+
+bool cUnloadGovernor::CheckPressure(Int64 & a_Memory, Int64 & a_Excess)
+{
+	a_Memory = 0;
+	a_Excess = 0;
+	Int64 Budget = s_MemoryBudget.load();
+	if (Budget <= 0)
+	{
+		s_IsUnderPressure.store(false);
+		return false;
+	}
+
+	a_Memory = GetChunkMemory();
+	Int64 LowWatermark = Budget / 100 * LOW_WATERMARK_PERCENT;
+	a_Excess = a_Memory - LowWatermark;
+	if (a_Memory > Budget)
+	{
+		s_IsUnderPressure.store(true);
+	}
+	else if (a_Memory < LowWatermark)
+	{
+		s_IsUnderPressure.store(false);
+	}
+	return s_IsUnderPressure.load();
+}
+
+
+
+
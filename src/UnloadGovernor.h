@@ -0,0 +1,160 @@
+
+// UnloadGovernor.h
+
+// Declares the cUnloadGovernor class that unloads the unused chunks of a world, keeping the chunk memory within a budget
+
+/*
+A chunk that no client nor chunkstay uses is not unloaded right away; it is kept as a cache, so that a player
+returning to the area gets it instantly instead of waiting for the storage. Once per second the governor
+unloads the chunks that have been unused for longer than the cache time, least recently used first.
+The memory taken by all the worlds' chunks is compared against the budget ([Memory] ChunkMemoryBudgetMiB in
+settings.ini, 0 means no budget). When the memory goes over the budget, the server is under memory pressure until
+the memory drops below LOW_WATERMARK_PERCENT of the budget. Under pressure, each world unloads its share of the excess
+from its least recently used chunks, regardless of the cache time; the dirty ones are queued for saving first and
+unloaded by a later pass once saved. If that isn't enough, the idle players' view distance is lowered, so that they
+release the chunks on the edge of their view; the limit is lifted as soon as the player moves or the pressure ends.
+The chunk memory is the memory of the sections used in the cChunkSectionPool plus the overhead of the slabs holding
+them, plus the fixed size of each cChunk. The free sections and the reserve slabs are not counted, so that each
+unloaded chunk lowers the reading right away, even if its slab stays mapped for the other chunks. The unused chunks
+that are already queued for saving, or being saved, count towards the excess: their memory is released by a later
+pass, once they are saved, so they don't make each pass pick yet more chunks.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+// fwd:
+class cWorld;
+class cChunkMap;
+class cCommandOutputCallback;
+class cIniFile;
+
+
+
+
+
+/** A single unused chunk that can be unloaded, as reported by cChunkMap::CollectUnloadCandidates() */
+struct sUnloadCandidate
+{
+	int m_ChunkX;
+	int m_ChunkZ;
+
+	/** The world age (in ticks) when the chunk was last used */
+	Int64 m_UnusedSince;
+
+	/** The world age (in ticks) when the chunk was first modified since the last save; only valid if m_IsDirty */
+	Int64 m_DirtySince;
+
+	/** True if the chunk needs saving before it can be unloaded */
+	bool m_IsDirty;
+
+	/** True if the chunk is queued for saving or being saved, it cannot be unloaded before that finishes */
+	bool m_IsSaving;
+} ;
+
+typedef std::vector<sUnloadCandidate> cUnloadCandidates;
+
+
+
+
+
+/** Unloads the unused chunks by their age and the memory pressure, see the comment at the top of this file. */
+class cUnloadGovernor
+{
+public:
+	/** Under pressure, the chunks are unloaded until the memory drops below this percentage of the budget */
+	static const int LOW_WATERMARK_PERCENT = 90;
+
+
+	cUnloadGovernor(cWorld & a_World, cChunkMap & a_ChunkMap);
+
+	/** Reads the settings from the [Memory] section of the world's ini file, writing the defaults for missing values. */
+	void LoadSettings(cIniFile & a_IniFile);
+
+	/** Called by the world in each tick; runs a pass once per second. */
+	void Tick(Int64 a_WorldAge);
+
+	/** Outputs the governor's statistics, used by the "chunkstats" console command. */
+	void LogStats(cCommandOutputCallback & a_Output);
+
+	/** Returns the number of unused chunks currently kept loaded as the cache, as of the last pass. */
+	int GetNumCachedChunks(void) const { return m_NumCachedChunks; }
+
+	/** Returns the number of players whose view distance is currently limited. */
+	int GetNumLimitedPlayers(void) const { return static_cast<int>(m_LimitedPlayers.size()); }
+
+	/** Sets the memory budget for the chunks of all the worlds, in bytes; 0 means no budget. */
+	static void SetMemoryBudget(Int64 a_Budget);
+
+	/** Returns the estimated memory taken by the chunks of all the worlds, in bytes: the used sections with their slab
+	overhead, plus the chunk headers. */
+	static Int64 GetChunkMemory(void);
+
+protected:
+	/** The activity tracking of a single player, for detecting the idle players */
+	struct sPlayerActivity
+	{
+		double m_PosX, m_PosY, m_PosZ;
+		double m_Yaw, m_Pitch;
+
+		/** The world age when the player last moved or looked around */
+		Int64 m_LastActive;
+	} ;
+
+	typedef std::map<int, sPlayerActivity> cPlayerActivities;
+
+
+	cWorld & m_World;
+	cChunkMap & m_ChunkMap;
+
+	/** The unused chunks are kept loaded for this many ticks, unless under memory pressure */
+	Int64 m_CacheTicks;
+
+	/** A player is considered idle after not moving for this many ticks */
+	Int64 m_IdleTicks;
+
+	/** The view distance limit for the idle players under memory pressure */
+	int m_IdleViewDistance;
+
+	/** The world age at which the last pass was run */
+	Int64 m_LastPassTick;
+
+	/** The activity of the players in the world, by their entity ID */
+	cPlayerActivities m_PlayerActivities;
+
+	/** The entity IDs of the players whose view distance has been limited */
+	std::set<int> m_LimitedPlayers;
+
+	// Statistics from the last pass:
+	int m_NumCachedChunks;
+	int m_NumUnloadedLastPass;
+	int m_NumQueuedForSaveLastPass;
+
+	/** Total number of chunks unloaded because of the memory pressure since the start */
+	UInt64 m_NumUnloadedUnderPressure;
+
+	/** Total number of chunks unloaded since the start */
+	UInt64 m_NumUnloadedTotal;
+
+
+	/** Runs a single pass: unloads the old and, under pressure, the least recently used chunks and limits the idle players. */
+	void RunPass(Int64 a_WorldAge);
+
+	/** Updates the players' activity and lowers or lifts their view distance limit based on the pressure. */
+	void UpdatePlayers(Int64 a_WorldAge, bool a_IsUnderPressure);
+
+	/** Returns true if the server is under memory pressure, updating the pressure state shared by all the worlds.
+	a_Memory is set to the current chunk memory, a_Excess to the memory above the low watermark (may be negative). */
+	static bool CheckPressure(Int64 & a_Memory, Int64 & a_Excess);
+} ;
+
+
+
+
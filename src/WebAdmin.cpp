@@ -14,6 +14,8 @@
 
 #include "HTTPServer/HTTPMessage.h"
 #include "HTTPServer/HTTPConnection.h"
+#include "StringCompression.h"
+#include "Metrics.h"
 
 
 
@@ -21,6 +23,12 @@
 
 static const char DEFAULT_WEBADMIN_PORTS[] = "8080";
 
+/** The static files larger than this are read from the disk on each request, instead of being cached */
+static const int MAX_CACHED_FILE_SIZE = 1024 * 1024;
+
+/** The content smaller than this is not worth compressing */
+static const size_t MIN_GZIP_SIZE = 256;
+
 
 
 
@@ -55,7 +63,8 @@ public:
 cWebAdmin::cWebAdmin(void) :
 	m_IsInitialized(false),
 	m_IsRunning(false),
-	m_TemplateScript("<webadmin_template>")
+	m_TemplateScript("<webadmin_template>"),
+	m_PageCacheTTL(2)
 {
 }
 
@@ -143,6 +152,9 @@ bool cWebAdmin::Init(void)
 	// Note that historically the ports were stored in the "Port" and "PortsIPv6" values
 	m_Ports = ReadUpgradeIniPorts(m_IniFile, "WebAdmin", "Ports", "Port", "PortsIPv6", DEFAULT_WEBADMIN_PORTS);
 
+	m_PageCacheTTL = std::max(m_IniFile.GetValueSetI("WebAdmin", "PageCacheTTL", m_PageCacheTTL), 0);
+	m_OverviewRenderer.LoadSettings(m_IniFile);
+
 	if (!m_HTTPServer.Initialize())
 	{
 		return false;
@@ -167,6 +179,23 @@ bool cWebAdmin::Start(void)
 	LOGD("Starting WebAdmin...");
 
 	m_IsRunning = m_HTTPServer.Start(*this, m_Ports);
+	if (m_IsRunning)
+	{
+		// Start rendering the overview of all the worlds:
+		class cWorldNamesCallback :
+			public cWorldListCallback
+		{
+			virtual bool Item(cWorld * a_World) override
+			{
+				m_WorldNames.push_back(a_World->GetName());
+				return false;
+			}
+		public:
+			AStringVector m_WorldNames;
+		} WorldNames;
+		cRoot::Get()->ForEachWorld(WorldNames);
+		m_OverviewRenderer.StartRendering(WorldNames.m_WorldNames);
+	}
 	return m_IsRunning;
 }
 
@@ -182,6 +211,7 @@ void cWebAdmin::Stop(void)
 	}
 	
 	LOGD("Stopping WebAdmin...");
+	m_OverviewRenderer.StopRendering();
 	m_HTTPServer.Stop();
 	m_IsRunning = false;
 }
@@ -228,6 +258,18 @@ void cWebAdmin::HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPReque
 		return;
 	}
 
+	// The overview tiles are served directly from the renderer's cache:
+	if (strncmp(a_Request.GetURL().c_str(), "/~webadmin/overview/", 20) == 0)
+	{
+		HandleOverviewRequest(a_Connection, a_Request);
+		return;
+	}
+	if (a_Request.GetBareURL() == "/~webadmin/metrics")
+	{
+		HandleMetricsRequest(a_Connection, a_Request);
+		return;
+	}
+
 	// Check if the contents should be wrapped in the template:
 	AString BareURL = a_Request.GetBareURL();
 	ASSERT(BareURL.length() > 0);
@@ -241,6 +283,23 @@ void cWebAdmin::HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPReque
 		return;
 	}
 
+	// Only the plain GET requests may be served from the page cache, the others may have side effects (form posts, action params):
+	AString CacheKey;
+	if ((a_Request.GetMethod() == "GET") && (a_Request.GetURL().find('?') == AString::npos) && (m_PageCacheTTL > 0))
+	{
+		CacheKey = a_Request.GetAuthUsername() + ":" + a_Request.GetURL();
+		if (SendCachedPage(a_Connection, a_Request, CacheKey))
+		{
+			return;
+		}
+	}
+	else
+	{
+		// The request may change what the pages show, drop all the cached pages:
+		cCSLock Lock(m_CSCache);
+		m_CachedPages.clear();
+	}
+
 	// Wrap it all up for the Lua call:
 	AString Template;
 	HTTPTemplateRequest TemplateRequest;
@@ -279,10 +338,7 @@ void cWebAdmin::HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPReque
 	{
 		if (m_TemplateScript.Call("ShowPage", this, &TemplateRequest, cLuaState::Return, Template))
 		{
-			cHTTPResponse Resp;
-			Resp.SetContentType("text/html");
-			a_Connection.Send(Resp);
-			a_Connection.Send(Template.c_str(), Template.length());
+			SendPage(a_Connection, a_Request, Template, CacheKey);
 			return;
 		}
 		a_Connection.SendStatusAndReason(500, "m_TemplateScript failed");
@@ -338,10 +394,61 @@ void cWebAdmin::HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPReque
 	Printf(NumChunks, "%d", cRoot::Get()->GetTotalChunkCount());
 	ReplaceString(Template, "{NUMCHUNKS}", NumChunks);
 
+	SendPage(a_Connection, a_Request, Template, CacheKey);
+}
+
+
+
+
+
+void cWebAdmin::HandleOverviewRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request)
+{
+	// Parse the "/~webadmin/overview/<world>/<zoom>/<X>.<Z>.png" URL:
+	AStringVector Split = StringSplit(URLDecode(a_Request.GetBareURL().substr(20)), "/");
+	int Zoom = 0, TileX = 0, TileZ = 0;
+	char Dummy;
+	if (
+		(Split.size() != 3) ||
+		!StringToInteger(Split[1], Zoom) ||
+		(sscanf(Split[2].c_str(), "%d.%d.pn%c", &TileX, &TileZ, &Dummy) != 3)
+	)
+	{
+		a_Connection.SendStatusAndReason(400, "Bad Request");
+		return;
+	}
+
+	AString PNGData;
+	time_t LastModified;
+	if (!m_OverviewRenderer.GetTile(Split[0], Zoom, TileX, TileZ, PNGData, LastModified))
+	{
+		a_Connection.SendStatusAndReason(404, "Not Found");
+		return;
+	}
+
+	// The tiles change at most once per rendering pass, let the browsers cache them for that long:
+	char LastModifiedStr[64];
+	strftime(LastModifiedStr, sizeof(LastModifiedStr), "%a, %d %b %Y %H:%M:%S GMT", gmtime(&LastModified));
 	cHTTPResponse Resp;
-	Resp.SetContentType("text/html");
+	Resp.SetContentType("image/png");
+	Resp.AddHeader("Cache-Control", Printf("max-age=%d", m_OverviewRenderer.GetUpdateInterval()));
+	Resp.AddHeader("Last-Modified", LastModifiedStr);
 	a_Connection.Send(Resp);
-	a_Connection.Send(Template.c_str(), Template.length());
+	a_Connection.Send(PNGData);
+	a_Connection.FinishResponse();
+}
+
+
+
+
+
+void cWebAdmin::HandleMetricsRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request)
+{
+	// The metrics are gathered anew for each request, they must never be served from a cache:
+	static const char ContentType[] = "text/plain; version=0.0.4";
+	AString Content = cMetricsRegistry::Get().Export();
+	AString GzippedContent, ETag;
+	PrepareContent(ContentType, Content, GzippedContent, ETag);
+	SendContent(a_Connection, a_Request, ContentType, Content, GzippedContent, ETag, "no-store");
 }
 
 
@@ -381,34 +488,181 @@ void cWebAdmin::HandleFileRequest(cHTTPConnection & a_Connection, cHTTPRequest &
 	// Remove all "../" strings:
 	ReplaceString(FileURL, "../", "");
 
-	bool LoadedSuccessfull = false;
-	AString Content = "<h2>404 Not Found</h2>";
 	AString Path = Printf(FILE_IO_PREFIX "webadmin/files/%s", FileURL.c_str());
-	if (cFile::IsFile(Path))
+	cStaticFilePtr File = GetStaticFile(Path);
+	if (File == nullptr)
+	{
+		cHTTPResponse Resp;
+		Resp.SetContentType("text/html");
+		a_Connection.Send(Resp);
+		a_Connection.Send("<h2>404 Not Found</h2>");
+		a_Connection.FinishResponse();
+		return;
+	}
+
+	// The files rarely change, let the browsers use their copy for a while before revalidating it using the ETag:
+	SendContent(a_Connection, a_Request, File->m_ContentType, File->m_Content, File->m_GzippedContent, File->m_ETag, "max-age=60");
+}
+
+
+
+
+
+cWebAdmin::cStaticFilePtr cWebAdmin::GetStaticFile(const AString & a_Path)
+{
+	time_t ModificationTime = cFile::GetLastModificationTime(a_Path);
+	int Size = cFile::GetSize(a_Path);
+	if ((ModificationTime < 0) || (Size < 0) || !cFile::IsFile(a_Path))
+	{
+		return nullptr;
+	}
+
+	// Use the cached copy, if the file hasn't changed since it was read:
 	{
-		cFile File(Path, cFile::fmRead);
-		AString FileContent;
-		if (File.IsOpen() && (File.ReadRestOfFile(FileContent) != -1))
+		cCSLock Lock(m_CSCache);
+		cStaticFiles::const_iterator itr = m_StaticFiles.find(a_Path);
+		if ((itr != m_StaticFiles.end()) && (itr->second->m_ModificationTime == ModificationTime) && (itr->second->m_Size == Size))
 		{
-			LoadedSuccessfull = true;
-			Content = FileContent;
+			return itr->second;
 		}
 	}
 
-	// Find content type (The currently method is very bad. We should change it later)
-	AString ContentType = "text/html";
-	size_t LastPointPosition = Path.find_last_of('.');
-	if (LoadedSuccessfull && (LastPointPosition != AString::npos) && (LastPointPosition < Path.length()))
+	// Read the file:
+	std::shared_ptr<sStaticFile> File = std::make_shared<sStaticFile>();
+	cFile f(a_Path, cFile::fmRead);
+	if (!f.IsOpen() || (f.ReadRestOfFile(File->m_Content) == -1))
 	{
-		AString FileExtension = Path.substr(LastPointPosition + 1);
-		ContentType = GetContentTypeFromFileExt(FileExtension);
+		return nullptr;
+	}
+	File->m_ModificationTime = ModificationTime;
+	File->m_Size = Size;
+	File->m_ContentType = "text/html";
+	size_t LastPointPosition = a_Path.find_last_of('.');
+	if (LastPointPosition != AString::npos)
+	{
+		File->m_ContentType = GetContentTypeFromFileExt(a_Path.substr(LastPointPosition + 1));
+	}
+	PrepareContent(File->m_ContentType, File->m_Content, File->m_GzippedContent, File->m_ETag);
+
+	if (Size <= MAX_CACHED_FILE_SIZE)
+	{
+		cCSLock Lock(m_CSCache);
+		m_StaticFiles[a_Path] = File;
+	}
+	return File;
+}
+
+
+
+
+
+bool cWebAdmin::SendCachedPage(cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const AString & a_CacheKey)
+{
+	cCachedPagePtr Page;
+	{
+		cCSLock Lock(m_CSCache);
+		cCachedPages::const_iterator itr = m_CachedPages.find(a_CacheKey);
+		if ((itr == m_CachedPages.end()) || (itr->second->m_ExpireTime < std::chrono::steady_clock::now()))
+		{
+			return false;
+		}
+		Page = itr->second;
+	}
+	SendContent(a_Connection, a_Request, "text/html", Page->m_Content, Page->m_GzippedContent, Page->m_ETag, "private, no-cache");
+	return true;
+}
+
+
+
+
+
+void cWebAdmin::SendPage(cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const AString & a_Content, const AString & a_CacheKey)
+{
+	std::shared_ptr<sCachedPage> Page = std::make_shared<sCachedPage>();
+	Page->m_Content = a_Content;
+	PrepareContent("text/html", Page->m_Content, Page->m_GzippedContent, Page->m_ETag);
+	SendContent(a_Connection, a_Request, "text/html", Page->m_Content, Page->m_GzippedContent, Page->m_ETag, "private, no-cache");
+	if (a_CacheKey.empty())
+	{
+		return;
+	}
+
+	// Store the page in the cache, dropping the expired pages:
+	std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+	Page->m_ExpireTime = Now + std::chrono::seconds(m_PageCacheTTL);
+	cCSLock Lock(m_CSCache);
+	for (cCachedPages::iterator itr = m_CachedPages.begin(); itr != m_CachedPages.end();)
+	{
+		if (itr->second->m_ExpireTime < Now)
+		{
+			itr = m_CachedPages.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+	m_CachedPages[a_CacheKey] = Page;
+}
+
+
+
+
+
+void cWebAdmin::PrepareContent(const AString & a_ContentType, const AString & a_Content, AString & a_GzippedContent, AString & a_ETag)
+{
+	uLong CRC = crc32(0, reinterpret_cast<const Bytef *>(a_Content.data()), static_cast<uInt>(a_Content.size()));
+	a_ETag = Printf("\"%08lx-" SIZE_T_FMT_HEX "\"", static_cast<unsigned long>(CRC), a_Content.size());
+
+	// Only the text formats are worth compressing, the images are compressed already:
+	a_GzippedContent.clear();
+	bool IsCompressible = (
+		(a_ContentType.compare(0, 5, "text/") == 0) ||
+		(a_ContentType.find("javascript") != AString::npos) ||
+		(a_ContentType.find("json") != AString::npos) ||
+		(a_ContentType.find("xml") != AString::npos)
+	);
+	if (IsCompressible && (a_Content.size() >= MIN_GZIP_SIZE))
+	{
+		if (CompressStringGZIP(a_Content.data(), a_Content.size(), a_GzippedContent) != Z_OK)
+		{
+			a_GzippedContent.clear();
+		}
+	}
+}
+
+
+
+
+
+void cWebAdmin::SendContent(
+	cHTTPConnection & a_Connection, cHTTPRequest & a_Request,
+	const AString & a_ContentType, const AString & a_Content, const AString & a_GzippedContent,
+	const AString & a_ETag, const AString & a_CacheControl
+)
+{
+	// The compressed variant has its own ETag, so that the caches don't mix the two:
+	bool ShouldGzip = (!a_GzippedContent.empty() && a_Request.DoesAcceptGzip());
+	AString ETag = ShouldGzip ? (a_ETag.substr(0, a_ETag.size() - 1) + "-gz\"") : a_ETag;
+
+	AString IfNoneMatch = a_Request.GetHeader("If-None-Match");
+	if (!IfNoneMatch.empty() && ((IfNoneMatch.find(ETag) != AString::npos) || (IfNoneMatch == "*")))
+	{
+		a_Connection.SendNotModified(ETag);
+		return;
 	}
 
-	// Send the response:
 	cHTTPResponse Resp;
-	Resp.SetContentType(ContentType);
+	Resp.SetContentType(a_ContentType);
+	Resp.AddHeader("ETag", ETag);
+	Resp.AddHeader("Cache-Control", a_CacheControl);
+	Resp.AddHeader("Vary", "Accept-Encoding");
+	if (ShouldGzip)
+	{
+		Resp.AddHeader("Content-Encoding", "gzip");
+	}
 	a_Connection.Send(Resp);
-	a_Connection.Send(Content);
+	a_Connection.Send(ShouldGzip ? a_GzippedContent : a_Content);
 	a_Connection.FinishResponse();
 }
 
@@ -498,7 +752,15 @@ AString cWebAdmin::GetDefaultPage(void)
 		{
 			continue;
 		}
-		AppendPrintf(Content, "<li>%s V.%i</li>", itr->second->GetName().c_str(), itr->second->GetVersion());
+		AString MemoryStats = itr->second->GetMemoryStats();
+		if (MemoryStats.empty())
+		{
+			AppendPrintf(Content, "<li>%s V.%i</li>", itr->second->GetName().c_str(), itr->second->GetVersion());
+		}
+		else
+		{
+			AppendPrintf(Content, "<li>%s V.%i<br/><small>Lua memory: %s</small></li>", itr->second->GetName().c_str(), itr->second->GetVersion(), MemoryStats.c_str());
+		}
 	}
 	Content += "</ul>";
 	Content += "<h4>Players:</h4><ul>";
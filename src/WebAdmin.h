@@ -9,6 +9,7 @@
 #include "IniFile.h"
 #include "HTTPServer/HTTPServer.h"
 #include "HTTPServer/HTTPFormParser.h"
+#include "OverviewRenderer.h"
 
 
 
@@ -200,6 +201,38 @@ protected:
 		virtual void OnFileEnd(cHTTPFormParser &) override {}
 	} ;
 
+	/** A static file cached in memory; revalidated against the file's size and modification time on each request */
+	struct sStaticFile
+	{
+		AString m_Content;
+
+		/** The gzip-compressed content; empty if the content is not worth compressing */
+		AString m_GzippedContent;
+
+		AString m_ContentType;
+		AString m_ETag;
+		time_t m_ModificationTime;
+		int m_Size;
+	} ;
+
+	typedef std::shared_ptr<const sStaticFile> cStaticFilePtr;
+	typedef std::map<AString, cStaticFilePtr> cStaticFiles;
+
+	/** A rendered page, served to the repeated requests by the same user until it expires */
+	struct sCachedPage
+	{
+		AString m_Content;
+
+		/** The gzip-compressed content; empty if the content is not worth compressing */
+		AString m_GzippedContent;
+
+		AString m_ETag;
+		std::chrono::steady_clock::time_point m_ExpireTime;
+	} ;
+
+	typedef std::shared_ptr<const sCachedPage> cCachedPagePtr;
+	typedef std::map<AString, cCachedPagePtr> cCachedPages;
+
 
 	/** Set to true if Init() succeeds and the webadmin isn't to be disabled */
 	bool m_IsInitialized;
@@ -224,15 +257,58 @@ protected:
 	/** The HTTP server which provides the underlying HTTP parsing, serialization and events */
 	cHTTPServer m_HTTPServer;
 
+	/** Renders the worlds' overview tiles in the background, served in the "/~webadmin/overview/" URLs */
+	cOverviewRenderer m_OverviewRenderer;
+
+	/** Protects m_StaticFiles and m_CachedPages */
+	cCriticalSection m_CSCache;
+
+	/** The files from the "webadmin/files" folder that have been served, by their path */
+	cStaticFiles m_StaticFiles;
+
+	/** The recently rendered pages, by the username and URL */
+	cCachedPages m_CachedPages;
+
+	/** Number of seconds for which a rendered page is served from m_CachedPages; 0 disables the page cache */
+	int m_PageCacheTTL;
+
 	/** Handles requests coming to the "/webadmin" or "/~webadmin" URLs */
 	void HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request);
 
+	/** Handles requests for the world overview tiles, "/~webadmin/overview/<world>/<zoom>/<X>.<Z>.png" */
+	void HandleOverviewRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request);
+
+	/** Handles requests for the server metrics, "/~webadmin/metrics", in the Prometheus text format */
+	void HandleMetricsRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request);
+
 	/** Handles requests for the root page */
 	void HandleRootRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request);
 
 	/** Handles requests for a file */
 	void HandleFileRequest(cHTTPConnection & a_Connection, cHTTPRequest & a_Request);
 
+	/** Returns the static file at the specified path, from the cache if it hasn't changed on the disk.
+	Returns nullptr if the file doesn't exist or cannot be read. */
+	cStaticFilePtr GetStaticFile(const AString & a_Path);
+
+	/** Sends the page from the page cache, if it is there and hasn't expired. Returns true if sent. */
+	bool SendCachedPage(cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const AString & a_CacheKey);
+
+	/** Sends the rendered page as the response. If a_CacheKey is not empty, the page is stored in the page cache. */
+	void SendPage(cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const AString & a_Content, const AString & a_CacheKey);
+
+	/** Computes the ETag for the content and compresses it with gzip, if the content type is worth compressing. */
+	static void PrepareContent(const AString & a_ContentType, const AString & a_Content, AString & a_GzippedContent, AString & a_ETag);
+
+	/** Sends the content as the response, with the ETag and Cache-Control headers.
+	If the client's cached copy is still valid (If-None-Match), only "304 Not Modified" is sent. If the client accepts
+	gzip and a_GzippedContent is not empty, the compressed content is sent instead. */
+	static void SendContent(
+		cHTTPConnection & a_Connection, cHTTPRequest & a_Request,
+		const AString & a_ContentType, const AString & a_Content, const AString & a_GzippedContent,
+		const AString & a_ETag, const AString & a_CacheControl
+	);
+
 	// cHTTPServer::cCallbacks overrides:
 	virtual void OnRequestBegun   (cHTTPConnection & a_Connection, cHTTPRequest & a_Request) override;
 	virtual void OnRequestBody    (cHTTPConnection & a_Connection, cHTTPRequest & a_Request, const char * a_Data, size_t a_Size) override;
@@ -47,6 +47,7 @@
 #include "Generating/Trees.h"
 #include "Bindings/PluginManager.h"
 #include "Blocks/BlockHandler.h"
+#include "Metrics.h"
 
 #include "Tracer.h"
 
@@ -235,12 +236,20 @@ void cWorld::cTickThread::Execute(void)
 	auto LastTime = std::chrono::steady_clock::now();
 	auto TickTime = std::chrono::duration_cast<std::chrono::milliseconds>(cTickTime(1));
 
+	// The metric is registered once per thread, each tick only does the atomic updates:
+	cMetricHistogram & TickDurationMetric = cMetricsRegistry::Get().AddHistogram(
+		"mcserver_tick_duration_milliseconds", "Duration of the world ticks",
+		cMetricHistogram::cBounds{10, 25, 50, 75, 100, 200, 500, 1000},
+		cMetricsWriter::Label("world", m_World.GetName())
+	);
+
 	while (!m_ShouldTerminate)
 	{
 		auto NowTime = std::chrono::steady_clock::now();
 		auto WaitTime = std::chrono::duration_cast<std::chrono::milliseconds>(NowTime - LastTime);
 		m_World.Tick(WaitTime, TickTime);
 		TickTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - NowTime);
+		TickDurationMetric.Observe(static_cast<UInt64>(TickTime.count()));
 		
 		if (TickTime < cTickTime(1))
 		{
@@ -280,8 +289,6 @@ cWorld::cWorld(const AString & a_WorldName, eDimension a_Dimension, const AStrin
 	m_WorldAge(0),
 	m_TimeOfDay(0),
 	m_LastTimeUpdate(0),
-	m_LastUnload(0),
-	m_LastSave(0),
 	m_SkyDarkness(0),
 	m_GameMode(gmNotSet),
 	m_bEnabledPVP(false),
@@ -622,6 +629,12 @@ void cWorld::Start(void)
 	SetTimeOfDay(IniFile.GetValueSetI("General", "TimeInTicks", GetTimeOfDay()));
 
 	m_ChunkMap = make_unique<cChunkMap>(this);
+	m_AutosaveScheduler = make_unique<cAutosaveScheduler>(*this, *m_ChunkMap);
+	m_AutosaveScheduler->LoadSettings(IniFile);
+	m_UnloadGovernor = make_unique<cUnloadGovernor>(*this, *m_ChunkMap);
+	m_UnloadGovernor->LoadSettings(IniFile);
+	m_EntityTracker.LoadSettings(IniFile);
+	m_MapManager.LoadSettings(IniFile);
 	
 	// preallocate some memory for ticking blocks so we don't need to allocate that often
 	m_BlockTickQueue.reserve(1000);
@@ -641,7 +654,7 @@ void cWorld::Start(void)
 
 	m_Lighting.Start(this);
 	m_Storage.Start(this, m_StorageSchema, m_StorageCompressionFactor);
-	m_Generator.Start(m_GeneratorCallbacks, m_GeneratorCallbacks, IniFile);
+	m_Generator.Start(m_GeneratorCallbacks, m_GeneratorCallbacks, IniFile, FILE_IO_PREFIX + m_WorldName);
 	m_ChunkSender.Start(this);
 	m_TickThread.Start();
 
@@ -842,6 +855,7 @@ void cWorld::Stop(void)
 		IniFile.SetValueI("General", "TimeInTicks", GetTimeOfDay());
 	IniFile.WriteFile(m_IniFileName);
 	
+	m_MapManager.StopRendering();
 	m_TickThread.Stop();
 	m_Lighting.Stop();
 	m_Generator.Stop();
@@ -908,6 +922,7 @@ void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_La
 	AddQueuedPlayers();
 
 	m_ChunkMap->Tick(a_Dt);
+	FlushPlayerMoves();
 
 	TickClients(static_cast<float>(a_Dt.count()));
 	TickQueuedBlocks();
@@ -920,17 +935,11 @@ void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_La
 
 	m_ChunkMap->FastSetQueuedBlocks();
 
-	if (m_WorldAge - m_LastSave > std::chrono::minutes(5))  // Save each 5 minutes
-	{
-		SaveAllChunks();
-	}
-
-	if (m_WorldAge - m_LastUnload > std::chrono::minutes(5))  // Unload every 10 seconds
-	{
-		UnloadUnusedChunks();
-	}
+	m_AutosaveScheduler->Tick(GetWorldAge());
+	m_UnloadGovernor->Tick(GetWorldAge());
 
 	TickMobs(a_Dt);
+	FlushClientsOutgoingData();
 }
 
 
@@ -1141,6 +1150,65 @@ void cWorld::TickClients(float a_Dt)
 
 
 
+void cWorld::FlushClientsOutgoingData(void)
+{
+	// Flush without holding m_CSClients, the clients' links may need to be waited for:
+	cClientHandlePtrs Clients;
+	{
+		cCSLock Lock(m_CSClients);
+		Clients = m_Clients;
+	}
+	for (auto itr = Clients.begin(), end = Clients.end(); itr != end; ++itr)
+	{
+		(*itr)->FlushOutgoingData();
+	}
+}
+
+
+
+
+
+void cWorld::FlushPlayerMoves(void)
+{
+	if (m_PlayerMoves.empty())
+	{
+		return;
+	}
+
+	// Drop the moves of the players that have left the world during this tick, the hook must not see dangling pointers.
+	// The players are matched by their UniqueID, a new player may have been allocated at the address of a removed one:
+	cPlayerMoves Moves;
+	{
+		cCSLock Lock(m_CSPlayers);
+		std::map<cPlayer *, int> PlayerIDs;
+		for (cPlayerList::const_iterator itr = m_Players.begin(), end = m_Players.end(); itr != end; ++itr)
+		{
+			PlayerIDs[*itr] = (*itr)->GetUniqueID();
+		}
+		for (cPlayerMoves::const_iterator itr = m_PlayerMoves.begin(), end = m_PlayerMoves.end(); itr != end; ++itr)
+		{
+			std::map<cPlayer *, int>::const_iterator Player = PlayerIDs.find(itr->m_Player);
+			if ((Player != PlayerIDs.end()) && (Player->second == itr->m_PlayerID))
+			{
+				Moves.push_back(*itr);
+			}
+		}
+	}
+	m_PlayerMoves.clear();
+
+	// Call the hook without holding m_CSPlayers, the plugins may call ForEachPlayer() in other worlds:
+	if (!Moves.empty())
+	{
+		cPluginManager::Get()->CallHookPlayersMoved(*this, Moves);
+	}
+}
+
+
+
+
+
+
+
 void cWorld::UpdateSkyDarkness(void)
 {
 	int TempTime = std::chrono::duration_cast<cTickTime>(m_TimeOfDay).count();
@@ -1185,6 +1253,15 @@ void cWorld::WakeUpSimulatorsInArea(int a_MinBlockX, int a_MaxBlockX, int a_MinB
 
 
 
+void cWorld::WakeUpBlockEntitiesAround(int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+	m_ChunkMap->WakeUpBlockEntitiesAround(a_BlockX, a_BlockY, a_BlockZ);
+}
+
+
+
+
+
 bool cWorld::ForEachBlockEntityInChunk(int a_ChunkX, int a_ChunkZ, cBlockEntityCallback & a_Callback)
 {
 	return m_ChunkMap->ForEachBlockEntityInChunk(a_ChunkX, a_ChunkZ, a_Callback);
@@ -2138,6 +2215,15 @@ void cWorld::BroadcastEntityMetadata(const cEntity & a_Entity, const cClientHand
 
 
 
+void cWorld::BroadcastEntityMovement(const cEntity & a_Entity, const cClientHandle * a_Exclude)
+{
+	m_ChunkMap->BroadcastEntityMovement(a_Entity, m_EntityTracker, a_Exclude);
+}
+
+
+
+
+
 void cWorld::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
 	m_ChunkMap->BroadcastEntityRelMove(a_Entity, a_RelX, a_RelY, a_RelZ, a_Exclude);
@@ -2608,9 +2694,17 @@ bool cWorld::HasChunkAnyClients(int a_ChunkX, int a_ChunkZ) const
 
 
 
+void cWorld::GetChunkClients(int a_ChunkX, int a_ChunkZ, cClientHandleList & a_Clients)
+{
+	m_ChunkMap->GetChunkClients(a_ChunkX, a_ChunkZ, a_Clients);
+}
+
+
+
+
+
 void cWorld::UnloadUnusedChunks(void)
 {
-	m_LastUnload = std::chrono::duration_cast<cTickTimeLong>(m_WorldAge);
 	m_ChunkMap->UnloadUnusedChunks();
 }
 
@@ -2636,6 +2730,20 @@ void cWorld::CollectPickupsByPlayer(cPlayer & a_Player)
 
 
 
+void cWorld::AddPlayerMove(cPlayer & a_Player, const Vector3d & a_OldPosition, const Vector3d & a_NewPosition)
+{
+	sPlayerMove Move;
+	Move.m_Player = &a_Player;
+	Move.m_PlayerID = a_Player.GetUniqueID();
+	Move.m_OldPosition = a_OldPosition;
+	Move.m_NewPosition = a_NewPosition;
+	m_PlayerMoves.push_back(Move);
+}
+
+
+
+
+
 void cWorld::AddPlayer(cPlayer * a_Player)
 {
 	cCSLock Lock(m_CSPlayersToAdd);
@@ -3086,7 +3194,6 @@ bool cWorld::ForEachChunkInRect(int a_MinChunkX, int a_MaxChunkX, int a_MinChunk
 
 void cWorld::SaveAllChunks(void)
 {
-	m_LastSave = std::chrono::duration_cast<cTickTimeLong>(m_WorldAge);
 	m_ChunkMap->SaveAllChunks();
 }
 
@@ -11,6 +11,9 @@
 
 #include "Simulator/SimulatorManager.h"
 #include "ChunkMap.h"
+#include "AutosaveScheduler.h"
+#include "UnloadGovernor.h"
+#include "EntityTracker.h"
 #include "WorldStorage/WorldStorage.h"
 #include "Generating/ChunkGenerator.h"
 #include "Vector3.h"
@@ -32,6 +35,8 @@
 
 
 class cFireSimulator;
+struct sPlayerMove;
+typedef std::vector<sPlayerMove> cPlayerMoves;
 class cFluidSimulator;
 class cSandSimulator;
 class cRedstoneSimulator;
@@ -237,6 +242,7 @@ public:
 	void BroadcastEntityHeadLook             (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityLook                 (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityMetadata             (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
+	void BroadcastEntityMovement             (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMove              (const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMoveLook          (const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityStatus               (const cEntity & a_Entity, char a_Status, const cClientHandle * a_Exclude = nullptr);
@@ -296,12 +302,19 @@ public:
 	bool IsChunkValid(int a_ChunkX, int a_ChunkZ) const;
 
 	bool HasChunkAnyClients(int a_ChunkX, int a_ChunkZ) const;
+
+	/** Appends all the clients that have the specified chunk loaded to a_Clients. */
+	void GetChunkClients(int a_ChunkX, int a_ChunkZ, cClientHandleList & a_Clients);
 	
 	/** Queues a task to unload unused chunks onto the tick thread. The prefferred way of unloading*/
 	void QueueUnloadUnusedChunks(void);  // tolua_export
 	
 	void CollectPickupsByPlayer(cPlayer & a_Player);
 
+	/** Records the player's movement in the current tick, to be delivered to the plugins in a single
+	HOOK_PLAYERS_MOVED call at the end of the chunkmap tick. Must be called from the tick thread. */
+	void AddPlayerMove(cPlayer & a_Player, const Vector3d & a_OldPosition, const Vector3d & a_NewPosition);
+
 	/** Adds the player to the world.
 	Uses a queue to store the player object until the Tick thread processes the addition event.
 	Also adds the player as an entity in the chunkmap, and the player's ClientHandle, if any, for ticking. */
@@ -520,6 +533,9 @@ public:
 
 	// tolua_end
 
+	/** Wakes up the sleeping block entities (hoppers, furnaces, droppers...) that may react to a change at the specified block */
+	void WakeUpBlockEntitiesAround(int a_BlockX, int a_BlockY, int a_BlockZ);
+
 	inline cSimulatorManager * GetSimulatorManager(void) { return m_SimulatorManager.get(); }
 	
 	inline cFluidSimulator * GetWaterSimulator(void) { return m_WaterSimulator; }
@@ -703,6 +719,15 @@ public:
 	/** Returns the number of chunks loaded and dirty, and in the lighting queue */
 	void GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLightingQueue);
 
+	/** Returns the scheduler that queues the dirty chunks for saving, used for its statistics */
+	cAutosaveScheduler & GetAutosaveScheduler(void) { return *m_AutosaveScheduler; }
+
+	/** Returns the governor that unloads the unused chunks, used for its statistics */
+	cUnloadGovernor & GetUnloadGovernor(void) { return *m_UnloadGovernor; }
+
+	/** Returns the tracker that rate-limits the entity movement updates by distance, used for its statistics */
+	cEntityTracker & GetEntityTracker(void) { return m_EntityTracker; }
+
 	// Various queues length queries (cannot be const, they lock their CS):
 	inline int GetGeneratorQueueLength     (void) { return m_Generator.GetQueueLength();   }    // tolua_export
 	inline size_t GetLightingQueueLength   (void) { return m_Lighting.GetQueueLength();    }    // tolua_export
@@ -920,8 +945,6 @@ private:
 	std::chrono::milliseconds  m_WorldAge;
 	std::chrono::milliseconds  m_TimeOfDay;
 	cTickTimeLong  m_LastTimeUpdate;    // The tick in which the last time update has been sent.
-	cTickTimeLong  m_LastUnload;        // The last WorldAge (in ticks) in which unloading was triggerred
-	cTickTimeLong  m_LastSave;          // The last WorldAge (in ticks) in which save-all was triggerred
 	std::map<cMonster::eFamily, cTickTimeLong> m_LastSpawnMonster;  // The last WorldAge (in ticks) in which a monster was spawned (for each megatype of monster)  // MG TODO : find a way to optimize without creating unmaintenability (if mob IDs are becoming unrowed)
 
 	NIBBLETYPE m_SkyDarkness;
@@ -945,12 +968,24 @@ private:
 	cCriticalSection m_CSPlayers;
 	cPlayerList      m_Players;
 
+	/** The player movements recorded during the current tick, see AddPlayerMove(). Only accessed from the tick thread. */
+	cPlayerMoves m_PlayerMoves;
+
 	cWorldStorage     m_Storage;
 	
 	unsigned int m_MaxPlayers;
 
 	std::unique_ptr<cChunkMap> m_ChunkMap;
 
+	/** Queues the dirty chunks for saving, a portion in each tick */
+	std::unique_ptr<cAutosaveScheduler> m_AutosaveScheduler;
+
+	/** Unloads the unused chunks by their age and the memory pressure */
+	std::unique_ptr<cUnloadGovernor> m_UnloadGovernor;
+
+	/** Decides which clients receive each entity movement update, by their distance from the entity */
+	cEntityTracker m_EntityTracker;
+
 	bool m_bAnimals;
 	std::set<eMonsterType> m_AllowedMobs;
 
@@ -1069,6 +1104,13 @@ private:
 	/** Ticks all clients that are in this world */
 	void TickClients(float a_Dt);
 
+	/** Hands the packets queued during this tick over to the network, for all clients in this world,
+	so that they don't wait until the clients are ticked in the next tick. */
+	void FlushClientsOutgoingData(void);
+
+	/** Delivers the player movements recorded during this tick to the plugins, in a single HOOK_PLAYERS_MOVED call. */
+	void FlushPlayerMoves(void);
+
 	/** Unloads all chunks immediately.*/
 	void UnloadUnusedChunks(void);
 
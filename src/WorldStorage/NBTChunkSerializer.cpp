@@ -75,6 +75,13 @@ void cNBTChunkSerializer::Finish(void)
 	{
 		m_Writer.EndList();
 	}
+
+	// Expand the block data snapshot into the arrays; the chunk may have changed meanwhile, the snapshot hasn't:
+	if (m_BlockDataSnapshot.get() != nullptr)
+	{
+		cChunkDataSeparateCollector::ChunkData(*m_BlockDataSnapshot);
+		m_BlockDataSnapshot.reset();
+	}
 	
 	// If light not valid, reset it to all zeroes:
 	if (!m_IsLightValid)
@@ -113,42 +120,42 @@ void cNBTChunkSerializer::AddItem(const cItem & a_Item, int a_Slot, const AStrin
 	
 	// Write the tag compound (for enchantment, firework, custom name and repair cost):
 	if (
-		(!a_Item.m_Enchantments.IsEmpty()) ||
+		(!a_Item.GetEnchantments().IsEmpty()) ||
 		((a_Item.m_ItemType == E_ITEM_FIREWORK_ROCKET) || (a_Item.m_ItemType == E_ITEM_FIREWORK_STAR)) ||
-		(a_Item.m_RepairCost > 0) ||
-		(a_Item.m_CustomName != "") ||
-		(a_Item.m_Lore != "")
+		(a_Item.GetRepairCost() > 0) ||
+		(a_Item.GetCustomName() != "") ||
+		(a_Item.GetLore() != "")
 	)
 	{
 		m_Writer.BeginCompound("tag");
-			if (a_Item.m_RepairCost > 0)
+			if (a_Item.GetRepairCost() > 0)
 			{
-				m_Writer.AddInt("RepairCost", a_Item.m_RepairCost);
+				m_Writer.AddInt("RepairCost", a_Item.GetRepairCost());
 			}
 
-			if ((a_Item.m_CustomName != "") || (a_Item.m_Lore != ""))
+			if ((a_Item.GetCustomName() != "") || (a_Item.GetLore() != ""))
 			{
 				m_Writer.BeginCompound("display");
-				if (a_Item.m_CustomName != "")
+				if (a_Item.GetCustomName() != "")
 				{
-					m_Writer.AddString("Name", a_Item.m_CustomName);
+					m_Writer.AddString("Name", a_Item.GetCustomName());
 				}
-				if (a_Item.m_Lore != "")
+				if (a_Item.GetLore() != "")
 				{
-					m_Writer.AddString("Lore", a_Item.m_Lore);
+					m_Writer.AddString("Lore", a_Item.GetLore());
 				}
 				m_Writer.EndCompound();
 			}
 
 			if ((a_Item.m_ItemType == E_ITEM_FIREWORK_ROCKET) || (a_Item.m_ItemType == E_ITEM_FIREWORK_STAR))
 			{
-				cFireworkItem::WriteToNBTCompound(a_Item.m_FireworkItem, m_Writer, (ENUM_ITEM_ID)a_Item.m_ItemType);
+				cFireworkItem::WriteToNBTCompound(a_Item.GetFireworkItem(), m_Writer, (ENUM_ITEM_ID)a_Item.m_ItemType);
 			}
 
-			if (!a_Item.m_Enchantments.IsEmpty())
+			if (!a_Item.GetEnchantments().IsEmpty())
 			{
 				const char * TagName = (a_Item.m_ItemType == E_ITEM_BOOK) ? "StoredEnchantments" : "ench";
-				EnchantmentSerializer::WriteToNBTCompound(a_Item.m_Enchantments, m_Writer, TagName);
+				EnchantmentSerializer::WriteToNBTCompound(a_Item.GetEnchantments(), m_Writer, TagName);
 			}
 		m_Writer.EndCompound();
 	}
@@ -809,6 +816,16 @@ void cNBTChunkSerializer::AddMinecartChestContents(cMinecartWithChest * a_Mineca
 
 
 
+void cNBTChunkSerializer::ChunkData(const cChunkData & a_ChunkBuffer)
+{
+	// Only take a snapshot now, the chunk is locked; the data is copied out in Finish()
+	m_BlockDataSnapshot.reset(new cChunkData(a_ChunkBuffer.Snapshot()));
+}
+
+
+
+
+
 void cNBTChunkSerializer::LightIsValid(bool a_IsLightValid)
 {
 	m_IsLightValid = a_IsLightValid;
@@ -66,7 +66,8 @@ public:
 
 	cNBTChunkSerializer(cFastNBTWriter & a_Writer);
 
-	/// Close NBT tags that we've opened
+	/** Close NBT tags that we've opened and fill the block data arrays from the snapshot.
+	To be called after the chunk data has been received, without holding the chunkmap lock. */
 	void Finish(void);
 	
 	bool IsLightValid(void) const {return m_IsLightValid; }
@@ -87,6 +88,9 @@ protected:
 	bool m_HasHadBlockEntity;  // True if any BlockEntity has already been received and processed
 	bool m_IsLightValid;  // True if the chunk lighting is valid
 
+	/** Copy-on-write snapshot of the chunk's blocks, taken while the chunk is locked and copied into the block arrays in Finish() */
+	std::unique_ptr<cChunkData> m_BlockDataSnapshot;
+
 
 	/// Writes an item into the writer, if slot >= 0, adds the Slot tag. The compound is named as requested.
 	void AddItem(const cItem & a_Item, int a_Slot, const AString & a_CompoundName = "");
@@ -127,6 +131,7 @@ protected:
 	void AddMinecartChestContents(cMinecartWithChest * a_Minecart);
 	
 	// cChunkDataSeparateCollector overrides:
+	virtual void ChunkData(const cChunkData & a_ChunkBuffer) override;
 	virtual void LightIsValid(bool a_IsLightValid) override;
 	virtual void HeightMap(const cChunkDef::HeightMap * a_HeightMap) override;
 	virtual void BiomeData(const cChunkDef::BiomeMap * a_BiomeMap) override;
@@ -465,30 +465,40 @@ bool cWSSAnvil::SaveChunkToNBT(const cChunkCoords & a_Chunk, cFastNBTWriter & a_
 		LOGWARNING("Cannot get chunk [%d, %d] data for NBT saving", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
 		return false;
 	}
-	Serializer.Finish();  // Close NBT tags
+	FinishChunkNBT(Serializer, m_World->GetWorldAge(), a_Writer);
+	return true;
+}
+
+
+
+
+
+void cWSSAnvil::FinishChunkNBT(cNBTChunkSerializer & a_Serializer, Int64 a_WorldAge, cFastNBTWriter & a_Writer)
+{
+	a_Serializer.Finish();  // Close NBT tags
 	
 	// Save biomes, both MCS (IntArray) and MC-vanilla (ByteArray):
-	if (Serializer.m_BiomesAreValid)
+	if (a_Serializer.m_BiomesAreValid)
 	{
-		a_Writer.AddByteArray("Biomes",    (const char *)(Serializer.m_VanillaBiomes), ARRAYCOUNT(Serializer.m_VanillaBiomes));
-		a_Writer.AddIntArray ("MCSBiomes", (const int *)(Serializer.m_Biomes),         ARRAYCOUNT(Serializer.m_Biomes));
+		a_Writer.AddByteArray("Biomes",    (const char *)(a_Serializer.m_VanillaBiomes), ARRAYCOUNT(a_Serializer.m_VanillaBiomes));
+		a_Writer.AddIntArray ("MCSBiomes", (const int *)(a_Serializer.m_Biomes),         ARRAYCOUNT(a_Serializer.m_Biomes));
 	}
 
 	// Save heightmap (Vanilla require this):
-	a_Writer.AddIntArray("HeightMap", (const int *)Serializer.m_VanillaHeightMap, ARRAYCOUNT(Serializer.m_VanillaHeightMap));
+	a_Writer.AddIntArray("HeightMap", (const int *)a_Serializer.m_VanillaHeightMap, ARRAYCOUNT(a_Serializer.m_VanillaHeightMap));
 
 	// Save blockdata:
 	a_Writer.BeginList("Sections", TAG_Compound);
 	size_t SliceSizeBlock  = cChunkDef::Width * cChunkDef::Width * 16;
 	size_t SliceSizeNibble = SliceSizeBlock / 2;
-	const char * BlockTypes    = (const char *)(Serializer.m_BlockTypes);
-	const char * BlockMetas    = (const char *)(Serializer.m_BlockMetas);
+	const char * BlockTypes    = (const char *)(a_Serializer.m_BlockTypes);
+	const char * BlockMetas    = (const char *)(a_Serializer.m_BlockMetas);
 	#ifdef DEBUG_SKYLIGHT
-		const char * BlockLight  = (const char *)(Serializer.m_BlockSkyLight);
+		const char * BlockLight  = (const char *)(a_Serializer.m_BlockSkyLight);
 	#else
-		const char * BlockLight  = (const char *)(Serializer.m_BlockLight);
+		const char * BlockLight  = (const char *)(a_Serializer.m_BlockLight);
 	#endif
-	const char * BlockSkyLight = (const char *)(Serializer.m_BlockSkyLight);
+	const char * BlockSkyLight = (const char *)(a_Serializer.m_BlockSkyLight);
 	for (int Y = 0; Y < 16; Y++)
 	{
 		a_Writer.BeginCompound("");
@@ -503,19 +513,18 @@ bool cWSSAnvil::SaveChunkToNBT(const cChunkCoords & a_Chunk, cFastNBTWriter & a_
 	
 	// Store the information that the lighting is valid.
 	// For compatibility reason, the default is "invalid" (missing) - this means older data is re-lighted upon loading.
-	if (Serializer.IsLightValid())
+	if (a_Serializer.IsLightValid())
 	{
 		a_Writer.AddByte("MCSIsLightValid", 1);
 	}
 
 	// Save the world age to the chunk data. Required by vanilla and mcedit.
-	a_Writer.AddLong("LastUpdate", m_World->GetWorldAge());
+	a_Writer.AddLong("LastUpdate", a_WorldAge);
 	
 	// Store the flag that the chunk has all the ores, trees, dungeons etc. MCS chunks are always complete.
 	a_Writer.AddByte("TerrainPopulated", 1);
 	
 	a_Writer.EndCompound();  // "Level"
-	return true;
 }
 
 
@@ -750,7 +759,7 @@ bool cWSSAnvil::LoadItemFromNBT(cItem & a_Item, const cParsedNBT & a_NBT, int a_
 	int RepairCost = a_NBT.FindChildByName(TagTag, "RepairCost");
 	if ((RepairCost > 0) && (a_NBT.GetType(RepairCost) == TAG_Int))
 	{
-		a_Item.m_RepairCost = a_NBT.GetInt(RepairCost);
+		a_Item.SetRepairCost(a_NBT.GetInt(RepairCost));
 	}
 
 	// Load display name:
@@ -760,12 +769,12 @@ bool cWSSAnvil::LoadItemFromNBT(cItem & a_Item, const cParsedNBT & a_NBT, int a_
 		int DisplayName = a_NBT.FindChildByName(DisplayTag, "Name");
 		if ((DisplayName > 0) && (a_NBT.GetType(DisplayName) == TAG_String))
 		{
-			a_Item.m_CustomName = a_NBT.GetString(DisplayName);
+			a_Item.SetCustomName(a_NBT.GetString(DisplayName));
 		}
 		int Lore = a_NBT.FindChildByName(DisplayTag, "Lore");
 		if ((Lore > 0) && (a_NBT.GetType(Lore) == TAG_String))
 		{
-			a_Item.m_Lore = a_NBT.GetString(Lore);
+			a_Item.SetLore(a_NBT.GetString(Lore));
 		}
 	}
 
@@ -774,14 +783,14 @@ bool cWSSAnvil::LoadItemFromNBT(cItem & a_Item, const cParsedNBT & a_NBT, int a_
 	int EnchTag = a_NBT.FindChildByName(TagTag, EnchName);
 	if (EnchTag > 0)
 	{
-		EnchantmentSerializer::ParseFromNBT(a_Item.m_Enchantments, a_NBT, EnchTag);
+		EnchantmentSerializer::ParseFromNBT(a_Item.ModifyEnchantments(), a_NBT, EnchTag);
 	}
 
 	// Load firework data:
 	int FireworksTag = a_NBT.FindChildByName(TagTag, ((a_Item.m_ItemType == E_ITEM_FIREWORK_STAR) ? "Fireworks" : "Explosion"));
 	if (EnchTag > 0)
 	{
-		cFireworkItem::ParseFromNBT(a_Item.m_FireworkItem, a_NBT, FireworksTag, (ENUM_ITEM_ID)a_Item.m_ItemType);
+		cFireworkItem::ParseFromNBT(a_Item.ModifyFireworkItem(), a_NBT, FireworksTag, (ENUM_ITEM_ID)a_Item.m_ItemType);
 	}
 	
 	return true;
@@ -3093,6 +3102,31 @@ bool cWSSAnvil::cMCAFile::GetChunkData(const cChunkCoords & a_Chunk, AString & a
 
 
 
+bool cWSSAnvil::cMCAFile::HasChunkData(const cChunkCoords & a_Chunk)
+{
+	if (!OpenFile(true))
+	{
+		return false;
+	}
+
+	int LocalX = a_Chunk.m_ChunkX % 32;
+	if (LocalX < 0)
+	{
+		LocalX = 32 + LocalX;
+	}
+	int LocalZ = a_Chunk.m_ChunkZ % 32;
+	if (LocalZ < 0)
+	{
+		LocalZ = 32 + LocalZ;
+	}
+	unsigned ChunkLocation = ntohl(m_Header[LocalX + 32 * LocalZ]);
+	return ((ChunkLocation >> 8) >= 2);
+}
+
+
+
+
+
 bool cWSSAnvil::cMCAFile::SetChunkData(const cChunkCoords & a_Chunk, const AString & a_Data)
 {
 	if (!OpenFile(false))
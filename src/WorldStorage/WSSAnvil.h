@@ -22,6 +22,7 @@ class cItemGrid;
 class cProjectileEntity;
 class cHangingEntity;
 class cWolf;
+class cNBTChunkSerializer;
 
 
 
@@ -52,9 +53,8 @@ public:
 
 	cWSSAnvil(cWorld * a_World, int a_CompressionFactor);
 	virtual ~cWSSAnvil();
-	
-protected:
 
+	/** A single region file. Public so that the tools (such as the pregenerator) can write region files directly. */
 	class cMCAFile
 	{
 	public:
@@ -64,6 +64,9 @@ protected:
 		bool GetChunkData  (const cChunkCoords & a_Chunk, AString & a_Data);
 		bool SetChunkData  (const cChunkCoords & a_Chunk, const AString & a_Data);
 		bool EraseChunkData(const cChunkCoords & a_Chunk);
+
+		/** Returns true if the file contains data for the specified chunk. Doesn't read nor verify the data itself. */
+		bool HasChunkData(const cChunkCoords & a_Chunk);
 		
 		int             GetRegionX (void) const {return m_RegionX; }
 		int             GetRegionZ (void) const {return m_RegionZ; }
@@ -89,6 +92,14 @@ protected:
 		/// Opens a MCA file either for a Read operation (fails if doesn't exist) or for a Write operation (creates new if not found)
 		bool OpenFile(bool a_IsForReading);
 	} ;
+
+	/** Finishes a_Serializer (see cNBTChunkSerializer::Finish()), writes the chunk's biomes, heightmap, block data and
+	the chunk flags into a_Writer and closes the "Level" compound.
+	The caller is expected to have begun the "Level" compound, written the chunk coords and fed the chunk data into the serializer. */
+	static void FinishChunkNBT(cNBTChunkSerializer & a_Serializer, Int64 a_WorldAge, cFastNBTWriter & a_Writer);
+	
+protected:
+
 	typedef std::list<cMCAFile *> cMCAFiles;
 	
 	cCriticalSection m_CS;
@@ -40,7 +40,10 @@ protected:
 cWorldStorage::cWorldStorage(void) :
 	super("cWorldStorage"),
 	m_World(nullptr),
-	m_SaveSchema(nullptr)
+	m_SaveSchema(nullptr),
+	m_NumSaved(0),
+	m_TotalSaveMsec(0),
+	m_MaxSaveMsec(0)
 {
 }
 
@@ -140,6 +143,20 @@ size_t cWorldStorage::GetSaveQueueLength(void)
 
 
 
+cWorldStorage::sSaveStats cWorldStorage::GetSaveStats(void)
+{
+	cCSLock Lock(m_CSSaveStats);
+	sSaveStats Stats;
+	Stats.m_NumSaved = m_NumSaved;
+	Stats.m_AvgSaveMsec = (m_NumSaved > 0) ? m_TotalSaveMsec / static_cast<double>(m_NumSaved) : 0;
+	Stats.m_MaxSaveMsec = m_MaxSaveMsec;
+	return Stats;
+}
+
+
+
+
+
 void cWorldStorage::QueueLoadChunk(int a_ChunkX, int a_ChunkZ, cChunkCoordCallback * a_Callback)
 {
 	ASSERT(m_World->IsChunkQueued(a_ChunkX, a_ChunkZ));
@@ -289,9 +306,21 @@ bool cWorldStorage::SaveOneChunk(void)
 	if (m_World->IsChunkValid(ToSave.m_ChunkX, ToSave.m_ChunkZ))
 	{
 		m_World->MarkChunkSaving(ToSave.m_ChunkX, ToSave.m_ChunkZ);
-		if (m_SaveSchema->SaveChunk(cChunkCoords(ToSave.m_ChunkX, ToSave.m_ChunkZ)))
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		bool Success = m_SaveSchema->SaveChunk(cChunkCoords(ToSave.m_ChunkX, ToSave.m_ChunkZ));
+		double SaveMsec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+		if (Success)
 		{
 			m_World->MarkChunkSaved(ToSave.m_ChunkX, ToSave.m_ChunkZ);
+			cCSLock Lock(m_CSSaveStats);
+			m_NumSaved += 1;
+			m_TotalSaveMsec += SaveMsec;
+			m_MaxSaveMsec = std::max(m_MaxSaveMsec, SaveMsec);
+		}
+		else
+		{
+			// Keep the chunk dirty so that the autosave retries it later:
+			m_World->MarkChunkDirty(ToSave.m_ChunkX, ToSave.m_ChunkZ);
 		}
 	}
 
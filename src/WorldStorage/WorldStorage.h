@@ -61,6 +61,14 @@ class cWorldStorage :
 	
 public:
 
+	/** Statistics of the chunk saving, used by the "chunkstats" console command */
+	struct sSaveStats
+	{
+		UInt64 m_NumSaved;
+		double m_AvgSaveMsec;
+		double m_MaxSaveMsec;
+	} ;
+
 	cWorldStorage(void);
 	~cWorldStorage();
 	
@@ -78,6 +86,9 @@ public:
 	
 	size_t GetLoadQueueLength(void);
 	size_t GetSaveQueueLength(void);
+
+	/** Returns the statistics of the chunks saved so far. */
+	sSaveStats GetSaveStats(void);
 	
 protected:
 
@@ -103,6 +114,12 @@ protected:
 	
 	cEvent m_Event;       // Set when there's any addition to the queues
 
+	/** Protects the save statistics below, they are written by the storage thread and read by the console command */
+	cCriticalSection m_CSSaveStats;
+	UInt64 m_NumSaved;
+	double m_TotalSaveMsec;
+	double m_MaxSaveMsec;
+
 	/// Loads one chunk from the queue (if any queued); returns true if there are more chunks in the load queue
 	bool LoadOneChunk(void);
 	
@@ -66,6 +66,7 @@ void NonCtrlHandler(int a_Signal)
 			LOGERROR("  D:    | MCServer has encountered an error and needs to close");
 			LOGERROR("Details | SIGSEGV: Segmentation fault");
 			PrintStackTrace();
+			cLogger::GetInstance().Flush();
 			abort();
 		}
 		case SIGABRT:
@@ -77,6 +78,7 @@ void NonCtrlHandler(int a_Signal)
 			LOGERROR("  D:    | MCServer has encountered an error and needs to close");
 			LOGERROR("Details | SIGABRT: Server self-terminated due to an internal fault");
 			PrintStackTrace();
+			cLogger::GetInstance().Flush();
 			abort();
 		}
 		case SIGINT:
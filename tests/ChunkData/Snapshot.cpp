@@ -0,0 +1,76 @@
+
+#include "Globals.h"
+#include "ChunkData.h"
+
+
+
+int main(int argc, char** argv)
+{
+	class cMockAllocationPool
+		: public cAllocationPool<cChunkData::sChunkSection>
+	{
+	public:
+		int m_NumAllocated;
+
+		cMockAllocationPool(void) :
+			m_NumAllocated(0)
+		{
+		}
+
+		virtual cChunkData::sChunkSection * Allocate()
+		{
+			m_NumAllocated += 1;
+			return new cChunkData::sChunkSection();
+		}
+		
+		virtual void Free(cChunkData::sChunkSection * a_Ptr)
+		{
+			m_NumAllocated -= 1;
+			delete a_Ptr;
+		}
+	} Pool;
+	{
+		cChunkData buffer(Pool);
+		buffer.SetBlock(3, 1, 4, 0xDE);
+		buffer.SetMeta(3, 1, 4, 0xA);
+		buffer.SetBlock(5, 100, 6, 0x12);
+		testassert(Pool.m_NumAllocated == 2);
+
+		// The snapshot shares the sections:
+		cChunkData snapshot = buffer.Snapshot();
+		testassert(Pool.m_NumAllocated == 2);
+		testassert(snapshot.GetBlock(3, 1, 4) == 0xDE);
+		testassert(snapshot.GetMeta(3, 1, 4) == 0xA);
+
+		// Writing into the original copies only the written section, the snapshot keeps the old data:
+		buffer.SetBlock(3, 1, 4, 0xAD);
+		testassert(Pool.m_NumAllocated == 3);
+		testassert(buffer.GetBlock(3, 1, 4) == 0xAD);
+		testassert(buffer.GetMeta(3, 1, 4) == 0xA);
+		testassert(snapshot.GetBlock(3, 1, 4) == 0xDE);
+		buffer.SetMeta(3, 1, 4, 0x5);
+		testassert(Pool.m_NumAllocated == 3);
+		testassert(snapshot.GetMeta(3, 1, 4) == 0xA);
+
+		// Writing into the snapshot doesn't affect the original either:
+		snapshot.SetBlock(5, 100, 6, 0x34);
+		testassert(Pool.m_NumAllocated == 4);
+		testassert(buffer.GetBlock(5, 100, 6) == 0x12);
+		testassert(snapshot.GetBlock(5, 100, 6) == 0x34);
+
+		// Bulk writes into a shared section:
+		cChunkData snapshot2 = buffer.Snapshot();
+		BLOCKTYPE SrcBlockBuffer[16 * 16 * 256];
+		memset(SrcBlockBuffer, 0x07, sizeof(SrcBlockBuffer));
+		buffer.SetBlockTypes(SrcBlockBuffer);
+		testassert(buffer.GetBlock(3, 1, 4) == 0x07);
+		testassert(snapshot2.GetBlock(3, 1, 4) == 0xAD);
+		testassert(snapshot2.GetBlock(5, 100, 6) == 0x12);
+	}
+
+	// All sections have been released:
+	testassert(Pool.m_NumAllocated == 0);
+
+	// All tests successful:
+	return 0;
+}
@@ -0,0 +1,196 @@
+
+// SectionPool.cpp
+
+// Checks the cChunkSectionPool allocations across the slab boundaries, the release of the reserve slabs and the stats
+
+#include "Globals.h"
+#include "ChunkSectionPool.h"
+#include <thread>
+
+
+
+
+
+/** Exposes the pool's internal geometry to the test */
+class cTestPool :
+	public cChunkSectionPool
+{
+public:
+	using cChunkSectionPool::GetSectionsPerSlab;
+	using cChunkSectionPool::GetFirstSectionOffset;
+} ;
+
+
+
+
+
+typedef std::vector<cChunkSectionPool::sChunkSection *> cSections;
+
+
+
+
+
+/** Exits with an error message if the condition doesn't hold */
+static void Check(bool a_Condition, const char * a_What)
+{
+	if (!a_Condition)
+	{
+		printf("Check failed: %s\n", a_What);
+		exit(1);
+	}
+}
+
+
+
+
+
+/** Checks that the stats add up: all the sections in all the mapped slabs are accounted for exactly once */
+static cChunkSectionPool::sStats CheckStats(void)
+{
+	cChunkSectionPool::sStats Stats = cChunkSectionPool::Get().GetStats();
+	size_t NumSlabs = Stats.m_NumSlabsFull + Stats.m_NumSlabsPartial + Stats.m_NumSlabsEmpty;
+	Check(
+		Stats.m_NumSectionsUsed + Stats.m_NumSectionsCached + Stats.m_NumSectionsFreePartial + Stats.m_NumSectionsFreeEmpty ==
+		NumSlabs * cTestPool::GetSectionsPerSlab(),
+		"the sections in the stats add up to the mapped slabs"
+	);
+	Check(Stats.m_NumSectionsCached <= cChunkSectionPool::THREAD_CACHE_SIZE, "the thread caches hold at most their capacity");
+	Check(Stats.m_NumSlabsEmpty <= cChunkSectionPool::MAX_RESERVE_SLABS, "the reserve is limited");
+	return Stats;
+}
+
+
+
+
+
+/** Allocates a_Count sections, checks that they are valid, distinct, within their slabs, and writable */
+static void AllocateSections(size_t a_Count, cSections & a_Sections)
+{
+	std::set<cChunkSectionPool::sChunkSection *> Seen(a_Sections.begin(), a_Sections.end());
+	for (size_t i = 0; i < a_Count; i++)
+	{
+		cChunkSectionPool::sChunkSection * Section = cChunkSectionPool::Get().Allocate();
+		Check(Section != nullptr, "the allocation succeeds");
+		Check(Seen.insert(Section).second, "each section is handed out only once");
+
+		// The section must lie completely within its slab, after the slab header:
+		uintptr_t Offset = reinterpret_cast<uintptr_t>(Section) & (cChunkSectionPool::SLAB_SIZE - 1);
+		Check(Offset >= cTestPool::GetFirstSectionOffset(), "the section doesn't overlap the slab header");
+		Check(Offset + sizeof(*Section) <= cChunkSectionPool::SLAB_SIZE, "the section doesn't cross the slab boundary");
+		Check((Offset - cTestPool::GetFirstSectionOffset()) % sizeof(*Section) == 0, "the section is on the slab's section grid");
+
+		memset(static_cast<void *>(Section), static_cast<int>(i & 0xff), sizeof(*Section));
+		a_Sections.push_back(Section);
+	}
+}
+
+
+
+
+
+/** Frees all the sections in a_Sections and clears the container */
+static void FreeSections(cSections & a_Sections)
+{
+	for (cSections::iterator itr = a_Sections.begin(), end = a_Sections.end(); itr != end; ++itr)
+	{
+		cChunkSectionPool::Get().Free(*itr);
+	}
+	a_Sections.clear();
+}
+
+
+
+
+
+/** Returns the number of distinct slabs that the sections come from */
+static size_t CountSlabs(const cSections & a_Sections)
+{
+	std::set<uintptr_t> Slabs;
+	for (cSections::const_iterator itr = a_Sections.begin(), end = a_Sections.end(); itr != end; ++itr)
+	{
+		Slabs.insert(reinterpret_cast<uintptr_t>(*itr) & ~static_cast<uintptr_t>(cChunkSectionPool::SLAB_SIZE - 1));
+	}
+	return Slabs.size();
+}
+
+
+
+
+
+/** Allocates and frees a few sections in a separate thread, so that they stay in that thread's cache when it exits */
+static void ThreadAllocateAndFree(void)
+{
+	cSections Sections;
+	AllocateSections(5, Sections);
+	FreeSections(Sections);
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	const size_t PerSlab = cTestPool::GetSectionsPerSlab();
+	Check(PerSlab > 1, "a slab holds multiple sections");
+	printf("Sections per slab: " SIZE_T_FMT "\n", PerSlab);
+
+	cChunkSectionPool::sStats Stats = CheckStats();
+	Check(Stats.m_NumSlabsFull + Stats.m_NumSlabsPartial == 0, "the pool starts with no sections used");
+	Check(Stats.m_NumSlabsEmpty == cChunkSectionPool::MAX_RESERVE_SLABS, "the pool starts with the reserve mapped");
+
+	// Fill three slabs and spill over into a fourth one:
+	cSections Sections;
+	AllocateSections(3 * PerSlab + PerSlab / 2, Sections);
+	Stats = CheckStats();
+	Check(Stats.m_NumSectionsUsed == Sections.size(), "the used sections are counted");
+	Check(CountSlabs(Sections) == 4, "the sections are packed into the slabs");
+	Check(Stats.m_NumSlabsFull == 3, "the filled slabs are full");
+	Check(Stats.m_NumSlabsPartial == 1, "the spilled-over slab is partial");
+	Check(Stats.m_NumSlabsEmpty == cChunkSectionPool::MAX_RESERVE_SLABS, "the reserve is kept while the OS provides the memory");
+	Check(
+		cChunkSectionPool::Get().GetUsedMemory() ==
+		(Stats.m_NumSectionsUsed + Stats.m_NumSectionsCached) * sizeof(cChunkSectionPool::sChunkSection) +
+		4 * (cChunkSectionPool::SLAB_SIZE - PerSlab * sizeof(cChunkSectionPool::sChunkSection)),
+		"the used memory counts the used sections and the overhead of their slabs"
+	);
+
+	// Free every other section, all the slabs become partial and the freed sections are reused first:
+	cSections Kept, Freed;
+	for (size_t i = 0; i < Sections.size(); i++)
+	{
+		((i % 2 == 0) ? Kept : Freed).push_back(Sections[i]);
+	}
+	Sections.clear();
+	size_t NumFreed = Freed.size();
+	FreeSections(Freed);
+	Stats = CheckStats();
+	Check(Stats.m_NumSectionsUsed == Kept.size(), "the freed sections are not counted as used");
+	Check(Stats.m_NumSlabsFull == 0, "no slab is full after freeing every other section");
+	AllocateSections(NumFreed, Kept);
+	Stats = CheckStats();
+	Check(CountSlabs(Kept) == 4, "the freed sections are reused before mapping new slabs");
+	Check(Stats.m_NumSlabsFull + Stats.m_NumSlabsPartial == 4, "no new slab is mapped for the reused sections");
+
+	// Free everything, only the reserve slabs are kept:
+	FreeSections(Kept);
+	AllocateSections((cChunkSectionPool::MAX_RESERVE_SLABS + 4) * PerSlab, Sections);
+	Stats = CheckStats();
+	Check(Stats.m_NumSlabsFull + Stats.m_NumSlabsPartial >= cChunkSectionPool::MAX_RESERVE_SLABS + 4, "the slabs are mapped as needed");
+	FreeSections(Sections);
+	Stats = CheckStats();
+	Check(Stats.m_NumSectionsUsed == 0, "no sections are used after freeing all");
+	Check(Stats.m_NumSlabsEmpty == cChunkSectionPool::MAX_RESERVE_SLABS, "the reserve is kept full");
+	Check(Stats.m_NumSlabsFull == 0, "no slab is full after freeing all");
+	Check(Stats.m_NumSlabsPartial <= 2, "only the sections in this thread's cache keep the slabs partial");
+
+	// The sections cached by an exiting thread are returned to the slabs:
+	size_t NumCachedBefore = Stats.m_NumSectionsCached;
+	std::thread Thread(ThreadAllocateAndFree);
+	Thread.join();
+	Stats = CheckStats();
+	Check(Stats.m_NumSectionsCached == NumCachedBefore, "the exiting thread's cache is returned to the slabs");
+
+	printf("The chunk section pool works as expected\n");
+	return 0;
+}
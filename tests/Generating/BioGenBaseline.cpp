@@ -0,0 +1,135 @@
+// BioGenBaseline.cpp
+
+// Checks that the biome generators still produce the same biomes for fixed seeds as they did before the batch generation was added
+
+#include "Globals.h"
+#include "Generating/ComposableGenerator.h"
+#include "IniFile.h"
+
+
+
+
+
+/** Number of chunks along each side of the checked area */
+static const int AREA_SIZE = 4;
+
+
+
+
+
+/** The recorded hash of the biomes in a single area */
+struct sBaseline
+{
+	const char * m_BiomeGen;
+	int m_Seed;
+	int m_MinChunkX;
+	int m_MinChunkZ;
+	UInt32 m_Hash;
+} ;
+
+/** The hashes recorded with the per-chunk generators before the batch generation was added */
+static const sBaseline g_Baselines[] =
+{
+	{ "Grown",        0,       0,    0,     0x9563e358 },
+	{ "Grown",        0,       -3,   -7,    0xd67d3451 },
+	{ "Grown",        0,       1000, -2000, 0xb9372f3d },
+	{ "Grown",        12345,   0,    0,     0x8250040f },
+	{ "Grown",        12345,   -3,   -7,    0x6ae1404c },
+	{ "Grown",        12345,   1000, -2000, 0xad08abeb },
+	{ "Grown",        -987654, 0,    0,     0x1f6ee033 },
+	{ "Grown",        -987654, -3,   -7,    0x34209ff5 },
+	{ "Grown",        -987654, 1000, -2000, 0x6d64e70d },
+	{ "GrownProt",    0,       0,    0,     0x9563e358 },
+	{ "GrownProt",    0,       -3,   -7,    0xd67d3451 },
+	{ "GrownProt",    0,       1000, -2000, 0x55a7711d },
+	{ "GrownProt",    12345,   0,    0,     0x8250040f },
+	{ "GrownProt",    12345,   -3,   -7,    0x6ae1404c },
+	{ "GrownProt",    12345,   1000, -2000, 0xad08abeb },
+	{ "GrownProt",    -987654, 0,    0,     0x1f6ee033 },
+	{ "GrownProt",    -987654, -3,   -7,    0x34209ff5 },
+	{ "GrownProt",    -987654, 1000, -2000, 0x6d64e70d },
+	{ "MultiStepMap", 0,       0,    0,     0x76efddc5 },
+	{ "MultiStepMap", 0,       -3,   -7,    0xc0cd6dc2 },
+	{ "MultiStepMap", 0,       1000, -2000, 0xc969ae9f },
+	{ "MultiStepMap", 12345,   0,    0,     0x261ae537 },
+	{ "MultiStepMap", 12345,   -3,   -7,    0xc81e4c3d },
+	{ "MultiStepMap", 12345,   1000, -2000, 0xfc50ddc5 },
+	{ "MultiStepMap", -987654, 0,    0,     0x64b89aa6 },
+	{ "MultiStepMap", -987654, -3,   -7,    0x16c76419 },
+	{ "MultiStepMap", -987654, 1000, -2000, 0xf1a41dc5 },
+};
+
+
+
+
+
+/** Adds the biomes of a single chunk to the FNV-1a hash in a_Hash */
+static void HashBiomes(const cChunkDef::BiomeMap & a_Biomes, UInt32 & a_Hash)
+{
+	for (size_t i = 0; i < ARRAYCOUNT(a_Biomes); i++)
+	{
+		a_Hash ^= static_cast<UInt32>(a_Biomes[i]);
+		a_Hash *= 16777619u;
+	}
+}
+
+
+
+
+
+/** Generates the area both chunk by chunk and as a batch, and compares the hashes of the biomes to the baseline */
+static void TestBaseline(const sBaseline & a_Baseline)
+{
+	cIniFile IniFile;
+	IniFile.SetValue("Generator", "BiomeGen", a_Baseline.m_BiomeGen);
+	bool CacheOffByDefault;
+	cBiomeGenPtr BiomeGen = cBiomeGen::CreateBiomeGen(IniFile, a_Baseline.m_Seed, CacheOffByDefault);
+	BiomeGen->InitializeBiomeGen(IniFile);
+
+	// The chunks are hashed row by row, in the same order in both ways:
+	UInt32 SingleHash = 2166136261u;
+	for (int z = 0; z < AREA_SIZE; z++)
+	{
+		for (int x = 0; x < AREA_SIZE; x++)
+		{
+			cChunkDef::BiomeMap Biomes;
+			BiomeGen->GenBiomes(a_Baseline.m_MinChunkX + x, a_Baseline.m_MinChunkZ + z, Biomes);
+			HashBiomes(Biomes, SingleHash);
+		}
+	}
+
+	std::vector<cChunkDef::BiomeMap> Batch(static_cast<size_t>(AREA_SIZE * AREA_SIZE));
+	BiomeGen->GenBiomesArea(a_Baseline.m_MinChunkX, a_Baseline.m_MinChunkZ, AREA_SIZE, Batch.data());
+	UInt32 BatchHash = 2166136261u;
+	for (std::vector<cChunkDef::BiomeMap>::const_iterator itr = Batch.begin(), end = Batch.end(); itr != end; ++itr)
+	{
+		HashBiomes(*itr, BatchHash);
+	}
+
+	if ((SingleHash != a_Baseline.m_Hash) || (BatchHash != a_Baseline.m_Hash))
+	{
+		printf("%s, seed %d, area at chunk [%d, %d]: single chunk hash 0x%08x, batch hash 0x%08x, expected 0x%08x\n",
+			a_Baseline.m_BiomeGen, a_Baseline.m_Seed, a_Baseline.m_MinChunkX, a_Baseline.m_MinChunkZ,
+			SingleHash, BatchHash, a_Baseline.m_Hash
+		);
+		exit(1);
+	}
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	for (size_t i = 0; i < ARRAYCOUNT(g_Baselines); i++)
+	{
+		TestBaseline(g_Baselines[i]);
+	}
+	printf("The biomes match the baseline\n");
+	return 0;
+}
+
+
+
+
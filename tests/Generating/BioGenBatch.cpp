@@ -0,0 +1,72 @@
+
+// BioGenBatch.cpp
+
+// Checks that the batch biome generation produces the same biomes as generating the chunks one by one
+
+#include "Globals.h"
+#include "Generating/ComposableGenerator.h"
+#include "IniFile.h"
+
+
+
+
+
+/** Generates a_NumChunks * a_NumChunks chunks both ways and checks that the biomes are the same */
+static void TestArea(const AString & a_BiomeGen, int a_Seed, int a_MinChunkX, int a_MinChunkZ, int a_NumChunks)
+{
+	cIniFile IniFile;
+	IniFile.SetValue("Generator", "BiomeGen", a_BiomeGen);
+	bool CacheOffByDefault;
+	cBiomeGenPtr BiomeGen = cBiomeGen::CreateBiomeGen(IniFile, a_Seed, CacheOffByDefault);
+	BiomeGen->InitializeBiomeGen(IniFile);
+
+	std::vector<cChunkDef::BiomeMap> Batch(static_cast<size_t>(a_NumChunks * a_NumChunks));
+	BiomeGen->GenBiomesArea(a_MinChunkX, a_MinChunkZ, a_NumChunks, Batch.data());
+
+	for (int z = 0; z < a_NumChunks; z++)
+	{
+		for (int x = 0; x < a_NumChunks; x++)
+		{
+			cChunkDef::BiomeMap Single;
+			BiomeGen->GenBiomes(a_MinChunkX + x, a_MinChunkZ + z, Single);
+			const cChunkDef::BiomeMap & FromBatch = Batch[static_cast<size_t>(x + a_NumChunks * z)];
+			for (size_t i = 0; i < ARRAYCOUNT(Single); i++)
+			{
+				if (Single[i] != FromBatch[i])
+				{
+					printf("%s, seed %d: chunk [%d, %d], column %u: batch biome %d, single chunk biome %d\n",
+						a_BiomeGen.c_str(), a_Seed, a_MinChunkX + x, a_MinChunkZ + z, static_cast<unsigned>(i), FromBatch[i], Single[i]
+					);
+					exit(1);
+				}
+			}
+		}  // for x
+	}  // for z
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	// The Grown generator has its own batch chain, the others use the default per-chunk loop:
+	const char * BiomeGens[] = { "Grown", "GrownProt", "MultiStepMap" };
+	const int Seeds[] = { 0, 1, 12345, -987654 };
+	for (size_t g = 0; g < ARRAYCOUNT(BiomeGens); g++)
+	{
+		for (size_t s = 0; s < ARRAYCOUNT(Seeds); s++)
+		{
+			// Areas both aligned and unaligned to the batch chain's 4 x 4 chunks, on both sides of the zero coords:
+			TestArea(BiomeGens[g], Seeds[s], 0, 0, 4);
+			TestArea(BiomeGens[g], Seeds[s], -3, -7, 6);
+			TestArea(BiomeGens[g], Seeds[s], 1000, -2000, 5);
+		}
+	}
+	printf("The batch and single chunk biomes match\n");
+	return 0;
+}
+
+
+
+